@@ -0,0 +1,82 @@
+#include "analyzer/analyzeraudiodigest.h"
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QtEndian>
+#include <cmath>
+
+#include "analyzer/constants.h"
+#include "util/assert.h"
+#include "util/math.h"
+#include "util/samplebuffer.h"
+
+namespace {
+
+// Distinguishes digests that have been calculated differently
+const QString kVersion = QStringLiteral("1");
+
+// The regions are distributed evenly, i.e. at 1/4, 2/4 and 3/4
+// of the track
+constexpr int kRegionCount = 3;
+
+constexpr double kRegionSeconds = 2.0;
+
+constexpr float kQuantizationScale = 32767.0f;
+
+} // anonymous namespace
+
+// static
+QString AnalyzerAudioDigest::calculate(mixxx::AudioSource* pAudioSource) {
+    VERIFY_OR_DEBUG_ASSERT(pAudioSource) {
+        return QString();
+    }
+    const auto& signalInfo = pAudioSource->getSignalInfo();
+    const auto frameIndexRange = pAudioSource->frameIndexRange();
+    if (frameIndexRange.empty()) {
+        return QString();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    // Tracks that only differ in their length must not be confused
+    hash.addData(QStringLiteral("%1|%2|%3|%4")
+                         .arg(kVersion,
+                                 QString::number(signalInfo.getSampleRate()),
+                                 QString::number(signalInfo.getChannelCount()),
+                                 QString::number(frameIndexRange.length()))
+                         .toLatin1());
+
+    const SINT regionFrames = math_min(frameIndexRange.length(),
+            static_cast<SINT>(signalInfo.secs2frames(kRegionSeconds)));
+    mixxx::SampleBuffer sampleBuffer(
+            signalInfo.frames2samples(mixxx::kAnalysisFramesPerChunk));
+    QByteArray quantizedSamples(
+            static_cast<int>(sampleBuffer.size() * sizeof(qint16)), Qt::Uninitialized);
+    for (int region = 1; region <= kRegionCount; ++region) {
+        const SINT regionStart = frameIndexRange.start() +
+                (frameIndexRange.length() - regionFrames) * region / (kRegionCount + 1);
+        auto remainingFrameIndexRange = mixxx::IndexRange::forward(regionStart, regionFrames);
+        while (!remainingFrameIndexRange.empty()) {
+            const auto chunkFrameIndexRange = remainingFrameIndexRange.splitAndShrinkFront(
+                    math_min(mixxx::kAnalysisFramesPerChunk,
+                            remainingFrameIndexRange.length()));
+            const auto readableSampleFrames = pAudioSource->readSampleFrames(
+                    mixxx::WritableSampleFrames(chunkFrameIndexRange,
+                            mixxx::SampleBuffer::WritableSlice(sampleBuffer)));
+            if (readableSampleFrames.frameIndexRange() != chunkFrameIndexRange) {
+                // Incomplete digests would not be comparable
+                return QString();
+            }
+            const CSAMPLE* pSamples = readableSampleFrames.readableData();
+            const SINT sampleCount = readableSampleFrames.readableLength();
+            auto* pQuantizedSamples = reinterpret_cast<uchar*>(quantizedSamples.data());
+            for (SINT i = 0; i < sampleCount; ++i) {
+                const auto quantizedSample = static_cast<qint16>(std::lround(
+                        math_clamp(pSamples[i], -1.0f, 1.0f) * kQuantizationScale));
+                qToLittleEndian(quantizedSample, pQuantizedSamples + i * sizeof(qint16));
+            }
+            hash.addData(quantizedSamples.left(
+                    static_cast<int>(sampleCount * sizeof(qint16))));
+        }
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <QString>
+
+#include "sources/audiosource.h"
+
+/// AnalyzerAudioDigest calculates a fingerprint of the decoded audio of
+/// a track. Files with identical audio have the same digest, even if they
+/// are located elsewhere or differ in their tags, so the analysis results
+/// of one can be reused for the other.
+///
+/// Only a few short regions of the track are decoded. The samples are
+/// quantized to 16 bits before hashing to ignore rounding differences
+/// of the decoders.
+class AnalyzerAudioDigest {
+  public:
+    /// Returns an empty string if the audio could not be decoded
+    static QString calculate(mixxx::AudioSource* pAudioSource);
+};
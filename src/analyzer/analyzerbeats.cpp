@@ -5,6 +5,7 @@
 #include <QVector>
 #include <QtDebug>
 
+#include "analyzer/analyzerpreview.h"
 #include "analyzer/analyzertrack.h"
 #include "analyzer/constants.h"
 #include "analyzer/plugins/analyzerqueenmarybeats.h"
@@ -29,6 +30,35 @@ mixxx::AnalyzerPluginInfo AnalyzerBeats::defaultPlugin() {
     return plugins.at(0);
 }
 
+// static
+QString AnalyzerBeats::preferredPluginId(const BeatDetectionSettings& bpmSettings) {
+    const auto plugins = availablePlugins();
+    if (plugins.isEmpty()) {
+        return QString();
+    }
+    const QString pluginId = bpmSettings.getBeatPluginId();
+    for (const auto& info : plugins) {
+        if (info.id() == pluginId) {
+            return pluginId; // configured Plug-In available
+        }
+    }
+    return defaultPlugin().id();
+}
+
+// static
+std::unique_ptr<mixxx::AnalyzerBeatsPlugin> AnalyzerBeats::createPlugin(
+        const QString& pluginId) {
+    if (pluginId == mixxx::AnalyzerQueenMaryBeats::pluginInfo().id()) {
+        return std::make_unique<mixxx::AnalyzerQueenMaryBeats>();
+    } else if (pluginId == mixxx::AnalyzerSoundTouchBeats::pluginInfo().id()) {
+        return std::make_unique<mixxx::AnalyzerSoundTouchBeats>();
+    }
+    // This must not happen, because the PlugInId has been
+    // verified by preferredPluginId()
+    DEBUG_ASSERT(false);
+    return nullptr;
+}
+
 AnalyzerBeats::AnalyzerBeats(UserSettingsPointer pConfig, bool enforceBpmDetection)
         : m_bpmSettings(pConfig),
           m_enforceBpmDetection(enforceBpmDetection),
@@ -67,17 +97,7 @@ bool AnalyzerBeats::initialize(const AnalyzerTrack& track,
     m_bPreferencesReanalyzeImported = m_bpmSettings.getReanalyzeImported();
     m_bPreferencesFastAnalysis = m_bpmSettings.getFastAnalysis();
 
-    const auto plugins = availablePlugins();
-    if (!plugins.isEmpty()) {
-        m_pluginId = defaultPlugin().id();
-        QString pluginId = m_bpmSettings.getBeatPluginId();
-        for (const auto& info : plugins) {
-            if (info.id() == pluginId) {
-                m_pluginId = pluginId; // configured Plug-In available
-                break;
-            }
-        }
-    }
+    m_pluginId = preferredPluginId(m_bpmSettings);
 
     qDebug() << "AnalyzerBeats preference settings:"
              << "\nPlugin:" << m_pluginId
@@ -103,16 +123,7 @@ bool AnalyzerBeats::initialize(const AnalyzerTrack& track,
 
     DEBUG_ASSERT(!m_pPlugin);
     if (bShouldAnalyze) {
-        if (m_pluginId == mixxx::AnalyzerQueenMaryBeats::pluginInfo().id()) {
-            m_pPlugin = std::make_unique<mixxx::AnalyzerQueenMaryBeats>();
-        } else if (m_pluginId == mixxx::AnalyzerSoundTouchBeats::pluginInfo().id()) {
-            m_pPlugin = std::make_unique<mixxx::AnalyzerSoundTouchBeats>();
-        } else {
-            // This must not happen, because we have already verified above
-            // that the PlugInId is valid
-            DEBUG_ASSERT(false);
-        }
-
+        m_pPlugin = createPlugin(m_pluginId);
         if (m_pPlugin) {
             if (m_pPlugin->initialize(m_sampleRate)) {
                 qDebug() << "Beat calculation started with plugin" << m_pluginId;
@@ -163,6 +174,10 @@ bool AnalyzerBeats::shouldAnalyze(TrackPointer pTrack) const {
     if (subVersion == mixxx::rekordboxconstants::beatsSubversion) {
         return m_bPreferencesReanalyzeImported;
     }
+    if (AnalyzerPreview::isPreviewSubVersion(subVersion)) {
+        // Refine the provisional result of the preview
+        return true;
+    }
 
     if (subVersion.isEmpty() && pBeats->firstBeat() <= mixxx::audio::kStartFramePos &&
             m_pluginId != mixxx::AnalyzerSoundTouchBeats::pluginInfo().id()) {
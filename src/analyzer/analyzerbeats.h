@@ -18,6 +18,11 @@ class AnalyzerBeats : public Analyzer {
 
     static QList<mixxx::AnalyzerPluginInfo> availablePlugins();
     static mixxx::AnalyzerPluginInfo defaultPlugin();
+    // The configured plugin if available, otherwise the default plugin
+    static QString preferredPluginId(const BeatDetectionSettings& bpmSettings);
+    static std::unique_ptr<mixxx::AnalyzerBeatsPlugin> createPlugin(const QString& pluginId);
+    static QHash<QString, QString> getExtraVersionInfo(
+            const QString& pluginId, bool bPreferencesFastAnalysis);
 
     bool initialize(const AnalyzerTrack& track,
             mixxx::audio::SampleRate sampleRate,
@@ -29,8 +34,6 @@ class AnalyzerBeats : public Analyzer {
 
   private:
     bool shouldAnalyze(TrackPointer pTrack) const;
-    static QHash<QString, QString> getExtraVersionInfo(
-            const QString& pluginId, bool bPreferencesFastAnalysis);
 
     BeatDetectionSettings m_bpmSettings;
     std::unique_ptr<mixxx::AnalyzerBeatsPlugin> m_pPlugin;
@@ -0,0 +1,162 @@
+#include "analyzer/analyzerfileprefetcher.h"
+
+#include <QFile>
+#include <mutex>
+
+#include "moc_analyzerfileprefetcher.cpp"
+#include "util/compatibility/qmutex.h"
+#include "util/logger.h"
+#include "util/math.h"
+
+namespace {
+
+const mixxx::Logger kLogger("AnalyzerFilePrefetcher");
+
+// Large blocks for sequential reading
+constexpr qint64 kReadBlockSize = 1024 * 1024;
+
+// The throughput is measured and the number of threads adjusted
+// after this number of files has been read
+constexpr int kMeasurementFileCount = 8;
+
+// Relative changes of the throughput below this threshold are
+// considered as noise
+constexpr double kThroughputTolerance = 0.1;
+
+constexpr double kBytesPerMegabyte = 1000.0 * 1000.0;
+
+std::once_flag registerMetaTypesOnceFlag;
+
+void registerMetaTypesOnce() {
+    qRegisterMetaType<TrackId>();
+}
+
+} // anonymous namespace
+
+AnalyzerFilePrefetcher::Task::Task(
+        AnalyzerFilePrefetcher* pPrefetcher, TrackId trackId, QString location)
+        : m_pPrefetcher(pPrefetcher),
+          m_trackId(trackId),
+          m_location(std::move(location)) {
+}
+
+void AnalyzerFilePrefetcher::Task::run() {
+    {
+        const auto locker = lockMutex(&m_pPrefetcher->m_mutex);
+        if (m_pPrefetcher->m_activeTaskCount++ == 0) {
+            m_pPrefetcher->m_busyTimer.start();
+        }
+    }
+
+    qint64 bytes = 0;
+    QFile file(m_location);
+    if (file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        // The contents only need to end up in the page cache
+        QByteArray buffer(kReadBlockSize, Qt::Uninitialized);
+        while (!m_pPrefetcher->m_cancelled.load(std::memory_order_relaxed)) {
+            const qint64 readBytes = file.read(buffer.data(), buffer.size());
+            if (readBytes <= 0) {
+                break;
+            }
+            bytes += readBytes;
+        }
+    } else {
+        kLogger.warning()
+                << "Failed to open file"
+                << m_location
+                << file.errorString();
+    }
+
+    {
+        const auto locker = lockMutex(&m_pPrefetcher->m_mutex);
+        m_pPrefetcher->m_readBytes += bytes;
+        if (--m_pPrefetcher->m_activeTaskCount == 0) {
+            m_pPrefetcher->m_busyDuration += m_pPrefetcher->m_busyTimer.elapsed();
+        }
+    }
+    emit m_pPrefetcher->prefetched(m_trackId, bytes);
+}
+
+AnalyzerFilePrefetcher::AnalyzerFilePrefetcher(QObject* parent)
+        : QObject(parent),
+          m_cancelled(false),
+          m_activeTaskCount(0),
+          m_readBytes(0),
+          m_prefetchedCount(0),
+          m_megabytesPerSecond(0),
+          m_lastThreadCountChange(0) {
+    std::call_once(registerMetaTypesOnceFlag, registerMetaTypesOnce);
+    m_threadPool.setMaxThreadCount(1);
+    // Queued, because the signal is emitted from the I/O threads
+    connect(this,
+            &AnalyzerFilePrefetcher::prefetched,
+            this,
+            &AnalyzerFilePrefetcher::onPrefetched);
+}
+
+AnalyzerFilePrefetcher::~AnalyzerFilePrefetcher() {
+    m_cancelled.store(true, std::memory_order_relaxed);
+    m_threadPool.clear();
+    m_threadPool.waitForDone();
+}
+
+void AnalyzerFilePrefetcher::prefetch(TrackId trackId, const QString& location) {
+    m_threadPool.start(new Task(this, trackId, location));
+}
+
+void AnalyzerFilePrefetcher::clear() {
+    m_threadPool.clear();
+}
+
+void AnalyzerFilePrefetcher::onPrefetched(TrackId /*trackId*/, qint64 /*bytes*/) {
+    if (++m_prefetchedCount % kMeasurementFileCount != 0) {
+        return;
+    }
+    mixxx::Duration busyDuration;
+    qint64 readBytes;
+    {
+        const auto locker = lockMutex(&m_mutex);
+        busyDuration = m_busyDuration;
+        if (m_activeTaskCount > 0) {
+            busyDuration += m_busyTimer.restart();
+        }
+        m_busyDuration = mixxx::Duration::empty();
+        readBytes = m_readBytes;
+        m_readBytes = 0;
+    }
+    if (busyDuration.toDoubleSeconds() <= 0) {
+        return;
+    }
+    adjustThreadCount(readBytes / kBytesPerMegabyte / busyDuration.toDoubleSeconds());
+}
+
+void AnalyzerFilePrefetcher::adjustThreadCount(double megabytesPerSecond) {
+    int change;
+    if (m_megabytesPerSecond <= 0) {
+        // Try concurrent reads after the first measurement
+        change = 1;
+    } else if (megabytesPerSecond > m_megabytesPerSecond * (1 + kThroughputTolerance)) {
+        // Continue in the same direction, if any
+        change = m_lastThreadCountChange;
+    } else if (megabytesPerSecond < m_megabytesPerSecond * (1 - kThroughputTolerance)) {
+        // Revert the last change
+        change = -m_lastThreadCountChange;
+    } else {
+        change = 0;
+    }
+    const int oldThreadCount = threadCount();
+    const int newThreadCount = math_clamp(oldThreadCount + change, 1, kMaxThreadCount);
+    m_lastThreadCountChange = newThreadCount - oldThreadCount;
+    m_megabytesPerSecond = megabytesPerSecond;
+    if (newThreadCount != oldThreadCount) {
+        kLogger.debug()
+                << "Reading with"
+                << newThreadCount
+                << "instead of"
+                << oldThreadCount
+                << "threads at"
+                << megabytesPerSecond
+                << "MB/s";
+        m_threadPool.setMaxThreadCount(newThreadCount);
+    }
+}
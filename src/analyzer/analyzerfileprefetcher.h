@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QMutex>
+#include <QObject>
+#include <QRunnable>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+
+#include "track/trackid.h"
+#include "util/duration.h"
+#include "util/performancetimer.h"
+
+/// AnalyzerFilePrefetcher reads the files of upcoming tracks sequentially
+/// on a small pool of I/O threads, so the analyzer threads decode them
+/// from the page cache instead of competing for seeks on slow storage.
+///
+/// The pool starts with a single thread. The number of threads is adjusted
+/// by comparing the throughput measured while reading, i.e. it only grows
+/// while concurrent reads are actually faster.
+///
+/// All functions must be called from the host thread.
+class AnalyzerFilePrefetcher : public QObject {
+    Q_OBJECT
+
+  public:
+    static constexpr int kMaxThreadCount = 4;
+
+    explicit AnalyzerFilePrefetcher(QObject* parent = nullptr);
+    ~AnalyzerFilePrefetcher() override;
+
+    /// Enqueues the file for reading
+    void prefetch(TrackId trackId, const QString& location);
+
+    /// Discards all files that are not being read yet
+    void clear();
+
+    int threadCount() const {
+        return m_threadPool.maxThreadCount();
+    }
+
+    /// The throughput of the last measurement, 0 if unknown
+    double megabytesPerSecond() const {
+        return m_megabytesPerSecond;
+    }
+
+  signals:
+    /// Emitted from the I/O thread after the file has been read completely
+    void prefetched(TrackId trackId, qint64 bytes);
+
+  private slots:
+    void onPrefetched(TrackId trackId, qint64 bytes);
+
+  private:
+    class Task : public QRunnable {
+      public:
+        Task(AnalyzerFilePrefetcher* pPrefetcher, TrackId trackId, QString location);
+
+        void run() override;
+
+      private:
+        AnalyzerFilePrefetcher* const m_pPrefetcher;
+        const TrackId m_trackId;
+        const QString m_location;
+    };
+
+    void adjustThreadCount(double megabytesPerSecond);
+
+    std::atomic<bool> m_cancelled;
+
+    // Shared with the I/O threads: The time during which at least one file
+    // has been read and the number of bytes read since the last measurement
+    QMutex m_mutex;
+    int m_activeTaskCount;
+    PerformanceTimer m_busyTimer;
+    mixxx::Duration m_busyDuration;
+    qint64 m_readBytes;
+
+    // Host thread only
+    int m_prefetchedCount;
+    double m_megabytesPerSecond;
+    int m_lastThreadCountChange;
+
+    // Destroyed first, after all tasks have returned
+    QThreadPool m_threadPool;
+};
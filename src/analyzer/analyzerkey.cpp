@@ -2,6 +2,7 @@
 
 #include <QtDebug>
 
+#include "analyzer/analyzerpreview.h"
 #include "analyzer/analyzertrack.h"
 #include "analyzer/constants.h"
 #if defined __KEYFINDER__
@@ -34,6 +35,37 @@ mixxx::AnalyzerPluginInfo AnalyzerKey::defaultPlugin() {
     return plugins.at(0);
 }
 
+// static
+QString AnalyzerKey::preferredPluginId(const KeyDetectionSettings& keySettings) {
+    const auto plugins = availablePlugins();
+    if (plugins.isEmpty()) {
+        return QString();
+    }
+    const QString pluginId = keySettings.getKeyPluginId();
+    for (const auto& info : plugins) {
+        if (info.id() == pluginId) {
+            return pluginId; // configured Plug-In available
+        }
+    }
+    return defaultPlugin().id();
+}
+
+// static
+std::unique_ptr<mixxx::AnalyzerKeyPlugin> AnalyzerKey::createPlugin(
+        const QString& pluginId) {
+    if (pluginId == mixxx::AnalyzerQueenMaryKey::pluginInfo().id()) {
+        return std::make_unique<mixxx::AnalyzerQueenMaryKey>();
+#if defined __KEYFINDER__
+    } else if (pluginId == mixxx::AnalyzerKeyFinder::pluginInfo().id()) {
+        return std::make_unique<mixxx::AnalyzerKeyFinder>();
+#endif
+    }
+    // This must not happen, because the PlugInId has been
+    // verified by preferredPluginId()
+    DEBUG_ASSERT(false);
+    return nullptr;
+}
+
 AnalyzerKey::AnalyzerKey(const KeyDetectionSettings& keySettings)
         : m_keySettings(keySettings),
           m_sampleRate(0),
@@ -62,17 +94,7 @@ bool AnalyzerKey::initialize(const AnalyzerTrack& track,
     m_bPreferencesFastAnalysisEnabled = m_keySettings.getFastAnalysis();
     m_bPreferencesReanalyzeEnabled = m_keySettings.getReanalyzeWhenSettingsChange();
 
-    const auto plugins = availablePlugins();
-    if (!plugins.isEmpty()) {
-        m_pluginId = defaultPlugin().id();
-        QString pluginId = m_keySettings.getKeyPluginId();
-        for (const auto& info : plugins) {
-            if (info.id() == pluginId) {
-                m_pluginId = pluginId; // configured Plug-In available
-                break;
-            }
-        }
-    }
+    m_pluginId = preferredPluginId(m_keySettings);
 
     qDebug() << "AnalyzerKey preference settings:"
              << "\nPlugin:" << m_pluginId
@@ -96,18 +118,7 @@ bool AnalyzerKey::initialize(const AnalyzerTrack& track,
 
     DEBUG_ASSERT(!m_pPlugin);
     if (bShouldAnalyze) {
-        if (m_pluginId == mixxx::AnalyzerQueenMaryKey::pluginInfo().id()) {
-            m_pPlugin = std::make_unique<mixxx::AnalyzerQueenMaryKey>();
-#if defined __KEYFINDER__
-        } else if (m_pluginId == mixxx::AnalyzerKeyFinder::pluginInfo().id()) {
-            m_pPlugin = std::make_unique<mixxx::AnalyzerKeyFinder>();
-#endif
-        } else {
-            // This must not happen, because we have already verified above
-            // that the PlugInId is valid
-            DEBUG_ASSERT(false);
-        }
-
+        m_pPlugin = createPlugin(m_pluginId);
         if (m_pPlugin) {
             if (m_pPlugin->initialize(mixxx::audio::SampleRate(m_sampleRate))) {
                 qDebug() << "Key calculation started with plugin" << m_pluginId;
@@ -134,6 +145,10 @@ bool AnalyzerKey::shouldAnalyze(TrackPointer pTrack) const {
     if (keys.getGlobalKey() != mixxx::track::io::key::INVALID) {
         QString version = keys.getVersion();
         QString subVersion = keys.getSubVersion();
+        if (AnalyzerPreview::isPreviewSubVersion(subVersion)) {
+            // Refine the provisional result of the preview
+            return true;
+        }
 
         QHash<QString, QString> extraVersionInfo = getExtraVersionInfo(
                 pluginID, bPreferencesFastAnalysisEnabled);
@@ -17,6 +17,11 @@ class AnalyzerKey : public Analyzer {
 
     static QList<mixxx::AnalyzerPluginInfo> availablePlugins();
     static mixxx::AnalyzerPluginInfo defaultPlugin();
+    // The configured plugin if available, otherwise the default plugin
+    static QString preferredPluginId(const KeyDetectionSettings& keySettings);
+    static std::unique_ptr<mixxx::AnalyzerKeyPlugin> createPlugin(const QString& pluginId);
+    static QHash<QString, QString> getExtraVersionInfo(
+            const QString& pluginId, bool bPreferencesFastAnalysis);
 
     bool initialize(const AnalyzerTrack& track,
             mixxx::audio::SampleRate sampleRate,
@@ -27,9 +32,6 @@ class AnalyzerKey : public Analyzer {
     void cleanup() override;
 
   private:
-    static QHash<QString, QString> getExtraVersionInfo(
-            const QString& pluginId, bool bPreferencesFastAnalysis);
-
     bool shouldAnalyze(TrackPointer tio) const;
 
     KeyDetectionSettings m_keySettings;
@@ -0,0 +1,127 @@
+#include "analyzer/analyzerpipeline.h"
+
+#include <cstring>
+#include <limits>
+
+#include "analyzer/constants.h"
+#include "util/assert.h"
+
+AnalyzerPipeline::Lane::Lane(AnalyzerPipeline* pPipeline, AnalyzerWithState* pAnalyzer)
+        : m_publishedChunks(0),
+          m_pPipeline(pPipeline),
+          m_pAnalyzer(pAnalyzer) {
+    setAutoDelete(false);
+}
+
+void AnalyzerPipeline::Lane::run() {
+    for (SINT chunkIndex = 0;; ++chunkIndex) {
+        m_publishedChunks.acquire();
+        if (m_pPipeline->m_cancelled.load(std::memory_order_acquire) ||
+                chunkIndex == m_pPipeline->m_endChunkIndex.load(std::memory_order_acquire)) {
+            break;
+        }
+        Chunk& chunk = m_pPipeline->m_chunks[chunkIndex % kChunkCount];
+        m_pAnalyzer->processSamples(chunk.buffer.data(), chunk.sampleCount);
+        m_pPipeline->releaseChunk(&chunk);
+    }
+    m_pPipeline->m_finishedLanes.release();
+}
+
+AnalyzerPipeline::AnalyzerPipeline(std::vector<AnalyzerWithState>* pAnalyzers)
+        : m_pAnalyzers(pAnalyzers),
+          m_freeChunks(kChunkCount),
+          m_finishedLanes(0),
+          m_pAcquiredChunk(nullptr),
+          m_publishedChunkCount(0),
+          m_endChunkIndex(std::numeric_limits<SINT>::max()),
+          m_cancelled(false) {
+    DEBUG_ASSERT(m_pAnalyzers);
+    for (auto& chunk : m_chunks) {
+        chunk.buffer = mixxx::SampleBuffer(mixxx::kAnalysisSamplesPerChunk);
+        chunk.sampleCount = 0;
+        chunk.pendingLanes.store(0, std::memory_order_relaxed);
+    }
+    m_threadPool.setMaxThreadCount(static_cast<int>(m_pAnalyzers->size()));
+}
+
+AnalyzerPipeline::~AnalyzerPipeline() {
+    if (!m_lanes.empty()) {
+        finish(true);
+    }
+}
+
+void AnalyzerPipeline::start() {
+    DEBUG_ASSERT(m_lanes.empty());
+    m_pAcquiredChunk = nullptr;
+    m_publishedChunkCount = 0;
+    m_endChunkIndex.store(std::numeric_limits<SINT>::max(), std::memory_order_relaxed);
+    m_cancelled.store(false, std::memory_order_relaxed);
+
+    for (auto& analyzer : *m_pAnalyzers) {
+        // Inactive analyzers are not going to process any samples
+        if (analyzer.isActive()) {
+            m_lanes.push_back(std::make_unique<Lane>(this, &analyzer));
+        }
+    }
+    for (const auto& pLane : m_lanes) {
+        m_threadPool.start(pLane.get());
+    }
+}
+
+mixxx::SampleBuffer::WritableSlice AnalyzerPipeline::acquireChunk() {
+    if (!m_pAcquiredChunk) {
+        m_freeChunks.acquire();
+        m_pAcquiredChunk = &m_chunks[m_publishedChunkCount % kChunkCount];
+    }
+    return mixxx::SampleBuffer::WritableSlice(m_pAcquiredChunk->buffer);
+}
+
+void AnalyzerPipeline::publishChunk(const CSAMPLE* pSamples, SINT sampleCount) {
+    VERIFY_OR_DEBUG_ASSERT(m_pAcquiredChunk) {
+        return;
+    }
+    DEBUG_ASSERT(sampleCount <= m_pAcquiredChunk->buffer.size());
+    if (m_lanes.empty()) {
+        return;
+    }
+    // The decoded samples may start at an offset within the chunk
+    if (pSamples != m_pAcquiredChunk->buffer.data()) {
+        std::memmove(m_pAcquiredChunk->buffer.data(),
+                pSamples,
+                sizeof(CSAMPLE) * sampleCount);
+    }
+    m_pAcquiredChunk->sampleCount = sampleCount;
+    m_pAcquiredChunk->pendingLanes.store(
+            static_cast<int>(m_lanes.size()), std::memory_order_relaxed);
+    m_pAcquiredChunk = nullptr;
+    ++m_publishedChunkCount;
+    for (const auto& pLane : m_lanes) {
+        pLane->m_publishedChunks.release();
+    }
+}
+
+void AnalyzerPipeline::releaseChunk(Chunk* pChunk) {
+    if (pChunk->pendingLanes.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        m_freeChunks.release();
+    }
+}
+
+void AnalyzerPipeline::finish(bool cancel) {
+    if (cancel) {
+        m_cancelled.store(true, std::memory_order_release);
+    }
+    m_endChunkIndex.store(m_publishedChunkCount, std::memory_order_release);
+    for (const auto& pLane : m_lanes) {
+        pLane->m_publishedChunks.release();
+    }
+    m_finishedLanes.acquire(static_cast<int>(m_lanes.size()));
+    m_lanes.clear();
+
+    // Chunks that have been skipped by cancelled lanes or that have been
+    // acquired but not published are free again
+    m_pAcquiredChunk = nullptr;
+    const int freeChunks = m_freeChunks.available();
+    if (freeChunks < kChunkCount) {
+        m_freeChunks.release(kChunkCount - freeChunks);
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "analyzer/analyzer.h"
+#include "util/samplebuffer.h"
+
+/// AnalyzerPipeline runs the analyzers of a single track concurrently. The
+/// analyzer thread decodes each chunk of audio only once into a ring of
+/// shared chunks and every active analyzer consumes the chunks in order on
+/// its own thread. A chunk is reused after the last analyzer has processed
+/// it, so the decoder is at most kChunkCount chunks ahead of the slowest
+/// analyzer.
+///
+/// The analyzers are only accessed by their pipeline threads between
+/// start() and finish().
+class AnalyzerPipeline {
+  public:
+    static constexpr int kChunkCount = 8;
+
+    /// The analyzers must outlive the pipeline
+    explicit AnalyzerPipeline(std::vector<AnalyzerWithState>* pAnalyzers);
+    ~AnalyzerPipeline();
+
+    AnalyzerPipeline(const AnalyzerPipeline&) = delete;
+    AnalyzerPipeline& operator=(const AnalyzerPipeline&) = delete;
+
+    /// Starts a thread for each active analyzer
+    void start();
+
+    /// Blocks until a free chunk is available and returns it for decoding
+    /// the next kAnalysisSamplesPerChunk samples. Returns the same chunk
+    /// until it has been published.
+    mixxx::SampleBuffer::WritableSlice acquireChunk();
+
+    /// Passes the decoded samples to all analyzers. The samples are
+    /// expected within the acquired chunk.
+    void publishChunk(const CSAMPLE* pSamples, SINT sampleCount);
+
+    /// Blocks until all analyzers have processed every published chunk or,
+    /// if cancelled, until they have stopped.
+    void finish(bool cancel);
+
+  private:
+    struct Chunk {
+        mixxx::SampleBuffer buffer;
+        SINT sampleCount;
+        std::atomic<int> pendingLanes;
+    };
+
+    class Lane : public QRunnable {
+      public:
+        Lane(AnalyzerPipeline* pPipeline, AnalyzerWithState* pAnalyzer);
+
+        void run() override;
+
+        // Released once for every published chunk and once more to stop
+        QSemaphore m_publishedChunks;
+
+      private:
+        AnalyzerPipeline* const m_pPipeline;
+        AnalyzerWithState* const m_pAnalyzer;
+    };
+
+    void releaseChunk(Chunk* pChunk);
+
+    std::vector<AnalyzerWithState>* const m_pAnalyzers;
+    std::array<Chunk, kChunkCount> m_chunks;
+    std::vector<std::unique_ptr<Lane>> m_lanes;
+
+    QSemaphore m_freeChunks;
+    QSemaphore m_finishedLanes;
+
+    // Owned by the decoding thread
+    Chunk* m_pAcquiredChunk;
+    SINT m_publishedChunkCount;
+
+    // The number of chunks of the track, set when finished
+    std::atomic<SINT> m_endChunkIndex;
+    std::atomic<bool> m_cancelled;
+
+    // Destroyed first, after all lanes have returned
+    QThreadPool m_threadPool;
+};
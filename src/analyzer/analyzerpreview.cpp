@@ -0,0 +1,195 @@
+#include "analyzer/analyzerpreview.h"
+
+#include <QHash>
+#include <QVector>
+#include <algorithm>
+
+#include "analyzer/analyzerbeats.h"
+#include "analyzer/analyzerkey.h"
+#include "analyzer/constants.h"
+#include "track/beatfactory.h"
+#include "track/keyfactory.h"
+#include "track/track.h"
+#include "util/logger.h"
+#include "util/math.h"
+#include "util/performancetimer.h"
+#include "util/samplebuffer.h"
+
+namespace {
+
+const mixxx::Logger kLogger("AnalyzerPreview");
+
+// The windows are distributed evenly, i.e. the intro and the
+// outro that often lack a beat are skipped
+constexpr int kWindowCount = 4;
+
+constexpr double kWindowSeconds = 10.0;
+
+// Recognized by Track::isProvisionalSubVersion()
+const QString kPreviewVersionInfoKey = QStringLiteral("preview");
+const QString kPreviewVersionInfoValue = QStringLiteral("1");
+
+QHash<QString, QString> previewExtraVersionInfo(
+        QHash<QString, QString> extraVersionInfo) {
+    extraVersionInfo.insert(kPreviewVersionInfoKey, kPreviewVersionInfoValue);
+    return extraVersionInfo;
+}
+
+} // anonymous namespace
+
+AnalyzerPreview::AnalyzerPreview(UserSettingsPointer pConfig, bool enforceBpmDetection)
+        : m_bpmSettings(pConfig),
+          m_keySettings(pConfig),
+          m_enforceBpmDetection(enforceBpmDetection) {
+}
+
+// static
+bool AnalyzerPreview::isPreviewSubVersion(const QString& subVersion) {
+    return Track::isProvisionalSubVersion(subVersion);
+}
+
+bool AnalyzerPreview::analyze(const AnalyzerTrack& track, mixxx::AudioSource* pAudioSource) {
+    VERIFY_OR_DEBUG_ASSERT(pAudioSource) {
+        return false;
+    }
+    const TrackPointer& pTrack = track.getTrack();
+    const auto& signalInfo = pAudioSource->getSignalInfo();
+    if (signalInfo.getChannelCount() != mixxx::audio::ChannelCount::stereo()) {
+        // The stems are mixed differently for beat and key detection,
+        // which is left to the full analysis
+        return false;
+    }
+
+    const bool analyzeBeats =
+            (m_enforceBpmDetection || m_bpmSettings.getBpmDetectionEnabled()) &&
+            !pTrack->getBeats();
+    const bool analyzeKey = m_keySettings.getKeyDetectionEnabled() &&
+            pTrack->getKeys().getGlobalKey() == mixxx::track::io::key::INVALID;
+    if (!analyzeBeats && !analyzeKey) {
+        return false;
+    }
+
+    const auto frameIndexRange = pAudioSource->frameIndexRange();
+    const auto windowFrames = static_cast<SINT>(signalInfo.secs2frames(kWindowSeconds));
+    if (frameIndexRange.length() < 2 * kWindowCount * windowFrames) {
+        // The full analysis of short tracks finishes soon enough
+        return false;
+    }
+
+    PerformanceTimer timer;
+    timer.start();
+
+    const QString beatsPluginId = AnalyzerBeats::preferredPluginId(m_bpmSettings);
+    const QString keyPluginId = AnalyzerKey::preferredPluginId(m_keySettings);
+
+    // The windows are passed to the key plugin one after another
+    std::unique_ptr<mixxx::AnalyzerKeyPlugin> pKeyPlugin;
+    if (analyzeKey) {
+        pKeyPlugin = AnalyzerKey::createPlugin(keyPluginId);
+        if (pKeyPlugin && !pKeyPlugin->initialize(signalInfo.getSampleRate())) {
+            pKeyPlugin.reset();
+        }
+    }
+
+    QVector<mixxx::audio::FramePos> beats;
+    QVector<double> bpmValues;
+    mixxx::SampleBuffer sampleBuffer(
+            signalInfo.frames2samples(mixxx::kAnalysisFramesPerChunk));
+    for (int window = 1; window <= kWindowCount; ++window) {
+        const SINT windowStart = frameIndexRange.start() +
+                (frameIndexRange.length() - windowFrames) * window / (kWindowCount + 1);
+        // The beats of each window are detected independently. The gaps
+        // between the windows just separate the regions of constant tempo.
+        std::unique_ptr<mixxx::AnalyzerBeatsPlugin> pBeatsPlugin;
+        if (analyzeBeats) {
+            pBeatsPlugin = AnalyzerBeats::createPlugin(beatsPluginId);
+            if (pBeatsPlugin && !pBeatsPlugin->initialize(signalInfo.getSampleRate())) {
+                pBeatsPlugin.reset();
+            }
+        }
+        auto remainingFrameIndexRange = mixxx::IndexRange::forward(windowStart, windowFrames);
+        while (!remainingFrameIndexRange.empty()) {
+            const auto chunkFrameIndexRange = remainingFrameIndexRange.splitAndShrinkFront(
+                    math_min(mixxx::kAnalysisFramesPerChunk,
+                            remainingFrameIndexRange.length()));
+            const auto readableSampleFrames = pAudioSource->readSampleFrames(
+                    mixxx::WritableSampleFrames(chunkFrameIndexRange,
+                            mixxx::SampleBuffer::WritableSlice(sampleBuffer)));
+            if (!readableSampleFrames.frameIndexRange().empty()) {
+                if (pBeatsPlugin) {
+                    pBeatsPlugin->processSamples(readableSampleFrames.readableData(),
+                            readableSampleFrames.readableLength());
+                }
+                if (pKeyPlugin) {
+                    pKeyPlugin->processSamples(readableSampleFrames.readableData(),
+                            readableSampleFrames.readableLength());
+                }
+            }
+            if (readableSampleFrames.frameIndexRange() != chunkFrameIndexRange) {
+                // Continue with the next window
+                break;
+            }
+        }
+        if (!pBeatsPlugin || !pBeatsPlugin->finalize()) {
+            continue;
+        }
+        if (pBeatsPlugin->supportsBeatTracking()) {
+            const auto windowOffset =
+                    static_cast<mixxx::audio::FrameDiff_t>(windowStart - frameIndexRange.start());
+            const auto windowBeats = pBeatsPlugin->getBeats();
+            for (const auto& beat : windowBeats) {
+                beats.append(beat + windowOffset);
+            }
+        } else {
+            const mixxx::Bpm bpm = pBeatsPlugin->getBpm();
+            if (bpm.isValid()) {
+                bpmValues.append(bpm.value());
+            }
+        }
+    }
+
+    bool published = false;
+    if (analyzeBeats) {
+        const auto extraVersionInfo = previewExtraVersionInfo(
+                AnalyzerBeats::getExtraVersionInfo(
+                        beatsPluginId, m_bpmSettings.getFastAnalysis()));
+        mixxx::BeatsPointer pBeats;
+        if (!beats.isEmpty()) {
+            // A beat map would have gaps between the windows
+            pBeats = BeatFactory::makePreferredBeats(
+                    beats, extraVersionInfo, true, signalInfo.getSampleRate());
+        } else if (!bpmValues.isEmpty()) {
+            const auto median = bpmValues.begin() + bpmValues.size() / 2;
+            std::nth_element(bpmValues.begin(), median, bpmValues.end());
+            pBeats = mixxx::Beats::fromConstTempo(signalInfo.getSampleRate(),
+                    mixxx::audio::kStartFramePos,
+                    mixxx::Bpm(*median),
+                    BeatFactory::getPreferredSubVersion(extraVersionInfo));
+        }
+        if (pBeats && pTrack->trySetBeats(pBeats)) {
+            published = true;
+        }
+    }
+    if (pKeyPlugin && pKeyPlugin->finalize()) {
+        // Only the global key is meaningful, the positions of the
+        // key changes refer to the concatenated windows
+        const Keys keys = KeyFactory::makePreferredKeys(pKeyPlugin->getKeyChanges(),
+                previewExtraVersionInfo(AnalyzerKey::getExtraVersionInfo(
+                        keyPluginId, m_keySettings.getFastAnalysis())),
+                signalInfo.getSampleRate(),
+                kWindowCount * windowFrames);
+        if (keys.getGlobalKey() != mixxx::track::io::key::INVALID) {
+            pTrack->setKeys(keys);
+            published = true;
+        }
+    }
+
+    kLogger.debug()
+            << "Analyzed"
+            << kWindowCount
+            << "windows of"
+            << pTrack->getLocation()
+            << "in"
+            << timer.elapsed().debugMillisWithUnit();
+    return published;
+}
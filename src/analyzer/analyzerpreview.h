@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QString>
+
+#include "analyzer/analyzertrack.h"
+#include "preferences/beatdetectionsettings.h"
+#include "preferences/keydetectionsettings.h"
+#include "preferences/usersettings.h"
+#include "sources/audiosource.h"
+
+/// AnalyzerPreview publishes a provisional BPM and key of a track within
+/// a fraction of a second. Only a few evenly spaced windows of the track
+/// are decoded and passed through the configured beat and key plugins,
+/// so new tracks can be sorted and mixed while they are still waiting
+/// for the full analysis.
+///
+/// The provisional results are marked by their sub-version. AnalyzerBeats
+/// and AnalyzerKey always replace them with the results of analyzing the
+/// whole track.
+class AnalyzerPreview {
+  public:
+    explicit AnalyzerPreview(
+            UserSettingsPointer pConfig,
+            bool enforceBpmDetection = false);
+
+    /// Only results that are missing are published. Returns true if
+    /// the BPM or the key of the track has been set.
+    bool analyze(const AnalyzerTrack& track, mixxx::AudioSource* pAudioSource);
+
+    static bool isPreviewSubVersion(const QString& subVersion);
+
+  private:
+    const BeatDetectionSettings m_bpmSettings;
+    const KeyDetectionSettings m_keySettings;
+    const bool m_enforceBpmDetection;
+};
@@ -23,3 +23,11 @@ int analyzerProgressPercent(AnalyzerProgress analyzerProgress) {
             100 * (analyzerProgressClamped - kAnalyzerProgressNone) /
             (kAnalyzerProgressDone - kAnalyzerProgressNone)));
 }
+
+// Average throughput while analyzing multiple tracks
+struct AnalyzerThroughput {
+    double tracksPerMinute = 0;
+    double megabytesPerSecond = 0;
+};
+
+Q_DECLARE_METATYPE(AnalyzerThroughput);
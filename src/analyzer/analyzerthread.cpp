@@ -2,13 +2,17 @@
 
 #include <mutex>
 
+#include "analyzer/analyzeraudiodigest.h"
 #include "analyzer/analyzerbeats.h"
 #include "analyzer/analyzerebur128.h"
 #include "analyzer/analyzergain.h"
 #include "analyzer/analyzerkey.h"
+#include "analyzer/analyzerpreview.h"
 #include "analyzer/analyzersilence.h"
 #include "analyzer/analyzerwaveform.h"
 #include "analyzer/constants.h"
+#include "engine/cachingreader/cachingreaderchunkstore.h"
+#include "engine/cachingreader/cachingreadersharedaudiosource.h"
 #include "library/dao/analysisdao.h"
 #include "moc_analyzerthread.cpp"
 #include "sources/audiosourcestereoproxy.h"
@@ -93,7 +97,7 @@ void AnalyzerThread::doRun() {
     // before returning from this function.
     mixxx::DbConnectionPooler dbConnectionPooler;
 
-    if (m_modeFlags & AnalyzerModeFlags::WithWaveform) {
+    if (m_modeFlags & (AnalyzerModeFlags::WithWaveform | AnalyzerModeFlags::ReuseResults)) {
         dbConnectionPooler = mixxx::DbConnectionPooler(m_dbConnectionPool); // move assignment
         if (!dbConnectionPooler.isPooling()) {
             kLogger.warning()
@@ -101,7 +105,14 @@ void AnalyzerThread::doRun() {
             return;
         }
         QSqlDatabase dbConnection = mixxx::DbConnectionPooled(m_dbConnectionPool);
-        m_analyzers.push_back(AnalyzerWithState(std::make_unique<AnalyzerWaveform>(m_pConfig, dbConnection)));
+        if (m_modeFlags & AnalyzerModeFlags::WithWaveform) {
+            m_analyzers.push_back(AnalyzerWithState(
+                    std::make_unique<AnalyzerWaveform>(m_pConfig, dbConnection)));
+        }
+        if (m_modeFlags & AnalyzerModeFlags::ReuseResults) {
+            pAnalysisDao = std::make_unique<AnalysisDao>(m_pConfig);
+            pAnalysisDao->initialize(dbConnection);
+        }
     }
     if (AnalyzerGain::isEnabled(ReplayGainSettings(m_pConfig))) {
         m_analyzers.push_back(AnalyzerWithState(std::make_unique<AnalyzerGain>(m_pConfig)));
@@ -118,6 +129,16 @@ void AnalyzerThread::doRun() {
     DEBUG_ASSERT(!m_analyzers.empty());
     kLogger.debug() << "Activated" << m_analyzers.size() << "analyzers";
 
+    std::unique_ptr<AnalyzerPreview> pPreview;
+    if (m_modeFlags & AnalyzerModeFlags::Preview) {
+        pPreview = std::make_unique<AnalyzerPreview>(m_pConfig, enforceBpmDetection);
+    }
+
+    if ((m_modeFlags & AnalyzerModeFlags::Pipelined) && QThread::idealThreadCount() > 1) {
+        // Must not be created before all analyzers have been added
+        m_pPipeline = std::make_unique<AnalyzerPipeline>(&m_analyzers);
+    }
+
     m_lastBusyProgressEmittedTimer.start();
 
     mixxx::AudioSource::OpenParams openParams;
@@ -138,11 +159,62 @@ void AnalyzerThread::doRun() {
             continue;
         }
 
+        const bool previewOnly = m_currentTrack->getOptions().previewOnly;
+        const TrackId trackId = m_currentTrack->getTrack()->getId();
+        QString audioDigest;
+        if (pAnalysisDao && !previewOnly) {
+            audioDigest = AnalyzerAudioDigest::calculate(audioSource.get());
+        }
+        if (!audioDigest.isEmpty() && m_currentTrack->getOptions().reuseResults) {
+            const TrackId identicalTrackId =
+                    pAnalysisDao->findTrackByAudioDigest(audioDigest, trackId);
+            if (identicalTrackId.isValid()) {
+                kLogger.debug()
+                        << "Reusing the results of track"
+                        << identicalTrackId
+                        << "with identical audio";
+                // The waveforms are only stored in the database, all other
+                // results are copied by the TrackAnalysisScheduler
+                if (m_modeFlags & AnalyzerModeFlags::WithWaveform) {
+                    pAnalysisDao->copyAnalyses(identicalTrackId, trackId);
+                }
+                // This track can be found by its digest like the original
+                pAnalysisDao->saveAudioDigest(trackId, audioDigest);
+                emitDoneProgress(kAnalyzerProgressDone, identicalTrackId);
+                continue;
+            }
+        }
+
+        const QString chunkStoreKey = CachingReaderChunkStore::fileKey(
+                m_currentTrack->getTrack()->getLocation(),
+                openParams,
+                audioSource->getSignalInfo().getChannelCount());
+
         // If we have a non-even multi channel audio source (mono or )
         if (audioSource->getSignalInfo().getChannelCount() % mixxx::kAnalysisChannels) {
+            // The shared audio source reads whole chunks
             audioSource = std::make_shared<mixxx::AudioSourceStereoProxy>(
                     audioSource,
-                    mixxx::kAnalysisFramesPerChunk);
+                    CachingReaderChunk::kFrames);
+        }
+
+        // Share the decoded audio with a deck that has loaded the same
+        // track, which usually triggered this analysis
+        audioSource = std::make_shared<CachingReaderSharedAudioSource>(
+                audioSource, chunkStoreKey);
+
+        if (previewOnly) {
+            // The full analysis of the track is submitted after all
+            // scheduled tracks have been previewed
+            if (pPreview) {
+                pPreview->analyze(*m_currentTrack, audioSource.get());
+            }
+            // Unlike emitDoneProgress() the track is not reported as
+            // analyzed, the provisional results must not trigger any
+            // actions that depend on the final results
+            m_currentTrack.reset();
+            emitProgress(AnalyzerThreadState::Done, trackId, kAnalyzerProgressDone);
+            continue;
         }
 
         bool processTrack = false;
@@ -158,8 +230,15 @@ void AnalyzerThread::doRun() {
         }
 
         if (processTrack) {
+            if (m_pPipeline) {
+                m_pPipeline->start();
+            }
             const auto analysisResult = analyzeAudioSource(audioSource);
             DEBUG_ASSERT(analysisResult != AnalysisResult::Pending);
+            if (m_pPipeline) {
+                // Wait until all analyzers are done with the decoded audio
+                m_pPipeline->finish(analysisResult != AnalysisResult::Finished);
+            }
             if (analysisResult == AnalysisResult::Finished) {
                 // The analysis has been finished, and is either complete without
                 // any errors or partial if it has been aborted due to a corrupt
@@ -172,6 +251,9 @@ void AnalyzerThread::doRun() {
                 for (auto&& analyzer : m_analyzers) {
                     analyzer.finish(*m_currentTrack);
                 }
+                if (!audioDigest.isEmpty()) {
+                    pAnalysisDao->saveAudioDigest(trackId, audioDigest);
+                }
                 emitDoneProgress(kAnalyzerProgressDone);
             } else {
                 for (auto&& analyzer : m_analyzers) {
@@ -181,12 +263,18 @@ void AnalyzerThread::doRun() {
             }
         } else {
             kLogger.debug() << "Skipping track analysis because no analyzer initialized.";
+            // The results of tracks that have been analyzed before
+            // this digest existed can be reused from now on
+            if (!audioDigest.isEmpty()) {
+                pAnalysisDao->saveAudioDigest(trackId, audioDigest);
+            }
             emitDoneProgress(kAnalyzerProgressDone);
         }
     }
     DEBUG_ASSERT(!m_currentTrack);
     DEBUG_ASSERT(isStopping());
 
+    m_pPipeline.reset();
     m_analyzers.clear();
 
     kLogger.debug() << "Exiting worker thread";
@@ -249,12 +337,16 @@ AnalyzerThread::AnalysisResult AnalyzerThread::analyzeAudioSource(
                         math_min(mixxx::kAnalysisFramesPerChunk, remainingFrameRange.length()));
         DEBUG_ASSERT(!chunkFrameRange.empty());
 
-        // Request the next chunk of audio data
+        // Request the next chunk of audio data. In pipelined mode it is
+        // decoded into a chunk that is shared by all analyzers.
         const auto readableSampleFrames =
                 audioSource->readSampleFrames(
                         mixxx::WritableSampleFrames(
                                 chunkFrameRange,
-                                mixxx::SampleBuffer::WritableSlice(m_sampleBuffer)));
+                                m_pPipeline
+                                        ? m_pPipeline->acquireChunk()
+                                        : mixxx::SampleBuffer::WritableSlice(
+                                                  m_sampleBuffer)));
         // The returned range fits into the requested range
         DEBUG_ASSERT(readableSampleFrames.frameIndexRange().isSubrangeOf(chunkFrameRange));
 
@@ -299,10 +391,16 @@ AnalyzerThread::AnalysisResult AnalyzerThread::analyzeAudioSource(
 
         // 2nd: step: Analyze chunk of decoded audio data
         if (!readableSampleFrames.frameIndexRange().empty()) {
-            for (auto&& analyzer : m_analyzers) {
-                analyzer.processSamples(
+            if (m_pPipeline) {
+                m_pPipeline->publishChunk(
                         readableSampleFrames.readableData(),
                         readableSampleFrames.readableLength());
+            } else {
+                for (auto&& analyzer : m_analyzers) {
+                    analyzer.processSamples(
+                            readableSampleFrames.readableData(),
+                            readableSampleFrames.readableLength());
+                }
             }
         }
 
@@ -346,7 +444,8 @@ void AnalyzerThread::emitBusyProgress(AnalyzerProgress busyProgress) {
     DEBUG_ASSERT(m_emittedState == AnalyzerThreadState::Busy);
 }
 
-void AnalyzerThread::emitDoneProgress(AnalyzerProgress doneProgress) {
+void AnalyzerThread::emitDoneProgress(
+        AnalyzerProgress doneProgress, TrackId identicalTrackId) {
     DEBUG_ASSERT(m_currentTrack.has_value());
     // Release all references of the track before emitting the signal
     // to ensure that the last reference is not dropped in this worker
@@ -355,7 +454,7 @@ void AnalyzerThread::emitDoneProgress(AnalyzerProgress doneProgress) {
     TrackId trackId = m_currentTrack->getTrack()->getId();
     m_currentTrack->getTrack()->analysisFinished();
     m_currentTrack.reset();
-    emitProgress(AnalyzerThreadState::Done, trackId, doneProgress);
+    emitProgress(AnalyzerThreadState::Done, trackId, doneProgress, identicalTrackId);
 }
 
 void AnalyzerThread::emitProgress(AnalyzerThreadState state) {
@@ -363,10 +462,14 @@ void AnalyzerThread::emitProgress(AnalyzerThreadState state) {
     emitProgress(state, TrackId(), kAnalyzerProgressUnknown);
 }
 
-void AnalyzerThread::emitProgress(AnalyzerThreadState state, TrackId trackId, AnalyzerProgress trackProgress) {
+void AnalyzerThread::emitProgress(AnalyzerThreadState state,
+        TrackId trackId,
+        AnalyzerProgress trackProgress,
+        TrackId identicalTrackId) {
     DEBUG_ASSERT(!m_currentTrack.has_value() || (state == AnalyzerThreadState::Busy));
     DEBUG_ASSERT(!m_currentTrack.has_value() || (m_currentTrack->getTrack()->getId() == trackId));
     DEBUG_ASSERT(trackId.isValid() || (trackProgress == kAnalyzerProgressUnknown));
+    DEBUG_ASSERT(!identicalTrackId.isValid() || (state == AnalyzerThreadState::Done));
     m_emittedState = state;
-    emit progress(m_id, m_emittedState, trackId, trackProgress);
+    emit progress(m_id, m_emittedState, trackId, trackProgress, identicalTrackId);
 }
@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "analyzer/analyzer.h"
+#include "analyzer/analyzerpipeline.h"
 #include "analyzer/analyzerprogress.h"
 #include "analyzer/analyzertrack.h"
 #include "preferences/usersettings.h"
@@ -22,6 +23,17 @@ enum AnalyzerModeFlags {
     WithBeats = 0x01,
     WithWaveform = 0x02,
     LowPriority = 0x04,
+    // Run the analyzers of a track concurrently, see AnalyzerPipeline
+    Pipelined = 0x08,
+    // Read the files of upcoming tracks ahead, see AnalyzerFilePrefetcher
+    Prefetch = 0x10,
+    // Reuse the results of tracks with identical audio, see AnalyzerAudioDigest
+    ReuseResults = 0x20,
+    // Publish a provisional BPM and key of all scheduled tracks in a
+    // separate pass before the full analysis of any track, see
+    // AnalyzerPreview. Only for batch analysis, it would delay the
+    // waveform of a loaded track.
+    Preview = 0x40,
     All = WithBeats | WithWaveform,
 };
 
@@ -86,7 +98,13 @@ class AnalyzerThread : public WorkerThread {
     // queued connections which are processed in an undefined order!
     // TODO(uklotzde): Encapsulate all signal parameters into an
     // AnalyzerThreadProgress object and register it as a new meta type.
-    void progress(int threadId, AnalyzerThreadState threadState, TrackId trackId, AnalyzerProgress trackProgress);
+    // When done, identicalTrackId refers to another track with identical
+    // audio whose results should be reused instead of analyzing the track.
+    void progress(int threadId,
+            AnalyzerThreadState threadState,
+            TrackId trackId,
+            AnalyzerProgress trackProgress,
+            TrackId identicalTrackId);
 
   protected:
     void doRun() override;
@@ -118,6 +136,9 @@ class AnalyzerThread : public WorkerThread {
 
     std::vector<AnalyzerWithState> m_analyzers;
 
+    // Only in pipelined mode
+    std::unique_ptr<AnalyzerPipeline> m_pPipeline;
+
     mixxx::SampleBuffer m_sampleBuffer;
 
     std::optional<AnalyzerTrack> m_currentTrack;
@@ -141,11 +162,15 @@ class AnalyzerThread : public WorkerThread {
     void emitBusyProgress(AnalyzerProgress busyProgress);
 
     // Unconditionally emits a progress() signal when done
-    void emitDoneProgress(AnalyzerProgress doneProgress);
+    void emitDoneProgress(AnalyzerProgress doneProgress,
+            TrackId identicalTrackId = TrackId());
 
     // Unconditionally emits any kind of progress() signal if not current track is present
     void emitProgress(AnalyzerThreadState state);
 
     // Unconditionally emits any kind of progress() signal
-    void emitProgress(AnalyzerThreadState state, TrackId trackId, AnalyzerProgress trackProgress);
+    void emitProgress(AnalyzerThreadState state,
+            TrackId trackId,
+            AnalyzerProgress trackProgress,
+            TrackId identicalTrackId = TrackId());
 };
@@ -10,6 +10,12 @@ class AnalyzerTrack {
     struct Options {
         /// If set, overrides whether the analysis should assume constant BPM.
         std::optional<bool> useFixedTempo;
+        /// If set, the results of another track with identical audio
+        /// may be reused instead of analyzing the track.
+        bool reuseResults = true;
+        /// If set, only a provisional BPM and key are published, see
+        /// AnalyzerPreview. The full analysis is scheduled separately.
+        bool previewOnly = false;
     };
 
     explicit AnalyzerTrack(TrackPointer track, Options options = Options());
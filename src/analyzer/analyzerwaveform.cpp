@@ -8,6 +8,7 @@
 #include "engine/filters/enginefilterbessel4.h"
 #include "track/track.h"
 #include "util/logger.h"
+#include "util/math.h"
 #include "waveform/waveform.h"
 #include "waveform/waveformfactory.h"
 
@@ -279,7 +280,9 @@ bool AnalyzerWaveform::processSamples(const CSAMPLE* pIn, SINT count) {
             }
             m_stride.store(m_waveformData + m_currentStride);
             m_currentStride += ChannelCount;
-            m_waveform->setCompletion(m_currentStride);
+            if (m_currentStride > m_waveform->getCompletion()) {
+                m_waveform->setCompletion(m_currentStride);
+            }
         }
 
         if (fmod(m_stride.m_position, m_stride.m_averageLength) < 1) {
@@ -289,7 +292,9 @@ bool AnalyzerWaveform::processSamples(const CSAMPLE* pIn, SINT count) {
             }
             m_stride.averageStore(m_waveformSummaryData + m_currentSummaryStride);
             m_currentSummaryStride += ChannelCount;
-            m_waveformSummary->setCompletion(m_currentSummaryStride);
+            if (m_currentSummaryStride > m_waveformSummary->getCompletion()) {
+                m_waveformSummary->setCompletion(m_currentSummaryStride);
+            }
 
 #ifdef TEST_HEAT_MAP
             QPointF point(m_stride.m_filteredData[Right][High],
@@ -312,6 +317,47 @@ bool AnalyzerWaveform::processSamples(const CSAMPLE* pIn, SINT count) {
     return true;
 }
 
+void AnalyzerWaveform::seekFrame(SINT frameIndex) {
+    VERIFY_OR_DEBUG_ASSERT(m_waveform && m_waveformSummary) {
+        return;
+    }
+    VERIFY_OR_DEBUG_ASSERT(frameIndex >= 0) {
+        return;
+    }
+    if (frameIndex == m_stride.m_position) {
+        // Contiguous
+        return;
+    }
+
+    // A stride is stored each time the position passes a multiple of
+    // its length, see processSamples()
+    m_stride.reset();
+    m_stride.m_position = static_cast<int>(frameIndex);
+    m_currentStride = math_min(
+            ChannelCount * static_cast<int>(frameIndex / m_stride.m_length),
+            m_waveform->getDataSize());
+    m_currentSummaryStride = math_min(
+            ChannelCount * static_cast<int>(frameIndex / m_stride.m_averageLength),
+            m_waveformSummary->getDataSize());
+
+    // The filter state belongs to the audio before the gap
+    m_filters.low->assumeSettled();
+    m_filters.mid->assumeSettled();
+    m_filters.high->assumeSettled();
+}
+
+void AnalyzerWaveform::storePartialResults(TrackPointer pTrack,
+        const QVector<QPair<double, double>>& cachedRanges) {
+    VERIFY_OR_DEBUG_ASSERT(m_waveform && m_waveformSummary) {
+        return;
+    }
+    m_waveform->setCachedRanges(cachedRanges);
+    m_waveformSummary->setCachedRanges(cachedRanges);
+    // Notifies the widgets about the new data
+    pTrack->setWaveform(m_waveform);
+    pTrack->setWaveformSummary(m_waveformSummary);
+}
+
 void AnalyzerWaveform::cleanup() {
     m_waveform.clear();
     m_waveformData = nullptr;
@@ -322,6 +368,7 @@ void AnalyzerWaveform::cleanup() {
 void AnalyzerWaveform::storeResults(TrackPointer pTrack) {
     // Force completion to waveform size
     if (m_waveform) {
+        m_waveform->setCachedRanges({});
         m_waveform->setSaveState(Waveform::SaveState::SavePending);
         m_waveform->setCompletion(m_waveform->getDataSize());
         m_waveform->setVersion(WaveformFactory::currentWaveformVersion());
@@ -330,6 +377,7 @@ void AnalyzerWaveform::storeResults(TrackPointer pTrack) {
 
     // Force completion to waveform size
     if (m_waveformSummary) {
+        m_waveformSummary->setCachedRanges({});
         m_waveformSummary->setSaveState(Waveform::SaveState::SavePending);
         m_waveformSummary->setCompletion(m_waveformSummary->getDataSize());
         m_waveformSummary->setVersion(WaveformFactory::currentWaveformSummaryVersion());
@@ -149,6 +149,18 @@ class AnalyzerWaveform : public Analyzer {
     void storeResults(TrackPointer tio) override;
     void cleanup() override;
 
+    /// Continues the analysis at frameIndex, counted from the first frame
+    /// of the track, instead of after the last processed frame. Used for
+    /// streamed tracks that are only partially downloaded: The samples
+    /// passed to processSamples() afterwards are stored at the corresponding
+    /// position and the completion never moves backwards.
+    void seekFrame(SINT frameIndex);
+
+    /// Sets the incomplete waveforms on the track, restricted to the given
+    /// parts of the track. See Waveform::getCachedRanges().
+    void storePartialResults(TrackPointer pTrack,
+            const QVector<QPair<double, double>>& cachedRanges);
+
   private:
     bool shouldAnalyze(TrackPointer tio) const;
 
@@ -1,8 +1,12 @@
 #include "analyzer/trackanalysisscheduler.h"
 
+#include <algorithm>
+
+#include "analyzer/analyzerpreview.h"
 #include "analyzer/analyzerscheduledtrack.h"
 #include "analyzer/analyzertrack.h"
 #include "moc_trackanalysisscheduler.cpp"
+#include "track/track.h"
 #include "track/trackid.h"
 #include "util/logger.h"
 
@@ -15,6 +19,8 @@ constexpr QThread::Priority kWorkerThreadPriority = QThread::LowPriority;
 // Maximum frequency of progress updates
 constexpr std::chrono::milliseconds kProgressInhibitDuration(100);
 
+constexpr double kBytesPerMegabyte = 1000.0 * 1000.0;
+
 void deleteTrackAnalysisScheduler(TrackAnalysisScheduler* plainPtr) {
     if (plainPtr) {
         // Trigger stop
@@ -53,9 +59,11 @@ TrackAnalysisScheduler::TrackAnalysisScheduler(
         const UserSettingsPointer& pConfig,
         AnalyzerModeFlags modeFlags)
         : m_pEnvironment(std::move(pEnvironment)),
+          m_previewEnabled(modeFlags & AnalyzerModeFlags::Preview),
           m_currentTrackProgress(kAnalyzerProgressUnknown),
           m_currentTrackNumber(0),
           m_dequeuedTracksCount(0),
+          m_finishedTracksBytes(0),
           // The first signal should always be emitted
           m_lastProgressEmittedAt(Clock::now() - kProgressInhibitDuration) {
     DEBUG_ASSERT(m_pEnvironment);
@@ -88,6 +96,15 @@ TrackAnalysisScheduler::TrackAnalysisScheduler(
         worker.thread()->suspend();
         worker.thread()->start(kWorkerThreadPriority);
     }
+    if (modeFlags & AnalyzerModeFlags::Prefetch) {
+        // Decoding from the page cache leaves the workers busy with
+        // analyzing while the next files are read sequentially
+        m_pPrefetcher = std::make_unique<AnalyzerFilePrefetcher>();
+        connect(m_pPrefetcher.get(),
+                &AnalyzerFilePrefetcher::prefetched,
+                this,
+                &TrackAnalysisScheduler::onFilePrefetched);
+    }
 }
 
 TrackAnalysisScheduler::~TrackAnalysisScheduler() {
@@ -101,6 +118,7 @@ void TrackAnalysisScheduler::emitProgressOrFinished() {
         m_currentTrackProgress = kAnalyzerProgressUnknown;
         m_currentTrackNumber = 0;
         m_dequeuedTracksCount = 0;
+        m_finishedTracksBytes = 0;
         emit finished();
         return;
     }
@@ -112,10 +130,10 @@ void TrackAnalysisScheduler::emitProgressOrFinished() {
     }
     m_lastProgressEmittedAt = now;
 
-    DEBUG_ASSERT(m_pendingTrackIds.size() <=
+    DEBUG_ASSERT(m_pendingTracks.size() <=
             static_cast<size_t>(m_dequeuedTracksCount));
     const int finishedTracksCount =
-            m_dequeuedTracksCount - static_cast<int>(m_pendingTrackIds.size());
+            m_dequeuedTracksCount - static_cast<int>(m_pendingTracks.size());
 
     AnalyzerProgress workerProgressSum = 0;
     int workerProgressCount = 0;
@@ -173,6 +191,16 @@ void TrackAnalysisScheduler::emitProgressOrFinished() {
             m_dequeuedTracksCount + static_cast<int>(m_queuedTracks.size());
     DEBUG_ASSERT(m_currentTrackNumber <= m_dequeuedTracksCount);
     DEBUG_ASSERT(m_dequeuedTracksCount <= totalTracksCount);
+    const double elapsedSeconds = m_throughputTimer.running()
+            ? m_throughputTimer.elapsed().toDoubleSeconds()
+            : 0;
+    if (m_dequeuedTracksCount > 0 && elapsedSeconds > 0) {
+        AnalyzerThroughput analyzerThroughput;
+        analyzerThroughput.tracksPerMinute = finishedTracksCount * 60 / elapsedSeconds;
+        analyzerThroughput.megabytesPerSecond =
+                m_finishedTracksBytes / kBytesPerMegabyte / elapsedSeconds;
+        emit throughput(analyzerThroughput);
+    }
     emit progress(
             m_currentTrackProgress,
             m_currentTrackNumber,
@@ -183,13 +211,15 @@ void TrackAnalysisScheduler::onWorkerThreadProgress(
         int threadId,
         AnalyzerThreadState threadState,
         TrackId trackId,
-        AnalyzerProgress analyzerProgress) {
+        AnalyzerProgress analyzerProgress,
+        TrackId identicalTrackId) {
     if (kLogger.traceEnabled()) {
         kLogger.trace() << "onWorkerThreadProgress"
                 << threadId
                 << int(threadState)
                 << trackId
-                << analyzerProgress;
+                << analyzerProgress
+                << identicalTrackId;
     }
     auto& worker = m_workers.at(threadId);
     switch (threadState) {
@@ -206,24 +236,53 @@ void TrackAnalysisScheduler::onWorkerThreadProgress(
     case AnalyzerThreadState::Busy:
         DEBUG_ASSERT(trackId.isValid());
         // Ignore delayed signals for tracks that are no longer pending
-        if (m_pendingTrackIds.find(trackId) != m_pendingTrackIds.end()) {
+        if (m_pendingTracks.find(trackId) != m_pendingTracks.end()) {
             DEBUG_ASSERT(analyzerProgress != kAnalyzerProgressUnknown);
             DEBUG_ASSERT(analyzerProgress < kAnalyzerProgressDone);
             worker.onAnalyzerProgress(analyzerProgress);
             emit trackProgress(trackId, analyzerProgress);
         }
         break;
-    case AnalyzerThreadState::Done:
+    case AnalyzerThreadState::Done: {
         DEBUG_ASSERT(trackId.isValid());
+        if (m_pendingPreviewTrackIds.erase(trackId) > 0) {
+            worker.onAnalyzerProgress(kAnalyzerProgressUnknown);
+            if (!isPreviewPassPending()) {
+                // Start the full analysis on all workers that have
+                // been waiting for the preview pass to finish
+                for (auto& idleWorker : m_workers) {
+                    if (idleWorker &&
+                            idleWorker.analyzerProgress() == kAnalyzerProgressUnknown) {
+                        submitNextTrack(&idleWorker);
+                    }
+                }
+            }
+            break;
+        }
         // Ignore delayed signals for tracks that are no longer pending
-        if (m_pendingTrackIds.find(trackId) != m_pendingTrackIds.end()) {
+        const auto pendingTrack = m_pendingTracks.find(trackId);
+        if (pendingTrack != m_pendingTracks.end()) {
             DEBUG_ASSERT((analyzerProgress == kAnalyzerProgressDone) // success
                     || (analyzerProgress == kAnalyzerProgressUnknown)); // failure
-            m_pendingTrackIds.erase(trackId);
+            if (identicalTrackId.isValid() &&
+                    !reuseResultsOfIdenticalTrack(trackId, identicalTrackId)) {
+                // Analyze the track for the missing results without
+                // looking for identical tracks again
+                AnalyzerTrack::Options options = pendingTrack->second.options;
+                options.reuseResults = false;
+                m_pendingTracks.erase(pendingTrack);
+                m_queuedTracks.push_front(AnalyzerScheduledTrack(trackId, options));
+                --m_dequeuedTracksCount;
+                worker.onAnalyzerProgress(kAnalyzerProgressUnknown);
+                break;
+            }
+            m_finishedTracksBytes += pendingTrack->second.fileSizeInBytes;
+            m_pendingTracks.erase(pendingTrack);
             worker.onAnalyzerProgress(analyzerProgress);
             emit trackProgress(trackId, analyzerProgress);
         }
         break;
+    }
     case AnalyzerThreadState::Exit:
         DEBUG_ASSERT(!trackId.isValid());
         DEBUG_ASSERT(analyzerProgress == kAnalyzerProgressUnknown);
@@ -243,6 +302,9 @@ bool TrackAnalysisScheduler::scheduleTrack(AnalyzerScheduledTrack track) {
                 << track.getTrackId();
         return false;
     }
+    if (m_previewEnabled) {
+        m_queuedPreviewTrackIds.push_back(track.getTrackId());
+    }
     m_queuedTracks.push_back(track);
     // Don't wake up the suspended thread now to avoid race conditions
     // if multiple threads are added in a row by calling this function
@@ -266,35 +328,154 @@ void TrackAnalysisScheduler::suspend() {
     for (auto& worker: m_workers) {
         worker.suspendThread();
     }
+    if (m_pPrefetcher) {
+        // Stop reading ahead, the files that have not been read
+        // completely are prefetched again after resuming
+        m_pPrefetcher->clear();
+        for (auto i = m_prefetchingTracks.begin(); i != m_prefetchingTracks.end();) {
+            if (m_prefetchedTrackIds.find(i->first) == m_prefetchedTrackIds.end()) {
+                i = m_prefetchingTracks.erase(i);
+            } else {
+                ++i;
+            }
+        }
+    }
 }
 
 void TrackAnalysisScheduler::resume() {
     kLogger.debug() << "Resuming";
+    prefetchQueuedTracks();
     for (auto& worker: m_workers) {
         worker.resumeThread();
     }
 }
 
+std::deque<AnalyzerScheduledTrack>::iterator TrackAnalysisScheduler::prefetchWindowEnd() {
+    // Enough files for all workers and I/O threads to keep busy
+    const auto windowSize = m_workers.size() + AnalyzerFilePrefetcher::kMaxThreadCount;
+    return m_queuedTracks.begin() +
+            static_cast<std::ptrdiff_t>(math_min(m_queuedTracks.size(), windowSize));
+}
+
+void TrackAnalysisScheduler::prefetchQueuedTracks() {
+    if (!m_pPrefetcher) {
+        return;
+    }
+    const auto windowEnd = prefetchWindowEnd();
+    for (auto i = m_queuedTracks.begin(); i != windowEnd; ++i) {
+        const TrackId trackId = i->getTrackId();
+        if (m_prefetchingTracks.find(trackId) != m_prefetchingTracks.end()) {
+            continue;
+        }
+        // Tracks that fail to load are skipped when submitting them
+        TrackPointer pTrack = m_pEnvironment->loadTrackById(trackId);
+        if (pTrack) {
+            m_pPrefetcher->prefetch(trackId, pTrack->getLocation());
+            m_prefetchingTracks.emplace(trackId, std::move(pTrack));
+        }
+    }
+}
+
+void TrackAnalysisScheduler::moveFirstPrefetchedTrackToFront() {
+    const auto windowEnd = prefetchWindowEnd();
+    const auto prefetchedTrack = std::find_if(m_queuedTracks.begin(),
+            windowEnd,
+            [this](const AnalyzerScheduledTrack& track) {
+                return m_prefetchedTrackIds.find(track.getTrackId()) !=
+                        m_prefetchedTrackIds.end();
+            });
+    if (prefetchedTrack != windowEnd) {
+        std::rotate(m_queuedTracks.begin(), prefetchedTrack, prefetchedTrack + 1);
+    }
+}
+
+void TrackAnalysisScheduler::onFilePrefetched(TrackId trackId) {
+    // Ignore files of tracks that are no longer queued
+    if (m_prefetchingTracks.find(trackId) != m_prefetchingTracks.end()) {
+        m_prefetchedTrackIds.insert(trackId);
+    }
+}
+
+void TrackAnalysisScheduler::dequeueNextTrack() {
+    DEBUG_ASSERT(!m_queuedTracks.empty());
+    if (m_dequeuedTracksCount == 0) {
+        m_throughputTimer.start();
+    }
+    const TrackId trackId = m_queuedTracks.front().getTrackId();
+    m_prefetchingTracks.erase(trackId);
+    m_prefetchedTrackIds.erase(trackId);
+    m_queuedTracks.pop_front();
+    ++m_dequeuedTracksCount;
+    prefetchQueuedTracks();
+}
+
+bool TrackAnalysisScheduler::submitNextPreview(Worker* worker) {
+    DEBUG_ASSERT(worker);
+    while (!m_queuedPreviewTrackIds.empty()) {
+        const TrackId nextTrackId = m_queuedPreviewTrackIds.front();
+        // Skip duplicates and tracks that are already analyzed by a worker
+        if (m_pendingPreviewTrackIds.find(nextTrackId) == m_pendingPreviewTrackIds.end() &&
+                m_pendingTracks.find(nextTrackId) == m_pendingTracks.end()) {
+            const auto prefetchingTrack = m_prefetchingTracks.find(nextTrackId);
+            TrackPointer nextTrackPtr = prefetchingTrack != m_prefetchingTracks.end()
+                    ? prefetchingTrack->second
+                    : m_pEnvironment->loadTrackById(nextTrackId);
+            if (nextTrackPtr) {
+                AnalyzerTrack::Options options;
+                options.previewOnly = true;
+                if (!worker->submitNextTrack(AnalyzerTrack(nextTrackPtr, options))) {
+                    kLogger.debug()
+                            << "Failed to submit next preview - worker thread"
+                            << worker->thread()->id()
+                            << "is busy";
+                    return false;
+                }
+                m_pendingPreviewTrackIds.insert(nextTrackId);
+                m_queuedPreviewTrackIds.pop_front();
+                return true;
+            }
+            // The full analysis reports the failure
+        }
+        m_queuedPreviewTrackIds.pop_front();
+    }
+    return false;
+}
+
 bool TrackAnalysisScheduler::submitNextTrack(Worker* worker) {
     DEBUG_ASSERT(worker);
+    if (submitNextPreview(worker)) {
+        return true;
+    }
+    if (isPreviewPassPending()) {
+        // The worker is started again when the last preview is done
+        return false;
+    }
     while (!m_queuedTracks.empty()) {
+        if (m_pPrefetcher) {
+            moveFirstPrefetchedTrackToFront();
+        }
         AnalyzerScheduledTrack nextScheduledTrack = m_queuedTracks.front();
         TrackId nextTrackId = nextScheduledTrack.getTrackId();
         DEBUG_ASSERT(nextTrackId.isValid());
         if (nextTrackId.isValid()) {
-            TrackPointer nextTrackPtr =
-                    m_pEnvironment->loadTrackById(nextTrackId);
+            const auto prefetchingTrack = m_prefetchingTracks.find(nextTrackId);
+            TrackPointer nextTrackPtr = prefetchingTrack != m_prefetchingTracks.end()
+                    ? prefetchingTrack->second
+                    : m_pEnvironment->loadTrackById(nextTrackId);
             if (nextTrackPtr) {
                 AnalyzerTrack nextTrack(nextTrackPtr, nextScheduledTrack.getOptions());
-                if (m_pendingTrackIds.insert(nextTrackId).second) {
+                if (m_pendingTracks
+                                .emplace(nextTrackId,
+                                        PendingTrack{nextScheduledTrack.getOptions(),
+                                                nextTrackPtr->getFileInfo().sizeInBytes()})
+                                .second) {
                     if (worker->submitNextTrack(std::move(nextTrack))) {
-                        m_queuedTracks.pop_front();
-                        ++m_dequeuedTracksCount;
+                        dequeueNextTrack();
                         return true;
                     } else {
                         // The worker may already have been assigned new tasks
                         // in the mean time, nothing to worry about.
-                        m_pendingTrackIds.erase(nextTrackId);
+                        m_pendingTracks.erase(nextTrackId);
                         kLogger.debug()
                                 << "Failed to submit next track - worker thread"
                                 << worker->thread()->id()
@@ -319,12 +500,60 @@ bool TrackAnalysisScheduler::submitNextTrack(Worker* worker) {
                     << nextTrackId;
         }
         // Skip this track
-        m_queuedTracks.pop_front();
-        ++m_dequeuedTracksCount;
+        dequeueNextTrack();
     }
     return false;
 }
 
+bool TrackAnalysisScheduler::reuseResultsOfIdenticalTrack(
+        TrackId trackId, TrackId identicalTrackId) const {
+    const TrackPointer pTrack = m_pEnvironment->loadTrackById(trackId);
+    const TrackPointer pIdenticalTrack = m_pEnvironment->loadTrackById(identicalTrackId);
+    if (!pTrack || !pIdenticalTrack) {
+        kLogger.warning()
+                << "Failed to load track"
+                << trackId
+                << "or the identical track"
+                << identicalTrackId;
+        return false;
+    }
+    kLogger.debug()
+            << "Reusing the results of track"
+            << identicalTrackId
+            << "for track"
+            << trackId;
+    // Results that already exist, e.g. imported or edited beats,
+    // are not replaced. Provisional results of an interrupted
+    // analysis are replaced, see AnalyzerPreview.
+    const mixxx::BeatsPointer pExistingBeats = pTrack->getBeats();
+    if (!pExistingBeats ||
+            AnalyzerPreview::isPreviewSubVersion(pExistingBeats->getSubVersion())) {
+        const mixxx::BeatsPointer pBeats = pIdenticalTrack->getBeats();
+        if (pBeats) {
+            pTrack->trySetBeats(pBeats);
+        }
+    }
+    const Keys existingKeys = pTrack->getKeys();
+    if (existingKeys.getGlobalKey() == mixxx::track::io::key::INVALID ||
+            AnalyzerPreview::isPreviewSubVersion(existingKeys.getSubVersion())) {
+        const Keys keys = pIdenticalTrack->getKeys();
+        if (keys.getGlobalKey() != mixxx::track::io::key::INVALID) {
+            pTrack->setKeys(keys);
+        }
+    }
+    if (!pTrack->getReplayGain().hasRatio()) {
+        const mixxx::ReplayGain replayGain = pIdenticalTrack->getReplayGain();
+        if (replayGain.hasRatio()) {
+            pTrack->setReplayGain(replayGain);
+        }
+    }
+    const mixxx::BeatsPointer pBeats = pTrack->getBeats();
+    const Keys keys = pTrack->getKeys();
+    return pBeats && !AnalyzerPreview::isPreviewSubVersion(pBeats->getSubVersion()) &&
+            keys.getGlobalKey() != mixxx::track::io::key::INVALID &&
+            !AnalyzerPreview::isPreviewSubVersion(keys.getSubVersion());
+}
+
 void TrackAnalysisScheduler::stop() {
     kLogger.debug() << "Stopping";
     for (auto& worker: m_workers) {
@@ -333,6 +562,13 @@ void TrackAnalysisScheduler::stop() {
     // The worker threads are still running at this point
     // and m_workers must not be modified!
     m_queuedTracks.clear();
-    m_pendingTrackIds.clear();
+    m_pendingTracks.clear();
+    m_queuedPreviewTrackIds.clear();
+    m_pendingPreviewTrackIds.clear();
+    if (m_pPrefetcher) {
+        m_pPrefetcher->clear();
+    }
+    m_prefetchingTracks.clear();
+    m_prefetchedTrackIds.clear();
     DEBUG_ASSERT((allTracksFinished()));
 }
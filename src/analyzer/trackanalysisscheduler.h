@@ -2,13 +2,16 @@
 
 #include <QList>
 #include <deque>
+#include <map>
 #include <memory>
 #include <set>
 #include <vector>
 
+#include "analyzer/analyzerfileprefetcher.h"
 #include "analyzer/analyzerscheduledtrack.h"
 #include "analyzer/analyzerthread.h"
 #include "util/db/dbconnectionpool.h"
+#include "util/performancetimer.h"
 
 /// Callbacks for triggering side-effects in the outer context of
 /// TrackAnalysisScheduler.
@@ -68,10 +71,17 @@ class TrackAnalysisScheduler : public QObject {
     void trackProgress(TrackId trackId, AnalyzerProgress analyzerProgress);
     // Current average progress for all scheduled tracks and from all workers
     void progress(AnalyzerProgress currentTrackProgress, int currentTrackNumber, int totalTracksCount);
+    // Emitted right before progress()
+    void throughput(AnalyzerThroughput throughput);
     void finished();
 
   private slots:
-    void onWorkerThreadProgress(int threadId, AnalyzerThreadState threadState, TrackId trackId, AnalyzerProgress analyzerProgress);
+    void onWorkerThreadProgress(int threadId,
+            AnalyzerThreadState threadState,
+            TrackId trackId,
+            AnalyzerProgress analyzerProgress,
+            TrackId identicalTrackId);
+    void onFilePrefetched(TrackId trackId);
 
   private:
     // Owns an analyzer thread and buffers the most recent progress update
@@ -140,11 +150,29 @@ class TrackAnalysisScheduler : public QObject {
     };
 
     bool submitNextTrack(Worker* worker);
+    bool submitNextPreview(Worker* worker);
+    bool isPreviewPassPending() const {
+        return !m_queuedPreviewTrackIds.empty() ||
+                !m_pendingPreviewTrackIds.empty();
+    }
+    // Copies the results that are missing for a track from another track
+    // with identical audio. Returns false if the track still needs to be
+    // analyzed.
+    bool reuseResultsOfIdenticalTrack(TrackId trackId, TrackId identicalTrackId) const;
+    void dequeueNextTrack();
     void emitProgressOrFinished();
 
+    // The queued tracks that are prefetched ahead of the workers
+    std::deque<AnalyzerScheduledTrack>::iterator prefetchWindowEnd();
+    void prefetchQueuedTracks();
+    // Lets the workers take tracks that have already been read before
+    // the ones that are still waiting for I/O
+    void moveFirstPrefetchedTrackToFront();
+
     bool allTracksFinished() const {
         return m_queuedTracks.empty() &&
-                m_pendingTrackIds.empty();
+                m_pendingTracks.empty() &&
+                !isPreviewPassPending();
     }
 
     const std::unique_ptr<const TrackAnalysisSchedulerEnvironment> m_pEnvironment;
@@ -153,9 +181,26 @@ class TrackAnalysisScheduler : public QObject {
 
     std::deque<AnalyzerScheduledTrack> m_queuedTracks;
 
+    struct PendingTrack {
+        AnalyzerTrack::Options options;
+        qint64 fileSizeInBytes;
+    };
     // Tracks that have already been submitted to workers
-    // and not yet reported back as finished.
-    std::set<TrackId> m_pendingTrackIds;
+    // and not yet reported back as finished
+    std::map<TrackId, PendingTrack> m_pendingTracks;
+
+    // Only with AnalyzerModeFlags::Preview. All queued tracks are
+    // previewed before the full analysis of any track starts.
+    const bool m_previewEnabled;
+    std::deque<TrackId> m_queuedPreviewTrackIds;
+    std::set<TrackId> m_pendingPreviewTrackIds;
+
+    // Only with AnalyzerModeFlags::Prefetch
+    std::unique_ptr<AnalyzerFilePrefetcher> m_pPrefetcher;
+    // Queued tracks whose file has been submitted for prefetching
+    std::map<TrackId, TrackPointer> m_prefetchingTracks;
+    // Queued tracks whose file has been read completely
+    std::set<TrackId> m_prefetchedTrackIds;
 
     AnalyzerProgress m_currentTrackProgress;
 
@@ -163,6 +208,10 @@ class TrackAnalysisScheduler : public QObject {
 
     int m_dequeuedTracksCount;
 
+    // For measuring the throughput since the first track has been dequeued
+    PerformanceTimer m_throughputTimer;
+    qint64 m_finishedTracksBytes;
+
     typedef std::chrono::steady_clock Clock;
     Clock::time_point m_lastProgressEmittedAt;
 };
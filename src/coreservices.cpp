@@ -37,6 +37,7 @@
 #include "preferences/dialog/dlgprefmodplug.h"
 #endif
 #include "skin/skincontrols.h"
+#include "streaming/streamingmanager.h"
 #ifdef MIXXX_USE_QML
 #include <QQuickWindow>
 #include <QSGRendererInterface>
@@ -614,6 +615,11 @@ void CoreServices::initialize(QApplication* pApp) {
     // the uninitialized singleton instance!
     m_pPlayerManager->bindToLibrary(m_pLibrary.get());
 
+    m_pStreamingManager = std::make_shared<StreamingManager>(
+            pConfig,
+            m_pPlayerManager.get(),
+            m_pLibrary.get());
+
     bool musicDirAdded = false;
 
     if (m_pTrackCollectionManager->internalCollection()->loadRootDirs().isEmpty()) {
@@ -945,6 +951,10 @@ void CoreServices::finalize() {
 
     Clipboard::destroy();
 
+    // StreamingManager depends on PlayerManager and Library
+    qDebug() << t.elapsed(false).debugMillisWithUnit() << "deleting StreamingManager";
+    CLEAR_AND_CHECK_DELETED(m_pStreamingManager);
+
     // PlayerManager depends on Engine, SoundManager, VinylControlManager, and Config
     // The player manager has to be deleted before the library to ensure
     // that all modified track metadata of loaded tracks is saved.
@@ -21,6 +21,7 @@ class VinylControlManager;
 class TrackCollectionManager;
 class Library;
 class SkinControls;
+class StreamingManager;
 class ControlPushButton;
 struct LibraryScanResultSummary;
 
@@ -52,6 +53,10 @@ class CoreServices : public QObject {
         return m_pControlIndicatorTimer;
     }
 
+    std::shared_ptr<EngineMixer> getEngineMixer() const {
+        return m_pEngine;
+    }
+
     std::shared_ptr<SoundManager> getSoundManager() const {
         return m_pSoundManager;
     }
@@ -141,6 +146,7 @@ class CoreServices : public QObject {
     std::shared_ptr<DbConnectionPool> m_pDbConnectionPool;
     std::shared_ptr<TrackCollectionManager> m_pTrackCollectionManager;
     std::shared_ptr<Library> m_pLibrary;
+    std::shared_ptr<StreamingManager> m_pStreamingManager;
 
     std::shared_ptr<KeyboardEventFilter> m_pKeyboardEventFilter;
     std::shared_ptr<ConfigObject<ConfigValueKbd>> m_pKbdConfig;
@@ -2,17 +2,21 @@
 
 #include <QDateTime>
 #include <QDir>
+#include <QFontDatabase>
 #include <QKeyEvent>
 
 #include "control/control.h"
+#include "engine/engineprofiler.h"
 #include "moc_dlgdevelopertools.cpp"
 #include "util/logging.h"
 #include "util/statsmanager.h"
 
 DlgDeveloperTools::DlgDeveloperTools(QWidget* pParent,
-                                     UserSettingsPointer pConfig)
+        UserSettingsPointer pConfig,
+        EngineProfiler* pEngineProfiler)
         : QDialog(pParent),
-          m_pConfig(pConfig) {
+          m_pConfig(pConfig),
+          m_pEngineProfiler(pEngineProfiler) {
     setupUi(this);
 
     controlsTable->setModel(&m_controlProxyModel);
@@ -62,6 +66,17 @@ DlgDeveloperTools::DlgDeveloperTools(QWidget* pParent,
 
     m_logCursor = logTextView->textCursor();
 
+    // Set up the audio callback profiler
+    profilerTextView->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    connect(profilerReset,
+            &QPushButton::clicked,
+            this,
+            &DlgDeveloperTools::slotProfilerReset);
+    connect(profilerDump,
+            &QPushButton::clicked,
+            this,
+            &DlgDeveloperTools::slotProfilerDump);
+
     // Update at 2FPS.
     startTimer(500);
 
@@ -104,6 +119,8 @@ void DlgDeveloperTools::timerEvent(QTimerEvent* pEvent) {
         if (pManager) {
             pManager->updateStats();
         }
+    } else if (toolTabWidget->currentWidget() == profilerTab) {
+        profilerTextView->setPlainText(m_pEngineProfiler->report());
     }
 }
 
@@ -144,6 +161,20 @@ void DlgDeveloperTools::slotControlDump() {
     }
 }
 
+void DlgDeveloperTools::slotProfilerReset() {
+    m_pEngineProfiler->reset();
+}
+
+void DlgDeveloperTools::slotProfilerDump() {
+    QString timestamp = QDateTime::currentDateTime()
+            .toString("yyyy-MM-dd_hh'h'mm'm'ss's'");
+    QString dumpFileName = m_pConfig->getSettingsPath() +
+            "/callback_profile_" + timestamp + ".txt";
+    if (!m_pEngineProfiler->dumpToFile(dumpFileName)) {
+        qWarning() << "open" << dumpFileName << "failed";
+    }
+}
+
 void DlgDeveloperTools::slotLogSearch() {
     QString textToFind = logSearch->text();
     m_logCursor = logTextView->document()->find(textToFind, m_logCursor);
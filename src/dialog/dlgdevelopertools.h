@@ -9,10 +9,14 @@
 #include "preferences/usersettings.h"
 #include "util/statmodel.h"
 
+class EngineProfiler;
+
 class DlgDeveloperTools : public QDialog, public Ui::DlgDeveloperTools {
     Q_OBJECT
   public:
-    DlgDeveloperTools(QWidget* pParent, UserSettingsPointer pConfig);
+    DlgDeveloperTools(QWidget* pParent,
+            UserSettingsPointer pConfig,
+            EngineProfiler* pEngineProfiler);
 
     bool eventFilter(QObject* pObj, QEvent* pEvent) override;
 
@@ -23,9 +27,13 @@ class DlgDeveloperTools : public QDialog, public Ui::DlgDeveloperTools {
     void slotControlSearch(const QString& search);
     void slotLogSearch();
     void slotControlDump();
+    void slotProfilerReset();
+    void slotProfilerDump();
 
   private:
     UserSettingsPointer m_pConfig;
+    // Owned by the EngineMixer
+    EngineProfiler* const m_pEngineProfiler;
     ControlSortFilterModel m_controlProxyModel;
 
     StatModel m_statModel;
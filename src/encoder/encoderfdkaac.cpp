@@ -365,9 +365,9 @@ void EncoderFdkAac::encodeBuffer(const CSAMPLE* samples, const std::size_t buffe
     }
     if (writeCount > 0) {
         SAMPLE* dataPtr1;
-        ring_buffer_size_t size1;
+        int size1;
         SAMPLE* dataPtr2;
-        ring_buffer_size_t size2;
+        int size2;
         // We use size1 and size2, so we can ignore the return value
         (void)m_pInputFifo->aquireWriteRegions(writeCount, &dataPtr1, &size1, &dataPtr2, &size2);
         // fdk-aac doesn't support float samples, so convert
@@ -3,6 +3,7 @@
 #include <QFile>
 #include <QtDebug>
 
+#include "engine/bufferscalers/rubberbandworkerpool.h"
 #include "engine/readaheadmanager.h"
 #include "moc_enginebufferscalerubberband.cpp"
 #include "util/counter.h"
@@ -17,6 +18,32 @@ using RubberBand::RubberBandStretcher;
 #define RUBBERBANDV3 (RUBBERBAND_API_MAJOR_VERSION >= 3 || \
         (RUBBERBAND_API_MAJOR_VERSION == 2 && RUBBERBAND_API_MINOR_VERSION >= 7))
 
+namespace {
+
+// The number of output buffers that are stretched in advance
+constexpr SINT kLookAheadBuffers = 2;
+
+// The block size used while Rubber Band does not request more input
+constexpr SINT kLookAheadBlockFrames = 256;
+
+} // anonymous namespace
+
+EngineBufferScaleRubberBand::LookAheadTask::LookAheadTask(
+        EngineBufferScaleRubberBand* pScaler)
+        : m_pScaler(pScaler),
+          m_completedSema(0) {
+    setAutoDelete(false);
+}
+
+void EngineBufferScaleRubberBand::LookAheadTask::run() {
+    m_pScaler->processLookAhead();
+    m_completedSema.release();
+}
+
+void EngineBufferScaleRubberBand::LookAheadTask::waitReady() {
+    m_completedSema.acquire();
+}
+
 EngineBufferScaleRubberBand::EngineBufferScaleRubberBand(
         ReadAheadManager* pReadAheadManager)
         : m_pReadAheadManager(pReadAheadManager),
@@ -24,15 +51,32 @@ EngineBufferScaleRubberBand::EngineBufferScaleRubberBand(
           m_bufferPtrs(),
           m_interleavedReadBuffer(MAX_BUFFER_LEN),
           m_bBackwards(false),
-          m_useEngineFiner(false) {
+          m_useEngineFiner(false),
+          m_lookAheadEnabled(false),
+          m_lookAheadPending(false),
+          m_lookAheadCancelled(false),
+          m_scaleParametersChanged(true),
+          m_lookAheadTask(this),
+          m_lookAheadReadBuffer(MAX_BUFFER_LEN),
+          m_lookAheadFrames(0),
+          m_lookAheadProcessedFrames(0) {
     // Initialize the internal buffers to prevent re-allocations
     // in the real-time thread.
     onSignalChanged();
 }
 
+EngineBufferScaleRubberBand::~EngineBufferScaleRubberBand() {
+    cancelLookAhead();
+}
+
 void EngineBufferScaleRubberBand::setScaleParameters(double base_rate,
                                                      double* pTempoRatio,
                                                      double* pPitchRatio) {
+    // The pending input must not be stretched with the old ratio, otherwise
+    // the change would become audible with the delay of the look-ahead
+    cancelLookAhead();
+    m_scaleParametersChanged = true;
+
     // Negative speed means we are going backwards. pitch does not affect
     // the playback direction.
     m_bBackwards = *pTempoRatio < 0;
@@ -98,6 +142,8 @@ void EngineBufferScaleRubberBand::onSignalChanged() {
     // TODO: Resetting the sample rate will cause internal
     // memory allocations that may block the real-time thread.
     // When is this function actually invoked??
+    cancelLookAhead();
+    dropLookAhead();
     if (!getOutputSignal().isValid()) {
         return;
     }
@@ -145,6 +191,10 @@ void EngineBufferScaleRubberBand::onSignalChanged() {
 }
 
 void EngineBufferScaleRubberBand::clear() {
+    // The stretched look-ahead is dropped together with the rest of
+    // the Rubber Band buffers
+    cancelLookAhead();
+    dropLookAhead();
     VERIFY_OR_DEBUG_ASSERT(m_rubberBand.isValid()) {
         return;
     }
@@ -290,12 +340,16 @@ double EngineBufferScaleRubberBand::scaleBuffer(
         return 0.0;
     }
     ScopedTimer t(QStringLiteral("EngineBufferScaleRubberBand::scaleBuffer"));
+    waitLookAhead();
     if (m_dBaseRate == 0.0 || m_dTempoRatio == 0.0) {
         SampleUtil::clear(pOutputBuffer, iOutputBufferSize);
         // No actual samples/frames have been read from the
         // unscaled input buffer!
         return 0.0;
     }
+    // Input left over by a cancelled look-ahead is stretched with the
+    // current ratio
+    processLookAhead();
 
     double readFramesProcessed = 0;
     SINT remaining_frames = getOutputSignal().samples2frames(iOutputBufferSize);
@@ -359,6 +413,13 @@ double EngineBufferScaleRubberBand::scaleBuffer(
         counter.increment();
     }
 
+    // Only look ahead while the rate is stable, otherwise a rate change
+    // would become audible with a delay
+    if (m_lookAheadEnabled.load(std::memory_order_relaxed) && !m_scaleParametersChanged) {
+        startLookAhead(getOutputSignal().samples2frames(iOutputBufferSize));
+    }
+    m_scaleParametersChanged = false;
+
     // readFramesProcessed is interpreted as the total number of frames
     // consumed to produce the scaled buffer. Due to this, we do not take into
     // account directionality or starting point.
@@ -377,6 +438,88 @@ void EngineBufferScaleRubberBand::useEngineFiner(bool enable) {
     }
 }
 
+void EngineBufferScaleRubberBand::setLookAheadEnabled(bool enabled) {
+    // Takes effect at the end of the next scaleBuffer()
+    m_lookAheadEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void EngineBufferScaleRubberBand::startLookAhead(SINT outputFrames) {
+    DEBUG_ASSERT(!m_lookAheadPending);
+    DEBUG_ASSERT(m_lookAheadProcessedFrames == m_lookAheadFrames);
+    RubberBandWorkerPool* pPool = RubberBandWorkerPool::instance();
+    if (!pPool) {
+        return;
+    }
+    const SINT bufferedFrames = m_rubberBand.available() - m_remainingPaddingInOutput;
+    const SINT missingFrames = kLookAheadBuffers * outputFrames - bufferedFrames;
+    if (missingFrames <= 0) {
+        return;
+    }
+
+    m_effectiveRate = m_dBaseRate * m_dTempoRatio;
+    const SINT readFrames = math_min(
+            static_cast<SINT>(std::ceil(missingFrames * m_effectiveRate)),
+            getOutputSignal().samples2frames(m_lookAheadReadBuffer.size()));
+    const SINT availableSamples = m_pReadAheadManager->getNextSamples(
+            (m_bBackwards ? -1.0 : 1.0) * m_effectiveRate,
+            m_lookAheadReadBuffer.data(),
+            getOutputSignal().frames2samples(readFrames),
+            getOutputSignal().getChannelCount());
+    m_lookAheadFrames = getOutputSignal().samples2frames(availableSamples);
+    m_lookAheadProcessedFrames = 0;
+    if (m_lookAheadFrames <= 0) {
+        dropLookAhead();
+        return;
+    }
+    m_lookAheadCancelled.store(false, std::memory_order_relaxed);
+    m_lookAheadPending = true;
+    pPool->start(&m_lookAheadTask);
+}
+
+void EngineBufferScaleRubberBand::waitLookAhead() {
+    if (!m_lookAheadPending) {
+        return;
+    }
+    m_lookAheadPending = false;
+    RubberBandWorkerPool* pPool = RubberBandWorkerPool::instance();
+    if (pPool && pPool->tryTake(&m_lookAheadTask)) {
+        // No worker has been available since the last callback
+        Counter counter("EngineBufferScaleRubberBand look-ahead not started");
+        counter.increment();
+        processLookAhead();
+        return;
+    }
+    m_lookAheadTask.waitReady();
+}
+
+void EngineBufferScaleRubberBand::cancelLookAhead() {
+    if (!m_lookAheadPending) {
+        return;
+    }
+    m_lookAheadCancelled.store(true, std::memory_order_relaxed);
+    waitLookAhead();
+    m_lookAheadCancelled.store(false, std::memory_order_relaxed);
+}
+
+void EngineBufferScaleRubberBand::processLookAhead() {
+    while (m_lookAheadProcessedFrames < m_lookAheadFrames &&
+            !m_lookAheadCancelled.load(std::memory_order_relaxed)) {
+        const auto requiredFrames = static_cast<SINT>(m_rubberBand.getSamplesRequired());
+        const SINT frames = math_min(m_lookAheadFrames - m_lookAheadProcessedFrames,
+                requiredFrames > 0 ? requiredFrames : kLookAheadBlockFrames);
+        deinterleaveAndProcess(m_lookAheadReadBuffer.data() +
+                        getOutputSignal().frames2samples(m_lookAheadProcessedFrames),
+                frames);
+        m_lookAheadProcessedFrames += frames;
+    }
+}
+
+void EngineBufferScaleRubberBand::dropLookAhead() {
+    DEBUG_ASSERT(!m_lookAheadPending);
+    m_lookAheadFrames = 0;
+    m_lookAheadProcessedFrames = 0;
+}
+
 size_t EngineBufferScaleRubberBand::getPreferredStartPad() const {
     return m_rubberBand.getPreferredStartPad();
 }
@@ -2,7 +2,10 @@
 
 #include <rubberband/RubberBandStretcher.h>
 
+#include <QRunnable>
+#include <QSemaphore>
 #include <array>
+#include <atomic>
 #include <memory>
 
 #include "engine/bufferscalers/enginebufferscale.h"
@@ -18,6 +21,8 @@ class EngineBufferScaleRubberBand final : public EngineBufferScale {
     explicit EngineBufferScaleRubberBand(
             ReadAheadManager* pReadAheadManager);
 
+    ~EngineBufferScaleRubberBand() override;
+
     EngineBufferScaleRubberBand(const EngineBufferScaleRubberBand&) = delete;
     EngineBufferScaleRubberBand& operator=(const EngineBufferScaleRubberBand&) = delete;
 
@@ -30,6 +35,15 @@ class EngineBufferScaleRubberBand final : public EngineBufferScale {
     // Enable engine v3 if available
     void useEngineFiner(bool enable);
 
+    /// In look-ahead mode the input for the next one or two buffers is
+    /// fetched at the end of scaleBuffer() and stretched on a
+    /// RubberBandWorkerPool thread until the next callback. A change of the
+    /// scale parameters cancels the stretching of the pending input, which
+    /// is then stretched with the new ratio. The next buffer is processed
+    /// synchronously. Controlled by [App],keylock_lookahead, may be called
+    /// from any thread.
+    void setLookAheadEnabled(bool enabled);
+
     void setScaleParameters(double base_rate,
                             double* pTempoRatio,
                             double* pPitchRatio) override;
@@ -42,6 +56,18 @@ class EngineBufferScaleRubberBand final : public EngineBufferScale {
     void clear() override;
 
   private:
+    class LookAheadTask : public QRunnable {
+      public:
+        explicit LookAheadTask(EngineBufferScaleRubberBand* pScaler);
+
+        void run() override;
+        void waitReady();
+
+      private:
+        EngineBufferScaleRubberBand* const m_pScaler;
+        QSemaphore m_completedSema;
+    };
+
     // Reset RubberBand library with new audio signal
     void onSignalChanged() override;
 
@@ -60,6 +86,20 @@ class EngineBufferScaleRubberBand final : public EngineBufferScale {
     void deinterleaveAndProcess(const CSAMPLE* pBuffer, SINT frames);
     SINT retrieveAndDeinterleave(CSAMPLE* pBuffer, SINT frames);
 
+    /// Fetches the input for the following buffers and starts to stretch it
+    /// on a worker thread.
+    void startLookAhead(SINT outputFrames);
+    /// Must be called before accessing the Rubber Band instance or the
+    /// channel buffers while a look-ahead task may be running.
+    void waitLookAhead();
+    /// Like waitLookAhead(), but stops the task after the current block.
+    /// The input that has not been stretched yet is kept for the next
+    /// scaleBuffer().
+    void cancelLookAhead();
+    /// Stretches the remaining look-ahead input
+    void processLookAhead();
+    void dropLookAhead();
+
     // The read-ahead manager that we use to fetch samples
     ReadAheadManager* m_pReadAheadManager;
 
@@ -85,4 +125,18 @@ class EngineBufferScaleRubberBand final : public EngineBufferScale {
     SINT m_remainingPaddingInOutput = 0;
 
     bool m_useEngineFiner;
+
+    std::atomic<bool> m_lookAheadEnabled;
+    /// Whether the task has been started and not been waited for
+    bool m_lookAheadPending;
+    /// Stops the task between two blocks
+    std::atomic<bool> m_lookAheadCancelled;
+    /// Set by setScaleParameters() and cleared by scaleBuffer()
+    bool m_scaleParametersChanged;
+    LookAheadTask m_lookAheadTask;
+    /// Interleaved input for the look-ahead task
+    mixxx::SampleBuffer m_lookAheadReadBuffer;
+    SINT m_lookAheadFrames;
+    /// The frames of m_lookAheadReadBuffer that have been stretched
+    SINT m_lookAheadProcessedFrames;
 };
@@ -1,13 +1,18 @@
 #include "engine/cachingreader/cachingreader.h"
 
 #include <QtDebug>
+#include <algorithm>
+#include <cmath>
+#include <utility>
 
 #include "moc_cachingreader.cpp"
 #include "util/assert.h"
 #include "util/compatibility/qatomic.h"
 #include "util/counter.h"
 #include "util/logger.h"
+#include "util/math.h"
 #include "util/sample.h"
+#include "util/stat.h"
 
 namespace {
 
@@ -29,11 +34,50 @@ constexpr SINT kDefaultHintFrames = 1024;
 // CachingReader must be multiplied by the number of decks to calculate
 // the total amount!
 //
+// The number of chunks in use is adapted at runtime between the default
+// and the maximum number of chunks, see adaptChunkBudget(). The memory for
+// the maximum number of chunks is allocated upfront, because the budget is
+// adapted in the engine thread where no memory must be allocated.
+//
 // NOTE(uklotzde, 2019-09-05): Reduce this number to just few chunks
-// (kNumberOfCachedChunksInMemory = 1, 2, 3, ...) for testing purposes
+// (kDefaultNumberOfCachedChunksInMemory = 1, 2, 3, ...) for testing purposes
 // to verify that the MRU/LRU cache works as expected. Even though
 // massive drop outs are expected to occur Mixxx should run reliably!
-constexpr SINT kNumberOfCachedChunksInMemory = 80;
+constexpr SINT kDefaultNumberOfCachedChunksInMemory = 80;
+constexpr SINT kMaxNumberOfCachedChunksInMemory = 160;
+
+// Limits the memory of readers with many channels, e.g. 128 chunks for
+// stem files with 8 channels.
+constexpr SINT kMaxCachedChunksBytes = 32 * 1024 * 1024;
+
+// The budget is adapted once every kChunkBudgetWindow engine callbacks,
+// i.e. about every 0.4 s at a latency of 5.8 ms.
+constexpr int kChunkBudgetWindow = 64;
+// Growing is immediate, shrinking by at most this number of chunks per
+// window to avoid oscillation.
+constexpr SINT kChunkBudgetStep = 16;
+// The pool is considered too small if more than 1 of kMissRateDivisor
+// chunk lookups missed while chunks were evicted at the same time.
+constexpr int kMissRateDivisor = 16;
+// Playing faster than this does not increase the budget any further.
+constexpr double kMaxBudgetRate = 4.0;
+
+// A chunk that could only be read partially is requested again after this
+// number of hints, i.e. engine callbacks.
+constexpr int kPartialChunkRetryHints = 8;
+
+const QString kStatChunkHits = QStringLiteral("CachingReader chunk hits");
+const QString kStatChunkMisses = QStringLiteral("CachingReader chunk misses");
+const QString kStatChunkEvictions = QStringLiteral("CachingReader chunk evictions");
+const QString kStatChunkBudget = QStringLiteral("CachingReader chunk budget");
+
+SINT maxNumberOfCachedChunks(mixxx::audio::ChannelCount maxSupportedChannel) {
+    const SINT chunkBytes = CachingReaderChunk::kFrames * maxSupportedChannel *
+            static_cast<SINT>(sizeof(CSAMPLE));
+    return math_max(kDefaultNumberOfCachedChunksInMemory,
+            math_min(kMaxNumberOfCachedChunksInMemory,
+                    kMaxCachedChunksBytes / chunkBytes));
+}
 
 } // anonymous namespace
 
@@ -50,31 +94,44 @@ CachingReader::CachingReader(const QString& group,
           // buffer, where new requests replace old requests when full. Those
           // old requests need to be returned immediately to the CachingReader
           // that must take ownership and free them!!!
-          m_chunkReadRequestFIFO(kNumberOfCachedChunksInMemory / 4),
+          m_chunkReadRequestFIFO(maxNumberOfCachedChunks(maxSupportedChannel) / 4),
           // The capacity of the back channel must be equal to the number of
           // allocated chunks, because the worker use writeBlocking(). Otherwise
           // the worker could get stuck in a hot loop!!!
-          m_readerStatusUpdateFIFO(kNumberOfCachedChunksInMemory),
+          m_readerStatusUpdateFIFO(maxNumberOfCachedChunks(maxSupportedChannel)),
           m_state(STATE_IDLE),
           m_mruCachingReaderChunk(nullptr),
           m_lruCachingReaderChunk(nullptr),
           m_sampleBuffer(CachingReaderChunk::kFrames * maxSupportedChannel *
-                  kNumberOfCachedChunksInMemory),
+                  maxNumberOfCachedChunks(maxSupportedChannel)),
+          m_maxChunkCount(maxNumberOfCachedChunks(maxSupportedChannel)),
+          m_chunkBudget(kDefaultNumberOfCachedChunksInMemory),
+          m_missChunkBudget(0),
+          m_adaptCallCount(0),
+          m_windowHitCount(0),
+          m_windowMissCount(0),
+          m_windowEvictionCount(0),
+          m_nextDeferredChunkRetry(0),
+          m_hintCount(0),
+          m_pPreloadedSamples(nullptr),
           m_worker(group,
+                  config,
                   &m_chunkReadRequestFIFO,
                   &m_readerStatusUpdateFIFO,
                   maxSupportedChannel) {
-    m_allocatedCachingReaderChunks.reserve(kNumberOfCachedChunksInMemory);
+    m_allocatedCachingReaderChunks.reserve(m_maxChunkCount);
+    m_chunks.reserve(m_maxChunkCount);
     // Divide up the allocated raw memory buffer into total_chunks
     // chunks. Initialize each chunk to hold nothing and add it to the free
     // list.
-    for (SINT i = 0; i < kNumberOfCachedChunksInMemory; ++i) {
+    const SINT chunkSampleCount = CachingReaderChunk::kFrames * maxSupportedChannel;
+    for (SINT i = 0; i < m_maxChunkCount; ++i) {
         CachingReaderChunkForOwner* c =
                 new CachingReaderChunkForOwner(
                         mixxx::SampleBuffer::WritableSlice(
                                 m_sampleBuffer,
-                                CachingReaderChunk::kFrames * maxSupportedChannel * i,
-                                CachingReaderChunk::kFrames * maxSupportedChannel));
+                                chunkSampleCount * i,
+                                chunkSampleCount));
         m_chunks.push_back(c);
         m_freeChunks.push_back(c);
     }
@@ -138,7 +195,7 @@ void CachingReader::freeAllChunks() {
 }
 
 CachingReaderChunkForOwner* CachingReader::allocateChunk(SINT chunkIndex) {
-    if (m_freeChunks.empty()) {
+    if (m_freeChunks.empty() || usedChunkCount() >= m_chunkBudget) {
         return nullptr;
     }
     CachingReaderChunkForOwner* pChunk = m_freeChunks.front();
@@ -153,13 +210,15 @@ CachingReaderChunkForOwner* CachingReader::allocateChunk(SINT chunkIndex) {
 
 CachingReaderChunkForOwner* CachingReader::allocateChunkExpireLRU(SINT chunkIndex) {
     auto* pChunk = allocateChunk(chunkIndex);
+    // More than one chunk needs to be freed if the budget has just been
+    // reduced
+    while (!pChunk && m_lruCachingReaderChunk) {
+        freeChunk(m_lruCachingReaderChunk);
+        ++m_windowEvictionCount;
+        pChunk = allocateChunk(chunkIndex);
+    }
     if (!pChunk) {
-        if (m_lruCachingReaderChunk) {
-            freeChunk(m_lruCachingReaderChunk);
-            pChunk = allocateChunk(chunkIndex);
-        } else {
-            kLogger.warning() << "No cached LRU chunk available for freeing";
-        }
+        kLogger.warning() << "No cached LRU chunk available for freeing";
     }
     if (kLogger.traceEnabled()) {
         kLogger.trace() << "allocateChunkExpireLRU" << chunkIndex << pChunk;
@@ -167,6 +226,32 @@ CachingReaderChunkForOwner* CachingReader::allocateChunkExpireLRU(SINT chunkInde
     return pChunk;
 }
 
+void CachingReader::deferChunkRetry(SINT chunkIndex) {
+    auto it = std::find_if(m_deferredChunkRetries.begin(),
+            m_deferredChunkRetries.end(),
+            [chunkIndex](const DeferredChunkRetry& retry) {
+                return retry.chunkIndex == chunkIndex;
+            });
+    if (it == m_deferredChunkRetries.end()) {
+        it = m_deferredChunkRetries.begin() + m_nextDeferredChunkRetry;
+        m_nextDeferredChunkRetry = (m_nextDeferredChunkRetry + 1) %
+                m_deferredChunkRetries.size();
+    }
+    auto& retry = *it;
+    retry.chunkIndex = chunkIndex;
+    retry.notBeforeHintCount = m_hintCount + kPartialChunkRetryHints;
+}
+
+bool CachingReader::isChunkRetryDeferred(SINT chunkIndex) const {
+    for (const auto& retry : m_deferredChunkRetries) {
+        if (retry.chunkIndex == chunkIndex) {
+            // Signed difference of the wrapping counters
+            return static_cast<int>(retry.notBeforeHintCount - m_hintCount) > 0;
+        }
+    }
+    return false;
+}
+
 CachingReaderChunkForOwner* CachingReader::lookupChunk(SINT chunkIndex) {
     // Defaults to nullptr if it's not in the hash.
     auto* pChunk = m_allocatedCachingReaderChunks.value(chunkIndex, nullptr);
@@ -243,6 +328,7 @@ void CachingReader::process() {
                     update.status == CHUNK_READ_SUCCESS ||
                     update.status == CHUNK_READ_EOF ||
                     update.status == CHUNK_READ_INVALID ||
+                    update.status == CHUNK_READ_PARTIAL ||
                     update.status == CHUNK_READ_DISCARDED);
             if (m_state.loadAcquire() == STATE_TRACK_LOADING) {
                 // Discard all results from pending read requests for the
@@ -255,6 +341,11 @@ void CachingReader::process() {
                 // Insert or freshen the chunk in the MRU/LRU list after
                 // obtaining ownership from the worker.
                 freshenChunk(pChunk);
+            } else if (update.status == CHUNK_READ_PARTIAL) {
+                // Incomplete chunks are not cached, otherwise the missing
+                // frames would remain silent even after they have arrived
+                deferChunkRetry(pChunk->getIndex());
+                freeChunk(pChunk);
             } else {
                 // Discard chunks that don't carry any data
                 freeChunk(pChunk);
@@ -282,11 +373,16 @@ void CachingReader::process() {
                     DEBUG_ASSERT(atomicLoadRelaxed(m_state) == STATE_TRACK_LOADING);
                     freeAllChunks();
                 }
+                m_deferredChunkRetries.fill(DeferredChunkRetry{});
                 // Reset the readable frame index range
                 m_readableFrameIndexRange = update.readableFrameIndexRange();
+                m_pPreloadedSamples = update.getPreloadedSamples();
+                m_worker.acknowledgePreload(update.getPreloadAck());
                 m_state.storeRelease(STATE_TRACK_LOADED);
             } else {
                 DEBUG_ASSERT(update.status == TRACK_UNLOADED);
+                m_pPreloadedSamples = nullptr;
+                m_worker.acknowledgePreload(update.getPreloadAck());
                 // This message could be processed later when a new
                 // track is already loading! In this case the TRACK_LOADED will
                 // be the very next status update.
@@ -359,6 +455,10 @@ CachingReader::ReadResult CachingReader::read(SINT startSample,
     // the first chunk and to update m_readableFrameIndexRange
     process();
 
+    if (m_pPreloadedSamples) {
+        return readPreloaded(sample, numSamples, reverse, buffer, channelCount);
+    }
+
     auto remainingFrameIndexRange =
             mixxx::IndexRange::forward(
                     CachingReaderChunk::samples2frames(sample, channelCount),
@@ -450,6 +550,7 @@ CachingReader::ReadResult CachingReader::read(SINT startSample,
                 mixxx::IndexRange bufferedFrameIndexRange;
                 const CachingReaderChunkForOwner* const pChunk = lookupChunkAndFreshen(chunkIndex);
                 if (pChunk && (pChunk->getState() == CachingReaderChunkForOwner::READY)) {
+                    ++m_windowHitCount;
                     if (reverse) {
                         bufferedFrameIndexRange =
                                 pChunk->readBufferedSampleFramesReverse(
@@ -470,6 +571,7 @@ CachingReader::ReadResult CachingReader::read(SINT startSample,
                     DEBUG_ASSERT(!pChunk ||
                             (pChunk->getState() == CachingReaderChunkForOwner::READ_PENDING));
                     Counter("CachingReader::read(): Failed to read chunk on cache miss")++;
+                    ++m_windowMissCount;
                     if (kLogger.traceEnabled()) {
                         kLogger.trace()
                                 << "Cache miss for chunk with index"
@@ -536,12 +638,70 @@ CachingReader::ReadResult CachingReader::read(SINT startSample,
     return result;
 }
 
+CachingReader::ReadResult CachingReader::readPreloaded(SINT sample,
+        SINT numSamples,
+        bool reverse,
+        CSAMPLE* buffer,
+        mixxx::audio::ChannelCount channelCount) {
+    DEBUG_ASSERT(m_pPreloadedSamples);
+    const auto frameIndexRange =
+            mixxx::IndexRange::forward(
+                    CachingReaderChunk::samples2frames(sample, channelCount),
+                    CachingReaderChunk::samples2frames(numSamples, channelCount));
+    const auto copyableFrameIndexRange =
+            intersect(frameIndexRange, m_readableFrameIndexRange);
+    if (copyableFrameIndexRange.empty()) {
+        SampleUtil::clear(buffer, numSamples);
+        return ReadResult::PARTIALLY_AVAILABLE;
+    }
+
+    // Silence before and after the readable range, e.g. in preroll. In
+    // reverse the frames are copied in reverse order, i.e. the silence
+    // before the readable range ends up at the end of the buffer.
+    SINT leadingSamples = CachingReaderChunk::frames2samples(
+            copyableFrameIndexRange.start() - frameIndexRange.start(),
+            channelCount);
+    SINT trailingSamples = CachingReaderChunk::frames2samples(
+            frameIndexRange.end() - copyableFrameIndexRange.end(),
+            channelCount);
+    if (reverse) {
+        std::swap(leadingSamples, trailingSamples);
+    }
+    const SINT copySamples = numSamples - leadingSamples - trailingSamples;
+    const CSAMPLE* pSrc = m_pPreloadedSamples +
+            CachingReaderChunk::frames2samples(
+                    copyableFrameIndexRange.start() -
+                            m_readableFrameIndexRange.start(),
+                    channelCount);
+    if (leadingSamples > 0) {
+        SampleUtil::clear(buffer, leadingSamples);
+    }
+    if (reverse) {
+        SampleUtil::copyReverse(&buffer[leadingSamples], pSrc, copySamples, channelCount);
+    } else {
+        SampleUtil::copy(&buffer[leadingSamples], pSrc, copySamples);
+    }
+    if (trailingSamples > 0) {
+        SampleUtil::clear(&buffer[numSamples - trailingSamples], trailingSamples);
+    }
+    return copyableFrameIndexRange == frameIndexRange
+            ? ReadResult::AVAILABLE
+            : ReadResult::PARTIALLY_AVAILABLE;
+}
+
 void CachingReader::hintAndMaybeWake(const HintVector& hintList) {
     // If no file is loaded, skip.
     if (atomicLoadRelaxed(m_state) != STATE_TRACK_LOADED) {
         return;
     }
 
+    // Nothing to read for a preloaded track
+    if (m_pPreloadedSamples) {
+        return;
+    }
+
+    ++m_hintCount;
+
     // For every chunk that the hints indicated, check if it is in the cache. If
     // any are not, then wake.
     bool shouldWake = false;
@@ -582,6 +742,9 @@ void CachingReader::hintAndMaybeWake(const HintVector& hintList) {
         for (int chunkIndex = firstChunkIndex; chunkIndex <= lastChunkIndex; ++chunkIndex) {
             CachingReaderChunkForOwner* pChunk = lookupChunk(chunkIndex);
             if (!pChunk) {
+                if (isChunkRetryDeferred(chunkIndex)) {
+                    continue;
+                }
                 shouldWake = true;
                 pChunk = allocateChunkExpireLRU(chunkIndex);
                 if (!pChunk) {
@@ -621,3 +784,63 @@ void CachingReader::hintAndMaybeWake(const HintVector& hintList) {
         m_worker.workReady();
     }
 }
+
+void CachingReader::adaptChunkBudget(double rate, mixxx::audio::ChannelCount channelCount) {
+    if (++m_adaptCallCount < kChunkBudgetWindow) {
+        return;
+    }
+    m_adaptCallCount = 0;
+
+    // Only add chunks after misses if evicted chunks might have prevented
+    // them. Misses after seeking into uncached regions are expected.
+    const int lookupCount = m_windowHitCount + m_windowMissCount;
+    if (m_windowEvictionCount > 0 &&
+            m_windowMissCount * kMissRateDivisor > lookupCount) {
+        m_missChunkBudget += kChunkBudgetStep;
+    } else if (m_windowMissCount == 0) {
+        m_missChunkBudget = math_max<SINT>(0, m_missChunkBudget - kChunkBudgetStep / 4);
+    }
+
+    // Scratching and fast playback consume chunks faster, decoding many
+    // channels takes longer and needs more chunks in advance.
+    const double budgetRate = math_min(math_max(std::abs(rate), 1.0), kMaxBudgetRate);
+    SINT targetBudget = static_cast<SINT>(kDefaultNumberOfCachedChunksInMemory * budgetRate);
+    if (channelCount > mixxx::audio::ChannelCount::stereo()) {
+        targetBudget += targetBudget / 2;
+    }
+    targetBudget += m_missChunkBudget;
+    targetBudget = math_min(targetBudget, m_maxChunkCount);
+    // Don't keep growing the miss budget beyond the limit
+    m_missChunkBudget = math_min(m_missChunkBudget, m_maxChunkCount);
+
+    if (targetBudget >= m_chunkBudget) {
+        m_chunkBudget = targetBudget;
+    } else {
+        m_chunkBudget = math_max(targetBudget, m_chunkBudget - kChunkBudgetStep);
+        // Release the least recently used chunks beyond the budget. Chunks
+        // with pending reads are released later when they are returned.
+        while (usedChunkCount() > m_chunkBudget && m_lruCachingReaderChunk) {
+            freeChunk(m_lruCachingReaderChunk);
+            ++m_windowEvictionCount;
+        }
+    }
+
+    // Report the statistics of the window in one go to keep the overhead
+    // in the engine thread low
+    if (m_windowHitCount > 0) {
+        Counter(kStatChunkHits).increment(m_windowHitCount);
+    }
+    if (m_windowMissCount > 0) {
+        Counter(kStatChunkMisses).increment(m_windowMissCount);
+    }
+    if (m_windowEvictionCount > 0) {
+        Counter(kStatChunkEvictions).increment(m_windowEvictionCount);
+    }
+    Stat::track(kStatChunkBudget,
+            Stat::UNSPECIFIED,
+            Stat::experimentFlags(Stat::COUNT | Stat::AVERAGE | Stat::MIN | Stat::MAX),
+            m_chunkBudget);
+    m_windowHitCount = 0;
+    m_windowMissCount = 0;
+    m_windowEvictionCount = 0;
+}
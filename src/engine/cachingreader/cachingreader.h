@@ -5,7 +5,9 @@
 #include <QList>
 #include <QVarLengthArray>
 #include <QVector>
+#include <array>
 #include <list>
+#include <vector>
 
 #include "engine/cachingreader/cachingreaderworker.h"
 #include "preferences/usersettings.h"
@@ -76,6 +78,11 @@ typedef QVarLengthArray<Hint, 512> HintVector;
 // least-recently-used list. When a chunk needs to be allocated and there are no
 // free chunks then the least recently used chunk is free'd (see
 // allocateChunkExpireLRU).
+//
+// Small tracks, or all tracks of decks with the preload_whole_track option,
+// are decoded completely by the worker when loading them. Reading from such
+// a track is a plain copy from memory that never misses and bypasses the
+// chunks.
 class CachingReader : public QObject {
     Q_OBJECT
 
@@ -113,6 +120,12 @@ class CachingReader : public QObject {
     // from the engine callback.
     void hintAndMaybeWake(const HintVector& hintList);
 
+    // Adapts the number of chunks that are kept in memory to the playback
+    // rate, the channel count of the track and the recent cache misses.
+    // Only the number of usable chunks is changed, all chunks are allocated
+    // upfront. Must only be called from the engine callback.
+    void adaptChunkBudget(double rate, mixxx::audio::ChannelCount channelCount);
+
     // Request that the CachingReader load a new track. These requests are
     // processed in the work thread, so the reader must be woken up via wake()
     // for this to take effect.
@@ -143,6 +156,13 @@ class CachingReader : public QObject {
     FIFO<CachingReaderChunkReadRequest> m_chunkReadRequestFIFO;
     FIFO<ReaderStatusUpdate> m_readerStatusUpdateFIFO;
 
+    // read() for preloaded tracks
+    ReadResult readPreloaded(SINT sample,
+            SINT numSamples,
+            bool reverse,
+            CSAMPLE* buffer,
+            mixxx::audio::ChannelCount channelCount);
+
     // Looks for the provided chunk number in the index of in-memory chunks and
     // returns it if it is present. If not, returns nullptr. If it is present then
     // freshenChunk is called on the chunk to make it the MRU chunk.
@@ -162,12 +182,23 @@ class CachingReader : public QObject {
     // Returns all allocated chunks to the free list
     void freeAllChunks();
 
-    // Gets a chunk from the free list. Returns nullptr if none available.
+    SINT usedChunkCount() const {
+        return m_chunks.size() - static_cast<SINT>(m_freeChunks.size());
+    }
+
+    // Gets a chunk from the free list. Returns nullptr if none available
+    // or if the budget is exhausted.
     CachingReaderChunkForOwner* allocateChunk(SINT chunkIndex);
 
     // Gets a chunk from the free list, frees the LRU CachingReaderChunk if none available.
     CachingReaderChunkForOwner* allocateChunkExpireLRU(SINT chunkIndex);
 
+    // Chunks that could only be read partially are requested again after a
+    // few callbacks, i.e. after more data has been downloaded, instead of
+    // decoding the available part again and again.
+    void deferChunkRetry(SINT chunkIndex);
+    bool isChunkRetryDeferred(SINT chunkIndex) const;
+
     enum State {
         STATE_IDLE,
         STATE_TRACK_LOADING,
@@ -193,9 +224,37 @@ class CachingReader : public QObject {
 
     // The raw memory buffer which is divided up into chunks.
     mixxx::SampleBuffer m_sampleBuffer;
+    const SINT m_maxChunkCount;
+
+    // The number of chunks that may be used, at most m_maxChunkCount.
+    // All chunks are allocated, the chunks beyond the budget stay free.
+    SINT m_chunkBudget;
+    // Additional chunks after cache misses, decays if no misses occur.
+    SINT m_missChunkBudget;
+    int m_adaptCallCount;
+    // Statistics of the current adaption window
+    int m_windowHitCount;
+    int m_windowMissCount;
+    int m_windowEvictionCount;
+
+    struct DeferredChunkRetry {
+        SINT chunkIndex = -1;
+        unsigned int notBeforeHintCount = 0;
+    };
+    // Round robin, only the few chunks around the play position matter
+    std::array<DeferredChunkRetry, 4> m_deferredChunkRetries;
+    std::size_t m_nextDeferredChunkRetry;
+    // Wraps around
+    unsigned int m_hintCount;
 
     // The readable frame index range as reported by the worker.
     mixxx::IndexRange m_readableFrameIndexRange;
 
+    // The samples of m_readableFrameIndexRange if the track has been
+    // preloaded. Owned by the worker.
+    const CSAMPLE* m_pPreloadedSamples;
+
     CachingReaderWorker m_worker;
+
+    friend class CachingReaderTest;
 };
@@ -43,12 +43,14 @@ mixxx::IndexRange CachingReaderChunk::frameIndexRange(
             pAudioSource->frameIndexRange());
 }
 
-mixxx::IndexRange CachingReaderChunk::bufferSampleFrames(
+mixxx::ReadableSampleFrames CachingReaderChunk::readSampleFrames(
         const mixxx::AudioSourcePointer& pAudioSource,
-        mixxx::SampleBuffer::WritableSlice tempOutputBuffer) {
+        mixxx::SampleBuffer::WritableSlice tempOutputBuffer,
+        mixxx::SampleBuffer::WritableSlice outputBuffer) const {
     DEBUG_ASSERT(m_index != kInvalidChunkIndex);
     const auto sourceFrameIndexRange = frameIndexRange(pAudioSource);
 
+    mixxx::ReadableSampleFrames readableSampleFrames;
     if (pAudioSource->getSignalInfo().getChannelCount() %
                     mixxx::audio::ChannelCount::stereo() !=
             0) {
@@ -60,20 +62,54 @@ mixxx::IndexRange CachingReaderChunk::bufferSampleFrames(
         DEBUG_ASSERT(
                 audioSourceProxy.getSignalInfo().getChannelCount() ==
                 mixxx::audio::ChannelCount::stereo());
-        m_bufferedSampleFrames =
+        readableSampleFrames =
                 audioSourceProxy.readSampleFrames(
                         mixxx::WritableSampleFrames(
                                 sourceFrameIndexRange,
-                                mixxx::SampleBuffer::WritableSlice(m_sampleBuffer)));
+                                outputBuffer));
     } else {
-        m_bufferedSampleFrames =
+        readableSampleFrames =
                 pAudioSource->readSampleFrames(
                         mixxx::WritableSampleFrames(
                                 sourceFrameIndexRange,
-                                mixxx::SampleBuffer::WritableSlice(m_sampleBuffer)));
+                                outputBuffer));
     }
-    DEBUG_ASSERT(m_bufferedSampleFrames.frameIndexRange().empty() ||
-            m_bufferedSampleFrames.frameIndexRange().isSubrangeOf(sourceFrameIndexRange));
+    DEBUG_ASSERT(readableSampleFrames.frameIndexRange().empty() ||
+            readableSampleFrames.frameIndexRange().isSubrangeOf(sourceFrameIndexRange));
+    return readableSampleFrames;
+}
+
+mixxx::IndexRange CachingReaderChunk::bufferSampleFrames(
+        const mixxx::AudioSourcePointer& pAudioSource,
+        mixxx::SampleBuffer::WritableSlice tempOutputBuffer) {
+    m_pSharedChunk.reset();
+    m_bufferedSampleFrames = readSampleFrames(
+            pAudioSource,
+            tempOutputBuffer,
+            m_sampleBuffer);
+    return m_bufferedSampleFrames.frameIndexRange();
+}
+
+std::shared_ptr<const CachingReaderSharedChunk> CachingReaderChunk::bufferSharedSampleFrames(
+        const mixxx::AudioSourcePointer& pAudioSource,
+        mixxx::SampleBuffer::WritableSlice tempOutputBuffer) {
+    auto pSharedChunk = std::make_shared<CachingReaderSharedChunk>(
+            m_sampleBuffer.length());
+    pSharedChunk->readableSampleFrames = readSampleFrames(
+            pAudioSource,
+            tempOutputBuffer,
+            mixxx::SampleBuffer::WritableSlice(pSharedChunk->sampleBuffer));
+    m_bufferedSampleFrames = pSharedChunk->readableSampleFrames;
+    m_pSharedChunk = pSharedChunk;
+    return pSharedChunk;
+}
+
+mixxx::IndexRange CachingReaderChunk::referSharedSampleFrames(
+        std::shared_ptr<const CachingReaderSharedChunk> pSharedChunk) {
+    DEBUG_ASSERT(m_index != kInvalidChunkIndex);
+    DEBUG_ASSERT(pSharedChunk);
+    m_bufferedSampleFrames = pSharedChunk->readableSampleFrames;
+    m_pSharedChunk = std::move(pSharedChunk);
     return m_bufferedSampleFrames.frameIndexRange();
 }
 
@@ -1,7 +1,21 @@
 #pragma once
 
+#include <memory>
+
 #include "sources/audiosource.h"
 
+// The decoded samples of a chunk that can be referenced by the chunks of
+// all readers of the same file, see CachingReaderChunkStore.
+struct CachingReaderSharedChunk {
+    explicit CachingReaderSharedChunk(SINT sampleCount)
+            : sampleBuffer(sampleCount) {
+    }
+
+    mixxx::SampleBuffer sampleBuffer;
+    // Refers to sampleBuffer
+    mixxx::ReadableSampleFrames readableSampleFrames;
+};
+
 // A Chunk is a memory-resident section of audio that has been cached.
 // Each chunk holds a fixed number kFrames of frames with samples for
 // kChannels.
@@ -63,6 +77,17 @@ public:
             const mixxx::AudioSourcePointer& pAudioSource,
             mixxx::SampleBuffer::WritableSlice tempOutputBuffer);
 
+    // Like bufferSampleFrames(), but the samples are read into a new
+    // shared chunk instead of the own buffer. The shared chunk is returned
+    // for referring to it from the chunks of other readers.
+    std::shared_ptr<const CachingReaderSharedChunk> bufferSharedSampleFrames(
+            const mixxx::AudioSourcePointer& pAudioSource,
+            mixxx::SampleBuffer::WritableSlice tempOutputBuffer);
+
+    // Refers to the samples of a shared chunk instead of reading them
+    mixxx::IndexRange referSharedSampleFrames(
+            std::shared_ptr<const CachingReaderSharedChunk> pSharedChunk);
+
     mixxx::IndexRange readBufferedSampleFrames(CSAMPLE* sampleBuffer,
             mixxx::audio::ChannelCount channelCount,
             const mixxx::IndexRange& frameIndexRange) const;
@@ -83,12 +108,22 @@ public:
         return m_index * kFrames;
     }
 
+    mixxx::ReadableSampleFrames readSampleFrames(
+            const mixxx::AudioSourcePointer& pAudioSource,
+            mixxx::SampleBuffer::WritableSlice tempOutputBuffer,
+            mixxx::SampleBuffer::WritableSlice outputBuffer) const;
+
     SINT m_index;
 
     // The worker thread will fill the sample buffer and
     // set the corresponding frame index range.
     mixxx::SampleBuffer::WritableSlice m_sampleBuffer;
     mixxx::ReadableSampleFrames m_bufferedSampleFrames;
+
+    // The shared chunk that m_bufferedSampleFrames refers to, if any. Only
+    // replaced by the worker and intentionally not reset by init(), because
+    // the engine thread must not release the memory.
+    std::shared_ptr<const CachingReaderSharedChunk> m_pSharedChunk;
 };
 
 // This derived class is only accessible for the cache as the owner,
@@ -0,0 +1,121 @@
+#include "engine/cachingreader/cachingreaderchunkstore.h"
+
+#include "util/assert.h"
+#include "util/compatibility/qmutex.h"
+
+namespace {
+
+// About 12 minutes of decoded stereo audio at 44.1 kHz
+constexpr qint64 kMaxRetainedBytes = qint64(256) * 1024 * 1024;
+
+qint64 chunkBytes(const CachingReaderSharedChunk& sharedChunk) {
+    return static_cast<qint64>(sharedChunk.sampleBuffer.size()) *
+            static_cast<qint64>(sizeof(CSAMPLE));
+}
+
+} // anonymous namespace
+
+// static
+CachingReaderChunkStore& CachingReaderChunkStore::instance() {
+    static CachingReaderChunkStore s_instance;
+    return s_instance;
+}
+
+// static
+QString CachingReaderChunkStore::fileKey(const QString& location,
+        const mixxx::AudioSource::OpenParams& openParams,
+        mixxx::audio::ChannelCount channelCount) {
+    QString stemKey;
+#ifdef __STEM__
+    stemKey = QString::number(openParams.stemMask().toInt());
+#else
+    Q_UNUSED(openParams);
+#endif
+    return QStringLiteral("%1|%2|%3")
+            .arg(location, stemKey, QString::number(channelCount));
+}
+
+void CachingReaderChunkStore::openFile(const QString& key) {
+    const auto locker = lockMutex(&m_mutex);
+    ++m_entries[key].readerCount;
+}
+
+void CachingReaderChunkStore::closeFile(const QString& key) {
+    const auto locker = lockMutex(&m_mutex);
+    auto it = m_entries.find(key);
+    VERIFY_OR_DEBUG_ASSERT(it != m_entries.end()) {
+        return;
+    }
+    if (--it->readerCount <= 0) {
+        for (const auto& pSharedChunk : std::as_const(it->retainedChunks)) {
+            m_retainedBytes -= chunkBytes(*pSharedChunk);
+        }
+        m_entries.erase(it);
+    }
+}
+
+bool CachingReaderChunkStore::isShared(const QString& key) const {
+    const auto locker = lockMutex(&m_mutex);
+    const auto it = m_entries.constFind(key);
+    return it != m_entries.constEnd() &&
+            (it->readerCount > 1 || !it->retainedChunks.isEmpty());
+}
+
+std::shared_ptr<const CachingReaderSharedChunk> CachingReaderChunkStore::lookup(
+        const QString& key, SINT chunkIndex) {
+    const auto locker = lockMutex(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return nullptr;
+    }
+    auto retainedIt = it->retainedChunks.find(chunkIndex);
+    if (retainedIt != it->retainedChunks.end()) {
+        // The reader keeps the chunk alive from now on
+        auto pSharedChunk = std::move(*retainedIt);
+        it->retainedChunks.erase(retainedIt);
+        m_retainedBytes -= chunkBytes(*pSharedChunk);
+        return pSharedChunk;
+    }
+    auto chunkIt = it->chunks.find(chunkIndex);
+    if (chunkIt == it->chunks.end()) {
+        return nullptr;
+    }
+    auto pSharedChunk = chunkIt->lock();
+    if (!pSharedChunk) {
+        it->chunks.erase(chunkIt);
+    }
+    return pSharedChunk;
+}
+
+void CachingReaderChunkStore::insert(const QString& key,
+        SINT chunkIndex,
+        std::shared_ptr<const CachingReaderSharedChunk> pSharedChunk) {
+    DEBUG_ASSERT(pSharedChunk);
+    const auto locker = lockMutex(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        // All readers have closed the file in the meantime
+        return;
+    }
+    it->chunks.insert(chunkIndex, std::move(pSharedChunk));
+}
+
+void CachingReaderChunkStore::retain(const QString& key,
+        SINT chunkIndex,
+        std::shared_ptr<const CachingReaderSharedChunk> pSharedChunk) {
+    DEBUG_ASSERT(pSharedChunk);
+    const auto locker = lockMutex(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        // All readers have closed the file in the meantime
+        return;
+    }
+    it->chunks.insert(chunkIndex, pSharedChunk);
+    const qint64 bytes = chunkBytes(*pSharedChunk);
+    if (m_retainedBytes + bytes > kMaxRetainedBytes ||
+            it->retainedChunks.contains(chunkIndex)) {
+        return;
+    }
+    m_retainedBytes += bytes;
+    it->retainedChunks.insert(chunkIndex, std::move(pSharedChunk));
+}
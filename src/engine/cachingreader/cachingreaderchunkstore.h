@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <memory>
+
+#include "engine/cachingreader/cachingreaderchunk.h"
+#include "sources/audiosource.h"
+
+// Process-wide store of the decoded chunks of files that are loaded by more
+// than one CachingReader at the same time, e.g. for doubles or when the
+// track playing on a deck is also loaded into the preview deck.
+//
+// The store usually only holds weak references. A decoded chunk lives as
+// long as a CachingReaderChunk of any reader refers to it, i.e. readers of
+// the same file share both the decoding work and the memory. Readers that
+// decode a file far ahead of the others, like the analysis of a track that
+// has just been loaded into a deck, retain their chunks in the store until
+// another reader looks them up. The store is accessed by the
+// CachingReaderWorker and the AnalyzerThread threads.
+class CachingReaderChunkStore {
+  public:
+    static CachingReaderChunkStore& instance();
+
+    // Identifies the decoded samples of a file. They also depend on
+    // the selected stems and the channel count of the audio source.
+    static QString fileKey(const QString& location,
+            const mixxx::AudioSource::OpenParams& openParams,
+            mixxx::audio::ChannelCount channelCount);
+
+    // Registers a reader of the file identified by key
+    void openFile(const QString& key);
+    void closeFile(const QString& key);
+
+    // Returns true if the file is opened by more than one reader or
+    // if chunks are retained for it
+    bool isShared(const QString& key) const;
+
+    // Returns nullptr if the chunk has not been decoded by any reader
+    // or is no longer referenced. A retained chunk is released by the
+    // store when it is returned.
+    std::shared_ptr<const CachingReaderSharedChunk> lookup(
+            const QString& key, SINT chunkIndex);
+    void insert(const QString& key,
+            SINT chunkIndex,
+            std::shared_ptr<const CachingReaderSharedChunk> pSharedChunk);
+    // Like insert(), but the store keeps the chunk alive until it is looked
+    // up or the file is closed by all readers. Only inserted if the memory
+    // of all retained chunks stays within a fixed budget.
+    void retain(const QString& key,
+            SINT chunkIndex,
+            std::shared_ptr<const CachingReaderSharedChunk> pSharedChunk);
+
+  private:
+    CachingReaderChunkStore() = default;
+
+    struct Entry {
+        int readerCount = 0;
+        QHash<SINT, std::weak_ptr<const CachingReaderSharedChunk>> chunks;
+        QHash<SINT, std::shared_ptr<const CachingReaderSharedChunk>> retainedChunks;
+    };
+
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    qint64 m_retainedBytes = 0;
+};
@@ -0,0 +1,96 @@
+#include "engine/cachingreader/cachingreadersharedaudiosource.h"
+
+#include "engine/cachingreader/cachingreaderchunkstore.h"
+#include "util/sample.h"
+
+namespace {
+
+constexpr SINT kInvalidChunkIndex = -1;
+
+} // anonymous namespace
+
+CachingReaderSharedAudioSource::CachingReaderSharedAudioSource(
+        mixxx::AudioSourcePointer pAudioSource,
+        QString chunkStoreKey)
+        : AudioSourceProxy(std::move(pAudioSource)),
+          m_chunkStoreKey(std::move(chunkStoreKey)),
+          m_chunkIndex(kInvalidChunkIndex) {
+    DEBUG_ASSERT(getSignalInfo().getChannelCount() %
+                    mixxx::audio::ChannelCount::stereo() ==
+            0);
+    CachingReaderChunkStore::instance().openFile(m_chunkStoreKey);
+}
+
+CachingReaderSharedAudioSource::~CachingReaderSharedAudioSource() {
+    m_pChunk.reset();
+    CachingReaderChunkStore::instance().closeFile(m_chunkStoreKey);
+}
+
+std::shared_ptr<const CachingReaderSharedChunk> CachingReaderSharedAudioSource::sharedChunk(
+        SINT chunkIndex) {
+    if (m_pChunk && m_chunkIndex == chunkIndex) {
+        return m_pChunk;
+    }
+    auto& chunkStore = CachingReaderChunkStore::instance();
+    const bool shared = chunkStore.isShared(m_chunkStoreKey);
+    std::shared_ptr<const CachingReaderSharedChunk> pChunk;
+    if (shared) {
+        pChunk = chunkStore.lookup(m_chunkStoreKey, chunkIndex);
+    }
+    if (!pChunk) {
+        // Like CachingReaderChunk::frameIndexRange()
+        const auto chunkFrameIndexRange = intersect(
+                mixxx::IndexRange::forward(
+                        frameIndexMin() + chunkIndex * CachingReaderChunk::kFrames,
+                        CachingReaderChunk::kFrames),
+                frameIndexRange());
+        auto pNewChunk = std::make_shared<CachingReaderSharedChunk>(
+                getSignalInfo().frames2samples(CachingReaderChunk::kFrames));
+        pNewChunk->readableSampleFrames = readSampleFramesClampedOn(*m_pAudioSource,
+                mixxx::WritableSampleFrames(chunkFrameIndexRange,
+                        mixxx::SampleBuffer::WritableSlice(pNewChunk->sampleBuffer)));
+        // Only complete chunks are shared
+        if (shared &&
+                pNewChunk->readableSampleFrames.frameIndexRange() == chunkFrameIndexRange) {
+            chunkStore.retain(m_chunkStoreKey, chunkIndex, pNewChunk);
+        }
+        pChunk = std::move(pNewChunk);
+    }
+    m_chunkIndex = chunkIndex;
+    m_pChunk = pChunk;
+    return pChunk;
+}
+
+mixxx::ReadableSampleFrames CachingReaderSharedAudioSource::readSampleFramesClamped(
+        const mixxx::WritableSampleFrames& writableSampleFrames) {
+    const auto requestedFrameIndexRange = writableSampleFrames.frameIndexRange();
+    SINT frameIndex = requestedFrameIndexRange.start();
+    while (frameIndex < requestedFrameIndexRange.end()) {
+        const SINT chunkIndex = (frameIndex - frameIndexMin()) / CachingReaderChunk::kFrames;
+        const auto pChunk = sharedChunk(chunkIndex);
+        const auto& chunkSampleFrames = pChunk->readableSampleFrames;
+        const auto copyFrameIndexRange = intersect(
+                mixxx::IndexRange::between(frameIndex, requestedFrameIndexRange.end()),
+                chunkSampleFrames.frameIndexRange());
+        if (copyFrameIndexRange.empty() || copyFrameIndexRange.start() != frameIndex) {
+            // Failed to decode the chunk
+            break;
+        }
+        if (writableSampleFrames.writableLength() > 0) {
+            SampleUtil::copy(
+                    writableSampleFrames.writableData(getSignalInfo().frames2samples(
+                            frameIndex - requestedFrameIndexRange.start())),
+                    chunkSampleFrames.readableData(getSignalInfo().frames2samples(
+                            frameIndex - chunkSampleFrames.frameIndexRange().start())),
+                    getSignalInfo().frames2samples(copyFrameIndexRange.length()));
+        }
+        frameIndex = copyFrameIndexRange.end();
+    }
+    const auto readFrameIndexRange =
+            mixxx::IndexRange::between(requestedFrameIndexRange.start(), frameIndex);
+    return mixxx::ReadableSampleFrames(readFrameIndexRange,
+            mixxx::SampleBuffer::ReadableSlice(writableSampleFrames.writableData(),
+                    writableSampleFrames.writableLength() > 0
+                            ? getSignalInfo().frames2samples(readFrameIndexRange.length())
+                            : 0));
+}
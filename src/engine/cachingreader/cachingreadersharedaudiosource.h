@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QString>
+#include <memory>
+
+#include "engine/cachingreader/cachingreaderchunk.h"
+#include "sources/audiosourceproxy.h"
+
+// Reads the samples of an audio source in the chunks of the CachingReader
+// and shares them through the CachingReaderChunkStore. Chunks that have
+// already been decoded by a deck are copied instead of being decoded again.
+// While the file is also loaded into a deck, all chunks decoded by this
+// source are retained in the store for the deck.
+//
+// The samples must be read in ascending order for sharing to be effective.
+// Audio sources with an odd number of channels need to be wrapped into an
+// AudioSourceStereoProxy first like the chunks of the CachingReader.
+class CachingReaderSharedAudioSource : public mixxx::AudioSourceProxy {
+  public:
+    // The key is obtained from CachingReaderChunkStore::fileKey() with
+    // the channel count of the original audio source.
+    CachingReaderSharedAudioSource(
+            mixxx::AudioSourcePointer pAudioSource,
+            QString chunkStoreKey);
+    ~CachingReaderSharedAudioSource() override;
+
+  protected:
+    mixxx::ReadableSampleFrames readSampleFramesClamped(
+            const mixxx::WritableSampleFrames& writableSampleFrames) override;
+
+  private:
+    std::shared_ptr<const CachingReaderSharedChunk> sharedChunk(SINT chunkIndex);
+
+    const QString m_chunkStoreKey;
+
+    // Most requests are smaller than a chunk
+    SINT m_chunkIndex;
+    std::shared_ptr<const CachingReaderSharedChunk> m_pChunk;
+};
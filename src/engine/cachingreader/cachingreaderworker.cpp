@@ -4,13 +4,16 @@
 #include <QtDebug>
 
 #include "analyzer/analyzersilence.h"
+#include "engine/cachingreader/cachingreaderchunkstore.h"
 #include "moc_cachingreaderworker.cpp"
+#include "sources/audiosourcestereoproxy.h"
 #include "sources/soundsourceproxy.h"
 #include "track/track.h"
 #include "util/compatibility/qmutex.h"
 #include "util/event.h"
 #include "util/fifo.h"
 #include "util/logger.h"
+#include "util/math.h"
 #include "util/span.h"
 
 namespace {
@@ -20,18 +23,48 @@ mixxx::Logger kLogger("CachingReaderWorker");
 // we need the last silence frame and the first sound frame
 constexpr SINT kNumSoundFrameToVerify = 2;
 
+// Tracks up to this size are decoded into memory at once, unless configured
+// otherwise. 32 MB are about 90 seconds of stereo audio at 44.1 kHz, i.e.
+// most samples and loops.
+const ConfigKey kPreloadMaxMegabytesConfigKey{
+        QStringLiteral("[App]"), QStringLiteral("track_preload_max_megabytes")};
+constexpr int kDefaultPreloadMaxMegabytes = 32;
+// Per deck option to preload every track regardless of the size above
+const QString kPreloadWholeTrackConfigItem = QStringLiteral("preload_whole_track");
+// Upper limit for decks with the option enabled
+constexpr qint64 kMaxPreloadBytes = qint64(1024) * 1024 * 1024;
+
+// The acknowledgement consists of the generation of an update and the
+// preload slot (-1 for none) in the lowest 2 bits
+constexpr int encodePreloadAck(int generation, int slot) {
+    return (generation << 2) | (slot + 1);
+}
+
+constexpr int preloadAckGeneration(int preloadAck) {
+    return preloadAck >> 2;
+}
+
+constexpr int preloadAckSlot(int preloadAck) {
+    return (preloadAck & 0x3) - 1;
+}
+
 } // anonymous namespace
 
 CachingReaderWorker::CachingReaderWorker(
         const QString& group,
+        UserSettingsPointer pConfig,
         FIFO<CachingReaderChunkReadRequest>* pChunkReadRequestFIFO,
         FIFO<ReaderStatusUpdate>* pReaderStatusFIFO,
         mixxx::audio::ChannelCount maxSupportedChannel)
         : m_group(group),
           m_tag(QString("CachingReaderWorker %1").arg(m_group)),
+          m_pConfig(std::move(pConfig)),
           m_pChunkReadRequestFIFO(pChunkReadRequestFIFO),
           m_pReaderStatusFIFO(pReaderStatusFIFO),
-          m_maxSupportedChannel(maxSupportedChannel) {
+          m_maxSupportedChannel(maxSupportedChannel),
+          m_preloadGeneration(0),
+          m_preloadAck(encodePreloadAck(0, -1)) {
+    m_preloadSlotGenerations.fill(0);
 }
 
 ReaderStatusUpdate CachingReaderWorker::processReadRequest(
@@ -52,9 +85,8 @@ ReaderStatusUpdate CachingReaderWorker::processReadRequest(
     }
 
     // Try to read the data required for the chunk from the audio source
-    const mixxx::IndexRange bufferedFrameIndexRange = pChunk->bufferSampleFrames(
-            m_pAudioSource,
-            mixxx::SampleBuffer::WritableSlice(m_tempReadBuffer));
+    const mixxx::IndexRange bufferedFrameIndexRange =
+            bufferChunk(pChunk, chunkFrameIndexRange);
     DEBUG_ASSERT(!m_pAudioSource ||
             bufferedFrameIndexRange.isSubrangeOf(m_pAudioSource->frameIndexRange()));
     // The readable frame range might have changed
@@ -63,7 +95,19 @@ ReaderStatusUpdate CachingReaderWorker::processReadRequest(
             bufferedFrameIndexRange.isSubrangeOf(chunkFrameIndexRange));
 
     ReaderStatus status = bufferedFrameIndexRange.empty() ? CHUNK_READ_EOF : CHUNK_READ_SUCCESS;
-    if (bufferedFrameIndexRange != chunkFrameIndexRange) {
+    if (bufferedFrameIndexRange != chunkFrameIndexRange &&
+            m_pAudioSource->isShortReadTransient()) {
+        // Expected while a streamed track is still being downloaded,
+        // the source accounts for these underruns itself
+        if (kLogger.traceEnabled()) {
+            kLogger.trace()
+                    << m_group
+                    << "Chunk samples temporarily unavailable:"
+                    << "expected =" << chunkFrameIndexRange
+                    << ", actual =" << bufferedFrameIndexRange;
+        }
+        status = CHUNK_READ_PARTIAL;
+    } else if (bufferedFrameIndexRange != chunkFrameIndexRange) {
         kLogger.warning()
                 << m_group
                 << "Failed to read chunk samples for frame index range:"
@@ -84,13 +128,42 @@ ReaderStatusUpdate CachingReaderWorker::processReadRequest(
     // to further checks whether a automatic offset adjustment is possible or a the
     // sample position metadata shall be treated as outdated.
     // Failures of the sanity check only result in an entry into the log at the moment.
-    verifyFirstSound(pChunk, m_pAudioSource->getSignalInfo().getChannelCount());
+    if (status != CHUNK_READ_PARTIAL) {
+        verifyFirstSound(pChunk, m_pAudioSource->getSignalInfo().getChannelCount());
+    }
 
     ReaderStatusUpdate result;
     result.init(status, pChunk, m_pAudioSource ? m_pAudioSource->frameIndexRange() : mixxx::IndexRange());
     return result;
 }
 
+mixxx::IndexRange CachingReaderWorker::bufferChunk(
+        CachingReaderChunk* pChunk,
+        const mixxx::IndexRange& chunkFrameIndexRange) {
+    auto& chunkStore = CachingReaderChunkStore::instance();
+    if (m_chunkStoreKey.isEmpty() || !chunkStore.isShared(m_chunkStoreKey)) {
+        return pChunk->bufferSampleFrames(
+                m_pAudioSource,
+                mixxx::SampleBuffer::WritableSlice(m_tempReadBuffer));
+    }
+
+    // The file is also loaded by another reader that might have decoded
+    // the chunk already
+    auto pSharedChunk = chunkStore.lookup(m_chunkStoreKey, pChunk->getIndex());
+    if (pSharedChunk) {
+        return pChunk->referSharedSampleFrames(std::move(pSharedChunk));
+    }
+    pSharedChunk = pChunk->bufferSharedSampleFrames(
+            m_pAudioSource,
+            mixxx::SampleBuffer::WritableSlice(m_tempReadBuffer));
+    // Only complete chunks are shared, read errors are handled by each
+    // reader individually
+    if (pSharedChunk->readableSampleFrames.frameIndexRange() == chunkFrameIndexRange) {
+        chunkStore.insert(m_chunkStoreKey, pChunk->getIndex(), pSharedChunk);
+    }
+    return pSharedChunk->readableSampleFrames.frameIndexRange();
+}
+
 // WARNING: Always called from a different thread (GUI)
 #ifdef __STEM__
 void CachingReaderWorker::newTrack(TrackPointer pTrack, mixxx::StemChannelSelection stemMask) {
@@ -175,6 +248,11 @@ void CachingReaderWorker::closeAudioSource() {
         m_pAudioSource.reset();
     }
 
+    if (!m_chunkStoreKey.isEmpty()) {
+        CachingReaderChunkStore::instance().closeFile(m_chunkStoreKey);
+        m_chunkStoreKey.clear();
+    }
+
     // This function has to be called with the engine stopped only
     // to avoid collecting new requests for the old track
     DEBUG_ASSERT(!m_pChunkReadRequestFIFO->readAvailable());
@@ -183,10 +261,109 @@ void CachingReaderWorker::closeAudioSource() {
 void CachingReaderWorker::unloadTrack() {
     closeAudioSource();
 
-    const auto update = ReaderStatusUpdate::trackUnloaded();
+    publishTrackUnloaded();
+    releaseFreePreloadBuffers(-1);
+}
+
+void CachingReaderWorker::publishTrackUnloaded() {
+    const auto update = ReaderStatusUpdate::trackUnloaded(publishPreloadSlot(-1));
     m_pReaderStatusFIFO->writeBlocking(&update, 1);
 }
 
+int CachingReaderWorker::findFreePreloadSlot() const {
+    const int preloadAck = m_preloadAck.loadAcquire();
+    for (int slot = 0; slot < kPreloadSlotCount; ++slot) {
+        if (slot != preloadAckSlot(preloadAck) &&
+                m_preloadSlotGenerations[slot] <= preloadAckGeneration(preloadAck)) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+void CachingReaderWorker::releaseFreePreloadBuffers(int keepSlot) {
+    const int preloadAck = m_preloadAck.loadAcquire();
+    for (int slot = 0; slot < kPreloadSlotCount; ++slot) {
+        if (slot != keepSlot &&
+                slot != preloadAckSlot(preloadAck) &&
+                m_preloadSlotGenerations[slot] <= preloadAckGeneration(preloadAck)) {
+            mixxx::SampleBuffer().swap(m_preloadBuffers[slot]);
+        }
+    }
+}
+
+int CachingReaderWorker::publishPreloadSlot(int slot) {
+    ++m_preloadGeneration;
+    if (slot >= 0) {
+        m_preloadSlotGenerations[slot] = m_preloadGeneration;
+    }
+    return encodePreloadAck(m_preloadGeneration, slot);
+}
+
+bool CachingReaderWorker::shouldPreloadWholeTrack() const {
+    const auto signalInfo = m_pAudioSource->getSignalInfo();
+    const qint64 trackBytes = static_cast<qint64>(
+                                      signalInfo.frames2samples(m_pAudioSource->frameLength())) *
+            static_cast<qint64>(sizeof(CSAMPLE));
+    if (!m_pConfig) {
+        return trackBytes <= qint64(kDefaultPreloadMaxMegabytes) * 1024 * 1024;
+    }
+    if (m_pConfig->getValue(ConfigKey(m_group, kPreloadWholeTrackConfigItem), false)) {
+        return trackBytes <= kMaxPreloadBytes;
+    }
+    const int maxMegabytes = m_pConfig->getValue(
+            kPreloadMaxMegabytesConfigKey, kDefaultPreloadMaxMegabytes);
+    return trackBytes <= qint64(maxMegabytes) * 1024 * 1024;
+}
+
+bool CachingReaderWorker::preloadWholeTrack(mixxx::SampleBuffer* pBuffer) {
+    // Like CachingReaderChunk::bufferSampleFrames()
+    mixxx::AudioSourcePointer pAudioSource = m_pAudioSource;
+    if (pAudioSource->getSignalInfo().getChannelCount() %
+                    mixxx::audio::ChannelCount::stereo() !=
+            0) {
+        pAudioSource = std::make_shared<mixxx::AudioSourceStereoProxy>(
+                m_pAudioSource,
+                mixxx::SampleBuffer::WritableSlice(m_tempReadBuffer));
+    }
+    const auto signalInfo = pAudioSource->getSignalInfo();
+    const auto frameIndexRange = pAudioSource->frameIndexRange();
+    const SINT sampleCount = signalInfo.frames2samples(frameIndexRange.length());
+    if (pBuffer->size() != sampleCount) {
+        mixxx::SampleBuffer(sampleCount).swap(*pBuffer);
+    }
+
+    SINT frameIndex = frameIndexRange.start();
+    while (frameIndex < frameIndexRange.end()) {
+        if (m_newTrackAvailable.loadAcquire() || m_stop.loadAcquire()) {
+            return false;
+        }
+        const auto readFrameIndexRange = mixxx::IndexRange::forward(frameIndex,
+                math_min(CachingReaderChunk::kFrames, frameIndexRange.end() - frameIndex));
+        const auto readableSampleFrames = pAudioSource->readSampleFrames(
+                mixxx::WritableSampleFrames(readFrameIndexRange,
+                        mixxx::SampleBuffer::WritableSlice(*pBuffer,
+                                signalInfo.frames2samples(
+                                        frameIndex - frameIndexRange.start()),
+                                signalInfo.frames2samples(
+                                        readFrameIndexRange.length()))));
+        if (readableSampleFrames.frameIndexRange() != readFrameIndexRange) {
+            // Leave corrupt or incompletely downloaded files to the chunks
+            // that handle read errors
+            if (!pAudioSource->isShortReadTransient()) {
+                kLogger.warning()
+                        << m_group
+                        << "Failed to preload sample frames:"
+                        << "expected =" << readFrameIndexRange
+                        << ", actual =" << readableSampleFrames.frameIndexRange();
+            }
+            return false;
+        }
+        frameIndex = readFrameIndexRange.end();
+    }
+    return true;
+}
+
 #ifdef __STEM__
 void CachingReaderWorker::loadTrack(
         const TrackPointer& pTrack, mixxx::StemChannelSelection stemMask) {
@@ -204,8 +381,7 @@ void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
                 << m_group
                 << "File not found"
                 << pTrack->getFileInfo();
-        const auto update = ReaderStatusUpdate::trackUnloaded();
-        m_pReaderStatusFIFO->writeBlocking(&update, 1);
+        publishTrackUnloaded();
         emit trackLoadFailed(pTrack,
                 tr("The file '%1' could not be found.")
                         .arg(QDir::toNativeSeparators(pTrack->getLocation())));
@@ -223,8 +399,7 @@ void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
                 << m_group
                 << "Failed to open file"
                 << pTrack->getFileInfo();
-        const auto update = ReaderStatusUpdate::trackUnloaded();
-        m_pReaderStatusFIFO->writeBlocking(&update, 1);
+        publishTrackUnloaded();
         emit trackLoadFailed(pTrack,
                 tr("The file '%1' could not be loaded.")
                         .arg(QDir::toNativeSeparators(pTrack->getLocation())));
@@ -238,8 +413,7 @@ void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
             m_pAudioSource->getSignalInfo().getChannelCount() <=
                     m_maxSupportedChannel) {
         m_pAudioSource.reset(); // Close open file handles
-        const auto update = ReaderStatusUpdate::trackUnloaded();
-        m_pReaderStatusFIFO->writeBlocking(&update, 1);
+        publishTrackUnloaded();
         emit trackLoadFailed(pTrack,
                 tr("The file '%1' could not be loaded because it contains %2 "
                    "channels, and only 1 to %3 are supported.")
@@ -259,14 +433,19 @@ void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
                 << m_group
                 << "Failed to open empty file"
                 << pTrack->getFileInfo();
-        const auto update = ReaderStatusUpdate::trackUnloaded();
-        m_pReaderStatusFIFO->writeBlocking(&update, 1);
+        publishTrackUnloaded();
         emit trackLoadFailed(pTrack,
                 tr("The file '%1' is empty and could not be loaded.")
                         .arg(QDir::toNativeSeparators(pTrack->getLocation())));
         return;
     }
 
+    // Share decoded chunks with other readers of the same file
+    m_chunkStoreKey = CachingReaderChunkStore::fileKey(pTrack->getLocation(),
+            config,
+            m_pAudioSource->getSignalInfo().getChannelCount());
+    CachingReaderChunkStore::instance().openFile(m_chunkStoreKey);
+
     // Adjust the internal buffer
     const SINT tempReadBufferSize =
             m_pAudioSource->getSignalInfo().frames2samples(
@@ -275,18 +454,43 @@ void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
         mixxx::SampleBuffer(tempReadBufferSize).swap(m_tempReadBuffer);
     }
 
+    // Decode the whole track upfront if it fits into memory. The engine
+    // then copies from a contiguous buffer and no cache misses occur.
+    int preloadSlot = -1;
+    if (shouldPreloadWholeTrack()) {
+        preloadSlot = findFreePreloadSlot();
+        if (preloadSlot < 0) {
+            kLogger.info()
+                    << m_group
+                    << "Not preloading the track, because the engine has not"
+                    << "released the previous track yet";
+        } else if (!preloadWholeTrack(&m_preloadBuffers[preloadSlot])) {
+            preloadSlot = -1;
+        }
+    }
+    if (preloadSlot >= 0) {
+        // No chunks are read from a preloaded track, so other readers
+        // must not retain their chunks for it
+        CachingReaderChunkStore::instance().closeFile(m_chunkStoreKey);
+        m_chunkStoreKey.clear();
+    }
+    releaseFreePreloadBuffers(preloadSlot);
+
     const auto update =
             ReaderStatusUpdate::trackLoaded(
-                    m_pAudioSource->frameIndexRange());
+                    m_pAudioSource->frameIndexRange(),
+                    preloadSlot >= 0 ? m_preloadBuffers[preloadSlot].data() : nullptr,
+                    publishPreloadSlot(preloadSlot));
     m_pReaderStatusFIFO->writeBlocking(&update, 1);
 
     // Emit that the track is loaded.
 
     // This code is a workaround until we have found a better solution to
-    // verify and correct offsets.
+    // verify and correct offsets. The check is done when reading the chunks,
+    // so it is skipped for preloaded tracks.
     CuePointer pN60dBSound =
             pTrack->findCueByType(mixxx::CueType::N60dBSound);
-    if (pN60dBSound) {
+    if (pN60dBSound && preloadSlot < 0) {
         m_firstSoundFrameToVerify = pN60dBSound->getPosition();
     }
 
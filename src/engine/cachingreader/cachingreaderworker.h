@@ -2,11 +2,13 @@
 
 #include <QMutex>
 #include <QString>
+#include <array>
 
 #include "audio/frame.h"
 #include "audio/types.h"
 #include "engine/cachingreader/cachingreaderchunk.h"
 #include "engine/engineworker.h"
+#include "preferences/usersettings.h"
 #include "sources/audiosource.h"
 #include "track/track_decl.h"
 
@@ -30,6 +32,9 @@ enum ReaderStatus {
     CHUNK_READ_SUCCESS,
     CHUNK_READ_EOF,
     CHUNK_READ_INVALID,
+    // Some frames are temporarily unavailable, e.g. not downloaded yet.
+    // The chunk must be read again later.
+    CHUNK_READ_PARTIAL,
     CHUNK_READ_DISCARDED, // response without frame index range!
 };
 
@@ -39,6 +44,9 @@ typedef struct ReaderStatusUpdate {
     CachingReaderChunk* chunk;
     SINT readableFrameIndexRangeStart;
     SINT readableFrameIndexRangeEnd;
+    // Only for TRACK_LOADED and TRACK_UNLOADED, see CachingReaderWorker
+    const CSAMPLE* preloadedSamples;
+    int preloadAck;
 
   public:
     ReaderStatus status;
@@ -51,6 +59,8 @@ typedef struct ReaderStatusUpdate {
         chunk = chunkArg;
         readableFrameIndexRangeStart = readableFrameIndexRangeArg.start();
         readableFrameIndexRangeEnd = readableFrameIndexRangeArg.end();
+        preloadedSamples = nullptr;
+        preloadAck = 0;
     }
 
     static ReaderStatusUpdate readDiscarded(
@@ -61,16 +71,21 @@ typedef struct ReaderStatusUpdate {
     }
 
     static ReaderStatusUpdate trackLoaded(
-            const mixxx::IndexRange& readableFrameIndexRange) {
+            const mixxx::IndexRange& readableFrameIndexRange,
+            const CSAMPLE* preloadedSamples,
+            int preloadAck) {
         DEBUG_ASSERT(!readableFrameIndexRange.empty());
         ReaderStatusUpdate update;
         update.init(TRACK_LOADED, nullptr, readableFrameIndexRange);
+        update.preloadedSamples = preloadedSamples;
+        update.preloadAck = preloadAck;
         return update;
     }
 
-    static ReaderStatusUpdate trackUnloaded() {
+    static ReaderStatusUpdate trackUnloaded(int preloadAck) {
         ReaderStatusUpdate update;
         update.init(TRACK_UNLOADED, nullptr, mixxx::IndexRange());
+        update.preloadAck = preloadAck;
         return update;
     }
 
@@ -90,6 +105,17 @@ typedef struct ReaderStatusUpdate {
                 readableFrameIndexRangeStart,
                 readableFrameIndexRangeEnd);
     }
+
+    // The samples of the whole readable frame index range if the track has
+    // been preloaded, otherwise nullptr. Interleaved with the channel count
+    // of the chunks, i.e. odd channel counts are mixed to stereo.
+    const CSAMPLE* getPreloadedSamples() const {
+        return preloadedSamples;
+    }
+
+    int getPreloadAck() const {
+        return preloadAck;
+    }
 } ReaderStatusUpdate;
 
 class CachingReaderWorker : public EngineWorker {
@@ -98,6 +124,7 @@ class CachingReaderWorker : public EngineWorker {
   public:
     // Construct a CachingReader with the given group.
     CachingReaderWorker(const QString& group,
+            UserSettingsPointer pConfig,
             FIFO<CachingReaderChunkReadRequest>* pChunkReadRequestFIFO,
             FIFO<ReaderStatusUpdate>* pReaderStatusFIFO,
             mixxx::audio::ChannelCount maxSupportedChannel);
@@ -116,6 +143,12 @@ class CachingReaderWorker : public EngineWorker {
 
     void quitWait();
 
+    // Must be called from the engine thread with ReaderStatusUpdate::getPreloadAck()
+    // of every TRACK_LOADED and TRACK_UNLOADED update.
+    void acknowledgePreload(int preloadAck) {
+        m_preloadAck.storeRelease(preloadAck);
+    }
+
   signals:
     // Emitted once a new track is loaded and ready to be read from.
     void trackLoading();
@@ -134,6 +167,7 @@ class CachingReaderWorker : public EngineWorker {
 #endif
     const QString m_group;
     QString m_tag;
+    const UserSettingsPointer m_pConfig;
 
     // Thread-safe FIFOs for communication between the engine callback and
     // reader thread.
@@ -167,6 +201,27 @@ class CachingReaderWorker : public EngineWorker {
     void loadTrack(const TrackPointer& pTrack);
 #endif
 
+    // Writes TRACK_UNLOADED to the status FIFO
+    void publishTrackUnloaded();
+
+    bool shouldPreloadWholeTrack() const;
+    // Decodes the whole track into the buffer. Returns false if decoding
+    // fails or is interrupted by a new track.
+    bool preloadWholeTrack(mixxx::SampleBuffer* pBuffer);
+
+    // Returns a preload buffer that is no longer accessed by the engine or
+    // -1 if none is available.
+    int findFreePreloadSlot() const;
+    void releaseFreePreloadBuffers(int keepSlot);
+    // Returns the acknowledgement for the update that publishes the slot
+    int publishPreloadSlot(int slot);
+
+    // Reads the samples of a chunk or refers to the samples that another
+    // reader of the same file has already decoded
+    mixxx::IndexRange bufferChunk(
+            CachingReaderChunk* pChunk,
+            const mixxx::IndexRange& chunkFrameIndexRange);
+
     ReaderStatusUpdate processReadRequest(
             const CachingReaderChunkReadRequest& request);
 
@@ -176,6 +231,9 @@ class CachingReaderWorker : public EngineWorker {
     // The current audio source of the track loaded
     mixxx::AudioSourcePointer m_pAudioSource;
 
+    // Identifies the file of the audio source in the CachingReaderChunkStore
+    QString m_chunkStoreKey;
+
     mixxx::audio::FramePos m_firstSoundFrameToVerify;
 
     // Temporary buffer for reading samples from all channels
@@ -185,5 +243,16 @@ class CachingReaderWorker : public EngineWorker {
     // The maximum number of channel that this reader can support
     mixxx::audio::ChannelCount m_maxSupportedChannel;
 
+    // Buffers for whole track preloading. The engine keeps reading from the
+    // previous buffer until it has received the update of the next track,
+    // so a buffer must only be reused after the engine has acknowledged an
+    // update that has been published after it.
+    static constexpr int kPreloadSlotCount = 2;
+    std::array<mixxx::SampleBuffer, kPreloadSlotCount> m_preloadBuffers;
+    std::array<int, kPreloadSlotCount> m_preloadSlotGenerations;
+    int m_preloadGeneration;
+    // The generation and slot of the last update processed by the engine
+    QAtomicInt m_preloadAck;
+
     QAtomicInt m_stop;
 };
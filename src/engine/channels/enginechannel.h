@@ -63,6 +63,25 @@ class EngineChannel : public EngineObject {
         m_channelIndex = channelIndex;
     }
 
+    // Whether process() only touches the state of this channel and may run on
+    // an engine worker thread, concurrently with other channels.
+    virtual bool canProcessConcurrently() const {
+        return false;
+    }
+
+    // Called on the engine thread before a process() that runs concurrently.
+    // Work that affects other channels has to be done here.
+    virtual void prepareConcurrentProcess() {
+    }
+
+    // Called on the engine thread after a process() that has run concurrently
+    // with the same buffer. Work that uses state shared with other channels,
+    // like the effect chains, has to be done here.
+    virtual void finishConcurrentProcess(CSAMPLE* pOutput, const std::size_t bufferSize) {
+        Q_UNUSED(pOutput);
+        Q_UNUSED(bufferSize);
+    }
+
     virtual void postProcessLocalBpm() {
     }
 
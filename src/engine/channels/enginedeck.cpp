@@ -27,7 +27,10 @@ EngineDeck::EngineDeck(
           m_pConfig(pConfig),
 #ifdef __STEM__
           m_stemClonedState(false),
+          m_bStemMixPending(false),
 #endif
+          m_bConcurrentProcess(false),
+          m_bEffectsPending(false),
           m_pInputConfigured(new ControlObject(ConfigKey(getGroup(), "input_configured"))),
           m_pPassing(new ControlPushButton(ConfigKey(getGroup(), "passthrough"))) {
     m_pInputConfigured->setReadOnly();
@@ -132,11 +135,10 @@ void EngineDeck::processStem(CSAMPLE* pOut, const std::size_t bufferSize) {
     mixxx::audio::SampleRate sampleRate = mixxx::audio::SampleRate::fromDouble(m_sampleRate.get());
     unsigned int stemCount = chCount / mixxx::kEngineChannelOutputCount;
     SINT numFrames = bufferSize / mixxx::kEngineChannelOutputCount;
-    std::size_t allChannelBufferSize = bufferSize * stemCount;
-    if (m_stemBuffer.size() < static_cast<SINT>(allChannelBufferSize)) {
-        m_stemBuffer = mixxx::SampleBuffer(allChannelBufferSize);
+    VERIFY_OR_DEBUG_ASSERT(m_stemBuffer.size() >= static_cast<SINT>(bufferSize * stemCount)) {
+        SampleUtil::clear(pOut, bufferSize);
+        return;
     }
-    m_pBuffer->process(m_stemBuffer.data(), allChannelBufferSize);
 
     CSAMPLE* pIn = m_stemBuffer.data();
 
@@ -220,6 +222,18 @@ void EngineDeck::cloneStemState(const EngineDeck* deckToClone) {
 #endif
 
 void EngineDeck::process(CSAMPLE* pOut, const std::size_t bufferSize) {
+    if (!processInput(pOut, bufferSize)) {
+        return;
+    }
+    if (m_bConcurrentProcess) {
+        // Running on an engine worker thread
+        m_bEffectsPending = true;
+        return;
+    }
+    processEffects(pOut, bufferSize);
+}
+
+bool EngineDeck::processInput(CSAMPLE* pOut, const std::size_t bufferSize) {
     // Feed the incoming audio through if passthrough is active
     const CSAMPLE* sampleBuffer = m_sampleBuffer; // save pointer on stack
     if (isPassthroughActive() && sampleBuffer) {
@@ -227,29 +241,47 @@ void EngineDeck::process(CSAMPLE* pOut, const std::size_t bufferSize) {
         m_bPassthroughWasActive = true;
         m_sampleBuffer = nullptr;
         m_pPregain->setSpeedAndScratching(1, false);
-    } else {
-        // If passthrough is no longer enabled, zero out the buffer
-        if (m_bPassthroughWasActive) {
-            SampleUtil::clear(pOut, bufferSize);
-            m_bPassthroughWasActive = false;
-            return;
-        }
+        return true;
+    }
+    // If passthrough is no longer enabled, zero out the buffer
+    if (m_bPassthroughWasActive) {
+        SampleUtil::clear(pOut, bufferSize);
+        m_bPassthroughWasActive = false;
+        return false;
+    }
 
 #ifdef __STEM__
-        // Process the raw audio
-        if (m_pBuffer->getChannelCount() <= mixxx::kEngineChannelOutputCount) {
-            // Process a single mono or stereo channel
+    // Process the raw audio
+    const mixxx::audio::ChannelCount chCount = m_pBuffer->getChannelCount();
+    if (chCount <= mixxx::kEngineChannelOutputCount) {
+        // Process a single mono or stereo channel
 #endif
-            m_pBuffer->process(pOut, bufferSize);
+        m_pBuffer->process(pOut, bufferSize);
 #ifdef __STEM__
-        } else {
-            // Process multiple stereo channels (stems) and mix them together
-            processStem(pOut, bufferSize);
+    } else {
+        // Read multiple stereo channels (stems), they are mixed together
+        // by processStem()
+        const std::size_t allChannelBufferSize =
+                bufferSize * (chCount / mixxx::kEngineChannelOutputCount);
+        if (m_stemBuffer.size() < static_cast<SINT>(allChannelBufferSize)) {
+            m_stemBuffer = mixxx::SampleBuffer(allChannelBufferSize);
         }
+        m_pBuffer->process(m_stemBuffer.data(), allChannelBufferSize);
+        m_bStemMixPending = true;
+    }
 #endif
-        m_pPregain->setSpeedAndScratching(m_pBuffer->getSpeed(), m_pBuffer->getScratching());
-        m_bPassthroughWasActive = false;
+    m_pPregain->setSpeedAndScratching(m_pBuffer->getSpeed(), m_pBuffer->getScratching());
+    return true;
+}
+
+void EngineDeck::processEffects(CSAMPLE* pOut, const std::size_t bufferSize) {
+#ifdef __STEM__
+    if (m_bStemMixPending) {
+        m_bStemMixPending = false;
+        // The quick effects of the stems are applied while mixing
+        processStem(pOut, bufferSize);
     }
+#endif
 
     // Apply pregain
     m_pPregain->process(pOut, bufferSize);
@@ -273,6 +305,19 @@ void EngineDeck::collectFeatures(GroupFeatureState* pGroupFeatures) const {
     m_pPregain->collectFeatures(pGroupFeatures);
 }
 
+void EngineDeck::prepareConcurrentProcess() {
+    m_pBuffer->prepareConcurrentProcess();
+    m_bConcurrentProcess = true;
+}
+
+void EngineDeck::finishConcurrentProcess(CSAMPLE* pOut, const std::size_t bufferSize) {
+    m_bConcurrentProcess = false;
+    if (m_bEffectsPending) {
+        m_bEffectsPending = false;
+        processEffects(pOut, bufferSize);
+    }
+}
+
 void EngineDeck::postProcessLocalBpm() {
     m_pBuffer->postProcessLocalBpm();
 }
@@ -29,6 +29,15 @@ class EngineDeck : public EngineChannel, public AudioDestination {
     void process(CSAMPLE* pOutput, const std::size_t bufferSize) override;
     void collectFeatures(GroupFeatureState* pGroupFeatures) const override;
 
+    // Interactions with the EngineSync are moved to prepareConcurrentProcess().
+    // The effect chains are not safe to run on several threads, they are
+    // applied in finishConcurrentProcess().
+    bool canProcessConcurrently() const override {
+        return true;
+    }
+    void prepareConcurrentProcess() override;
+    void finishConcurrentProcess(CSAMPLE* pOutput, const std::size_t bufferSize) override;
+
     // postProcessLocalBpm() is called on all decks to update the localBpm after
     // process() is done. Updated localBpms for all decks are required for the
     // postProcess() step, to avoid issues with the order they are processed.
@@ -85,8 +94,15 @@ class EngineDeck : public EngineChannel, public AudioDestination {
 #endif
 
   private:
+    // Reads the passthrough input or the track. Returns false if the output
+    // is silence that needs no further processing.
+    bool processInput(CSAMPLE* pOutput, const std::size_t bufferSize);
+    // Mixes the stems, applies the pregain, the prefader effects and feeds
+    // the VU meter
+    void processEffects(CSAMPLE* pOutput, const std::size_t bufferSize);
+
 #ifdef __STEM__
-    // Process multiple channels and mix them together into the passed buffer
+    // Mix the channels read into m_stemBuffer together into the passed buffer
     void processStem(CSAMPLE* pOutput, const std::size_t bufferSize);
 #endif
 
@@ -104,8 +120,14 @@ class EngineDeck : public EngineChannel, public AudioDestination {
     std::vector<std::unique_ptr<ControlPotmeter>> m_stemGain;
     std::vector<std::unique_ptr<ControlPushButton>> m_stemMute;
     bool m_stemClonedState;
+    // The track has been read into m_stemBuffer and still has to be mixed
+    bool m_bStemMixPending;
 #endif
 
+    // Set by prepareConcurrentProcess() until finishConcurrentProcess()
+    bool m_bConcurrentProcess;
+    bool m_bEffectsPending;
+
     // Begin vinyl passthrough fields
     QScopedPointer<ControlObject> m_pInputConfigured;
     ControlPushButton* m_pPassing;
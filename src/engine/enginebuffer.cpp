@@ -92,6 +92,7 @@ EngineBuffer::EngineBuffer(const QString& group,
           m_iSeekPhaseQueued(0),
           m_iEnableSyncQueued(SYNC_REQUEST_NONE),
           m_iSyncModeQueued(static_cast<int>(SyncMode::Invalid)),
+          m_bConcurrentProcessPrepared(false),
           m_slipQuitAndAdopt(0),
           m_bPlayAfterLoading(false),
           m_channelCount(mixxx::kEngineChannelOutputCount),
@@ -279,6 +280,11 @@ EngineBuffer::EngineBuffer(const QString& group,
     m_pScaleST = new EngineBufferScaleST(m_pReadAheadManager);
 #ifdef __RUBBERBAND__
     m_pScaleRB = new EngineBufferScaleRubberBand(m_pReadAheadManager);
+    m_pKeylockLookAhead = new ControlProxy(kAppGroup, QStringLiteral("keylock_lookahead"), this);
+    m_pKeylockLookAhead->connectValueChanged(this,
+            &EngineBuffer::slotKeylockLookAheadChanged,
+            Qt::DirectConnection);
+    slotKeylockLookAheadChanged(m_pKeylockLookAhead->get());
 #endif
     slotKeylockEngineChanged(m_pKeylockEngine->get());
     m_pScaleVinyl = m_pScaleLinear;
@@ -886,6 +892,12 @@ void EngineBuffer::slotKeylockEngineChanged(double dIndex) {
     }
 }
 
+#ifdef __RUBBERBAND__
+void EngineBuffer::slotKeylockLookAheadChanged(double value) {
+    m_pScaleRB->setLookAheadEnabled(value > 0.0);
+}
+#endif
+
 void EngineBuffer::slipQuitAndAdopt() {
     m_slipQuitAndAdopt.storeRelease(1);
     m_pSlipButton->set(0);
@@ -904,7 +916,9 @@ void EngineBuffer::processTrackLocked(
     }
 
     // Sync requests can affect rate, so process those first.
-    processSyncRequests();
+    if (!m_bConcurrentProcessPrepared) {
+        processSyncRequests();
+    }
 
     // Note: play is also active during cue preview
     bool paused = !m_playButton->toBool();
@@ -1269,12 +1283,23 @@ void EngineBuffer::process(CSAMPLE* pOutput, const std::size_t bufferSize) {
     }
 #endif
 
-    m_pSyncControl->updateAudible();
+    if (m_bConcurrentProcessPrepared) {
+        m_bConcurrentProcessPrepared = false;
+    } else {
+        m_pSyncControl->updateAudible();
+    }
 
     m_lastBufferSize = bufferSize;
     m_bCrossfadeReady = false;
 }
 
+void EngineBuffer::prepareConcurrentProcess() {
+    processSyncRequests();
+    // May pick a new sync leader
+    m_pSyncControl->updateAudible();
+    m_bConcurrentProcessPrepared = true;
+}
+
 void EngineBuffer::processSlip(std::size_t bufferSize) {
     // Do a single read from m_bSlipEnabled so we don't run in to race conditions.
     bool enabled = m_pSlipButton->toBool();
@@ -1574,6 +1599,7 @@ void EngineBuffer::hintReader(const double dRate) {
     for (const auto& pControl : std::as_const(m_engineControls)) {
         pControl->hintReader(&m_hintList);
     }
+    m_pReader->adaptChunkBudget(dRate, m_channelCount);
     m_pReader->hintAndMaybeWake(m_hintList);
 }
 
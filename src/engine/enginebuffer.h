@@ -145,6 +145,9 @@ class EngineBuffer : public EngineObject {
     void processSlip(std::size_t bufferSize);
     void postProcessLocalBpm();
     void postProcess(const std::size_t bufferSize);
+    // Processes the sync requests and audible state changes on the engine
+    // thread, the following process() skips them and may run on a worker.
+    void prepareConcurrentProcess();
 
     /// Returns the seek position iff a seek is currently queued but not yet
     /// processed. If no seek was queued, and invalid frame position is returned.
@@ -255,6 +258,9 @@ class EngineBuffer : public EngineObject {
     void slotControlEnd(double);
     void slotControlSeek(double);
     void slotKeylockEngineChanged(double);
+#ifdef __RUBBERBAND__
+    void slotKeylockLookAheadChanged(double);
+#endif
 
   signals:
     void trackLoaded(TrackPointer pNewTrack, TrackPointer pOldTrack);
@@ -427,6 +433,9 @@ class EngineBuffer : public EngineObject {
     ControlPotmeter* m_playposSlider;
     ControlProxy* m_pSampleRate;
     ControlProxy* m_pKeylockEngine;
+#ifdef __RUBBERBAND__
+    ControlProxy* m_pKeylockLookAhead;
+#endif
     ControlPushButton* m_pKeylock;
     ControlProxy* m_pReplayGain;
 
@@ -474,6 +483,8 @@ class EngineBuffer : public EngineObject {
     QAtomicInt m_iSeekPhaseQueued;
     QAtomicInt m_iEnableSyncQueued;
     QAtomicInt m_iSyncModeQueued;
+    // Set by prepareConcurrentProcess() for the next process() only
+    bool m_bConcurrentProcessPrepared;
     ControlValueAtomic<QueuedSeek> m_queuedSeek;
     bool m_previousBufferSeek = false;
 
@@ -13,6 +13,8 @@
 #include "engine/effects/engineeffectsmanager.h"
 #include "engine/enginebuffer.h"
 #include "engine/enginedelay.h"
+#include "engine/engineprocessingpool.h"
+#include "engine/engineprofiler.h"
 #include "engine/enginetalkoverducking.h"
 #include "engine/enginevumeter.h"
 #include "engine/engineworkerscheduler.h"
@@ -24,7 +26,9 @@
 #include "preferences/configobject.h"
 #include "preferences/usersettings.h"
 #include "util/defs.h"
+#include "util/math.h"
 #include "util/parented_ptr.h"
+#include "util/performancetimer.h"
 #include "util/sample.h"
 #include "util/samplebuffer.h"
 
@@ -34,6 +38,9 @@ const QString kLegacyGroup = QStringLiteral("[Master]");
 const QString kMainGroup = QStringLiteral("[Main]");
 
 const ConfigKey kInternalClockBpmKey{QStringLiteral("[InternalClock]"), QStringLiteral("bpm")};
+// The number of threads that process channels in parallel with the audio
+// callback thread. 0 processes all channels on the callback thread.
+const ConfigKey kEngineWorkerCountKey{kAppGroup, QStringLiteral("engine_worker_count")};
 } // namespace
 
 EngineMixer::EngineMixer(UserSettingsPointer pConfig,
@@ -52,6 +59,7 @@ EngineMixer::EngineMixer(UserSettingsPointer pConfig,
                   ConfigKey(group, "booth_enabled"))),
           m_pChannelHandleFactory(pChannelHandleFactory),
           m_pEngineEffectsManager(pEffectsManager->getEngineEffectsManager()),
+          m_concurrentBufferSize(0),
           m_outputBusBuffers({mixxx::SampleBuffer(kMaxEngineSamples),
                   mixxx::SampleBuffer(kMaxEngineSamples),
                   mixxx::SampleBuffer(kMaxEngineSamples)}),
@@ -129,6 +137,8 @@ EngineMixer::EngineMixer(UserSettingsPointer pConfig,
                   static_cast<double>(pConfig->getValue(
                           ConfigKey(group, "keylock_engine"),
                           EngineBuffer::defaultKeylockEngine())))),
+          m_pKeylockLookAhead(std::make_unique<ControlPushButton>(
+                  ConfigKey(kAppGroup, QStringLiteral("keylock_lookahead")), true)),
           m_mainGainOld(0.0),
           m_boothGainOld(0.0),
           m_headphoneMainGainOld(0.0),
@@ -147,7 +157,8 @@ EngineMixer::EngineMixer(UserSettingsPointer pConfig,
           m_pMainMonoMixdown(std::make_unique<ControlObject>(
                   ConfigKey(group, "mono_mixdown"), true, false, true)),
           m_pMicMonitorMode(std::make_unique<ControlObject>(
-                  ConfigKey(group, "talkover_mix"), true, false, true)) {
+                  ConfigKey(group, "talkover_mix"), true, false, true)),
+          m_pProfiler(std::make_unique<EngineProfiler>()) {
     pEffectsManager->registerInputChannel(m_mainHandle);
     pEffectsManager->registerInputChannel(m_headphoneHandle);
     pEffectsManager->registerOutputChannel(m_mainHandle);
@@ -164,6 +175,14 @@ EngineMixer::EngineMixer(UserSettingsPointer pConfig,
     m_bExternalRecordBroadcastInputConnected = false;
     m_pWorkerScheduler->start(QThread::HighPriority);
 
+    // Leave one core for the audio callback thread
+    const int engineWorkerCount = math_min(
+            pConfig->getValue(kEngineWorkerCountKey, 0),
+            QThread::idealThreadCount() - 1);
+    if (engineWorkerCount > 0) {
+        m_pProcessingPool = std::make_unique<EngineProcessingPool>(engineWorkerCount);
+    }
+
     m_pSampleRate->addAlias(ConfigKey(group, QStringLiteral("samplerate")));
     m_pSampleRate->set(44100.);
 
@@ -189,6 +208,7 @@ EngineMixer::EngineMixer(UserSettingsPointer pConfig,
     m_pHeadMix->set(-1.);
 
     m_pHeadSplitEnabled->setButtonMode(mixxx::control::ButtonMode::Toggle);
+    m_pKeylockLookAhead->setButtonMode(mixxx::control::ButtonMode::Toggle);
     m_pHeadSplitEnabled->set(0.0);
 
     // zero out otherwise uninitialized buffers
@@ -231,8 +251,11 @@ std::span<const CSAMPLE> EngineMixer::getSidechainBuffer() const {
 }
 
 void EngineMixer::processChannels(std::size_t bufferSize) {
-    // Update internal sync lock rate.
-    m_pEngineSync->onCallbackStart(m_sampleRate, bufferSize);
+    {
+        // Update internal sync lock rate.
+        EngineProfiler::ScopedStage stage(m_pProfiler.get(), EngineProfiler::Stage::Sync);
+        m_pEngineSync->onCallbackStart(m_sampleRate, bufferSize);
+    }
 
     m_activeBusChannels[EngineChannel::LEFT].clear();
     m_activeBusChannels[EngineChannel::CENTER].clear();
@@ -241,7 +264,6 @@ void EngineMixer::processChannels(std::size_t bufferSize) {
     m_activeTalkoverChannels.clear();
     m_activeChannels.clear();
 
-    // ScopedTimer timer(QStringLiteral("EngineMixer::processChannels"));
     EngineChannel* pLeaderChannel = m_pEngineSync->getLeaderChannel();
     // Reserve the first place for the main channel which
     // should be processed first
@@ -319,38 +341,39 @@ void EngineMixer::processChannels(std::size_t bufferSize) {
     }
 
     // Now that the list is built and ordered, do the processing.
-    for (int i = activeChannelsStartIndex; i < m_activeChannels.size(); ++i) {
-        ChannelInfo* pChannelInfo = m_activeChannels[i];
-        auto& pChannel = pChannelInfo->m_pChannel;
-        DEBUG_ASSERT(pChannelInfo->m_pBuffer.size() >= static_cast<SINT>(bufferSize));
-        pChannel->process(pChannelInfo->m_pBuffer.data(), bufferSize);
-
-        // Collect metadata for effects
-        if (m_pEngineEffectsManager) {
-            GroupFeatureState features;
-            pChannel->collectFeatures(&features);
-            pChannelInfo->m_features = features;
+    {
+        EngineProfiler::ScopedStage stage(m_pProfiler.get(), EngineProfiler::Stage::Channels);
+        if (m_pProcessingPool) {
+            processChannelsConcurrently(activeChannelsStartIndex, bufferSize);
+        } else {
+            for (int i = activeChannelsStartIndex; i < m_activeChannels.size(); ++i) {
+                processChannel(m_activeChannels[i], bufferSize);
+            }
         }
     }
-    // Do internal sync lock post-processing before the other
-    // channels.
-    // Note, because we call this on the internal clock first,
-    // it will have an up-to-date beatDistance, whereas the other
-    // Syncables will not.
-    m_pEngineSync->onCallbackEnd(m_sampleRate, bufferSize);
-
-    // After all engines have been processed, trigger updates of local bpm values
-    // which may have changed based on track position
-    std::for_each(m_activeChannels.cbegin() + activeChannelsStartIndex,
-            m_activeChannels.cend(),
-            [](const auto& pChannelInfo) {
-                pChannelInfo->m_pChannel->postProcessLocalBpm();
-            });
+    {
+        EngineProfiler::ScopedStage stage(m_pProfiler.get(), EngineProfiler::Stage::Sync);
+        // Do internal sync lock post-processing before the other
+        // channels.
+        // Note, because we call this on the internal clock first,
+        // it will have an up-to-date beatDistance, whereas the other
+        // Syncables will not.
+        m_pEngineSync->onCallbackEnd(m_sampleRate, bufferSize);
+
+        // After all engines have been processed, trigger updates of local bpm values
+        // which may have changed based on track position
+        std::for_each(m_activeChannels.cbegin() + activeChannelsStartIndex,
+                m_activeChannels.cend(),
+                [](const auto& pChannelInfo) {
+                    pChannelInfo->m_pChannel->postProcessLocalBpm();
+                });
+    }
 
     // After local bpms are updated, trigger the rest of the post-processing
     // which ensures that all channels are updating certain values at the
     // same point in time. This prevents sync from failing depending on
     // if the sync target was processed before or after the sync origin.
+    EngineProfiler::ScopedStage stage(m_pProfiler.get(), EngineProfiler::Stage::Channels);
     std::for_each(m_activeChannels.cbegin() + activeChannelsStartIndex,
             m_activeChannels.cend(),
             [bufferSize](const auto& pChannelInfo) {
@@ -358,6 +381,65 @@ void EngineMixer::processChannels(std::size_t bufferSize) {
             });
 }
 
+void EngineMixer::processChannel(ChannelInfo* pChannelInfo, std::size_t bufferSize) {
+    PerformanceTimer timer;
+    timer.start();
+    auto& pChannel = pChannelInfo->m_pChannel;
+    DEBUG_ASSERT(pChannelInfo->m_pBuffer.size() >= static_cast<SINT>(bufferSize));
+    pChannel->process(pChannelInfo->m_pBuffer.data(), bufferSize);
+    collectChannelFeatures(pChannelInfo);
+    m_pProfiler->addChannelTime(pChannelInfo->m_index, timer.elapsed());
+}
+
+void EngineMixer::collectChannelFeatures(ChannelInfo* pChannelInfo) {
+    // Collect metadata for effects
+    if (m_pEngineEffectsManager) {
+        GroupFeatureState features;
+        pChannelInfo->m_pChannel->collectFeatures(&features);
+        pChannelInfo->m_features = features;
+    }
+}
+
+void EngineMixer::processChannelsConcurrently(
+        int activeChannelsStartIndex, std::size_t bufferSize) {
+    m_concurrentChannels.clear();
+    for (int i = activeChannelsStartIndex; i < m_activeChannels.size(); ++i) {
+        ChannelInfo* pChannelInfo = m_activeChannels[i];
+        // The sync leader at index 0 must be done before the followers start
+        if (i > 0 && pChannelInfo->m_pChannel->canProcessConcurrently()) {
+            pChannelInfo->m_pChannel->prepareConcurrentProcess();
+            m_concurrentChannels.append(pChannelInfo);
+        } else {
+            processChannel(pChannelInfo, bufferSize);
+        }
+    }
+
+    m_concurrentBufferSize = bufferSize;
+    m_pProcessingPool->run(static_cast<int>(m_concurrentChannels.size()),
+            [](void* pContext, int taskIndex) {
+                auto* pEngineMixer = static_cast<EngineMixer*>(pContext);
+                ChannelInfo* pChannelInfo = pEngineMixer->m_concurrentChannels[taskIndex];
+                PerformanceTimer timer;
+                timer.start();
+                pChannelInfo->m_pChannel->process(pChannelInfo->m_pBuffer.data(),
+                        pEngineMixer->m_concurrentBufferSize);
+                pEngineMixer->m_pProfiler->addChannelTime(
+                        pChannelInfo->m_index, timer.elapsed());
+            },
+            this);
+
+    // The channel effects share state between the channels and are
+    // processed in order on this thread
+    for (ChannelInfo* pChannelInfo : std::as_const(m_concurrentChannels)) {
+        PerformanceTimer timer;
+        timer.start();
+        pChannelInfo->m_pChannel->finishConcurrentProcess(
+                pChannelInfo->m_pBuffer.data(), bufferSize);
+        collectChannelFeatures(pChannelInfo);
+        m_pProfiler->addChannelTime(pChannelInfo->m_index, timer.elapsed());
+    }
+}
+
 void EngineMixer::process(const std::size_t bufferSize) {
     DEBUG_ASSERT(bufferSize <= static_cast<int>(kMaxEngineSamples));
 
@@ -367,6 +449,7 @@ void EngineMixer::process(const std::size_t bufferSize) {
         haveSetName = true;
     }
     // Trace t("EngineMixer::process");
+    m_pProfiler->beginCallback();
 
     bool mainEnabled = m_pMainEnabled->toBool();
     bool boothEnabled = m_pBoothEnabled->toBool();
@@ -400,6 +483,7 @@ void EngineMixer::process(const std::size_t bufferSize) {
     m_headphoneGain.setGain(pflMixGainInHeadphones);
 
     if (headphoneEnabled) {
+        EngineProfiler::ScopedStage stage(m_pProfiler.get(), EngineProfiler::Stage::Headphones);
         // Process effects and mix PFL channels together for the headphones.
         // Effects will be reprocessed post-fader for the crossfader buses
         // and main mix, so the channel input buffers cannot be modified here.
@@ -435,22 +519,26 @@ void EngineMixer::process(const std::size_t bufferSize) {
         }
     }
 
-    // Mix all the talkover enabled channels together.
-    // Effects processing is done in place to avoid unnecessary buffer copying.
-    ChannelMixer::applyEffectsInPlaceAndMixChannels(
-            m_talkoverGain,
-            m_activeTalkoverChannels,
-            &m_channelTalkoverGainCache,
-            m_talkover.data(),
-            m_mainHandle.handle(),
-            bufferSize,
-            m_sampleRate,
-            m_pEngineEffectsManager);
+    {
+        EngineProfiler::ScopedStage stage(m_pProfiler.get(), EngineProfiler::Stage::ChannelMix);
+        // Mix all the talkover enabled channels together.
+        // Effects processing is done in place to avoid unnecessary buffer copying.
+        ChannelMixer::applyEffectsInPlaceAndMixChannels(
+                m_talkoverGain,
+                m_activeTalkoverChannels,
+                &m_channelTalkoverGainCache,
+                m_talkover.data(),
+                m_mainHandle.handle(),
+                bufferSize,
+                m_sampleRate,
+                m_pEngineEffectsManager);
+    }
 
     // Process effects on all microphones mixed together
     // We have no metadata for mixed effect buses, so use an empty GroupFeatureState.
     GroupFeatureState busFeatures;
     if (m_pEngineEffectsManager) {
+        EngineProfiler::ScopedStage stage(m_pProfiler.get(), EngineProfiler::Stage::BusEffects);
         m_pEngineEffectsManager->processPostFaderInPlace(
                 m_busTalkoverHandle.handle(),
                 m_mainHandle.handle(),
@@ -493,6 +581,7 @@ void EngineMixer::process(const std::size_t bufferSize) {
     m_mainGain.setGains(crossfaderLeftGain, 1.0f, crossfaderRightGain);
 
     for (int o = EngineChannel::LEFT; o <= EngineChannel::RIGHT; o++) {
+        EngineProfiler::ScopedStage stage(m_pProfiler.get(), EngineProfiler::Stage::ChannelMix);
         ChannelMixer::applyEffectsInPlaceAndMixChannels(m_mainGain,
                 m_activeBusChannels[o],
                 &m_channelMainGainCache, // no [o] because the old gain
@@ -506,6 +595,7 @@ void EngineMixer::process(const std::size_t bufferSize) {
 
     // Process crossfader orientation bus channel effects
     if (m_pEngineEffectsManager) {
+        EngineProfiler::ScopedStage stage(m_pProfiler.get(), EngineProfiler::Stage::BusEffects);
         m_pEngineEffectsManager->processPostFaderInPlace(
                 m_busCrossfaderLeftHandle.handle(),
                 m_mainHandle.handle(),
@@ -730,12 +820,14 @@ void EngineMixer::process(const std::size_t bufferSize) {
         // EngineSideChain::receiveBuffer has copied the input buffer to m_pSidechainMix
         // via before (called by SoundManager::pushInputBuffers())
         if (m_pEngineSideChain) {
+            EngineProfiler::ScopedStage stage(m_pProfiler.get(), EngineProfiler::Stage::Sidechain);
             m_pEngineSideChain->writeSamples(m_sidechainMix.data(), iFrames);
         }
 
         // Process effects that apply to main hardware output only but not
         // record/broadcast signal
         if (m_pEngineEffectsManager) {
+            EngineProfiler::ScopedStage stage(m_pProfiler.get(), EngineProfiler::Stage::BusEffects);
             GroupFeatureState mainFeatures;
             mainFeatures.gain = m_pMainGain->get();
             m_pEngineEffectsManager->processPostFaderInPlace(
@@ -794,11 +886,16 @@ void EngineMixer::process(const std::size_t bufferSize) {
     // We're close to the end of the callback. Wake up the engine worker
     // scheduler so that it runs the workers.
     m_pWorkerScheduler->runWorkers();
+
+    m_pProfiler->endCallback(m_sampleRate.isValid()
+                    ? mixxx::Duration::fromSeconds(iFrames / m_sampleRate.toDouble())
+                    : mixxx::Duration());
 }
 
 void EngineMixer::applyMainEffects(std::size_t bufferSize) {
     // Apply main effects
     if (m_pEngineEffectsManager) {
+        EngineProfiler::ScopedStage stage(m_pProfiler.get(), EngineProfiler::Stage::BusEffects);
         GroupFeatureState mainFeatures;
         mainFeatures.gain = m_pMainGain->get();
         m_pEngineEffectsManager->processPostFaderInPlace(m_mainHandle.handle(),
@@ -816,6 +913,7 @@ void EngineMixer::applyMainEffects(std::size_t bufferSize) {
 void EngineMixer::processHeadphones(
         const CSAMPLE_GAIN mainMixGainInHeadphones,
         std::size_t bufferSize) {
+    EngineProfiler::ScopedStage stage(m_pProfiler.get(), EngineProfiler::Stage::Headphones);
     // Add main mix to headphones
     SampleUtil::addWithRampingGain(
             m_head.data(),
@@ -853,6 +951,7 @@ void EngineMixer::addChannel(std::unique_ptr<EngineChannel> pChannel) {
     auto pChannelInfo = std::make_unique<ChannelInfo>(m_channels.size());
     pChannel->setChannelIndex(pChannelInfo->m_index);
     const QString& group = pChannel->getGroup();
+    m_pProfiler->setChannelName(pChannelInfo->m_index, group);
     // take ownership of the pointer explicitly
     pChannelInfo->m_pChannel = std::move(pChannel);
     pChannelInfo->m_handle = m_pChannelHandleFactory->getOrCreateHandle(group);
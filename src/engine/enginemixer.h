@@ -22,6 +22,8 @@
 #include "util/types.h"
 
 class EngineWorkerScheduler;
+class EngineProcessingPool;
+class EngineProfiler;
 class EngineVuMeter;
 class ControlPotmeter;
 class ControlPushButton;
@@ -99,6 +101,11 @@ class EngineMixer : public QObject, public AudioSource {
         return m_pEngineSync.get();
     }
 
+    // The timing of the callbacks of this engine
+    EngineProfiler* getProfiler() const {
+        return m_pProfiler.get();
+    }
+
     // These are really only exposed for tests to use.
     std::span<const CSAMPLE> getMainBuffer() const;
     std::span<const CSAMPLE> getBoothBuffer() const;
@@ -257,8 +264,18 @@ class EngineMixer : public QObject, public AudioSource {
     // first and all others are processed after. Populates m_activeChannels,
     // m_activeBusChannels, m_activeHeadphoneChannels, and
     // m_activeTalkoverChannels with each channel that is active for the
-    // respective output.
+    // respective output. If engine workers are configured the channels are
+    // processed in parallel after the sync lock channel. The post-processing
+    // always runs in order on the calling thread.
     void processChannels(std::size_t bufferSize);
+    // Processes the channel and collects its features for the effects
+    void processChannel(ChannelInfo* pChannelInfo, std::size_t bufferSize);
+    void collectChannelFeatures(ChannelInfo* pChannelInfo);
+    // Processes the given active channels in parallel on the
+    // m_pProcessingPool. Channels that cannot be processed concurrently
+    // are processed in order on the calling thread, as well as the channel
+    // effects of all channels after the parallel part has finished.
+    void processChannelsConcurrently(int activeChannelsStartIndex, std::size_t bufferSize);
 
     ChannelHandleFactoryPointer m_pChannelHandleFactory;
     void applyMainEffects(std::size_t bufferSize);
@@ -284,6 +301,8 @@ class EngineMixer : public QObject, public AudioSource {
     QVarLengthArray<ChannelInfo*, kPreallocatedChannels> m_activeBusChannels[3];
     QVarLengthArray<ChannelInfo*, kPreallocatedChannels> m_activeHeadphoneChannels;
     QVarLengthArray<ChannelInfo*, kPreallocatedChannels> m_activeTalkoverChannels;
+    QVarLengthArray<ChannelInfo*, kPreallocatedChannels> m_concurrentChannels;
+    std::size_t m_concurrentBufferSize;
 
     mixxx::audio::SampleRate m_sampleRate;
 
@@ -324,6 +343,8 @@ class EngineMixer : public QObject, public AudioSource {
     std::unique_ptr<ControlPushButton> m_pXFaderReverse;
     std::unique_ptr<ControlPushButton> m_pHeadSplitEnabled;
     std::unique_ptr<ControlObject> m_pKeylockEngine;
+    // Stretch keylock audio ahead of time on the Rubber Band worker threads
+    std::unique_ptr<ControlPushButton> m_pKeylockLookAhead;
 
     PflGainCalculator m_headphoneGain;
     TalkoverGainCalculator m_talkoverGain;
@@ -348,6 +369,11 @@ class EngineMixer : public QObject, public AudioSource {
     std::unique_ptr<ControlObject> m_pMainMonoMixdown;
     std::unique_ptr<ControlObject> m_pMicMonitorMode;
 
+    // Null if the channels are processed one after another
+    std::unique_ptr<EngineProcessingPool> m_pProcessingPool;
+
+    std::unique_ptr<EngineProfiler> m_pProfiler;
+
     // TODO (Swiftb0y): remove volatile (probably supposed to be std::atomic instead).
     volatile bool m_bBusOutputConnected[3];
     bool m_bExternalRecordBroadcastInputConnected;
@@ -0,0 +1,115 @@
+#include "engine/engineprocessingpool.h"
+
+#ifdef __LINUX__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "util/assert.h"
+#include "util/logger.h"
+#include "util/math.h"
+
+namespace {
+
+const mixxx::Logger kLogger("EngineProcessingPool");
+
+constexpr int kTaskCountShift = 32;
+constexpr std::uint64_t kTaskIndexMask = (std::uint64_t(1) << kTaskCountShift) - 1;
+
+} // anonymous namespace
+
+EngineProcessingPool::Worker::Worker(EngineProcessingPool* pPool, int cpuIndex)
+        : m_pPool(pPool),
+          m_cpuIndex(cpuIndex) {
+}
+
+void EngineProcessingPool::Worker::run() {
+    QThread::currentThread()->setObjectName(
+            QStringLiteral("EngineProcessingPool %1").arg(m_cpuIndex));
+#ifdef __LINUX__
+    // Keep the worker on one core. The audio callback thread usually runs on
+    // the first core, so the workers start with the second one.
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(m_cpuIndex, &cpuSet);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0) {
+        kLogger.warning() << "Failed to pin worker to CPU" << m_cpuIndex;
+    }
+#endif
+    while (true) {
+        m_pPool->m_semaWork.acquire();
+        if (m_pPool->m_bQuit.load(std::memory_order_acquire)) {
+            return;
+        }
+        m_pPool->runTasks();
+    }
+}
+
+EngineProcessingPool::EngineProcessingPool(int workerCount)
+        : m_bQuit(false),
+          m_nextTask(0),
+          m_pendingTasks(0),
+          m_pTask(nullptr),
+          m_pContext(nullptr) {
+    const int cpuCount = math_max(1, QThread::idealThreadCount());
+    for (int i = 0; i < workerCount; ++i) {
+        m_workers.push_back(std::make_unique<Worker>(this, (i + 1) % cpuCount));
+    }
+    for (const auto& pWorker : m_workers) {
+        pWorker->start(QThread::TimeCriticalPriority);
+    }
+    kLogger.info() << "Started" << workerCount << "workers";
+}
+
+EngineProcessingPool::~EngineProcessingPool() {
+    m_bQuit.store(true, std::memory_order_release);
+    m_semaWork.release(workerCount());
+    for (const auto& pWorker : m_workers) {
+        pWorker->wait();
+    }
+}
+
+void EngineProcessingPool::run(int taskCount, TaskFunction pTask, void* pContext) {
+    VERIFY_OR_DEBUG_ASSERT(taskCount >= 0 && pTask) {
+        return;
+    }
+    if (taskCount == 0) {
+        return;
+    }
+    DEBUG_ASSERT(m_pendingTasks.load(std::memory_order_relaxed) == 0);
+
+    m_pTask = pTask;
+    m_pContext = pContext;
+    m_pendingTasks.store(taskCount, std::memory_order_relaxed);
+    m_nextTask.store(static_cast<std::uint64_t>(taskCount) << kTaskCountShift,
+            std::memory_order_release);
+
+    // The calling thread takes one of the tasks. Workers that have not
+    // consumed the permit of a previous batch yet will join this one, so
+    // only the difference is released and the permits do not pile up.
+    const int wakeCount = math_min(taskCount - 1, workerCount()) -
+            m_semaWork.available();
+    if (wakeCount > 0) {
+        m_semaWork.release(wakeCount);
+    }
+    runTasks();
+
+    // Returns immediately if the calling thread has finished the last task
+    m_semaDone.acquire();
+    DEBUG_ASSERT(m_pendingTasks.load(std::memory_order_relaxed) == 0);
+}
+
+void EngineProcessingPool::runTasks() {
+    while (true) {
+        const std::uint64_t nextTask = m_nextTask.fetch_add(1, std::memory_order_acq_rel);
+        const auto taskIndex = static_cast<int>(nextTask & kTaskIndexMask);
+        const auto taskCount = static_cast<int>(nextTask >> kTaskCountShift);
+        if (taskIndex >= taskCount) {
+            return;
+        }
+        m_pTask(m_pContext, taskIndex);
+        if (m_pendingTasks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            m_semaDone.release();
+        }
+    }
+}
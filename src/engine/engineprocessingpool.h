@@ -0,0 +1,70 @@
+#pragma once
+
+#include <QSemaphore>
+#include <QThread>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// EngineProcessingPool runs independent pieces of work of the audio callback,
+// e.g. the processing of several engine channels, in parallel (fork/join).
+//
+// The worker threads are spawned once in the constructor and pinned to
+// separate CPU cores where supported. Running a batch does not allocate and
+// does not take locks: The tasks are handed out through a single atomic
+// counter, the workers are woken with a semaphore and the calling thread
+// takes part in the processing. The call returns after all tasks of the
+// batch have finished. While the last tasks are still running on a worker
+// the calling thread sleeps on a second semaphore that is released by the
+// thread that finishes the last task.
+class EngineProcessingPool {
+  public:
+    typedef void (*TaskFunction)(void* pContext, int taskIndex);
+
+    explicit EngineProcessingPool(int workerCount);
+    ~EngineProcessingPool();
+
+    int workerCount() const {
+        return static_cast<int>(m_workers.size());
+    }
+
+    // Calls pTask(pContext, i) for all i in [0, taskCount) and returns when
+    // all calls have finished. The order in which the tasks are started is
+    // ascending, but they may finish in any order. Must only be called from
+    // a single thread at a time, i.e. the audio callback.
+    void run(int taskCount, TaskFunction pTask, void* pContext);
+
+  private:
+    class Worker : public QThread {
+      public:
+        Worker(EngineProcessingPool* pPool, int cpuIndex);
+
+      protected:
+        void run() override;
+
+      private:
+        EngineProcessingPool* const m_pPool;
+        const int m_cpuIndex;
+    };
+
+    // Processes tasks of the current batch until none are left
+    void runTasks();
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    // Wakes the workers. Permits of a previous batch that have not been
+    // consumed yet are counted as wake-ups for the next batch.
+    QSemaphore m_semaWork;
+    // Released once per batch when the last task has finished
+    QSemaphore m_semaDone;
+    std::atomic<bool> m_bQuit;
+
+    // The task count in the upper and the index of the next task in the
+    // lower 32 bits. Workers that wake up late only increment the index
+    // beyond the count and never observe a batch that is being set up.
+    std::atomic<std::uint64_t> m_nextTask;
+    std::atomic<int> m_pendingTasks;
+    // Written before m_nextTask is published
+    TaskFunction m_pTask;
+    void* m_pContext;
+};
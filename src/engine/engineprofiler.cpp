@@ -0,0 +1,283 @@
+#include "engine/engineprofiler.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <bit>
+
+#include "util/assert.h"
+#include "util/compatibility/qmutex.h"
+#include "util/math.h"
+
+namespace {
+
+constexpr int kSubBucketBits = 3;
+constexpr int kSubBucketCount = 1 << kSubBucketBits;
+
+} // anonymous namespace
+
+EngineProfiler::Histogram::Histogram()
+        : m_count(0),
+          m_sumNanos(0),
+          m_maxNanos(0),
+          m_overBudgetCount(0) {
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+// static
+int EngineProfiler::Histogram::bucketIndex(qint64 micros) {
+    if (micros < kSubBucketCount) {
+        return static_cast<int>(math_max<qint64>(micros, 0));
+    }
+    // Split each octave into sub-buckets
+    const int msb = std::bit_width(static_cast<quint64>(micros)) - 1;
+    const int subBucket = static_cast<int>(
+            (micros >> (msb - kSubBucketBits)) & (kSubBucketCount - 1));
+    return math_min((msb - kSubBucketBits + 1) * kSubBucketCount + subBucket,
+            kBucketCount - 1);
+}
+
+// static
+qint64 EngineProfiler::Histogram::bucketUpperBoundMicros(int index) {
+    if (index < kSubBucketCount) {
+        return index + 1;
+    }
+    const int msb = index / kSubBucketCount + kSubBucketBits - 1;
+    const int subBucket = index % kSubBucketCount;
+    return static_cast<qint64>(kSubBucketCount + subBucket + 1)
+            << (msb - kSubBucketBits);
+}
+
+void EngineProfiler::Histogram::add(qint64 nanos, bool overBudget) {
+    m_buckets[bucketIndex(nanos / 1000)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sumNanos.fetch_add(static_cast<quint64>(nanos), std::memory_order_relaxed);
+    if (nanos > m_maxNanos.load(std::memory_order_relaxed)) {
+        m_maxNanos.store(nanos, std::memory_order_relaxed);
+    }
+    if (overBudget) {
+        m_overBudgetCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void EngineProfiler::Histogram::reset() {
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sumNanos.store(0, std::memory_order_relaxed);
+    m_maxNanos.store(0, std::memory_order_relaxed);
+    m_overBudgetCount.store(0, std::memory_order_relaxed);
+}
+
+double EngineProfiler::Histogram::meanMicros() const {
+    const quint64 count = m_count.load(std::memory_order_relaxed);
+    if (count == 0) {
+        return 0.0;
+    }
+    return m_sumNanos.load(std::memory_order_relaxed) / 1000.0 / count;
+}
+
+double EngineProfiler::Histogram::percentileMicros(double percentile) const {
+    // The buckets are read one after another, so their sum may differ from
+    // the count while the engine is running
+    quint64 total = 0;
+    for (const auto& bucket : m_buckets) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0.0;
+    }
+    const auto threshold = static_cast<quint64>(percentile / 100.0 * total);
+    quint64 sum = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+        sum += m_buckets[i].load(std::memory_order_relaxed);
+        if (sum > threshold) {
+            return math_min(static_cast<double>(bucketUpperBoundMicros(i)),
+                    maxMicros());
+        }
+    }
+    return maxMicros();
+}
+
+EngineProfiler::EngineProfiler()
+        : m_resetRequested(false) {
+    m_callbackStageNanos.fill(0);
+    for (auto& channelNanos : m_callbackChannelNanos) {
+        channelNanos.store(0, std::memory_order_relaxed);
+    }
+}
+
+// static
+QString EngineProfiler::stageName(Stage stage) {
+    switch (stage) {
+    case Stage::Sync:
+        return QStringLiteral("Sync");
+    case Stage::Channels:
+        return QStringLiteral("Channels");
+    case Stage::ChannelMix:
+        return QStringLiteral("Channel mix");
+    case Stage::BusEffects:
+        return QStringLiteral("Bus effects");
+    case Stage::Headphones:
+        return QStringLiteral("Headphones");
+    case Stage::Sidechain:
+        return QStringLiteral("Sidechain");
+    case Stage::Callback:
+        return QStringLiteral("Callback");
+    }
+    DEBUG_ASSERT(!"unhandled Stage");
+    return QString();
+}
+
+void EngineProfiler::setChannelName(int channelIndex, const QString& name) {
+    if (channelIndex < 0 || channelIndex >= kMaxChannelCount) {
+        return;
+    }
+    const auto locker = lockMutex(&m_channelNameMutex);
+    m_channelNames[channelIndex] = name;
+}
+
+void EngineProfiler::beginCallback() {
+    m_callbackTimer.start();
+}
+
+void EngineProfiler::addStageTime(Stage stage, mixxx::Duration duration) {
+    DEBUG_ASSERT(stage != Stage::Callback);
+    // At least 1 ns, to distinguish it from a stage that did not run
+    m_callbackStageNanos[static_cast<int>(stage)] +=
+            math_max<qint64>(duration.toIntegerNanos(), 1);
+}
+
+void EngineProfiler::addChannelTime(int channelIndex, mixxx::Duration duration) {
+    if (channelIndex < 0 || channelIndex >= kMaxChannelCount) {
+        return;
+    }
+    m_callbackChannelNanos[channelIndex].fetch_add(
+            math_max<qint64>(duration.toIntegerNanos(), 1),
+            std::memory_order_relaxed);
+}
+
+void EngineProfiler::endCallback(mixxx::Duration budget) {
+    const qint64 callbackNanos = m_callbackTimer.elapsed().toIntegerNanos();
+    if (m_resetRequested.exchange(false, std::memory_order_acquire)) {
+        for (auto& histogram : m_stageHistograms) {
+            histogram.reset();
+        }
+        for (auto& histogram : m_channelHistograms) {
+            histogram.reset();
+        }
+    }
+
+    // The budget is unknown if it is zero
+    const bool overBudget = budget.toIntegerNanos() > 0 &&
+            callbackNanos > budget.toIntegerNanos();
+    // Blame the slowest stage and the slowest channel
+    int slowestStage = -1;
+    int slowestChannel = -1;
+    if (overBudget) {
+        qint64 maxNanos = 0;
+        for (int i = 0; i < kStageCount - 1; ++i) {
+            if (m_callbackStageNanos[i] > maxNanos) {
+                maxNanos = m_callbackStageNanos[i];
+                slowestStage = i;
+            }
+        }
+        maxNanos = 0;
+        for (int i = 0; i < kMaxChannelCount; ++i) {
+            const qint64 channelNanos =
+                    m_callbackChannelNanos[i].load(std::memory_order_relaxed);
+            if (channelNanos > maxNanos) {
+                maxNanos = channelNanos;
+                slowestChannel = i;
+            }
+        }
+    }
+
+    for (int i = 0; i < kStageCount - 1; ++i) {
+        if (m_callbackStageNanos[i] > 0) {
+            m_stageHistograms[i].add(m_callbackStageNanos[i], i == slowestStage);
+            m_callbackStageNanos[i] = 0;
+        }
+    }
+    m_stageHistograms[static_cast<int>(Stage::Callback)].add(callbackNanos, overBudget);
+    for (int i = 0; i < kMaxChannelCount; ++i) {
+        const qint64 channelNanos =
+                m_callbackChannelNanos[i].exchange(0, std::memory_order_relaxed);
+        if (channelNanos > 0) {
+            m_channelHistograms[i].add(channelNanos, i == slowestChannel);
+        }
+    }
+}
+
+void EngineProfiler::reset() {
+    m_resetRequested.store(true, std::memory_order_release);
+}
+
+QString EngineProfiler::report() const {
+    QString result;
+    QTextStream stream(&result);
+    const auto appendRow = [&stream](const QString& name, const Histogram& histogram) {
+        stream << name.leftJustified(24, ' ', true)
+               << QString::number(histogram.count()).rightJustified(10)
+               << QString::number(histogram.meanMicros(), 'f', 1).rightJustified(10)
+               << QString::number(histogram.percentileMicros(50), 'f', 0).rightJustified(10)
+               << QString::number(histogram.percentileMicros(99), 'f', 0).rightJustified(10)
+               << QString::number(histogram.percentileMicros(99.9), 'f', 0).rightJustified(10)
+               << QString::number(histogram.maxMicros(), 'f', 0).rightJustified(10)
+               << QString::number(histogram.overBudgetCount()).rightJustified(12)
+               << '\n';
+    };
+
+    stream << QStringLiteral("Stage").leftJustified(24)
+           << QStringLiteral("count").rightJustified(10)
+           << QStringLiteral("mean us").rightJustified(10)
+           << QStringLiteral("p50 us").rightJustified(10)
+           << QStringLiteral("p99 us").rightJustified(10)
+           << QStringLiteral("p99.9 us").rightJustified(10)
+           << QStringLiteral("max us").rightJustified(10)
+           << QStringLiteral("over budget").rightJustified(12) << '\n';
+    for (int i = 0; i < kStageCount; ++i) {
+        appendRow(stageName(static_cast<Stage>(i)), m_stageHistograms[i]);
+    }
+
+    stream << '\n';
+    const auto locker = lockMutex(&m_channelNameMutex);
+    for (int i = 0; i < kMaxChannelCount; ++i) {
+        if (m_channelNames[i].isEmpty() || m_channelHistograms[i].count() == 0) {
+            continue;
+        }
+        appendRow(m_channelNames[i], m_channelHistograms[i]);
+    }
+    return result;
+}
+
+bool EngineProfiler::dumpToFile(const QString& fileName) const {
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream stream(&file);
+    stream << report();
+
+    // The raw histograms, one line per bucket that is used by any stage
+    stream << "\nbucket us";
+    for (int i = 0; i < kStageCount; ++i) {
+        stream << ',' << stageName(static_cast<Stage>(i));
+    }
+    stream << '\n';
+    for (int bucket = 0; bucket < kBucketCount; ++bucket) {
+        bool used = false;
+        QString line = QString::number(Histogram::bucketUpperBoundMicros(bucket));
+        for (const auto& histogram : m_stageHistograms) {
+            const quint32 count = histogram.bucketCount(bucket);
+            used |= count > 0;
+            line += ',' + QString::number(count);
+        }
+        if (used) {
+            stream << line << '\n';
+        }
+    }
+    return stream.status() == QTextStream::Ok;
+}
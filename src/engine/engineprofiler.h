@@ -0,0 +1,148 @@
+#pragma once
+
+#include <QMutex>
+#include <QString>
+#include <array>
+#include <atomic>
+
+#include "util/duration.h"
+#include "util/performancetimer.h"
+
+// EngineProfiler breaks down the time spent in each audio callback by the
+// stages of EngineMixer::process() and by engine channel.
+//
+// It is always on. Each EngineMixer owns its own profiler. The engine thread
+// sums up the time of each stage during a callback and adds the totals to
+// preallocated histograms when the callback ends, so recording never
+// allocates or locks. The histograms can be read at any time from another
+// thread, e.g. the developer tools dialog, and may be slightly inconsistent
+// while the engine is running.
+//
+// A callback that exceeds the duration of its buffer is blamed on the stage
+// that took the longest, this shows which stage causes the xruns.
+class EngineProfiler {
+  public:
+    enum class Stage {
+        Sync,
+        // Includes the pregain and prefader effects of the channels
+        Channels,
+        // Postfader effects of the channels and mixing them into the
+        // talkover and crossfader buses
+        ChannelMix,
+        // Effects of the talkover, crossfader and main buses and of the
+        // main output
+        BusEffects,
+        // Effects and mix of the PFL channels and the headphone output
+        Headphones,
+        Sidechain,
+        // The whole callback
+        Callback,
+    };
+    static constexpr int kStageCount = static_cast<int>(Stage::Callback) + 1;
+    static constexpr int kMaxChannelCount = 64;
+
+    // The buckets have a resolution of 1/8 octave between 8 us and about 2 s
+    static constexpr int kBucketCount = 152;
+
+    class Histogram {
+      public:
+        Histogram();
+
+        // Single writer, the engine thread
+        void add(qint64 nanos, bool overBudget);
+        void reset();
+
+        quint64 count() const {
+            return m_count.load(std::memory_order_relaxed);
+        }
+        quint64 overBudgetCount() const {
+            return m_overBudgetCount.load(std::memory_order_relaxed);
+        }
+        double meanMicros() const;
+        double maxMicros() const {
+            return m_maxNanos.load(std::memory_order_relaxed) / 1000.0;
+        }
+        quint32 bucketCount(int index) const {
+            return m_buckets[index].load(std::memory_order_relaxed);
+        }
+        // Upper bound of the bucket that contains the percentile
+        double percentileMicros(double percentile) const;
+
+        static int bucketIndex(qint64 micros);
+        static qint64 bucketUpperBoundMicros(int index);
+
+      private:
+        std::array<std::atomic<quint32>, kBucketCount> m_buckets;
+        std::atomic<quint64> m_count;
+        std::atomic<quint64> m_sumNanos;
+        std::atomic<qint64> m_maxNanos;
+        std::atomic<quint64> m_overBudgetCount;
+    };
+
+    // Measures the time until it goes out of scope. Only to be used on the
+    // engine thread.
+    class ScopedStage {
+      public:
+        ScopedStage(EngineProfiler* pProfiler, Stage stage)
+                : m_pProfiler(pProfiler),
+                  m_stage(stage) {
+            m_timer.start();
+        }
+        ~ScopedStage() {
+            m_pProfiler->addStageTime(m_stage, m_timer.elapsed());
+        }
+
+      private:
+        EngineProfiler* const m_pProfiler;
+        const Stage m_stage;
+        PerformanceTimer m_timer;
+    };
+
+    EngineProfiler();
+
+    static QString stageName(Stage stage);
+
+    // Thread-safe. Called when a channel is added to the engine.
+    void setChannelName(int channelIndex, const QString& name);
+
+    // Engine thread
+    void beginCallback();
+    // The budget is the duration of the buffer, zero if unknown
+    void endCallback(mixxx::Duration budget);
+    void addStageTime(Stage stage, mixxx::Duration duration);
+
+    // May be called from the worker threads that process the channels of the
+    // current callback, each channel by a single thread at a time. The times
+    // of a channel within one callback are summed up.
+    void addChannelTime(int channelIndex, mixxx::Duration duration);
+
+    const Histogram& stageHistogram(Stage stage) const {
+        return m_stageHistograms[static_cast<int>(stage)];
+    }
+    const Histogram& channelHistogram(int channelIndex) const {
+        return m_channelHistograms[channelIndex];
+    }
+
+    // Thread-safe. The engine thread clears the histograms at the end of
+    // the next callback.
+    void reset();
+
+    // Thread-safe. A table with one row per stage and per channel.
+    QString report() const;
+    bool dumpToFile(const QString& fileName) const;
+
+  private:
+    std::array<Histogram, kStageCount> m_stageHistograms;
+    std::array<Histogram, kMaxChannelCount> m_channelHistograms;
+    // Never accessed by the engine thread
+    mutable QMutex m_channelNameMutex;
+    std::array<QString, kMaxChannelCount> m_channelNames;
+    std::atomic<bool> m_resetRequested;
+
+    // The times of the current callback, owned by the engine thread. Zero
+    // means that the stage or channel has not been processed.
+    PerformanceTimer m_callbackTimer;
+    std::array<qint64, kStageCount> m_callbackStageNanos;
+    // Also written by the engine workers
+    std::array<std::atomic<qint64>, kMaxChannelCount> m_callbackChannelNanos;
+};
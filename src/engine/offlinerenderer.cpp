@@ -0,0 +1,394 @@
+#include "engine/offlinerenderer.h"
+
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QTextStream>
+#include <QTimer>
+#include <algorithm>
+
+#include "audio/types.h"
+#include "control/controlobject.h"
+#include "engine/channels/enginedeck.h"
+#include "engine/enginebuffer.h"
+#include "engine/enginemixer.h"
+#include "mixer/basetrackplayer.h"
+#include "recording/defs_recording.h"
+#include "track/track.h"
+#include "util/logger.h"
+#include "util/math.h"
+#include "util/performancetimer.h"
+
+namespace {
+
+const mixxx::Logger kLogger("OfflineRenderer");
+
+const ConfigKey kSampleRateKey =
+        ConfigKey(QStringLiteral("[App]"), QStringLiteral("samplerate"));
+
+const QString kPreloadWholeTrackConfigItem = QStringLiteral("preload_whole_track");
+
+const QString kLoadTrackItem = QStringLiteral("load");
+
+const QString kMainGroup = QStringLiteral("[Master]");
+const QString kCrossfaderItem = QStringLiteral("crossfader");
+const QString kOrientationItem = QStringLiteral("orientation");
+const QString kPlayItem = QStringLiteral("play");
+
+// Crossfader positions of the orientations
+constexpr double kCrossfaderLeft = -1.0;
+constexpr double kCrossfaderRight = 1.0;
+constexpr double kOrientationLeft = 0.0;
+constexpr double kOrientationRight = 2.0;
+
+// Updates of the crossfader during a transition
+constexpr int kCrossfadeStepsPerSecond = 20;
+
+// Events are applied at the start of the buffer that contains them
+constexpr SINT kBufferFrames = 512;
+
+constexpr int kLoadTrackTimeoutMillis = 60000;
+
+} // anonymous namespace
+
+OfflineRenderer::OfflineRenderer(UserSettingsPointer pConfig, EngineMixer* pEngineMixer)
+        : m_pConfig(pConfig),
+          m_pEngineMixer(pEngineMixer),
+          m_realtimeFactor(0.0) {
+}
+
+OfflineRenderer::~OfflineRenderer() {
+    restoreConfig();
+}
+
+void OfflineRenderer::addPlayer(BaseTrackPlayerImpl* pPlayer) {
+    VERIFY_OR_DEBUG_ASSERT(pPlayer) {
+        return;
+    }
+    m_players.append(pPlayer);
+}
+
+void OfflineRenderer::addControlChange(
+        double timeSeconds, const ConfigKey& key, double value) {
+    m_events.append(Event{timeSeconds, Event::Type::SetControl, key, value, QString(), nullptr});
+}
+
+void OfflineRenderer::addTrackLoad(
+        double timeSeconds, const QString& group, const QString& trackLocation) {
+    m_events.append(Event{timeSeconds,
+            Event::Type::LoadTrack,
+            ConfigKey(group, kLoadTrackItem),
+            0.0,
+            trackLocation,
+            nullptr});
+}
+
+void OfflineRenderer::addTrackLoad(
+        double timeSeconds, const QString& group, TrackPointer pTrack) {
+    VERIFY_OR_DEBUG_ASSERT(pTrack) {
+        return;
+    }
+    const QString trackLocation = pTrack->getLocation();
+    m_events.append(Event{timeSeconds,
+            Event::Type::LoadTrack,
+            ConfigKey(group, kLoadTrackItem),
+            0.0,
+            trackLocation,
+            std::move(pTrack)});
+}
+
+bool OfflineRenderer::loadTimeline(QIODevice* pDevice, QString* pErrorMessage) {
+    QTextStream stream(pDevice);
+    int lineNumber = 0;
+    while (!stream.atEnd()) {
+        const QString line = stream.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        // The track location may contain spaces
+        const QStringList fields = line.split(' ', Qt::SkipEmptyParts);
+        bool timeOk = false;
+        const double timeSeconds = fields.value(0).toDouble(&timeOk);
+        if (fields.size() >= 4 && timeOk && timeSeconds >= 0) {
+            if (fields[2] == kLoadTrackItem) {
+                const int locationStart =
+                        line.indexOf(kLoadTrackItem,
+                                line.indexOf(fields[1]) + fields[1].size()) +
+                        kLoadTrackItem.size();
+                addTrackLoad(timeSeconds, fields[1], line.mid(locationStart).trimmed());
+                continue;
+            }
+            bool valueOk = false;
+            const double value = fields[3].toDouble(&valueOk);
+            if (fields.size() == 4 && valueOk) {
+                addControlChange(timeSeconds, ConfigKey(fields[1], fields[2]), value);
+                continue;
+            }
+        }
+        if (pErrorMessage) {
+            *pErrorMessage = QStringLiteral("Invalid timeline event in line %1: %2")
+                                     .arg(QString::number(lineNumber), line);
+        }
+        return false;
+    }
+    return true;
+}
+
+double OfflineRenderer::addTrackSequence(
+        const QList<TrackPointer>& tracks, double transitionSeconds) {
+    VERIFY_OR_DEBUG_ASSERT(m_players.size() >= 2) {
+        return 0.0;
+    }
+    const QString groups[] = {m_players[0]->getGroup(), m_players[1]->getGroup()};
+    addControlChange(0.0, ConfigKey(groups[0], kOrientationItem), kOrientationLeft);
+    addControlChange(0.0, ConfigKey(groups[1], kOrientationItem), kOrientationRight);
+    addControlChange(0.0, ConfigKey(kMainGroup, kCrossfaderItem), kCrossfaderLeft);
+
+    double startSeconds = 0.0;
+    double endSeconds = 0.0;
+    int trackCount = 0;
+    for (const auto& pTrack : tracks) {
+        const double durationSeconds = pTrack->getDuration();
+        if (durationSeconds <= 0) {
+            kLogger.warning() << "Skipping track without duration" << pTrack->getLocation();
+            continue;
+        }
+        const int deckIndex = trackCount++ % 2;
+        const QString& group = groups[deckIndex];
+        // Fade from the other deck over to this one
+        if (trackCount > 1) {
+            const double fadeSeconds = math_min(math_max(endSeconds - startSeconds, 0.0),
+                    durationSeconds / 2);
+            const int steps = math_max(1,
+                    static_cast<int>(fadeSeconds * kCrossfadeStepsPerSecond));
+            const double fromPosition = deckIndex ? kCrossfaderLeft : kCrossfaderRight;
+            const double toPosition = -fromPosition;
+            for (int step = 1; step <= steps; ++step) {
+                addControlChange(startSeconds + fadeSeconds * step / steps,
+                        ConfigKey(kMainGroup, kCrossfaderItem),
+                        fromPosition + (toPosition - fromPosition) * step / steps);
+            }
+        }
+        addTrackLoad(startSeconds, group, pTrack);
+        addControlChange(startSeconds, ConfigKey(group, kPlayItem), 1.0);
+        // The next track goes to the deck of the previous one, which must
+        // have finished by then
+        const double previousEndSeconds = endSeconds;
+        endSeconds = startSeconds + durationSeconds;
+        startSeconds = math_max(previousEndSeconds, endSeconds - transitionSeconds);
+    }
+    return endSeconds;
+}
+
+// static
+QString OfflineRenderer::encodingForFileName(const QString& fileName) {
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    if (suffix == QLatin1String("wav")) {
+        return ENCODING_WAVE;
+    } else if (suffix == QLatin1String("flac")) {
+        return ENCODING_FLAC;
+    } else if (suffix == QLatin1String("aif") || suffix == QLatin1String("aiff")) {
+        return ENCODING_AIFF;
+    } else if (suffix == QLatin1String("ogg")) {
+        return ENCODING_OGG;
+    } else if (suffix == QLatin1String("mp3")) {
+        return ENCODING_MP3;
+    } else if (suffix == QLatin1String("opus")) {
+        return ENCODING_OPUS;
+    }
+    return QString();
+}
+
+bool OfflineRenderer::render(const QString& fileName,
+        const QString& encoding,
+        double durationSeconds,
+        QString* pErrorMessage) {
+    const auto sampleRate = mixxx::audio::SampleRate::fromDouble(
+            ControlObject::get(kSampleRateKey));
+    VERIFY_OR_DEBUG_ASSERT(sampleRate.isValid()) {
+        if (pErrorMessage) {
+            *pErrorMessage = QStringLiteral("The engine has no valid sample rate");
+        }
+        return false;
+    }
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (pErrorMessage) {
+            *pErrorMessage = m_file.errorString();
+        }
+        return false;
+    }
+    const EncoderFactory& factory = EncoderFactory::getFactory();
+    EncoderPointer pEncoder = factory.createRecordingEncoder(
+            factory.getFormatFor(encoding), m_pConfig, this);
+    if (pEncoder->initEncoder(sampleRate, pErrorMessage) < 0) {
+        m_file.close();
+        return false;
+    }
+
+    QList<Event> events = m_events;
+    std::stable_sort(events.begin(), events.end(), [](const Event& lhs, const Event& rhs) {
+        return lhs.timeSeconds < rhs.timeSeconds;
+    });
+
+    const auto totalFrames = static_cast<SINT>(durationSeconds * sampleRate.toDouble());
+    PerformanceTimer timer;
+    timer.start();
+    bool success = true;
+    int nextEvent = 0;
+    SINT renderedFrames = 0;
+    while (renderedFrames < totalFrames) {
+        const SINT frames = math_min(kBufferFrames, totalFrames - renderedFrames);
+        const double bufferEndSeconds = (renderedFrames + frames) / sampleRate.toDouble();
+        while (nextEvent < events.size() && events[nextEvent].timeSeconds < bufferEndSeconds) {
+            if (!applyEvent(events[nextEvent], pErrorMessage)) {
+                success = false;
+                break;
+            }
+            ++nextEvent;
+        }
+        if (!success) {
+            break;
+        }
+
+        const auto samples = static_cast<std::size_t>(
+                frames * mixxx::kEngineChannelOutputCount);
+        m_pEngineMixer->process(samples);
+        pEncoder->encodeBuffer(m_pEngineMixer->getMainBuffer().data(), samples);
+        renderedFrames += frames;
+    }
+    pEncoder->flush();
+    m_file.close();
+    restoreConfig();
+
+    const double elapsedSeconds = timer.elapsed().toDoubleSeconds();
+    const double renderedSeconds = renderedFrames / sampleRate.toDouble();
+    m_realtimeFactor = elapsedSeconds > 0 ? renderedSeconds / elapsedSeconds : 0.0;
+    kLogger.info() << "Rendered" << renderedSeconds << "s to" << fileName << "in"
+                   << elapsedSeconds << "s," << m_realtimeFactor << "x real time";
+    return success;
+}
+
+bool OfflineRenderer::applyEvent(const Event& event, QString* pErrorMessage) {
+    switch (event.type) {
+    case Event::Type::SetControl:
+        if (!ControlObject::exists(event.key)) {
+            if (pErrorMessage) {
+                *pErrorMessage = QStringLiteral("Unknown control %1 %2")
+                                         .arg(event.key.group, event.key.item);
+            }
+            return false;
+        }
+        ControlObject::set(event.key, event.value);
+        return true;
+    case Event::Type::LoadTrack:
+        for (BaseTrackPlayerImpl* pPlayer : std::as_const(m_players)) {
+            if (pPlayer->getGroup() == event.key.group) {
+                return loadTrack(pPlayer,
+                        event.pTrack ? event.pTrack
+                                     : Track::newTemporary(event.trackLocation),
+                        pErrorMessage);
+            }
+        }
+        if (pErrorMessage) {
+            *pErrorMessage = QStringLiteral("Unknown player %1").arg(event.key.group);
+        }
+        return false;
+    }
+    DEBUG_ASSERT(!"unhandled Event::Type");
+    return false;
+}
+
+bool OfflineRenderer::loadTrack(BaseTrackPlayerImpl* pPlayer,
+        TrackPointer pTrack,
+        QString* pErrorMessage) {
+    // Reading from a completely decoded track never misses a chunk, no
+    // matter how fast we render.
+    const ConfigKey preloadKey(pPlayer->getGroup(), kPreloadWholeTrackConfigItem);
+    const bool alreadyChanged = std::any_of(m_changedConfigValues.cbegin(),
+            m_changedConfigValues.cend(),
+            [&preloadKey](const auto& changedValue) {
+                return changedValue.first == preloadKey;
+            });
+    if (!alreadyChanged) {
+        m_changedConfigValues.append(
+                std::make_pair(preloadKey, m_pConfig->getValueString(preloadKey)));
+    }
+    m_pConfig->setValue(preloadKey, true);
+
+    // The engine buffer receives the track from the reader thread. The time
+    // of the mix stands still until then.
+    EngineBuffer* pEngineBuffer = pPlayer->getEngineDeck()->getEngineBuffer();
+    QEventLoop loop;
+    QString failureReason;
+    QObject::connect(pEngineBuffer,
+            &EngineBuffer::trackLoaded,
+            &loop,
+            [&loop, pTrack](TrackPointer pNewTrack, TrackPointer) {
+                if (pNewTrack == pTrack) {
+                    loop.exit(0);
+                }
+            });
+    QObject::connect(pEngineBuffer,
+            &EngineBuffer::trackLoadFailed,
+            &loop,
+            [&loop, &failureReason, pTrack](TrackPointer pFailedTrack, const QString& reason) {
+                if (pFailedTrack == pTrack) {
+                    failureReason = reason;
+                    loop.exit(1);
+                }
+            });
+    QTimer::singleShot(kLoadTrackTimeoutMillis, &loop, [&loop, &failureReason]() {
+        failureReason = QStringLiteral("Timed out");
+        loop.exit(1);
+    });
+
+    pPlayer->slotLoadTrack(pTrack,
+#ifdef __STEM__
+            mixxx::StemChannelSelection(),
+#endif
+            false);
+    if (loop.exec() == 0) {
+        return true;
+    }
+    if (pErrorMessage) {
+        *pErrorMessage = QStringLiteral("Failed to load %1 into %2: %3")
+                                 .arg(pTrack->getLocation(), pPlayer->getGroup(), failureReason);
+    }
+    return false;
+}
+
+void OfflineRenderer::restoreConfig() {
+    for (const auto& [key, value] : std::as_const(m_changedConfigValues)) {
+        if (value.isEmpty()) {
+            m_pConfig->remove(key);
+        } else {
+            m_pConfig->set(key, ConfigValue(value));
+        }
+    }
+    m_changedConfigValues.clear();
+}
+
+void OfflineRenderer::write(const unsigned char* header,
+        const unsigned char* body,
+        int headerLen,
+        int bodyLen) {
+    if (headerLen > 0) {
+        m_file.write(reinterpret_cast<const char*>(header), headerLen);
+    }
+    m_file.write(reinterpret_cast<const char*>(body), bodyLen);
+}
+
+int OfflineRenderer::tell() {
+    return static_cast<int>(m_file.pos());
+}
+
+void OfflineRenderer::seek(int pos) {
+    m_file.seek(static_cast<qint64>(pos));
+}
+
+int OfflineRenderer::filelen() {
+    return static_cast<int>(m_file.size());
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <utility>
+
+#include "encoder/encoder.h"
+#include "encoder/encodercallback.h"
+#include "preferences/configobject.h"
+#include "preferences/usersettings.h"
+#include "track/track_decl.h"
+
+class BaseTrackPlayerImpl;
+class EngineMixer;
+class QIODevice;
+
+// OfflineRenderer drives EngineMixer::process() without a sound device, as
+// fast as the CPU allows, and encodes the main mix into a file.
+//
+// The mix follows a timeline of control changes and track loads. The time
+// does not advance while a track is loading and the tracks are decoded
+// completely before playback, so rendering the same timeline twice results
+// in the same output. This makes the renderer usable for batch mixdowns and
+// as an end-to-end throughput benchmark and regression test of the engine.
+//
+// Timeline files contain one event per line, times are in seconds:
+//   <time> <group> <item> <value>
+//   <time> <group> load <track location>
+// Empty lines and lines starting with # are ignored.
+//
+// Mixxx renders the Auto DJ queue with the --render-autodj command line
+// option, see addTrackSequence().
+class OfflineRenderer : public EncoderCallback {
+  public:
+    struct Event {
+        enum class Type {
+            SetControl,
+            LoadTrack,
+        };
+
+        double timeSeconds;
+        Type type;
+        // The group of the player for LoadTrack
+        ConfigKey key;
+        double value;
+        QString trackLocation;
+        // Tracks from the library are loaded with their metadata, e.g. the
+        // replay gain, beats and cues. nullptr for a plain track location.
+        TrackPointer pTrack;
+    };
+
+    OfflineRenderer(UserSettingsPointer pConfig, EngineMixer* pEngineMixer);
+    ~OfflineRenderer() override;
+
+    // Tracks can only be loaded into registered players
+    void addPlayer(BaseTrackPlayerImpl* pPlayer);
+
+    void addControlChange(double timeSeconds, const ConfigKey& key, double value);
+    void addTrackLoad(double timeSeconds, const QString& group, const QString& trackLocation);
+    void addTrackLoad(double timeSeconds, const QString& group, TrackPointer pTrack);
+    // Appends the events of a timeline file. Returns false on a syntax
+    // error and sets the error message.
+    bool loadTimeline(QIODevice* pDevice, QString* pErrorMessage);
+    // Appends events that play the tracks one after another, alternating
+    // between the first two players. Consecutive tracks are crossfaded
+    // during the last transitionSeconds of the previous track, like the
+    // fixed full track transition of Auto DJ. Returns the end time of the
+    // last track.
+    double addTrackSequence(const QList<TrackPointer>& tracks, double transitionSeconds);
+
+    const QList<Event>& events() const {
+        return m_events;
+    }
+
+    // Renders the given duration of the timeline into a file. The format is
+    // one of the recording encodings, e.g. ENCODING_WAVE or ENCODING_FLAC,
+    // encoded with the recording preferences. Blocks until the rendering
+    // has finished.
+    bool render(const QString& fileName,
+            const QString& encoding,
+            double durationSeconds,
+            QString* pErrorMessage);
+
+    // The recording encoding for the suffix of the file name, e.g.
+    // ENCODING_FLAC for "mix.flac". Empty for unsupported suffixes.
+    static QString encodingForFileName(const QString& fileName);
+
+    // The speed of the last rendering compared to real time
+    double realtimeFactor() const {
+        return m_realtimeFactor;
+    }
+
+    // EncoderCallback
+    void write(const unsigned char* header,
+            const unsigned char* body,
+            int headerLen,
+            int bodyLen) override;
+    int tell() override;
+    void seek(int pos) override;
+    int filelen() override;
+
+  private:
+    bool applyEvent(const Event& event, QString* pErrorMessage);
+    bool loadTrack(BaseTrackPlayerImpl* pPlayer, TrackPointer pTrack, QString* pErrorMessage);
+    void restoreConfig();
+
+    const UserSettingsPointer m_pConfig;
+    EngineMixer* const m_pEngineMixer;
+    QList<BaseTrackPlayerImpl*> m_players;
+    QList<Event> m_events;
+    // Preferences that are changed while rendering
+    QList<std::pair<ConfigKey, QString>> m_changedConfigValues;
+
+    QFile m_file;
+    double m_realtimeFactor;
+};
@@ -1,40 +1,108 @@
 // This class provides a way to do audio processing that does not need
 // to be executed in real-time. For example, broadcast encoding
-// and recording encoding can be done here. This class uses double-buffering
-// to increase the amount of time the CPU has to do whatever work needs to
-// be done, and that work is executed in a separate thread. (Threading
-// allows the next buffer to be filled while processing a buffer that's is
-// already full.)
+// and recording encoding can be done here. The engine callback copies
+// its samples once into a ring that is shared by all workers. Each worker
+// runs in a separate thread and reads from the ring at its own pace, so a
+// slow worker neither delays the engine nor the other workers.
 
 #include "engine/sidechain/enginesidechain.h"
 
 #include <QtDebug>
+#include <utility>
 
 #include "engine/engine.h"
 #include "engine/sidechain/sidechainworker.h"
-#include "moc_enginesidechain.cpp"
 #include "util/counter.h"
 #include "util/event.h"
 #include "util/sample.h"
 #include "util/trace.h"
 
-#define SIDECHAIN_BUFFER_SIZE 65536
+namespace {
+
+// The ring holds several work buffers, so a worker may fall behind for
+// a while before samples are lost
+constexpr int kRingSize = EngineSideChain::SIDECHAIN_BUFFER_SIZE * 4;
+
+// Wake up the workers after this many samples, like the former FIFO did
+// when it was filled up to 80%
+constexpr int kWakeUpSampleCount = EngineSideChain::SIDECHAIN_BUFFER_SIZE -
+        EngineSideChain::SIDECHAIN_BUFFER_SIZE / 5;
+
+} // anonymous namespace
+
+EngineSideChain::Consumer::Consumer(EngineSideChain* pSideChain,
+        SideChainWorker* pWorker,
+        std::shared_ptr<const SideChainRing> pRing)
+        : m_pSideChain(pSideChain),
+          m_pWorker(pWorker),
+          m_reader(std::move(pRing)),
+          m_workBuffer(SIDECHAIN_BUFFER_SIZE) {
+}
+
+void EngineSideChain::Consumer::run() {
+    // the id of this thread, for debugging purposes //XXX copypasta (should
+    // factor this out somehow), -kousu 2/2009
+    static QAtomicInt id = 0;
+    QThread::currentThread()->setObjectName(
+            QString("EngineSideChain %1").arg(++id));
+    static const QString tag("EngineSideChain");
+    Event::start(tag);
+    while (!m_pSideChain->m_bStopThread) {
+        // Sleep until samples are available.
+        m_pSideChain->m_waitLock.lock();
+
+        Event::end(tag);
+        // The flag is set while holding the lock, so we can't miss the
+        // final wake up
+        if (!m_pSideChain->m_bStopThread) {
+            m_pSideChain->m_waitForSamples.wait(&m_pSideChain->m_waitLock);
+        }
+        m_pSideChain->m_waitLock.unlock();
+        Event::start(tag);
+
+        processAvailableSamples();
+    }
+}
+
+void EngineSideChain::Consumer::processAvailableSamples() {
+    const CSAMPLE* dataPtr1;
+    int size1;
+    const CSAMPLE* dataPtr2;
+    int size2;
+    const int overrunCount = m_reader.overrunCount();
+    int samplesRead;
+    while ((samplesRead = m_reader.aquireReadRegions(
+                    SIDECHAIN_BUFFER_SIZE, &dataPtr1, &size1, &dataPtr2, &size2))) {
+        // The producer may overwrite the regions at any time. Copy the
+        // samples out and only pass them on if they are still intact
+        // afterwards, the encoders must never see a torn block.
+        SampleUtil::copy(m_workBuffer.data(), dataPtr1, size1);
+        if (size2 > 0) {
+            SampleUtil::copy(m_workBuffer.data(size1), dataPtr2, size2);
+        }
+        if (!m_reader.releaseReadRegions(samplesRead)) {
+            // Dropped, counted as an overrun below
+            continue;
+        }
+        Trace process("EngineSideChain::process");
+        m_pWorker->process(m_workBuffer.data(), samplesRead);
+    }
+    if (m_reader.overrunCount() != overrunCount) {
+        Counter("EngineSideChain::process buffer overrun")
+                .increment(m_reader.overrunCount() - overrunCount);
+        qWarning() << "EngineSideChain: Worker is too slow,"
+                   << m_reader.lostSampleCount() << "samples lost so far";
+    }
+}
 
 EngineSideChain::EngineSideChain(
         UserSettingsPointer pConfig,
         CSAMPLE* sidechainMix)
         : m_pConfig(pConfig),
           m_bStopThread(false),
-          m_sampleFifo(SIDECHAIN_BUFFER_SIZE),
-          m_pWorkBuffer(SampleUtil::alloc(SIDECHAIN_BUFFER_SIZE)),
+          m_pRing(std::make_shared<SideChainRing>(kRingSize)),
+          m_samplesSinceWakeUp(0),
           m_pSidechainMix(sidechainMix) {
-    // We use HighPriority to prevent starvation by lower-priority processes (Qt
-    // main thread, analysis, etc.). This used to be LowPriority but that is not
-    // a suitable choice since we do semi-realtime tasks
-    // in the sidechain thread. To get reliable timing, it's important
-    // that this work be prioritized over the GUI and non-realtime tasks. See
-    // discussion on issue #7272 and https://bugs.launchpad.net/mixxx/1.11/+bug/1194543.
-    start(QThread::HighPriority);
 }
 
 EngineSideChain::~EngineSideChain() {
@@ -43,23 +111,31 @@ EngineSideChain::~EngineSideChain() {
     m_waitForSamples.wakeAll();
     m_waitLock.unlock();
 
-    // Wait until the thread has finished.
-    wait();
-
     MMutexLocker locker(&m_workerLock);
-    while (!m_workers.empty()) {
-        SideChainWorker* pWorker = m_workers.takeLast();
+    // Wait until all threads have finished.
+    for (Consumer* pConsumer : std::as_const(m_consumers)) {
+        pConsumer->wait();
+    }
+    while (!m_consumers.empty()) {
+        Consumer* pConsumer = m_consumers.takeLast();
+        SideChainWorker* pWorker = pConsumer->worker();
+        delete pConsumer;
         pWorker->shutdown();
         delete pWorker;
     }
-    locker.unlock();
-
-    SampleUtil::free(m_pWorkBuffer);
 }
 
 void EngineSideChain::addSideChainWorker(SideChainWorker* pWorker) {
+    auto* pConsumer = new Consumer(this, pWorker, m_pRing);
     MMutexLocker locker(&m_workerLock);
-    m_workers.append(pWorker);
+    m_consumers.append(pConsumer);
+    // We use HighPriority to prevent starvation by lower-priority processes (Qt
+    // main thread, analysis, etc.). This used to be LowPriority but that is not
+    // a suitable choice since we do semi-realtime tasks
+    // in the sidechain thread. To get reliable timing, it's important
+    // that this work be prioritized over the GUI and non-realtime tasks. See
+    // discussion on issue #7272 and https://bugs.launchpad.net/mixxx/1.11/+bug/1194543.
+    pConsumer->start(QThread::HighPriority);
 }
 
 void EngineSideChain::receiveBuffer(const AudioInput& input,
@@ -78,48 +154,15 @@ void EngineSideChain::writeSamples(const CSAMPLE* pBuffer, int iFrames) {
     Trace sidechain("EngineSideChain::writeSamples");
     // TODO: remove assumption of stereo buffer
     const int numSamples = iFrames * mixxx::kEngineChannelOutputCount;
-    const int numSamplesWritten = m_sampleFifo.write(pBuffer, numSamples);
+    // The ring never blocks, workers that fall behind detect the
+    // overrun on their own
+    m_pRing->write(pBuffer, numSamples);
 
-    if (numSamplesWritten != numSamples) {
-        Counter("EngineSideChain::writeSamples buffer overrun").increment();
-    }
-
-    if (m_sampleFifo.writeAvailable() < SIDECHAIN_BUFFER_SIZE / 5) {
+    m_samplesSinceWakeUp += numSamples;
+    if (m_samplesSinceWakeUp >= kWakeUpSampleCount) {
+        m_samplesSinceWakeUp = 0;
         // Signal to the sidechain that samples are available.
         Trace wakeup("EngineSideChain::writeSamples wake up");
         m_waitForSamples.wakeAll();
     }
 }
-
-void EngineSideChain::run() {
-    // the id of this thread, for debugging purposes //XXX copypasta (should
-    // factor this out somehow), -kousu 2/2009
-    unsigned static id = 0;
-    QThread::currentThread()->setObjectName(QString("EngineSideChain %1").arg(++id));
-    static const QString tag("EngineSideChain");
-    Event::start(tag);
-    while (!m_bStopThread) {
-        // Sleep until samples are available.
-        m_waitLock.lock();
-
-        Event::end(tag);
-        m_waitForSamples.wait(&m_waitLock);
-        m_waitLock.unlock();
-        Event::start(tag);
-
-        int samples_read;
-        while ((samples_read = m_sampleFifo.read(m_pWorkBuffer,
-                                                 SIDECHAIN_BUFFER_SIZE))) {
-            Trace process("EngineSideChain::process");
-            MMutexLocker locker(&m_workerLock);
-            foreach (SideChainWorker* pWorker, m_workers) {
-                pWorker->process(m_pWorkBuffer, samples_read);
-            }
-        }
-
-        // Check to see if we're supposed to exit/stop this thread.
-        if (m_bStopThread) {
-            return;
-        }
-    }
-}
@@ -1,20 +1,21 @@
 #pragma once
 
-#include <QThread>
+#include <QList>
 #include <QMutex>
+#include <QThread>
 #include <QWaitCondition>
-#include <QList>
+#include <memory>
 
+#include "engine/sidechain/sidechainring.h"
 #include "preferences/usersettings.h"
 #include "soundio/soundmanagerutil.h"
-#include "util/fifo.h"
 #include "util/mutex.h"
+#include "util/samplebuffer.h"
 #include "util/types.h"
 
 class SideChainWorker;
 
-class EngineSideChain : public QThread, public AudioDestination {
-    Q_OBJECT
+class EngineSideChain : public AudioDestination {
   public:
     EngineSideChain(UserSettingsPointer pConfig, CSAMPLE* sidechainMix);
     ~EngineSideChain() override;
@@ -30,20 +31,46 @@ class EngineSideChain : public QThread, public AudioDestination {
             const CSAMPLE* pBuffer,
             unsigned int iFrames) override;
 
-    // Thread-safe, blocking.
+    // Thread-safe, blocking. Each worker gets its own thread that reads the
+    // samples from the shared ring at its own pace.
     void addSideChainWorker(SideChainWorker* pWorker);
 
+    // The maximum number of samples that are passed to SideChainWorker::process()
     static constexpr int SIDECHAIN_BUFFER_SIZE = 65536;
 
   private:
-    void run() override;
+    class Consumer : public QThread {
+      public:
+        Consumer(EngineSideChain* pSideChain,
+                SideChainWorker* pWorker,
+                std::shared_ptr<const SideChainRing> pRing);
+
+        SideChainWorker* worker() const {
+            return m_pWorker;
+        }
+
+      protected:
+        void run() override;
+
+      private:
+        void processAvailableSamples();
+
+        EngineSideChain* const m_pSideChain;
+        SideChainWorker* const m_pWorker;
+        SideChainRing::Reader m_reader;
+        // The samples are copied out of the ring before they are
+        // validated and processed
+        mixxx::SampleBuffer m_workBuffer;
+    };
 
     UserSettingsPointer m_pConfig;
-    // Indicates that the thread should exit.
+    // Indicates that the consumer threads should exit.
     volatile bool m_bStopThread;
 
-    FIFO<CSAMPLE> m_sampleFifo;
-    CSAMPLE* m_pWorkBuffer;
+    // Written once per callback, independent of the number of workers
+    const std::shared_ptr<SideChainRing> m_pRing;
+    // Only accessed by the writer thread
+    int m_samplesSinceWakeUp;
     CSAMPLE* m_pSidechainMix;
 
     // Provides thread safety around the wait condition below.
@@ -53,5 +80,5 @@ class EngineSideChain : public QThread, public AudioDestination {
 
     // Sidechain workers registered with EngineSideChain.
     MMutex m_workerLock;
-    QList<SideChainWorker*> m_workers GUARDED_BY(m_workerLock);
+    QList<Consumer*> m_consumers GUARDED_BY(m_workerLock);
 };
@@ -1018,9 +1018,9 @@ void ShoutConnection::run() {
         if (readAvailable) {
             setFunctionCode(3);
             CSAMPLE* dataPtr1;
-            ring_buffer_size_t size1;
+            int size1;
             CSAMPLE* dataPtr2;
-            ring_buffer_size_t size2;
+            int size2;
 
             // We use size1 and size2, so we can ignore the return value
             (void)m_pOutputFifo->aquireReadRegions(readAvailable, &dataPtr1, &size1,
@@ -0,0 +1,108 @@
+#include "engine/sidechain/sidechainring.h"
+
+#include <utility>
+
+#include "util/assert.h"
+#include "util/math.h"
+#include "util/sample.h"
+
+SideChainRing::SideChainRing(int size)
+        : m_pBuffer(SampleUtil::alloc(
+                  roundUpToPowerOf2(static_cast<unsigned int>(size)))),
+          m_mask(roundUpToPowerOf2(static_cast<unsigned int>(size)) - 1),
+          m_reservedPosition(0),
+          m_writePosition(0) {
+    DEBUG_ASSERT(capacity() >= 2);
+    SampleUtil::clear(m_pBuffer, capacity());
+}
+
+SideChainRing::~SideChainRing() {
+    SampleUtil::free(m_pBuffer);
+}
+
+void SideChainRing::write(const CSAMPLE* pBuffer, int count) {
+    VERIFY_OR_DEBUG_ASSERT(count >= 0 && count <= capacity()) {
+        return;
+    }
+    const std::uint64_t writePosition = m_writePosition.load(std::memory_order_relaxed);
+    const std::uint64_t endPosition = writePosition + static_cast<std::uint64_t>(count);
+    // Announce the samples that are going to be overwritten
+    m_reservedPosition.store(endPosition, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const int offset = static_cast<int>(writePosition & m_mask);
+    const int size1 = math_min(count, capacity() - offset);
+    SampleUtil::copy(m_pBuffer + offset, pBuffer, size1);
+    if (size1 < count) {
+        SampleUtil::copy(m_pBuffer, pBuffer + size1, count - size1);
+    }
+
+    m_writePosition.store(endPosition, std::memory_order_release);
+}
+
+SideChainRing::Reader::Reader(std::shared_ptr<const SideChainRing> pRing)
+        : m_pRing(std::move(pRing)),
+          m_readPosition(m_pRing->writePosition()),
+          m_overrunCount(0),
+          m_lostSampleCount(0) {
+}
+
+int SideChainRing::Reader::readAvailable() const {
+    return static_cast<int>(math_min<std::uint64_t>(
+            m_pRing->writePosition() - m_readPosition,
+            static_cast<std::uint64_t>(m_pRing->capacity())));
+}
+
+int SideChainRing::Reader::aquireReadRegions(int count,
+        const CSAMPLE** dataPtr1,
+        int* sizePtr1,
+        const CSAMPLE** dataPtr2,
+        int* sizePtr2) {
+    const int capacity = m_pRing->capacity();
+    const std::uint64_t writePosition = m_pRing->writePosition();
+    const std::uint64_t lag = writePosition - m_readPosition;
+    if (lag > static_cast<std::uint64_t>(capacity - capacity / 4)) {
+        // Skip the oldest samples and keep half of the ring as headroom
+        // for the producer while the regions are in use. Both positions
+        // are multiples of the channel count, so the skipped samples
+        // are whole frames.
+        const std::uint64_t readPosition = writePosition - capacity / 2;
+        ++m_overrunCount;
+        m_lostSampleCount += readPosition - m_readPosition;
+        m_readPosition = readPosition;
+    }
+
+    const int available = static_cast<int>(writePosition - m_readPosition);
+    const int readCount = math_min(math_max(count, 0), available);
+    const int offset = static_cast<int>(m_readPosition & m_pRing->m_mask);
+    if (offset + readCount > capacity) {
+        // Wrap around the end of the buffer
+        const int size1 = capacity - offset;
+        *dataPtr1 = m_pRing->m_pBuffer + offset;
+        *sizePtr1 = size1;
+        *dataPtr2 = m_pRing->m_pBuffer;
+        *sizePtr2 = readCount - size1;
+    } else {
+        *dataPtr1 = m_pRing->m_pBuffer + offset;
+        *sizePtr1 = readCount;
+        *dataPtr2 = nullptr;
+        *sizePtr2 = 0;
+    }
+    return readCount;
+}
+
+bool SideChainRing::Reader::releaseReadRegions(int count) {
+    // Pairs with the fence in write(): If the producer has started to
+    // overwrite any of the samples we have read, we see its reservation.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const std::uint64_t reservedPosition =
+            m_pRing->m_reservedPosition.load(std::memory_order_relaxed);
+    const bool valid = reservedPosition - m_readPosition <=
+            static_cast<std::uint64_t>(m_pRing->capacity());
+    m_readPosition += static_cast<std::uint64_t>(count);
+    if (!valid) {
+        ++m_overrunCount;
+        m_lostSampleCount += static_cast<std::uint64_t>(count);
+    }
+    return valid;
+}
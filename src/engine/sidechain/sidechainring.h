@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "util/class.h"
+#include "util/types.h"
+
+/// Ring of samples that is written by a single producer, i.e. the engine
+/// callback, and read by any number of consumers at their own pace.
+///
+/// The producer copies each buffer only once, independent of the number of
+/// consumers, and never waits for them. Each consumer keeps its own read
+/// position in a Reader and copies the samples out of the ring. The copy
+/// is only valid if releaseReadRegions() succeeds. A consumer that
+/// falls too far behind is resynchronized and the lost samples are counted
+/// per consumer instead of blocking or slowing down the producer.
+///
+/// The ring is shared by the producer and the readers through a
+/// std::shared_ptr, so it stays valid until the last consumer is gone.
+class SideChainRing {
+  public:
+    /// The capacity is rounded up to the next power of 2
+    explicit SideChainRing(int size);
+    ~SideChainRing();
+
+    int capacity() const {
+        return static_cast<int>(m_mask + 1);
+    }
+
+    /// Producer: Appends count samples, overwriting the oldest ones
+    void write(const CSAMPLE* pBuffer, int count);
+
+    /// Total number of samples that have been written so far
+    std::uint64_t writePosition() const {
+        return m_writePosition.load(std::memory_order_acquire);
+    }
+
+    class Reader {
+      public:
+        /// Starts reading at the current write position of the ring
+        explicit Reader(std::shared_ptr<const SideChainRing> pRing);
+
+        int readAvailable() const;
+
+        /// Returns the number of samples that can be read from the regions,
+        /// at most count. If the reader has fallen behind so far that the
+        /// producer is about to overwrite unread samples, the oldest samples
+        /// are skipped first.
+        int aquireReadRegions(int count,
+                const CSAMPLE** dataPtr1,
+                int* sizePtr1,
+                const CSAMPLE** dataPtr2,
+                int* sizePtr2);
+        /// Advances the read position. Returns false if the producer has
+        /// overwritten the regions while they were in use, the samples that
+        /// have been read are invalid then.
+        bool releaseReadRegions(int count);
+
+        /// Number of times this reader has been resynchronized
+        int overrunCount() const {
+            return m_overrunCount;
+        }
+        /// Number of samples this reader has skipped or read invalid
+        std::uint64_t lostSampleCount() const {
+            return m_lostSampleCount;
+        }
+
+      private:
+        const std::shared_ptr<const SideChainRing> m_pRing;
+        std::uint64_t m_readPosition;
+        int m_overrunCount;
+        std::uint64_t m_lostSampleCount;
+    };
+
+  private:
+    CSAMPLE* const m_pBuffer;
+    const std::uint64_t m_mask;
+
+    // The positions are running freely, only the lower bits are used for
+    // addressing. The reserved position is published before the samples
+    // are copied and the write position afterwards (seqlock), this allows
+    // the readers to detect samples that have been overwritten while
+    // they were reading them.
+    std::atomic<std::uint64_t> m_reservedPosition;
+    std::atomic<std::uint64_t> m_writePosition;
+
+    DISALLOW_COPY_AND_ASSIGN(SideChainRing);
+};
@@ -36,7 +36,13 @@ AnalyzerModeFlags getAnalyzerModeFlags(
     // NOTE(uklotzde, 2018-12-26): The previous comment just states the status-quo
     // of the existing code. We should rethink the configuration of analyzers when
     // refactoring/redesigning the analyzer framework.
-    int modeFlags = AnalyzerModeFlags::WithBeats | AnalyzerModeFlags::LowPriority;
+    // Batch analysis reads the files ahead to keep the analyzer threads
+    // from competing for seeks on slow storage. Moved or duplicate files
+    // are recognized by their audio and not analyzed again. A quick first
+    // pass publishes a provisional BPM and key of all tracks.
+    int modeFlags = AnalyzerModeFlags::WithBeats | AnalyzerModeFlags::LowPriority |
+            AnalyzerModeFlags::Prefetch | AnalyzerModeFlags::ReuseResults |
+            AnalyzerModeFlags::Preview;
     if (pConfig->getValue<bool>(ConfigKey("[Library]", "EnableWaveformGenerationWithAnalysis"), true)) {
         modeFlags |= AnalyzerModeFlags::WithWaveform;
     }
@@ -149,6 +155,10 @@ void AnalysisFeature::analyzeTracks(const QList<AnalyzerScheduledTrack>& tracks)
                 &TrackAnalysisScheduler::progress,
                 m_pAnalysisView,
                 &DlgAnalysis::onTrackAnalysisSchedulerProgress);
+        connect(m_pTrackAnalysisScheduler.get(),
+                &TrackAnalysisScheduler::throughput,
+                m_pAnalysisView,
+                &DlgAnalysis::onTrackAnalysisSchedulerThroughput);
         connect(m_pTrackAnalysisScheduler.get(),
                 &TrackAnalysisScheduler::finished,
                 m_pAnalysisView,
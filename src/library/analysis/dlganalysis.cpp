@@ -161,6 +161,7 @@ void DlgAnalysis::slotAnalysisActive(bool bActive) {
         pushButtonAnalyze->setText(tr("Analyze"));
         labelProgress->setText("");
         labelProgress->setEnabled(false);
+        m_analyzerThroughput = AnalyzerThroughput();
     }
 }
 
@@ -182,10 +183,22 @@ void DlgAnalysis::onTrackAnalysisSchedulerProgress(
                     QString::number(finishedCount),
                     QString::number(totalCount));
         }
+        if (m_analyzerThroughput.tracksPerMinute > 0) {
+            progressText += QChar(' ') +
+                    tr("(%1 tracks/min, %2 MB/s)")
+                            .arg(QString::number(m_analyzerThroughput.tracksPerMinute, 'f', 1),
+                                    QString::number(m_analyzerThroughput.megabytesPerSecond,
+                                            'f',
+                                            1));
+        }
         labelProgress->setText(progressText);
     }
 }
 
+void DlgAnalysis::onTrackAnalysisSchedulerThroughput(AnalyzerThroughput analyzerThroughput) {
+    m_analyzerThroughput = analyzerThroughput;
+}
+
 void DlgAnalysis::onTrackAnalysisSchedulerFinished() {
     slotAnalysisActive(false);
 }
@@ -39,6 +39,7 @@ class DlgAnalysis : public QWidget, public Ui::DlgAnalysis, public virtual Libra
     void analyze();
     void slotAnalysisActive(bool bActive);
     void onTrackAnalysisSchedulerProgress(AnalyzerProgress analyzerProgress, int finishedCount, int totalCount);
+    void onTrackAnalysisSchedulerThroughput(AnalyzerThroughput analyzerThroughput);
     void onTrackAnalysisSchedulerFinished();
     void slotShowRecentSongs();
     void slotShowAllSongs();
@@ -55,6 +56,7 @@ class DlgAnalysis : public QWidget, public Ui::DlgAnalysis, public virtual Libra
     //Note m_pTrackTablePlaceholder is defined in the .ui file
     UserSettingsPointer m_pConfig;
     bool m_bAnalysisActive;
+    AnalyzerThroughput m_analyzerThroughput;
     QButtonGroup m_songsButtonGroup;
     WAnalysisLibraryTableView* m_pAnalysisLibraryTableView;
     AnalysisLibraryTableModel* m_pAnalysisLibraryTableModel;
@@ -1,5 +1,6 @@
 #include "library/dao/analysisdao.h"
 
+#include <QSet>
 #include <QSqlQuery>
 #include <QSqlRecord>
 #include <QtDebug>
@@ -10,6 +11,7 @@
 #include "waveform/waveform.h"
 
 const QString AnalysisDao::s_analysisTableName = "track_analysis";
+const QString AnalysisDao::s_audioDigestTableName = "track_audio_digests";
 
 // For a track that takes 1.2MB to store the big waveform, the default
 // compression level (-1) takes the size down to about 600KB. The difference
@@ -228,6 +230,12 @@ void AnalysisDao::deleteAnalyses(const QList<TrackId>& trackIds) {
     if (!query.exec()) {
         LOG_FAILED_QUERY(query) << "couldn't delete analysis";
     }
+    query.prepare(QString("DELETE FROM %1 "
+                          "WHERE track_id in (%2)")
+                          .arg(s_audioDigestTableName, idList.join(",")));
+    if (!query.exec()) {
+        LOG_FAILED_QUERY(query) << "couldn't delete audio digests";
+    }
 }
 
 bool AnalysisDao::deleteAnalysesForTrack(TrackId trackId) {
@@ -416,3 +424,79 @@ bool AnalysisDao::deleteAnalysesByType(
 
     return true;
 }
+
+bool AnalysisDao::saveAudioDigest(TrackId trackId, const QString& audioDigest) {
+    if (!m_database.isOpen() || !trackId.isValid() || audioDigest.isEmpty()) {
+        return false;
+    }
+
+    QSqlQuery query(m_database);
+    query.prepare(QString(
+            "INSERT OR REPLACE INTO %1 (track_id, digest) "
+            "VALUES (:trackId,:digest)")
+                          .arg(s_audioDigestTableName));
+    query.bindValue(":trackId", trackId.toVariant());
+    query.bindValue(":digest", audioDigest);
+    if (!query.exec()) {
+        LOG_FAILED_QUERY(query) << "couldn't save audio digest for track" << trackId;
+        return false;
+    }
+    return true;
+}
+
+TrackId AnalysisDao::findTrackByAudioDigest(
+        const QString& audioDigest, TrackId excludedTrackId) {
+    if (!m_database.isOpen() || audioDigest.isEmpty()) {
+        return TrackId();
+    }
+
+    // Prefer tracks that have not been removed from the library
+    QSqlQuery query(m_database);
+    query.prepare(QString(
+            "SELECT %1.track_id FROM %1 "
+            "INNER JOIN library ON library.id=%1.track_id "
+            "WHERE %1.digest=:digest AND %1.track_id<>:trackId "
+            "ORDER BY library.mixxx_deleted LIMIT 1")
+                          .arg(s_audioDigestTableName));
+    query.bindValue(":digest", audioDigest);
+    query.bindValue(":trackId", excludedTrackId.toVariant());
+    if (!query.exec()) {
+        LOG_FAILED_QUERY(query) << "couldn't find track by audio digest";
+        return TrackId();
+    }
+    if (!query.next()) {
+        return TrackId();
+    }
+    return TrackId(query.value(0));
+}
+
+bool AnalysisDao::copyAnalyses(TrackId fromTrackId, TrackId toTrackId) {
+    if (!m_database.isOpen() || !fromTrackId.isValid() || !toTrackId.isValid()) {
+        return false;
+    }
+
+    QSqlQuery query(m_database);
+    query.prepare(QString(
+            "SELECT type FROM %1 WHERE track_id=:trackId").arg(s_analysisTableName));
+    query.bindValue(":trackId", toTrackId.toVariant());
+    if (!query.exec()) {
+        LOG_FAILED_QUERY(query) << "couldn't get analyses for track" << toTrackId;
+        return false;
+    }
+    QSet<int> existingTypes;
+    while (query.next()) {
+        existingTypes.insert(query.value(0).toInt());
+    }
+
+    bool success = true;
+    const QList<AnalysisInfo> analyses = getAnalysesForTrack(fromTrackId);
+    for (AnalysisInfo analysis : analyses) {
+        if (existingTypes.contains(analysis.type)) {
+            continue;
+        }
+        analysis.analysisId = -1;
+        analysis.trackId = toTrackId;
+        success &= saveAnalysis(&analysis);
+    }
+    return success;
+}
@@ -12,6 +12,7 @@ class QSqlDatabase;
 class AnalysisDao : public DAO {
   public:
     static const QString s_analysisTableName;
+    static const QString s_audioDigestTableName;
 
     enum AnalysisType {
         TYPE_UNKNOWN = 0,
@@ -57,6 +58,15 @@ class AnalysisDao : public DAO {
             ConstWaveformPointer pWaveform,
             ConstWaveformPointer pWaveSummary);
 
+    // The audio digest identifies tracks with identical audio regardless
+    // of their file, see AnalyzerAudioDigest. It is only stored for tracks
+    // that have been analyzed completely.
+    bool saveAudioDigest(TrackId trackId, const QString& audioDigest);
+    // Returns an invalid id if no other track has the same audio digest
+    TrackId findTrackByAudioDigest(const QString& audioDigest, TrackId excludedTrackId);
+    // Copies the analyses of all types that are missing for the other track
+    bool copyAnalyses(TrackId fromTrackId, TrackId toTrackId);
+
   private:
     QDir getAnalysisStoragePath() const;
     QByteArray loadDataFromFile(const QString& fileName) const;
@@ -9,16 +9,23 @@
 #include <QtDebug>
 #include <QtGlobal>
 #include <cstdio>
+#include <cstdlib>
 #include <memory>
 #include <stdexcept>
 
 #include "config.h"
 #include "controllers/controllermanager.h"
 #include "coreservices.h"
+#include "engine/enginemixer.h"
+#include "engine/offlinerenderer.h"
 #include "errordialoghandler.h"
+#include "library/dao/trackschema.h"
+#include "library/trackcollection.h"
+#include "library/trackcollectionmanager.h"
+#include "mixer/deck.h"
 #include "mixxxapplication.h"
-#ifdef MIXXX_USE_QML
 #include "mixer/playermanager.h"
+#ifdef MIXXX_USE_QML
 #include "qml/qmlapplication.h"
 #include "waveform/guitick.h"
 #include "waveform/visualsmanager.h"
@@ -28,7 +35,10 @@
 #if defined(__WINDOWS__)
 #include "nativeeventhandlerwin.h"
 #endif
+#include "soundio/soundmanager.h"
 #include "sources/soundsourceproxy.h"
+#include "track/track.h"
+#include "util/assert.h"
 #include "util/cmdlineargs.h"
 #include "util/console.h"
 #include "util/logging.h"
@@ -40,12 +50,17 @@ namespace {
 // Exit codes
 constexpr int kFatalErrorOnStartupExitCode = 1;
 constexpr int kParseCmdlineArgsErrorExitCode = 2;
+constexpr int kRenderAutoDjErrorExitCode = 3;
 
 constexpr char kScaleFactorEnvVar[] = "QT_SCALE_FACTOR";
 const QString kConfigGroup = QStringLiteral("[Config]");
 const QString kScaleFactorKey = QStringLiteral("ScaleFactor");
 const QString kNotifyMaxDbgTimeKey = QStringLiteral("notify_max_dbg_time");
 
+const ConfigKey kAutoDjTransitionKey =
+        ConfigKey(QStringLiteral("[Auto DJ]"), QStringLiteral("Transition"));
+constexpr double kAutoDjTransitionDefault = 10.0;
+
 // The default initial QPixmapCache limit is 10MB.
 // But this is used for all CoverArts in all used sizes and
 // as rendering cache for all SVG icons by Qt behind the scenes.
@@ -56,9 +71,71 @@ const QString kNotifyMaxDbgTimeKey = QStringLiteral("notify_max_dbg_time");
 // An indicator that the QPixmapCache was too small.
 constexpr int kPixmapCacheLimitAt100PercentZoom = 32 * 1024; // 32 MByte
 
+// Renders the Auto DJ queue into a file without showing the main window.
+// Tracks are crossfaded with the fixed transition time of Auto DJ.
+int renderAutoDj(MixxxApplication* pApp, const CmdlineArgs& args) {
+    const QString fileName = args.getRenderAutoDjPath();
+    const QString encoding = OfflineRenderer::encodingForFileName(fileName);
+    if (encoding.isEmpty()) {
+        qCritical() << "Unsupported file format for rendering" << fileName;
+        return kRenderAutoDjErrorExitCode;
+    }
+
+    auto pCoreServices = std::make_shared<mixxx::CoreServices>(args, pApp);
+    pCoreServices->initialize(pApp);
+    if (ErrorDialogHandler::instance()->checkError()) {
+        return kFatalErrorOnStartupExitCode;
+    }
+    // The renderer drives the engine itself
+    pCoreServices->getSoundManager()->closeDevices(false);
+
+    const auto pTrackCollectionManager = pCoreServices->getTrackCollectionManager();
+    const PlaylistDAO& playlistDao =
+            pTrackCollectionManager->internalCollection()->getPlaylistDAO();
+    QList<TrackPointer> tracks;
+    const auto trackIds = playlistDao.getTrackIdsInPlaylistOrder(
+            playlistDao.getPlaylistIdFromName(AUTODJ_TABLE));
+    for (const auto& trackId : trackIds) {
+        TrackPointer pTrack = pTrackCollectionManager->getTrackById(trackId);
+        if (pTrack) {
+            tracks.append(pTrack);
+        }
+    }
+    if (tracks.isEmpty()) {
+        qCritical() << "The Auto DJ queue is empty";
+        return kRenderAutoDjErrorExitCode;
+    }
+
+    const auto pPlayerManager = pCoreServices->getPlayerManager();
+    VERIFY_OR_DEBUG_ASSERT(PlayerManager::numDecks() >= 2) {
+        return kRenderAutoDjErrorExitCode;
+    }
+    OfflineRenderer renderer(pCoreServices->getSettings(),
+            pCoreServices->getEngineMixer().get());
+    renderer.addPlayer(pPlayerManager->getDeck(1));
+    renderer.addPlayer(pPlayerManager->getDeck(2));
+    const double durationSeconds = renderer.addTrackSequence(tracks,
+            pCoreServices->getSettings()->getValue(
+                    kAutoDjTransitionKey, kAutoDjTransitionDefault));
+
+    qInfo() << "Rendering" << tracks.size() << "Auto DJ tracks to" << fileName;
+    QString errorMessage;
+    if (!renderer.render(fileName, encoding, durationSeconds, &errorMessage)) {
+        qCritical() << "Rendering the Auto DJ queue failed:" << errorMessage;
+        return kRenderAutoDjErrorExitCode;
+    }
+    qInfo() << "Rendered" << durationSeconds << "seconds"
+            << renderer.realtimeFactor() << "times faster than real time";
+    return EXIT_SUCCESS;
+}
+
 int runMixxx(MixxxApplication* pApp, const CmdlineArgs& args) {
     CmdlineArgs::Instance().parseForUserFeedback();
 
+    if (args.getRenderAutoDjEnabled()) {
+        return renderAutoDj(pApp, args);
+    }
+
     int exitCode;
 #ifdef MIXXX_USE_QML
     if (args.isQml()) {
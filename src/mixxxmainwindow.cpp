@@ -33,6 +33,7 @@
 #include "broadcast/broadcastmanager.h"
 #endif
 #include "control/controlindicatortimer.h"
+#include "engine/enginemixer.h"
 #include "library/library.h"
 #include "library/library_decl.h"
 #include "library/library_prefs.h"
@@ -1074,7 +1075,9 @@ void MixxxMainWindow::slotDeveloperTools(bool visible) {
     if (visible) {
         if (m_pDeveloperToolsDlg == nullptr) {
             UserSettingsPointer pConfig = m_pCoreServices->getSettings();
-            m_pDeveloperToolsDlg = new DlgDeveloperTools(this, pConfig);
+            m_pDeveloperToolsDlg = new DlgDeveloperTools(this,
+                    pConfig,
+                    m_pCoreServices->getEngineMixer()->getProfiler());
             connect(m_pDeveloperToolsDlg,
                     &DlgDeveloperTools::destroyed,
                     this,
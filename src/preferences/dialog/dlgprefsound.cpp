@@ -27,6 +27,8 @@ const ConfigKey kKeylockEngingeCfgkey =
         ConfigKey(kAppGroup, QStringLiteral("keylock_engine"));
 const ConfigKey kKeylockMultiThreadingCfgkey =
         ConfigKey(kAppGroup, QStringLiteral("keylock_multithreading"));
+const ConfigKey kKeylockLookAheadCfgkey =
+        ConfigKey(kAppGroup, QStringLiteral("keylock_lookahead"));
 
 bool soundItemAlreadyExists(const AudioPath& output, const QWidget& widget) {
     for (const QObject* pObj : widget.children()) {
@@ -80,6 +82,7 @@ DlgPrefSound::DlgPrefSound(QWidget* pParent,
           m_pBoothDelay(kMasterGroup, QStringLiteral("boothDelay")),
           m_pMicMonitorMode(kMasterGroup, QStringLiteral("talkover_mix")),
           m_pKeylockEngine(kKeylockEngingeCfgkey),
+          m_pKeylockLookAhead(kKeylockLookAheadCfgkey),
           m_settingsModified(false),
           m_bLatencyChanged(false),
           m_bSkipConfigClear(true),
@@ -231,8 +234,13 @@ DlgPrefSound::DlgPrefSound(QWidget* pParent,
             &QCheckBox::clicked,
             this,
             &DlgPrefSound::updateKeylockMultithreading);
+    connect(keylockLookAheadCheckBox,
+            &QCheckBox::clicked,
+            this,
+            &DlgPrefSound::settingChanged);
 #else
     keylockDualthreadedCheckBox->hide();
+    keylockLookAheadCheckBox->hide();
 #endif
 
     connect(queryButton, &QAbstractButton::clicked, this, &DlgPrefSound::queryClicked);
@@ -385,6 +393,11 @@ void DlgPrefSound::slotApply() {
                     tr("Mixxx must be restarted before the multi-threaded "
                        "RubberBand setting change will take effect."));
         }
+        // The control is persisted in the settings
+        m_pKeylockLookAhead.set(keylockLookAheadCheckBox->isChecked() &&
+                        keylockLookAheadCheckBox->isEnabled()
+                        ? 1.0
+                        : 0.0);
 #endif
         status = m_pSoundManager->setConfig(m_config);
         m_configValid = (status == SoundDeviceStatus::Ok);
@@ -599,6 +612,7 @@ void DlgPrefSound::loadSettings(const SoundManagerConfig& config) {
     keylockDualthreadedCheckBox->setChecked(m_pSettings->getValue(
             kKeylockMultiThreadingCfgkey,
             false));
+    keylockLookAheadCheckBox->setChecked(m_pKeylockLookAhead.toBool());
 #endif
 
     // Collect selected I/O channel indices for all non-empty device comboboxes
@@ -804,6 +818,7 @@ void DlgPrefSound::updateKeylockDualThreadingCheckbox() {
             EngineBuffer::KeylockEngine::SoundTouch;
     bool monoMix = mainOutputModeComboBox->currentIndex() == 1;
     keylockDualthreadedCheckBox->setEnabled(!monoMix && supportedScaler);
+    keylockLookAheadCheckBox->setEnabled(supportedScaler);
     keylockDualthreadedCheckBox->setToolTip(monoMix
                     ? kKeylockMultiThreadedUnavailableMono
                     : (supportedScaler
@@ -931,6 +946,10 @@ void DlgPrefSound::slotResetToDefaults() {
         keylockComboBox->setCurrentIndex(index);
     }
     m_pKeylockEngine.set(static_cast<double>(keylockEngine));
+#ifdef __RUBBERBAND__
+    keylockLookAheadCheckBox->setChecked(false);
+    m_pKeylockLookAhead.set(0.0);
+#endif
 
     mainMixComboBox->setCurrentIndex(1);
     m_pMainEnabled->set(1.0);
@@ -146,9 +146,9 @@ void SoundDeviceNetwork::readProcess(SINT framesPerBuffer) {
     int copyCount = qMin(writeAvailable, readAvailable);
     if (copyCount > 0) {
         CSAMPLE* dataPtr1;
-        ring_buffer_size_t size1;
+        int size1;
         CSAMPLE* dataPtr2;
-        ring_buffer_size_t size2;
+        int size2;
         (void)m_inputFifo->aquireWriteRegions(copyCount,
                 &dataPtr1, &size1, &dataPtr2, &size2);
         // Fetch fresh samples and write to the the input buffer
@@ -201,9 +201,9 @@ void SoundDeviceNetwork::readProcess(SINT framesPerBuffer) {
     }
     if (readCount) {
         CSAMPLE* dataPtr1;
-        ring_buffer_size_t size1;
+        int size1;
         CSAMPLE* dataPtr2;
-        ring_buffer_size_t size2;
+        int size2;
         // We use size1 and size2, so we can ignore the return value
         (void) m_inputFifo->aquireReadRegions(readCount, &dataPtr1, &size1,
                 &dataPtr2, &size2);
@@ -245,9 +245,9 @@ void SoundDeviceNetwork::writeProcess(SINT framesPerBuffer) {
     //qDebug() << "writeProcess():" << (float) writeAvailable / outChunkSize;
     if (writeCount > 0) {
         CSAMPLE* dataPtr1;
-        ring_buffer_size_t size1;
+        int size1;
         CSAMPLE* dataPtr2;
-        ring_buffer_size_t size2;
+        int size2;
         // We use size1 and size2, so we can ignore the return value
         (void)m_outputFifo->aquireWriteRegions(writeCount, &dataPtr1,
                 &size1, &dataPtr2, &size2);
@@ -265,9 +265,9 @@ void SoundDeviceNetwork::writeProcess(SINT framesPerBuffer) {
     int readAvailable = m_outputFifo->readAvailable();
 
     CSAMPLE* dataPtr1;
-    ring_buffer_size_t size1;
+    int size1;
     CSAMPLE* dataPtr2;
-    ring_buffer_size_t size2;
+    int size2;
     // Try to read as most frames as possible.
     // NetworkStreamWorker::processWrite takes care of
     // keeping every output worker in sync
@@ -292,8 +292,8 @@ void SoundDeviceNetwork::writeProcess(SINT framesPerBuffer) {
 
 void SoundDeviceNetwork::workerWriteProcess(NetworkOutputStreamWorkerPtr pWorker,
         int outChunkSize, int readAvailable,
-        CSAMPLE* dataPtr1, ring_buffer_size_t size1,
-        CSAMPLE* dataPtr2, ring_buffer_size_t size2) {
+        CSAMPLE* dataPtr1, int size1,
+        CSAMPLE* dataPtr2, int size2) {
     int writeExpectedFrames = static_cast<int>(
             pWorker->getStreamTimeFrames() - pWorker->framesWritten());
 
@@ -413,9 +413,9 @@ void SoundDeviceNetwork::workerWriteSilence(NetworkOutputStreamWorkerPtr pWorker
         int clearCount = math_min(writeAvailable, writeRequired);
         if (clearCount > 0) {
             CSAMPLE* dataPtr1;
-            ring_buffer_size_t size1;
+            int size1;
             CSAMPLE* dataPtr2;
-            ring_buffer_size_t size2;
+            int size2;
 
             (void)pFifo->aquireWriteRegions(clearCount,
                     &dataPtr1, &size1, &dataPtr2, &size2);
@@ -49,8 +49,8 @@ class SoundDeviceNetwork : public SoundDevice {
 
     void workerWriteProcess(NetworkOutputStreamWorkerPtr pWorker,
             int outChunkSize, int readAvailable,
-            CSAMPLE* dataPtr1, ring_buffer_size_t size1,
-            CSAMPLE* dataPtr2, ring_buffer_size_t size2);
+            CSAMPLE* dataPtr1, int size1,
+            CSAMPLE* dataPtr2, int size2);
     void workerWrite(NetworkOutputStreamWorkerPtr pWorker,
             const CSAMPLE* buffer, int frames);
     void workerWriteSilence(NetworkOutputStreamWorkerPtr pWorker, int frames);
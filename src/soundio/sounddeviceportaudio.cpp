@@ -311,9 +311,9 @@ SoundDeviceStatus SoundDevicePortAudio::open(bool isClkRefDevice, int syncBuffer
             int writeCount = m_outputParams.channelCount * framesPerBuffer *
                     kFifoSize / 2;
             CSAMPLE* dataPtr1;
-            ring_buffer_size_t size1;
+            int size1;
             CSAMPLE* dataPtr2;
-            ring_buffer_size_t size2;
+            int size2;
             (void)m_outputFifo->aquireWriteRegions(writeCount, &dataPtr1,
                     &size1, &dataPtr2, &size2);
             SampleUtil::clear(dataPtr1, size1);
@@ -327,9 +327,9 @@ SoundDeviceStatus SoundDevicePortAudio::open(bool isClkRefDevice, int syncBuffer
             int writeCount = m_inputParams.channelCount * framesPerBuffer *
                     kFifoSize / 2;
             CSAMPLE* dataPtr1;
-            ring_buffer_size_t size1;
+            int size1;
             CSAMPLE* dataPtr2;
-            ring_buffer_size_t size2;
+            int size2;
             (void)m_inputFifo->aquireWriteRegions(writeCount, &dataPtr1,
                     &size1, &dataPtr2, &size2);
             SampleUtil::clear(dataPtr1, size1);
@@ -540,9 +540,9 @@ void SoundDevicePortAudio::readProcess(SINT framesPerBuffer) {
                 // Initial call or underflow at last call
                 // Init half of the buffer with silence
                 CSAMPLE* dataPtr1;
-                ring_buffer_size_t size1;
+                int size1;
                 CSAMPLE* dataPtr2;
-                ring_buffer_size_t size2;
+                int size2;
                 (void)m_inputFifo->aquireWriteRegions(inChunkSize,
                         &dataPtr1, &size1, &dataPtr2, &size2);
                 // Fetch fresh samples and write to the the input buffer
@@ -560,9 +560,9 @@ void SoundDevicePortAudio::readProcess(SINT framesPerBuffer) {
             //qDebug() << "readProcess()" << (float)writeAvailable / inChunkSize << (float)readAvailable / inChunkSize;
             if (copyCount > 0) {
                 CSAMPLE* dataPtr1;
-                ring_buffer_size_t size1;
+                int size1;
                 CSAMPLE* dataPtr2;
-                ring_buffer_size_t size2;
+                int size2;
                 (void)m_inputFifo->aquireWriteRegions(copyCount,
                         &dataPtr1, &size1, &dataPtr2, &size2);
                 // Fetch fresh samples and write to the the input buffer
@@ -634,9 +634,9 @@ void SoundDevicePortAudio::readProcess(SINT framesPerBuffer) {
         //qDebug() << "readProcess()" << (float)readAvailable / inChunkSize;
         if (readCount) {
             CSAMPLE* dataPtr1;
-            ring_buffer_size_t size1;
+            int size1;
             CSAMPLE* dataPtr2;
-            ring_buffer_size_t size2;
+            int size2;
             // We use size1 and size2, so we can ignore the return value
             (void) m_inputFifo->aquireReadRegions(readCount, &dataPtr1, &size1,
                     &dataPtr2, &size2);
@@ -677,9 +677,9 @@ void SoundDevicePortAudio::writeProcess(SINT framesPerBuffer) {
         }
         if (writeCount > 0) {
             CSAMPLE* dataPtr1;
-            ring_buffer_size_t size1;
+            int size1;
             CSAMPLE* dataPtr2;
-            ring_buffer_size_t size2;
+            int size2;
             // We use size1 and size2, so we can ignore the return value
             (void) m_outputFifo->aquireWriteRegions(writeCount, &dataPtr1,
                     &size1, &dataPtr2, &size2);
@@ -704,9 +704,9 @@ void SoundDevicePortAudio::writeProcess(SINT framesPerBuffer) {
             //qDebug() << "SoundDevicePortAudio::writeProcess()" << (float)readAvailable / outChunkSize << (float)writeAvailable / outChunkSize;
             if (copyCount > 0) {
                 CSAMPLE* dataPtr1;
-                ring_buffer_size_t size1;
+                int size1;
                 CSAMPLE* dataPtr2;
-                ring_buffer_size_t size2;
+                int size2;
                 m_outputFifo->aquireReadRegions(copyCount,
                         &dataPtr1, &size1, &dataPtr2, &size2);
                 if (writeAvailable >= outChunkSize * 2) {
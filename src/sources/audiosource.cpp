@@ -293,7 +293,8 @@ ReadableSampleFrames AudioSource::readSampleFrames(
         ReadableSampleFrames readable = readSampleFramesClamped(writable);
         DEBUG_ASSERT(readable.frameIndexRange().empty() ||
                 readable.frameIndexRange().isSubrangeOf(writable.frameIndexRange()));
-        if (readable.frameIndexRange() != writable.frameIndexRange()) {
+        if (readable.frameIndexRange() != writable.frameIndexRange() &&
+                !isShortReadTransient()) {
             kLogger.warning()
                     << "Failed to read sample frames:"
                     << "expected =" << writable.frameIndexRange()
@@ -339,6 +339,16 @@ class AudioSource : public UrlResource, public virtual /*implements*/ IAudioSour
     ReadableSampleFrames readSampleFrames(
             const WritableSampleFrames& sampleFrames);
 
+    // A short read is usually caused by corrupt audio data and the
+    // readable frame index range is shrunk accordingly. Sources that
+    // are only temporarily unable to provide some frames, e.g. while
+    // the audio data is still being downloaded, return true after such
+    // a short read to keep the frame index range unmodified. Readers
+    // should then request the missing frames again later.
+    virtual bool isShortReadTransient() const {
+        return false;
+    }
+
   protected:
     explicit AudioSource(const QUrl& url);
 
@@ -45,6 +45,10 @@ class AudioSourceProxy : public AudioSource {
         adjustFrameIndexRangeOn(*m_pAudioSource, frameIndexRange);
     }
 
+    bool isShortReadTransient() const override {
+        return m_pAudioSource->isShortReadTransient();
+    }
+
     const AudioSourcePointer m_pAudioSource;
 };
 
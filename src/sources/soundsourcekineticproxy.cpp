@@ -1,33 +1,276 @@
-#include "soundsourcekineticproxy.h"
+#include "sources/soundsourcekineticproxy.h"
 
-SoundSourceKineticProxy::SoundSourceKineticProxy(const QString& virtualPath)
-        : m_virtualPath(virtualPath) {
+#include <algorithm>
+
+#include "moc_soundsourcekineticproxy.cpp"
+#include "streaming/bridge/streamcachemanager.h"
+#include "util/assert.h"
+#include "util/logger.h"
+#include "util/sample.h"
+
+namespace mixxx {
+
+namespace {
+
+const Logger kLogger("SoundSourceKineticProxy");
+
+// The decoder needs the container header to open the file
+constexpr int64_t kHeaderBytes = 64 * 1024;
+
+// Decoders may read some frames ahead of the requested position for
+// preroll or to find the next frame header
+constexpr int64_t kLeadingMarginBytes = 16 * 1024;
+
+// Covers read ahead of the decoder and bitrate variations
+constexpr int64_t kTrailingMarginBytes = 16 * 1024;
+
+} // anonymous namespace
+
+SoundSourceKineticProxy::SoundSourceKineticProxy(const QUrl& url,
+        std::shared_ptr<SparseCache> pCache,
+        SoundSourcePointer pDecoder)
+        : SoundSource(url, pDecoder ? pDecoder->getType() : getTypeFromUrl(url)),
+          m_pCache(std::move(pCache)),
+          m_pDecoder(std::move(pDecoder)),
+          m_underrunPending(false),
+          m_underrunCount(0),
+          m_underrunFrameCount(0) {
 }
 
 SoundSourceKineticProxy::~SoundSourceKineticProxy() {
+    close();
 }
 
-unsigned SoundSourceKineticProxy::read(unsigned long size, const SAMPLE* destination) {
-    // Stub
-    return 0;
+void SoundSourceKineticProxy::close() {
+    m_pPcmCache.reset();
+    if (m_pDecoder) {
+        m_pDecoder->close();
+    }
+    m_underrunPending = false;
 }
 
-void SoundSourceKineticProxy::seek(long filepos) {
-    // Stub
+SoundSource::OpenResult SoundSourceKineticProxy::tryOpen(
+        OpenMode mode,
+        const OpenParams& params) {
+    VERIFY_OR_DEBUG_ASSERT(m_pCache && m_pDecoder) {
+        return OpenResult::Aborted;
+    }
+    if (!m_pCache->hasBackingFile() || m_pCache->getTotalSize() <= 0) {
+        kLogger.warning()
+                << "No backing file available for"
+                << getUrlString();
+        return OpenResult::Aborted;
+    }
+    // Opening the decoder on a header that has not been downloaded yet
+    // would parse zeros and fail permanently
+    const int64_t headerBytes = std::min(kHeaderBytes, m_pCache->getTotalSize());
+    if (!m_pCache->isRangeCached(0, headerBytes)) {
+        kLogger.info()
+                << "Header not downloaded yet"
+                << getUrlString();
+        return OpenResult::Aborted;
+    }
+
+    const OpenResult result = tryOpenOn(*m_pDecoder, mode, params);
+    if (result != OpenResult::Succeeded) {
+        return result;
+    }
+    if (!initChannelCountOnce(m_pDecoder->getSignalInfo().getChannelCount()) ||
+            !initSampleRateOnce(m_pDecoder->getSignalInfo().getSampleRate()) ||
+            !initBitrateOnce(m_pDecoder->getBitrate()) ||
+            !initFrameIndexRangeOnce(m_pDecoder->frameIndexRange())) {
+        return OpenResult::Failed;
+    }
+    if (!m_pcmCachePath.isEmpty()) {
+        auto pPcmCache = std::make_unique<PcmChunkCache>();
+        if (pPcmCache->open(m_pcmCachePath.toStdString(),
+                    getSignalInfo(),
+                    frameIndexRange())) {
+            m_pPcmCache = std::move(pPcmCache);
+        } else {
+            // Not fatal, every read will be decoded
+            kLogger.warning()
+                    << "Failed to open PCM cache"
+                    << m_pcmCachePath;
+        }
+    }
+    return OpenResult::Succeeded;
 }
 
-long SoundSourceKineticProxy::length() const {
-    return 0;
+ReadableSampleFrames SoundSourceKineticProxy::readSampleFramesClamped(
+        const WritableSampleFrames& sampleFrames) {
+    m_underrunPending = false;
+
+    const auto requestedRange = sampleFrames.frameIndexRange();
+    const bool writeSamples = !sampleFrames.writableSlice().empty();
+    // Returns the frames from the start of the request up to endFrame
+    const auto readableUpTo = [&](SINT endFrame) {
+        const auto readableRange = IndexRange::between(requestedRange.start(), endFrame);
+        if (!writeSamples) {
+            return ReadableSampleFrames(readableRange);
+        }
+        return ReadableSampleFrames(readableRange,
+                SampleBuffer::ReadableSlice(
+                        sampleFrames.writableData(),
+                        getSignalInfo().frames2samples(readableRange.length())));
+    };
+
+    // Chunks that have been decoded before don't need the decoder
+    SINT firstFrame = requestedRange.start();
+    if (m_pPcmCache && writeSamples) {
+        firstFrame += m_pPcmCache->read(requestedRange, sampleFrames.writableData());
+        if (firstFrame == requestedRange.end()) {
+            if (m_pCacheManager) {
+                m_pCacheManager->recordHit();
+            }
+            return readableUpTo(firstFrame);
+        }
+    }
+
+    const SINT endFrame = readableEndFrame(
+            IndexRange::between(firstFrame, requestedRange.end()));
+    DEBUG_ASSERT(endFrame >= firstFrame);
+    DEBUG_ASSERT(endFrame <= requestedRange.end());
+    if (endFrame > firstFrame) {
+        const auto decodeRange = IndexRange::between(firstFrame, endFrame);
+        const SINT sampleOffset = getSignalInfo().frames2samples(
+                firstFrame - requestedRange.start());
+        SampleBuffer::WritableSlice writableSlice;
+        if (writeSamples) {
+            writableSlice = SampleBuffer::WritableSlice(
+                    sampleFrames.writableData(sampleOffset),
+                    getSignalInfo().frames2samples(decodeRange.length()));
+        }
+        const auto decoded = m_pDecoder->readSampleFrames(
+                WritableSampleFrames(decodeRange, writableSlice));
+        if (decoded.frameIndexRange() != decodeRange) {
+            // A decoding error that is not related to missing data
+            if (decoded.frameIndexRange().empty() ||
+                    decoded.frameIndexRange().start() != firstFrame) {
+                return readableUpTo(firstFrame);
+            }
+            return readableUpTo(decoded.frameIndexRange().end());
+        }
+        if (m_pPcmCache && writeSamples) {
+            m_pPcmCache->write(decodeRange, sampleFrames.writableData(sampleOffset));
+        }
+    }
+    if (endFrame == requestedRange.end()) {
+        if (m_pCacheManager) {
+            m_pCacheManager->recordHit();
+        }
+        return readableUpTo(endFrame);
+    }
+
+    // Underrun: Fill the frames that are not available yet with silence
+    // and report them without shrinking the frame index range
+    const SINT missingFrames = requestedRange.end() - endFrame;
+    if (writeSamples) {
+        const SINT sampleOffset = getSignalInfo().frames2samples(
+                endFrame - requestedRange.start());
+        SampleUtil::clear(
+                sampleFrames.writableData(sampleOffset),
+                getSignalInfo().frames2samples(missingFrames));
+    }
+    m_underrunPending = true;
+    m_underrunCount.fetch_add(1, std::memory_order_relaxed);
+    m_underrunFrameCount.fetch_add(missingFrames, std::memory_order_relaxed);
+    if (m_pCacheManager) {
+        m_pCacheManager->recordMiss();
+    }
+    if (kLogger.debugEnabled()) {
+        kLogger.debug()
+                << "Underrun while reading"
+                << requestedRange
+                << "- missing"
+                << missingFrames
+                << "frames";
+    }
+    emit bufferUnderrun(endFrame, missingFrames);
+    return readableUpTo(endFrame);
+}
+
+void SoundSourceKineticProxy::adjustFrameIndexRange(
+        IndexRange frameIndexRange) {
+    // Keep both the proxy and the inner decoder in sync. The decoder
+    // might already have shrunk its own range after a decoding error.
+    AudioSource::adjustFrameIndexRange(frameIndexRange);
+    const auto decoderFrameIndexRange =
+            intersect(frameIndexRange, m_pDecoder->frameIndexRange());
+    if (decoderFrameIndexRange != m_pDecoder->frameIndexRange()) {
+        adjustFrameIndexRangeOn(*m_pDecoder, decoderFrameIndexRange);
+    }
+}
+
+int64_t SoundSourceKineticProxy::byteOffsetForFrame(SINT frameIndex) const {
+    const auto range = frameIndexRange();
+    if (range.empty()) {
+        return 0;
+    }
+    const double position =
+            static_cast<double>(range.clampIndex(frameIndex) - range.start()) /
+            range.length();
+    return static_cast<int64_t>(position * m_pCache->getTotalSize());
+}
+
+SINT SoundSourceKineticProxy::frameIndexForByteOffset(int64_t byteOffset) const {
+    const auto range = frameIndexRange();
+    const int64_t totalSize = m_pCache->getTotalSize();
+    if (totalSize <= 0) {
+        return range.start();
+    }
+    const double position =
+            static_cast<double>(std::clamp<int64_t>(byteOffset, 0, totalSize)) /
+            totalSize;
+    return range.clampIndex(range.start() +
+            static_cast<SINT>(position * range.length()));
+}
+
+SINT SoundSourceKineticProxy::readableEndFrame(IndexRange frameIndexRange) const {
+    if (frameIndexRange.empty() || m_pCache->isFullyCached()) {
+        return frameIndexRange.end();
+    }
+    const int64_t startByte = std::max<int64_t>(0,
+            byteOffsetForFrame(frameIndexRange.start()) - kLeadingMarginBytes);
+    const int64_t cachedBytes = m_pCache->getCachedLength(startByte);
+    if (cachedBytes <= 0) {
+        return frameIndexRange.start();
+    }
+    const int64_t cachedEndByte = startByte + cachedBytes;
+    if (cachedEndByte >= m_pCache->getTotalSize()) {
+        return frameIndexRange.end();
+    }
+    const SINT endFrame = frameIndexForByteOffset(
+            cachedEndByte - kTrailingMarginBytes);
+    return std::clamp(endFrame, frameIndexRange.start(), frameIndexRange.end());
 }
 
 double SoundSourceKineticProxy::getCachedPercentage() const {
-    return 0.0;
+    return m_pCache ? m_pCache->getCachedPercentage() : 0.0;
 }
 
-QVector<QPair<qint64, qint64>> SoundSourceKineticProxy::getCachedRanges() const {
-    return {};
+QVector<IndexRange> SoundSourceKineticProxy::getCachedFrameRanges() const {
+    QVector<IndexRange> frameRanges;
+    if (!m_pCache || frameIndexRange().empty()) {
+        return frameRanges;
+    }
+    const int64_t totalSize = m_pCache->getTotalSize();
+    for (const auto& range : m_pCache->getAllCachedRanges()) {
+        const SINT startFrame = range.start > 0
+                ? frameIndexForByteOffset(range.start + kLeadingMarginBytes)
+                : frameIndexMin();
+        const SINT endFrame = range.end < totalSize
+                ? frameIndexForByteOffset(range.end - kTrailingMarginBytes)
+                : frameIndexMax();
+        if (startFrame < endFrame) {
+            frameRanges.append(IndexRange::between(startFrame, endFrame));
+        }
+    }
+    return frameRanges;
 }
 
 bool SoundSourceKineticProxy::isFullyCached() const {
-    return false;
+    return m_pCache && m_pCache->isFullyCached();
 }
+
+} // namespace mixxx
@@ -1,58 +1,112 @@
 #pragma once
 
-#include "sources/soundsource.h" // existing mixxx base
-#include "util/defs.h" // For SINT, etc.
-#include <QPair>
-#include <QString>
+#include <QObject>
 #include <QVector>
 #include <atomic>
 #include <memory>
 
-// Forward declaration
-template<typename T, size_t Capacity>
-class StreamRingBuffer;
-
-class SoundSourceKineticProxy : public SoundSource {
-    // Q_OBJECT // SoundSource might not be a QObject in mixxx?
-    // Spec showed QObject macros in StreamingService but not explicit in SoundSourceProxy snippet
-    // except for signals. SoundSource usually isn't a QObject.
-    // If signals are required, we might need to inherit QObject too or use a helper.
-    // Spec says: "signals: signal void bufferUnderrun();" - pseudosyntax.
-    // We will assume it needs QObject or similar mechanism.
-    // For now, adhering to C++ structure.
-  public:
-    explicit SoundSourceKineticProxy(const QString& virtualPath);
-    virtual ~SoundSourceKineticProxy();
+#include "sources/soundsource.h"
+#include "streaming/bridge/pcmchunkcache.h"
+#include "streaming/bridge/sparsecache.h"
+
+class StreamCacheManager;
 
-    // SoundSource interface - MUST return immediately
-    // Note: The signature in mixxx 2.4+ might differ.
-    // Found in existing proxy: ReadableSampleFrames readSampleFramesClamped(...)
-    // We'll use the spec's intended override.
-    // unsigned read(unsigned long size, const SAMPLE * destination) = 0; // Spec version
+namespace mixxx {
+
+/// Decodes a streamed track that is only partially downloaded.
+///
+/// The compressed data is read by an inner decoder from the backing file of
+/// the track's SparseCache, never through the FUSE mount or the network.
+/// Before delegating a read the proxy checks that the byte range which the
+/// decoder will need is cached. Reads are cut short before the first frame
+/// whose data is missing and the remaining frames are filled with silence.
+/// Those frames are reported as an underrun and not as a decoding error,
+/// i.e. the readable frame index range of the source is not shrunk and the
+/// frames can be read again once they arrive.
+///
+/// Reads never block, a deck playing into a region that has not been
+/// downloaded yet will only produce silence for the missing frames.
+///
+/// Byte offsets are derived from frame indices assuming a constant bitrate.
+/// A safety margin on both sides of each range covers decoder preroll and
+/// moderate bitrate variations.
+///
+/// Optionally the decoded samples are kept in a PcmChunkCache on disk.
+/// Frames of chunks that have been decoded once are then copied from there
+/// instead of seeking and decoding again.
+class SoundSourceKineticProxy : public QObject, public SoundSource {
+    Q_OBJECT
+  public:
+    SoundSourceKineticProxy(const QUrl& url,
+            std::shared_ptr<SparseCache> pCache,
+            SoundSourcePointer pDecoder);
+    ~SoundSourceKineticProxy() override;
 
-    // Using the one found in existing code to be safe?
-    // readableSampleFrames readSampleFramesClamped(const WritableSampleFrames& writableFrames) override;
+    void close() override;
 
-    // Spec says:
-    // virtual unsigned read(unsigned long size, const SAMPLE * destination) = 0;
-    // We will put the Spec version commenting the potential mismatch.
-    unsigned read(unsigned long size, const SAMPLE* destination) override;
+    /// Enables the PcmChunkCache at path. Takes effect when (re-)opening.
+    void setPcmCachePath(const QString& pcmCachePath) {
+        m_pcmCachePath = pcmCachePath;
+    }
 
-    void seek(long filepos) override;
-    long length() const override;
+    /// Reports cache hits and underruns to the manager, if set.
+    void setCacheManager(std::shared_ptr<StreamCacheManager> pCacheManager) {
+        m_pCacheManager = std::move(pCacheManager);
+    }
 
-    // Streaming extensions
     double getCachedPercentage() const;
-    QVector<QPair<qint64, qint64>> getCachedRanges() const;
+    /// Frame ranges that are expected to be decodable without underruns.
+    QVector<IndexRange> getCachedFrameRanges() const;
     bool isFullyCached() const;
 
-    // Mock signals (until we verify SoundSource inherits QObject)
-    // signal void bufferUnderrun();
-    // signal void cacheProgressChanged(double percentage);
+    bool isShortReadTransient() const override {
+        return m_underrunPending;
+    }
+
+    /// Number of reads that have been cut short, accessible from any thread.
+    int getUnderrunCount() const {
+        return m_underrunCount.load(std::memory_order_relaxed);
+    }
+    /// Total number of frames that could not be read in time.
+    qint64 getUnderrunFrameCount() const {
+        return m_underrunFrameCount.load(std::memory_order_relaxed);
+    }
+
+  signals:
+    /// Emitted from the reading thread, use queued connections.
+    void bufferUnderrun(qint64 firstFrame, qint64 frameCount);
+
+  protected:
+    OpenResult tryOpen(
+            OpenMode mode,
+            const OpenParams& params) override;
+
+    ReadableSampleFrames readSampleFramesClamped(
+            const WritableSampleFrames& sampleFrames) override;
+
+    void adjustFrameIndexRange(
+            IndexRange frameIndexRange) override;
 
   private:
-    // std::unique_ptr<StreamRingBuffer> m_buffer;
-    QString m_virtualPath;
-    qint64 m_totalFrames;
-    std::atomic<bool> m_underrunState;
+    int64_t byteOffsetForFrame(SINT frameIndex) const;
+    SINT frameIndexForByteOffset(int64_t byteOffset) const;
+    /// Returns the end of the longest prefix of frameIndexRange that can
+    /// be decoded from cached data.
+    SINT readableEndFrame(IndexRange frameIndexRange) const;
+
+    const std::shared_ptr<SparseCache> m_pCache;
+    const SoundSourcePointer m_pDecoder;
+
+    QString m_pcmCachePath;
+    std::unique_ptr<PcmChunkCache> m_pPcmCache;
+    std::shared_ptr<StreamCacheManager> m_pCacheManager;
+
+    /// Set by a short read that was caused by missing data. Only accessed
+    /// from the reading thread.
+    bool m_underrunPending;
+
+    std::atomic<int> m_underrunCount;
+    std::atomic<qint64> m_underrunFrameCount;
 };
+
+} // namespace mixxx
@@ -39,6 +39,7 @@
 #ifdef __STEM__
 #include "sources/soundsourcestem.h"
 #endif
+#include "sources/soundsourcestream.h"
 
 #include "library/coverartutils.h"
 #include "track/globaltrackcache.h"
@@ -529,7 +530,9 @@ bool SoundSourceProxy::initSoundSourceWithProvider(
     DEBUG_ASSERT(!m_pProvider);
     DEBUG_ASSERT(!m_pSoundSource);
     DEBUG_ASSERT(pProvider);
-    m_pSoundSource = pProvider->newSoundSource(m_url);
+    // Partially downloaded streams must never be decoded from missing data
+    m_pSoundSource = mixxx::SoundSourceStream::proxyIfStreamed(
+            m_url, pProvider->newSoundSource(m_url));
     if (!m_pSoundSource) {
         kLogger.warning() << "SoundSourceProvider"
                           << pProvider->getDisplayName()
@@ -1,8 +1,154 @@
-#include "soundsourcestream.h"
+#include "sources/soundsourcestream.h"
 
-SoundSourceStream::SoundSourceStream(const QString& virtualPath)
-        : SoundSourceKineticProxy(virtualPath) {
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <map>
+
+#include "moc_soundsourcestream.cpp"
+#include "sources/soundsourceproxy.h"
+#include "streaming/bridge/streamcachemanager.h"
+#include "util/compatibility/qmutex.h"
+#include "util/logger.h"
+
+namespace mixxx {
+
+namespace {
+
+const Logger kLogger("SoundSourceStream");
+
+QMutex s_cachesMutex;
+QString s_cacheDirectory;
+std::shared_ptr<StreamCacheManager> s_pCacheManager;
+// Keyed by the path of the backing file. The caches are owned by their users.
+std::map<QString, std::weak_ptr<SparseCache>> s_caches;
+
+SoundSourcePointer newDecoder(const QUrl& url, const QString& fileType) {
+    const auto pProvider =
+            SoundSourceProxy::getPrimaryProviderForFileType(fileType);
+    if (!pProvider) {
+        return nullptr;
+    }
+    return pProvider->newSoundSource(url);
+}
+
+QUrl backingFileUrl(const std::shared_ptr<SparseCache>& pCache) {
+    if (!pCache) {
+        return QUrl();
+    }
+    return QUrl::fromLocalFile(
+            QString::fromStdString(pCache->getBackingFilePath()));
+}
+
+} // anonymous namespace
+
+SoundSourceStream::SoundSourceStream(std::shared_ptr<SparseCache> pCache,
+        const QString& fileType,
+        bool cacheDecodedSamples)
+        : SoundSourceKineticProxy(backingFileUrl(pCache),
+                  pCache,
+                  newDecoder(backingFileUrl(pCache), fileType)) {
+    if (cacheDecodedSamples && pCache) {
+        setPcmCachePath(pcmCachePathFor(pCache->getBackingFilePath()));
+    }
 }
 
 SoundSourceStream::~SoundSourceStream() {
 }
+
+// static
+QString SoundSourceStream::pcmCachePathFor(const std::string& backingFilePath) {
+    return QString::fromStdString(PcmChunkCache::pathForBackingFile(backingFilePath));
+}
+
+// static
+void SoundSourceStream::setCacheDirectory(const QString& directory) {
+    const auto locker = lockMutex(&s_cachesMutex);
+    s_cacheDirectory = directory.isEmpty()
+            ? QString()
+            : QDir::cleanPath(QDir(directory).absolutePath());
+}
+
+// static
+QString SoundSourceStream::getCacheDirectory() {
+    const auto locker = lockMutex(&s_cachesMutex);
+    return s_cacheDirectory;
+}
+
+// static
+void SoundSourceStream::setCacheManager(
+        std::shared_ptr<StreamCacheManager> pCacheManager) {
+    const auto locker = lockMutex(&s_cachesMutex);
+    s_pCacheManager = std::move(pCacheManager);
+}
+
+// static
+std::shared_ptr<SparseCache> SoundSourceStream::sharedCacheForFile(
+        const QString& filePath) {
+    const QFileInfo fileInfo(filePath);
+    const QString path = QDir::cleanPath(fileInfo.absoluteFilePath());
+    const auto locker = lockMutex(&s_cachesMutex);
+    if (s_cacheDirectory.isEmpty() ||
+            QDir::cleanPath(fileInfo.absolutePath()) != s_cacheDirectory) {
+        return nullptr;
+    }
+    for (auto it = s_caches.begin(); it != s_caches.end();) {
+        if (it->first == path) {
+            if (auto pCache = it->second.lock()) {
+                return pCache;
+            }
+        }
+        if (it->second.expired()) {
+            it = s_caches.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    // Only backing files have a sidecar index. The file itself has the
+    // size of the complete stream.
+    const std::string backingFilePath = path.toStdString();
+    if (!QFile::exists(QString::fromStdString(
+                SparseCache::indexPathFor(backingFilePath))) ||
+            fileInfo.size() <= 0) {
+        return nullptr;
+    }
+    auto pCache = std::make_shared<SparseCache>(fileInfo.size());
+    if (!pCache->openBackingFile(backingFilePath)) {
+        kLogger.warning()
+                << "Failed to open the backing file"
+                << path;
+        return nullptr;
+    }
+    s_caches.emplace(path, pCache);
+    return pCache;
+}
+
+// static
+SoundSourcePointer SoundSourceStream::proxyIfStreamed(
+        const QUrl& url,
+        SoundSourcePointer pDecoder) {
+    if (!pDecoder || !url.isLocalFile()) {
+        return pDecoder;
+    }
+    auto pCache = sharedCacheForFile(url.toLocalFile());
+    if (!pCache) {
+        return pDecoder;
+    }
+    std::shared_ptr<StreamCacheManager> pCacheManager;
+    {
+        const auto locker = lockMutex(&s_cachesMutex);
+        pCacheManager = s_pCacheManager;
+    }
+    if (pCacheManager) {
+        // Fully cached tracks are never handed to the prefetcher, but
+        // must not be evicted while they are open either
+        pCacheManager->trackOpened(pCache);
+    }
+    auto pProxy = std::make_shared<SoundSourceKineticProxy>(
+            url, std::move(pCache), std::move(pDecoder));
+    pProxy->setCacheManager(std::move(pCacheManager));
+    return pProxy;
+}
+
+} // namespace mixxx
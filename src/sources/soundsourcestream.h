@@ -1,11 +1,45 @@
 #pragma once
 
-#include "soundsourcekineticproxy.h"
+#include "sources/soundsourcekineticproxy.h"
 
+namespace mixxx {
+
+/// A SoundSourceKineticProxy that decodes the backing file of the cache
+/// with the primary SoundSource provider registered for fileType.
+///
+/// If cacheDecodedSamples is set the decoded samples are stored next to the
+/// backing file, see pcmCachePathFor().
 class SoundSourceStream : public SoundSourceKineticProxy {
+    Q_OBJECT
   public:
-    explicit SoundSourceStream(const QString& virtualPath);
+    SoundSourceStream(std::shared_ptr<SparseCache> pCache,
+            const QString& fileType,
+            bool cacheDecodedSamples = false);
     ~SoundSourceStream() override;
 
-    // Implement abstract methods if any remaining
+    static QString pcmCachePathFor(const std::string& backingFilePath);
+
+    /// Streamed tracks are stored as SparseCache backing files in the cache
+    /// directory. Opening one of them through SoundSourceProxy decodes it
+    /// with a SoundSourceKineticProxy. Disabled if empty.
+    static void setCacheDirectory(const QString& directory);
+    static QString getCacheDirectory();
+
+    /// The manager that streamed tracks opened by proxyIfStreamed() report
+    /// to. Tracks stay registered as in use while they are open.
+    static void setCacheManager(std::shared_ptr<StreamCacheManager> pCacheManager);
+
+    /// Returns the cache of the streamed track stored at filePath or nullptr
+    /// if the file is not a streamed track. All users of the track share the
+    /// same cache, i.e. the data that one of them downloads is immediately
+    /// visible to the others.
+    static std::shared_ptr<SparseCache> sharedCacheForFile(const QString& filePath);
+
+    /// Wraps pDecoder into a SoundSourceKineticProxy if url refers to a
+    /// streamed track. Otherwise pDecoder is returned unmodified.
+    static SoundSourcePointer proxyIfStreamed(
+            const QUrl& url,
+            SoundSourcePointer pDecoder);
 };
+
+} // namespace mixxx
@@ -1,30 +1,345 @@
 #include "fusedriver.h"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 
-FuseDriver::FuseDriver() {
+namespace {
+
+// Tracks never change while they are registered, so the kernel may cache
+// attributes and directory entries for a long time.
+constexpr double kAttrTimeoutSeconds = 3600.0;
+
+} // anonymous namespace
+
+FuseDriver::FuseDriver(RangeFetcher* pFetcher)
+        : m_pFetcher(pFetcher),
+          m_nextIno(FUSE_ROOT_ID + 1) {
 }
 
 FuseDriver::~FuseDriver() {
+    // The session might be gone already, see failPendingReads()
+    const auto lock = std::lock_guard(m_pendingMutex);
+    if (!m_pendingReads.empty()) {
+        std::cerr << "FuseDriver: Dropping " << m_pendingReads.size()
+                  << " pending reads" << std::endl;
+    }
+}
+
+void FuseDriver::failPendingReads(int error) {
+    std::multimap<fuse_ino_t, PendingRead> pendingReads;
+    {
+        const auto lock = std::lock_guard(m_pendingMutex);
+        pendingReads.swap(m_pendingReads);
+    }
+    for (const auto& [ino, pending] : pendingReads) {
+        replyError(pending.req, error);
+    }
+}
+
+// static
+const fuse_lowlevel_ops& FuseDriver::operations() {
+    static const fuse_lowlevel_ops kOperations = [] {
+        fuse_lowlevel_ops ops;
+        std::memset(&ops, 0, sizeof(ops));
+        ops.init = &FuseDriver::init;
+        ops.lookup = &FuseDriver::lookup;
+        ops.getattr = &FuseDriver::getattr;
+        ops.open = &FuseDriver::open;
+        ops.read = &FuseDriver::read;
+        ops.readdir = &FuseDriver::readdir;
+        return ops;
+    }();
+    return kOperations;
+}
+
+fuse_ino_t FuseDriver::addTrack(const std::string& name, std::shared_ptr<SparseCache> pCache) {
+    if (name.empty() || name.find('/') != std::string::npos || !pCache ||
+            !pCache->hasBackingFile()) {
+        return 0;
+    }
+    const auto lock = std::unique_lock(m_tracksMutex);
+    if (m_inodesByName.count(name) > 0) {
+        return 0;
+    }
+    const fuse_ino_t ino = m_nextIno++;
+    m_tracks.emplace(ino, std::make_shared<const Track>(Track{name, std::move(pCache)}));
+    m_inodesByName.emplace(name, ino);
+    return ino;
+}
+
+void FuseDriver::removeTrack(fuse_ino_t ino) {
+    {
+        const auto lock = std::unique_lock(m_tracksMutex);
+        const auto it = m_tracks.find(ino);
+        if (it == m_tracks.end()) {
+            return;
+        }
+        m_inodesByName.erase(it->second->name);
+        m_tracks.erase(it);
+    }
+    notifyFetchFailed(ino, 0, INT64_MAX, EIO);
+}
+
+std::shared_ptr<const FuseDriver::Track> FuseDriver::findTrack(fuse_ino_t ino) const {
+    const auto lock = std::shared_lock(m_tracksMutex);
+    const auto it = m_tracks.find(ino);
+    if (it == m_tracks.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+void FuseDriver::fillAttr(fuse_ino_t ino, const Track* pTrack, struct stat* pStat) const {
+    std::memset(pStat, 0, sizeof(*pStat));
+    pStat->st_ino = ino;
+    if (!pTrack) {
+        pStat->st_mode = S_IFDIR | 0555;
+        pStat->st_nlink = 2;
+        return;
+    }
+    pStat->st_mode = S_IFREG | 0444;
+    pStat->st_nlink = 1;
+    pStat->st_size = pTrack->pCache->getTotalSize();
+    // Report the downloaded amount as allocated blocks, e.g. for du
+    pStat->st_blocks = (pTrack->pCache->getCachedBytes() + 511) / 512;
 }
 
 void FuseDriver::init(void* userdata, struct fuse_conn_info* conn) {
+    (void)userdata;
+    // Let the kernel move pages from the backing file into the reply
+    // pipe instead of copying them through a user space buffer.
+    if (conn->capable & FUSE_CAP_SPLICE_WRITE) {
+        conn->want |= FUSE_CAP_SPLICE_WRITE;
+    }
+    if (conn->capable & FUSE_CAP_SPLICE_MOVE) {
+        conn->want |= FUSE_CAP_SPLICE_MOVE;
+    }
     std::cout << "FuseDriver::init" << std::endl;
 }
 
 void FuseDriver::getattr(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi) {
-    // Stub
-    fuse_reply_err(req, ENOENT);
+    (void)fi;
+    FuseDriver* pDriver = instance(req);
+    struct stat attr;
+    if (ino == FUSE_ROOT_ID) {
+        pDriver->fillAttr(ino, nullptr, &attr);
+    } else {
+        const auto pTrack = pDriver->findTrack(ino);
+        if (!pTrack) {
+            fuse_reply_err(req, ENOENT);
+            return;
+        }
+        pDriver->fillAttr(ino, pTrack.get(), &attr);
+    }
+    fuse_reply_attr(req, &attr, kAttrTimeoutSeconds);
 }
 
 void FuseDriver::lookup(fuse_req_t req, fuse_ino_t parent, const char* name) {
-    fuse_reply_err(req, ENOENT);
+    FuseDriver* pDriver = instance(req);
+    if (parent != FUSE_ROOT_ID) {
+        fuse_reply_err(req, ENOENT);
+        return;
+    }
+    fuse_ino_t ino = 0;
+    {
+        const auto lock = std::shared_lock(pDriver->m_tracksMutex);
+        const auto it = pDriver->m_inodesByName.find(name);
+        if (it != pDriver->m_inodesByName.end()) {
+            ino = it->second;
+        }
+    }
+    const auto pTrack = pDriver->findTrack(ino);
+    if (!pTrack) {
+        fuse_reply_err(req, ENOENT);
+        return;
+    }
+    struct fuse_entry_param entry;
+    std::memset(&entry, 0, sizeof(entry));
+    entry.ino = ino;
+    entry.attr_timeout = kAttrTimeoutSeconds;
+    entry.entry_timeout = kAttrTimeoutSeconds;
+    pDriver->fillAttr(ino, pTrack.get(), &entry.attr);
+    fuse_reply_entry(req, &entry);
 }
 
 void FuseDriver::open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi) {
-    fuse_reply_err(req, ENOENT);
+    if (ino == FUSE_ROOT_ID) {
+        fuse_reply_err(req, EISDIR);
+        return;
+    }
+    if (!instance(req)->findTrack(ino)) {
+        fuse_reply_err(req, ENOENT);
+        return;
+    }
+    if ((fi->flags & O_ACCMODE) != O_RDONLY) {
+        fuse_reply_err(req, EACCES);
+        return;
+    }
+    // Only complete ranges are ever returned, so whatever the kernel has
+    // cached stays valid and decoders re-reading headers or seek tables
+    // do not have to come back to us.
+    fi->keep_cache = 1;
+    fuse_reply_open(req, fi);
 }
 
 void FuseDriver::read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info* fi) {
-    fuse_reply_err(req, EIO);
+    (void)fi;
+    instance(req)->doRead(req, ino, size, off);
+}
+
+void FuseDriver::readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info* fi) {
+    (void)fi;
+    FuseDriver* pDriver = instance(req);
+    if (ino != FUSE_ROOT_ID) {
+        fuse_reply_err(req, ENOTDIR);
+        return;
+    }
+
+    std::vector<char> buffer;
+    const auto addEntry = [req, &buffer](const char* name, fuse_ino_t entryIno) {
+        struct stat attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.st_ino = entryIno;
+        const size_t oldSize = buffer.size();
+        const size_t entrySize = fuse_add_direntry(req, nullptr, 0, name, nullptr, 0);
+        buffer.resize(oldSize + entrySize);
+        fuse_add_direntry(req,
+                buffer.data() + oldSize,
+                entrySize,
+                name,
+                &attr,
+                static_cast<off_t>(oldSize + entrySize));
+    };
+    addEntry(".", FUSE_ROOT_ID);
+    addEntry("..", FUSE_ROOT_ID);
+    {
+        const auto lock = std::shared_lock(pDriver->m_tracksMutex);
+        for (const auto& [name, trackIno] : pDriver->m_inodesByName) {
+            addEntry(name.c_str(), trackIno);
+        }
+    }
+
+    if (off < 0 || static_cast<size_t>(off) >= buffer.size()) {
+        fuse_reply_buf(req, nullptr, 0);
+        return;
+    }
+    fuse_reply_buf(req,
+            buffer.data() + off,
+            std::min(buffer.size() - static_cast<size_t>(off), size));
+}
+
+void FuseDriver::replyData(fuse_req_t req,
+        const SparseCache& cache,
+        int64_t start,
+        int64_t length) {
+    if (length <= 0) {
+        fuse_reply_buf(req, nullptr, 0);
+        return;
+    }
+    struct fuse_bufvec buffer = FUSE_BUFVEC_INIT(static_cast<size_t>(length));
+    buffer.buf[0].flags = static_cast<fuse_buf_flags>(FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK);
+    buffer.buf[0].fd = cache.getBackingFileDescriptor();
+    buffer.buf[0].pos = start;
+    fuse_reply_data(req, &buffer, FUSE_BUF_SPLICE_MOVE);
+}
+
+void FuseDriver::replyError(fuse_req_t req, int error) {
+    fuse_reply_err(req, error);
+}
+
+void FuseDriver::doRead(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off) {
+    const auto pTrack = findTrack(ino);
+    if (!pTrack) {
+        replyError(req, EBADF);
+        return;
+    }
+    const SparseCache& cache = *pTrack->pCache;
+    const int64_t fileSize = cache.getTotalSize();
+    if (off < 0 || off >= fileSize || size == 0) {
+        replyData(req, cache, off, 0);
+        return;
+    }
+    const int64_t length = std::min(static_cast<int64_t>(size), fileSize - off);
+
+    // Fast path without any locking
+    if (cache.isRangeCached(off, length)) {
+        replyData(req, cache, off, length);
+        return;
+    }
+    if (!m_pFetcher) {
+        replyError(req, EIO);
+        return;
+    }
+
+    {
+        const auto lock = std::lock_guard(m_pendingMutex);
+        // notifyRangeCached() inspects the pending reads while holding the
+        // same lock, so a download that completes concurrently is either
+        // visible here or picks up this read afterwards.
+        if (!cache.isRangeCached(off, length)) {
+            m_pendingReads.emplace(ino, PendingRead{req, off, length});
+            req = nullptr;
+        }
+    }
+    if (req) {
+        replyData(req, cache, off, length);
+        return;
+    }
+    const auto missingRanges = cache.getMissingRanges(off, length);
+    if (!missingRanges.empty()) {
+        m_pFetcher->fetchRanges(ino, pTrack->pCache, missingRanges);
+    } else {
+        notifyRangeCached(ino);
+    }
+}
+
+void FuseDriver::notifyRangeCached(fuse_ino_t ino) {
+    const auto pTrack = findTrack(ino);
+    if (!pTrack) {
+        return;
+    }
+    const SparseCache& cache = *pTrack->pCache;
+    std::vector<PendingRead> completedReads;
+    {
+        const auto lock = std::lock_guard(m_pendingMutex);
+        auto [it, end] = m_pendingReads.equal_range(ino);
+        while (it != end) {
+            if (cache.isRangeCached(it->second.start, it->second.length)) {
+                completedReads.push_back(it->second);
+                it = m_pendingReads.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (const auto& pending : completedReads) {
+        replyData(pending.req, cache, pending.start, pending.length);
+    }
+}
+
+void FuseDriver::notifyFetchFailed(fuse_ino_t ino, int64_t start, int64_t length, int error) {
+    const int64_t end = length > INT64_MAX - start ? INT64_MAX : start + length;
+    std::vector<fuse_req_t> failedReads;
+    {
+        const auto lock = std::lock_guard(m_pendingMutex);
+        auto [it, last] = m_pendingReads.equal_range(ino);
+        while (it != last) {
+            const PendingRead& pending = it->second;
+            if (pending.start < end && pending.start + pending.length > start) {
+                failedReads.push_back(pending.req);
+                it = m_pendingReads.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (const auto req : failedReads) {
+        replyError(req, error);
+    }
 }
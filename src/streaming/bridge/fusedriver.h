@@ -2,22 +2,110 @@
 
 #include <fuse_lowlevel.h>
 
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <vector>
 
+#include "streaming/bridge/sparsecache.h"
+
+/// Downloads missing byte ranges of a streamed file in the background.
+///
+/// Implementations must return immediately. Once data has been written to
+/// the cache (see SparseCache::getWritableData() and markCached()) they
+/// report back with FuseDriver::notifyRangeCached() or, on failure,
+/// FuseDriver::notifyFetchFailed().
+class RangeFetcher {
+  public:
+    virtual ~RangeFetcher() = default;
+
+    virtual void fetchRanges(fuse_ino_t ino,
+            const std::shared_ptr<SparseCache>& pCache,
+            const std::vector<SparseCache::CachedRange>& ranges) = 0;
+};
+
+/// Low-level FUSE file system that exposes streamed tracks as flat,
+/// read-only files in the root directory.
+///
+/// Reads of cached ranges are answered directly from the backing file of
+/// the SparseCache with fuse_reply_data(), which allows the kernel to
+/// splice the pages into the reply without copying them into a user space
+/// buffer. Reads of missing ranges are parked and handed to the
+/// RangeFetcher, so the FUSE session thread never blocks on the network.
 class FuseDriver {
   public:
-    FuseDriver();
+    explicit FuseDriver(RangeFetcher* pFetcher = nullptr);
     virtual ~FuseDriver();
 
+    /// The operations table to pass to fuse_session_new() together with
+    /// this instance as userdata.
+    static const fuse_lowlevel_ops& operations();
+
+    /// Registers a track. The cache must have its total size set and a
+    /// backing file opened. Returns the inode or 0 if the name is taken.
+    fuse_ino_t addTrack(const std::string& name, std::shared_ptr<SparseCache> pCache);
+    /// Unregisters a track. Pending reads of it fail with EIO.
+    void removeTrack(fuse_ino_t ino);
+
+    /// Called by the RangeFetcher when new data for ino has been cached.
+    void notifyRangeCached(fuse_ino_t ino);
+    /// Called by the RangeFetcher when a download has failed.
+    void notifyFetchFailed(fuse_ino_t ino, int64_t start, int64_t length, int error);
+
+    /// Fails all parked reads. Must be called after the RangeFetcher has
+    /// been stopped and before the FUSE session is destroyed, because the
+    /// replies are sent through the session.
+    void failPendingReads(int error);
+
     // FUSE operations
-    // Note: These will be static wrappers calling into the instance
+    // Note: These are static wrappers calling into the instance
     static void init(void* userdata, struct fuse_conn_info* conn);
     static void getattr(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi);
     static void lookup(fuse_req_t req, fuse_ino_t parent, const char* name);
     static void open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi);
     static void read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info* fi);
-    // ... other ops ...
+    static void readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info* fi);
+
+  protected:
+    /// Replies to a read with the requested range from the backing file.
+    /// Virtual to allow testing the read path without a FUSE session.
+    virtual void replyData(fuse_req_t req,
+            const SparseCache& cache,
+            int64_t start,
+            int64_t length);
+    virtual void replyError(fuse_req_t req, int error);
+
+    void doRead(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off);
 
   private:
-    // SparseCache* m_cache;
+    struct Track {
+        std::string name;
+        std::shared_ptr<SparseCache> pCache;
+    };
+
+    struct PendingRead {
+        fuse_req_t req;
+        int64_t start;
+        int64_t length;
+    };
+
+    static FuseDriver* instance(fuse_req_t req) {
+        return static_cast<FuseDriver*>(fuse_req_userdata(req));
+    }
+
+    std::shared_ptr<const Track> findTrack(fuse_ino_t ino) const;
+    void fillAttr(fuse_ino_t ino, const Track* pTrack, struct stat* pStat) const;
+
+    RangeFetcher* const m_pFetcher;
+
+    mutable std::shared_mutex m_tracksMutex;
+    std::map<fuse_ino_t, std::shared_ptr<const Track>> m_tracks;
+    std::map<std::string, fuse_ino_t> m_inodesByName;
+    fuse_ino_t m_nextIno;
+
+    std::mutex m_pendingMutex;
+    std::multimap<fuse_ino_t, PendingRead> m_pendingReads;
 };
@@ -0,0 +1,279 @@
+#include "httprangefetcher.h"
+
+#include <curl/curl.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+
+constexpr long kConnectTimeoutSeconds = 10;
+
+// Abort stalled transfers instead of parking the reads forever
+constexpr long kLowSpeedLimitBytesPerSecond = 1;
+constexpr long kLowSpeedTimeSeconds = 30;
+
+struct Transfer {
+    CURL* pCurl;
+    SparseCache* pCache;
+    int64_t position;
+    int64_t end;
+    bool statusChecked;
+    const std::atomic<bool>* pStopped;
+};
+
+size_t writeData(char* pData, size_t size, size_t count, void* pUserData) {
+    auto* pTransfer = static_cast<Transfer*>(pUserData);
+    const size_t bytes = size * count;
+    if (!pTransfer->statusChecked) {
+        long status = 0;
+        curl_easy_getinfo(pTransfer->pCurl, CURLINFO_RESPONSE_CODE, &status);
+        // A server that ignores the range sends the whole file, which
+        // is only usable from the beginning
+        if (status != 206 && !(status == 200 && pTransfer->position == 0)) {
+            return 0;
+        }
+        pTransfer->statusChecked = true;
+    }
+    const int64_t length = std::min(
+            static_cast<int64_t>(bytes), pTransfer->end - pTransfer->position);
+    if (length > 0) {
+        uint8_t* pDest = pTransfer->pCache->getWritableData(pTransfer->position, length);
+        if (!pDest) {
+            return 0;
+        }
+        std::memcpy(pDest, pData, static_cast<size_t>(length));
+        pTransfer->position += length;
+    }
+    // Stop after the requested range if the server sends more
+    return static_cast<size_t>(length) == bytes ? bytes : 0;
+}
+
+int checkStopped(void* pUserData, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+    const auto* pTransfer = static_cast<const Transfer*>(pUserData);
+    return pTransfer->pStopped->load() ? 1 : 0;
+}
+
+size_t abortOnData(char*, size_t, size_t, void*) {
+    // Only the headers are needed
+    return 0;
+}
+
+// Parses the total size from "Content-Range: bytes 0-0/12345"
+size_t parseContentRange(char* pData, size_t size, size_t count, void* pUserData) {
+    const size_t bytes = size * count;
+    const std::string header(pData, bytes);
+    constexpr char kPrefix[] = "content-range:";
+    if (header.size() > sizeof(kPrefix) &&
+            std::equal(kPrefix, kPrefix + sizeof(kPrefix) - 1, header.begin(), [](char a, char b) {
+                return a == std::tolower(static_cast<unsigned char>(b));
+            })) {
+        const auto slash = header.rfind('/');
+        if (slash != std::string::npos) {
+            char* pEnd = nullptr;
+            const long long totalSize = std::strtoll(header.c_str() + slash + 1, &pEnd, 10);
+            if (pEnd != header.c_str() + slash + 1 && totalSize > 0) {
+                *static_cast<int64_t*>(pUserData) = totalSize;
+            }
+        }
+    }
+    return bytes;
+}
+
+void setCommonOptions(CURL* pCurl, const std::string& url) {
+    curl_easy_setopt(pCurl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(pCurl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(pCurl, CURLOPT_FAILONERROR, 1L);
+    // Signals must not be used for timeouts in multi-threaded programs
+    curl_easy_setopt(pCurl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(pCurl, CURLOPT_CONNECTTIMEOUT, kConnectTimeoutSeconds);
+    curl_easy_setopt(pCurl, CURLOPT_LOW_SPEED_LIMIT, kLowSpeedLimitBytesPerSecond);
+    curl_easy_setopt(pCurl, CURLOPT_LOW_SPEED_TIME, kLowSpeedTimeSeconds);
+}
+
+} // anonymous namespace
+
+HttpRangeFetcher::HttpRangeFetcher(int workerCount)
+        : m_workerCount(std::max(workerCount, 1)),
+          m_pDriver(nullptr),
+          m_stopped(true) {
+}
+
+HttpRangeFetcher::~HttpRangeFetcher() {
+    stop();
+}
+
+void HttpRangeFetcher::start(FuseDriver* pDriver) {
+    stop();
+    m_pDriver = pDriver;
+    m_stopped.store(false);
+    for (int i = 0; i < m_workerCount; ++i) {
+        m_workers.emplace_back(&HttpRangeFetcher::run, this);
+    }
+}
+
+void HttpRangeFetcher::stop() {
+    {
+        const auto lock = std::lock_guard(m_mutex);
+        m_stopped.store(true);
+        m_jobs.clear();
+        m_requestedBlocks.clear();
+    }
+    m_jobAvailable.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+}
+
+void HttpRangeFetcher::setUrl(fuse_ino_t ino, const std::string& url) {
+    const auto lock = std::lock_guard(m_mutex);
+    m_urls[ino] = url;
+}
+
+void HttpRangeFetcher::removeUrl(fuse_ino_t ino) {
+    const auto lock = std::lock_guard(m_mutex);
+    m_urls.erase(ino);
+}
+
+void HttpRangeFetcher::fetchRanges(fuse_ino_t ino,
+        const std::shared_ptr<SparseCache>& pCache,
+        const std::vector<SparseCache::CachedRange>& ranges) {
+    {
+        const auto lock = std::lock_guard(m_mutex);
+        if (m_stopped.load()) {
+            // The reads stay parked until the driver fails them
+            return;
+        }
+        for (const auto& range : ranges) {
+            for (int64_t block = range.start / kBlockBytes;
+                    block * kBlockBytes < range.end;
+                    ++block) {
+                if (m_requestedBlocks.emplace(ino, block).second) {
+                    m_jobs.push_back(Job{ino, pCache, block});
+                }
+            }
+        }
+    }
+    m_jobAvailable.notify_all();
+}
+
+void HttpRangeFetcher::run() {
+    CURL* pCurl = curl_easy_init();
+    while (true) {
+        Job job;
+        std::string url;
+        {
+            auto lock = std::unique_lock(m_mutex);
+            m_jobAvailable.wait(lock, [this] {
+                return m_stopped.load() || !m_jobs.empty();
+            });
+            if (m_stopped.load()) {
+                break;
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            const auto it = m_urls.find(job.ino);
+            if (it != m_urls.end()) {
+                url = it->second;
+            }
+        }
+
+        const int64_t blockStart = job.block * kBlockBytes;
+        const int64_t blockEnd = std::min(
+                blockStart + kBlockBytes, job.pCache->getTotalSize());
+        bool success = pCurl && !url.empty();
+        if (success) {
+            for (const auto& range : job.pCache->getMissingRanges(
+                         blockStart, blockEnd - blockStart)) {
+                if (!download(pCurl, url, job.pCache.get(), range.start, range.end)) {
+                    success = false;
+                    break;
+                }
+            }
+        }
+        {
+            const auto lock = std::lock_guard(m_mutex);
+            m_requestedBlocks.erase(std::make_pair(job.ino, job.block));
+        }
+        if (success) {
+            m_pDriver->notifyRangeCached(job.ino);
+        } else if (!m_stopped.load()) {
+            m_pDriver->notifyFetchFailed(job.ino, blockStart, blockEnd - blockStart, EIO);
+        }
+    }
+    if (pCurl) {
+        curl_easy_cleanup(pCurl);
+    }
+}
+
+bool HttpRangeFetcher::download(void* pHandle,
+        const std::string& url,
+        SparseCache* pCache,
+        int64_t start,
+        int64_t end) {
+    CURL* pCurl = static_cast<CURL*>(pHandle);
+    Transfer transfer{pCurl, pCache, start, end, false, &m_stopped};
+    const std::string range = std::to_string(start) + '-' + std::to_string(end - 1);
+    // Resetting the options keeps the connection alive
+    curl_easy_reset(pCurl);
+    setCommonOptions(pCurl, url);
+    curl_easy_setopt(pCurl, CURLOPT_RANGE, range.c_str());
+    curl_easy_setopt(pCurl, CURLOPT_WRITEFUNCTION, &writeData);
+    curl_easy_setopt(pCurl, CURLOPT_WRITEDATA, &transfer);
+    curl_easy_setopt(pCurl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(pCurl, CURLOPT_XFERINFOFUNCTION, &checkStopped);
+    curl_easy_setopt(pCurl, CURLOPT_XFERINFODATA, &transfer);
+    const CURLcode result = curl_easy_perform(pCurl);
+    // Publish whatever has been received, even if the transfer broke off.
+    // A write error is expected when the server sends more than requested.
+    pCache->markCached(start, transfer.position - start);
+    if (transfer.position < end) {
+        if (!m_stopped.load()) {
+            std::cerr << "HttpRangeFetcher: Failed to download bytes " << range
+                      << ": " << curl_easy_strerror(result) << std::endl;
+        }
+        return false;
+    }
+    return true;
+}
+
+// static
+int64_t HttpRangeFetcher::queryContentLength(const std::string& url) {
+    CURL* pCurl = curl_easy_init();
+    if (!pCurl) {
+        return -1;
+    }
+    setCommonOptions(pCurl, url);
+    curl_easy_setopt(pCurl, CURLOPT_NOBODY, 1L);
+    curl_off_t length = -1;
+    if (curl_easy_perform(pCurl) == CURLE_OK) {
+        curl_easy_getinfo(pCurl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length);
+    }
+    if (length < 0) {
+        // Presigned URLs are often only valid for GET requests
+        int64_t totalSize = -1;
+        curl_easy_reset(pCurl);
+        setCommonOptions(pCurl, url);
+        curl_easy_setopt(pCurl, CURLOPT_RANGE, "0-0");
+        curl_easy_setopt(pCurl, CURLOPT_HEADERFUNCTION, &parseContentRange);
+        curl_easy_setopt(pCurl, CURLOPT_HEADERDATA, &totalSize);
+        curl_easy_setopt(pCurl, CURLOPT_WRITEFUNCTION, &abortOnData);
+        curl_easy_perform(pCurl);
+        long status = 0;
+        curl_easy_getinfo(pCurl, CURLINFO_RESPONSE_CODE, &status);
+        if (status == 206) {
+            length = totalSize;
+        } else if (status == 200) {
+            // The range has been ignored
+            curl_easy_getinfo(pCurl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length);
+        }
+    }
+    curl_easy_cleanup(pCurl);
+    return length;
+}
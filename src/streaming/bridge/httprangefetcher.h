@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "streaming/bridge/fusedriver.h"
+
+/// Downloads missing ranges of streamed files with HTTP range requests.
+///
+/// Files are split into blocks of kBlockBytes. Each missing block is
+/// requested at most once at a time, no matter how many reads are waiting
+/// for it, and the blocks are distributed among a few worker threads so
+/// that a seek does not have to wait for the download of another region.
+/// Every worker keeps its connection alive between requests.
+///
+/// Only uses libcurl, the daemon does not depend on Qt.
+class HttpRangeFetcher : public RangeFetcher {
+  public:
+    /// Larger blocks reduce the number of round trips, smaller blocks the
+    /// latency of the first bytes after a seek.
+    static constexpr int64_t kBlockBytes = 512 * 1024;
+
+    explicit HttpRangeFetcher(int workerCount = 4);
+    ~HttpRangeFetcher() override;
+
+    /// Starts the workers that report back to the driver.
+    void start(FuseDriver* pDriver);
+    /// Aborts all running downloads and joins the workers. Queued blocks
+    /// are discarded, the reads waiting for them stay parked in the driver.
+    void stop();
+
+    /// The URL of a registered track. Must be set before the track is
+    /// added to the driver.
+    void setUrl(fuse_ino_t ino, const std::string& url);
+    void removeUrl(fuse_ino_t ino);
+
+    void fetchRanges(fuse_ino_t ino,
+            const std::shared_ptr<SparseCache>& pCache,
+            const std::vector<SparseCache::CachedRange>& ranges) override;
+
+    /// Determines the size of the file with a blocking HEAD request.
+    /// Returns -1 on failure.
+    static int64_t queryContentLength(const std::string& url);
+
+  private:
+    struct Job {
+        fuse_ino_t ino;
+        std::shared_ptr<SparseCache> pCache;
+        int64_t block;
+    };
+
+    void run();
+    /// Downloads [start, end) directly into the backing file of the cache
+    /// and marks the received bytes as cached.
+    bool download(void* pCurl,
+            const std::string& url,
+            SparseCache* pCache,
+            int64_t start,
+            int64_t end);
+
+    const int m_workerCount;
+    FuseDriver* m_pDriver;
+
+    std::mutex m_mutex;
+    std::condition_variable m_jobAvailable;
+    std::deque<Job> m_jobs;
+    /// Blocks that are queued or being downloaded
+    std::set<std::pair<fuse_ino_t, int64_t>> m_requestedBlocks;
+    std::map<fuse_ino_t, std::string> m_urls;
+    std::atomic<bool> m_stopped;
+    std::vector<std::thread> m_workers;
+};
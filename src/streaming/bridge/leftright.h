@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+/// Left-Right concurrency control for a read-mostly data structure.
+///
+/// Two copies of the data are kept. Readers always access the copy that is
+/// currently published and never wait on a lock, so they can be used from
+/// threads that must not block (e.g. a reader answering a FUSE or audio
+/// request). Writers are serialized by a mutex, modify the hidden copy,
+/// publish it, wait until all readers have left the previously published
+/// copy and then replay the same modification on it.
+///
+/// The modification passed to modify() is applied twice and therefore must
+/// be deterministic.
+///
+/// Reference: P. Ramalhete, A. Correia, "Left-Right: A Concurrency Control
+/// Technique with Wait-Free Population Oblivious Reads" (2015).
+template<typename T>
+class LeftRight {
+  public:
+    LeftRight()
+            : m_leftRight(0),
+              m_versionIndex(0) {
+        m_readIndicators[0].count.store(0);
+        m_readIndicators[1].count.store(0);
+    }
+
+    LeftRight(const LeftRight&) = delete;
+    LeftRight& operator=(const LeftRight&) = delete;
+
+    /// Invokes func with a const reference to the published copy and
+    /// returns its result. Wait-free with respect to writers.
+    template<typename Func>
+    decltype(auto) read(Func&& func) const {
+        const ReadGuard guard(this);
+        return std::forward<Func>(func)(m_instances[m_leftRight.load()]);
+    }
+
+    /// Applies func to both copies without ever exposing a copy to readers
+    /// while it is being modified.
+    template<typename Func>
+    void modify(Func&& func) {
+        const auto lock = std::lock_guard(m_writeMutex);
+        const int published = m_leftRight.load();
+        const int hidden = 1 - published;
+        func(m_instances[hidden]);
+        m_leftRight.store(hidden);
+        // Drain readers that may still be looking at the old copy
+        const int versionIndex = m_versionIndex.load();
+        const int nextVersionIndex = 1 - versionIndex;
+        waitForReaders(nextVersionIndex);
+        m_versionIndex.store(nextVersionIndex);
+        waitForReaders(versionIndex);
+        func(m_instances[published]);
+    }
+
+  private:
+    // Padded to avoid false sharing between the two counters
+    struct alignas(64) ReadIndicator {
+        std::atomic<int> count;
+    };
+
+    class ReadGuard {
+      public:
+        explicit ReadGuard(const LeftRight* pLeftRight)
+                : m_pIndicator(&pLeftRight->m_readIndicators[
+                          pLeftRight->m_versionIndex.load()]) {
+            m_pIndicator->count.fetch_add(1);
+        }
+        ~ReadGuard() {
+            m_pIndicator->count.fetch_sub(1);
+        }
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+      private:
+        ReadIndicator* m_pIndicator;
+    };
+
+    void waitForReaders(int versionIndex) const {
+        while (m_readIndicators[versionIndex].count.load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    std::array<T, 2> m_instances;
+    std::atomic<int> m_leftRight;
+    std::atomic<int> m_versionIndex;
+    mutable std::array<ReadIndicator, 2> m_readIndicators;
+    std::mutex m_writeMutex;
+};
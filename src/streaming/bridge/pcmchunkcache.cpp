@@ -0,0 +1,301 @@
+#include "streaming/bridge/pcmchunkcache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include "engine/cachingreader/cachingreaderchunk.h"
+#include "util/sample.h"
+
+namespace {
+
+// Persist the index after this many chunks (~ 11 s at 48 kHz) have been
+// decoded. Limits the amount of audio that must be decoded again after a
+// crash. The index is persisted by a background task, the decoding thread
+// never waits for the disk.
+constexpr SINT kIndexPersistThresholdChunks = 64;
+
+constexpr char kIndexMagic[8] = {'M', 'X', 'P', 'C', 'M', 'I', 'D', 'X'};
+constexpr uint32_t kIndexVersion = 1;
+
+// On-disk layout of the sidecar index, followed by chunkCount bytes that
+// are 1 for complete chunks. Native byte order like the SparseCache index.
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t channelCount;
+    uint32_t sampleRate;
+    uint32_t sampleSize;
+    int64_t frameIndexStart;
+    int64_t frameIndexEnd;
+    int64_t chunkCount;
+};
+
+} // anonymous namespace
+
+PcmChunkCache::PcmChunkCache()
+        : m_firstChunkIndex(0),
+          m_chunkCount(0),
+          m_cachedChunkCount(0),
+          m_unpersistedChunkCount(0) {
+}
+
+PcmChunkCache::~PcmChunkCache() {
+    close();
+}
+
+bool PcmChunkCache::open(const std::string& path,
+        const mixxx::audio::SignalInfo& signalInfo,
+        mixxx::IndexRange frameIndexRange) {
+    close();
+    if (!signalInfo.isValid() ||
+            frameIndexRange.empty() ||
+            frameIndexRange.start() < 0) {
+        return false;
+    }
+    const SINT firstChunkIndex =
+            CachingReaderChunk::indexForFrame(frameIndexRange.start());
+    const SINT lastChunkIndex =
+            CachingReaderChunk::indexForFrame(frameIndexRange.end() - 1);
+    const SINT chunkCount = lastChunkIndex - firstChunkIndex + 1;
+    const int64_t chunkBytes = static_cast<int64_t>(
+                                       signalInfo.frames2samples(
+                                               CachingReaderChunk::kFrames)) *
+            sizeof(CSAMPLE);
+    if (!m_file.open(path, chunkCount * chunkBytes)) {
+        return false;
+    }
+    m_signalInfo = signalInfo;
+    m_frameIndexRange = frameIndexRange;
+    m_firstChunkIndex = firstChunkIndex;
+    m_chunkCount = chunkCount;
+    m_chunkCached = std::make_unique<std::atomic<bool>[]>(chunkCount);
+    m_cachedChunkCount.store(0);
+    m_unpersistedChunkCount.store(0);
+    m_persistedChunks.assign(chunkCount, 0);
+    // Without a matching index the content of the file is unknown
+    // and all chunks are considered missing
+    loadIndex();
+    return true;
+}
+
+void PcmChunkCache::close() {
+    if (!m_file.isOpen()) {
+        return;
+    }
+    waitForPendingPersist();
+    persistIndex();
+    m_file.close();
+    m_chunkCached.reset();
+    m_chunkCount = 0;
+    m_cachedChunkCount.store(0);
+}
+
+bool PcmChunkCache::isChunkCached(SINT chunkIndex) const {
+    const SINT chunkOffset = chunkIndex - m_firstChunkIndex;
+    if (chunkOffset < 0 || chunkOffset >= m_chunkCount) {
+        return false;
+    }
+    return m_chunkCached[chunkOffset].load(std::memory_order_acquire);
+}
+
+mixxx::IndexRange PcmChunkCache::chunkFrameIndexRange(SINT chunkOffset) const {
+    return intersect(
+            mixxx::IndexRange::forward(
+                    (m_firstChunkIndex + chunkOffset) * CachingReaderChunk::kFrames,
+                    CachingReaderChunk::kFrames),
+            m_frameIndexRange);
+}
+
+int64_t PcmChunkCache::chunkByteOffset(SINT chunkOffset) const {
+    return static_cast<int64_t>(chunkOffset) *
+            m_signalInfo.frames2samples(CachingReaderChunk::kFrames) *
+            sizeof(CSAMPLE);
+}
+
+SINT PcmChunkCache::read(mixxx::IndexRange frameIndexRange, CSAMPLE* pDest) const {
+    SINT frameIndex = frameIndexRange.start();
+    while (frameIndex < frameIndexRange.end()) {
+        const SINT chunkOffset =
+                CachingReaderChunk::indexForFrame(frameIndex) - m_firstChunkIndex;
+        if (chunkOffset < 0 ||
+                chunkOffset >= m_chunkCount ||
+                !m_chunkCached[chunkOffset].load(std::memory_order_acquire)) {
+            break;
+        }
+        const auto chunkRange = chunkFrameIndexRange(chunkOffset);
+        if (!chunkRange.containsIndex(frameIndex)) {
+            break;
+        }
+        const SINT endFrameIndex = std::min(frameIndexRange.end(), chunkRange.end());
+        const SINT sampleCount = m_signalInfo.frames2samples(endFrameIndex - frameIndex);
+        const auto* pChunk = reinterpret_cast<const CSAMPLE*>(m_file.data(
+                chunkByteOffset(chunkOffset),
+                m_signalInfo.frames2samples(chunkRange.length()) * sizeof(CSAMPLE)));
+        SampleUtil::copy(
+                pDest + m_signalInfo.frames2samples(frameIndex - frameIndexRange.start()),
+                pChunk + m_signalInfo.frames2samples(frameIndex - chunkRange.start()),
+                sampleCount);
+        frameIndex = endFrameIndex;
+    }
+    return frameIndex - frameIndexRange.start();
+}
+
+void PcmChunkCache::write(mixxx::IndexRange frameIndexRange, const CSAMPLE* pSource) {
+    if (!m_file.isOpen() || frameIndexRange.empty()) {
+        return;
+    }
+    const SINT firstChunkOffset = std::max<SINT>(0,
+            CachingReaderChunk::indexForFrame(frameIndexRange.start()) -
+                    m_firstChunkIndex);
+    const SINT lastChunkOffset = std::min<SINT>(m_chunkCount - 1,
+            CachingReaderChunk::indexForFrame(frameIndexRange.end() - 1) -
+                    m_firstChunkIndex);
+    SINT newChunkCount = 0;
+    for (SINT chunkOffset = firstChunkOffset; chunkOffset <= lastChunkOffset; ++chunkOffset) {
+        const auto chunkRange = chunkFrameIndexRange(chunkOffset);
+        if (chunkRange.empty() ||
+                !chunkRange.isSubrangeOf(frameIndexRange) ||
+                m_chunkCached[chunkOffset].load(std::memory_order_acquire)) {
+            continue;
+        }
+        const SINT sampleCount = m_signalInfo.frames2samples(chunkRange.length());
+        auto* pChunk = reinterpret_cast<CSAMPLE*>(m_file.data(
+                chunkByteOffset(chunkOffset),
+                sampleCount * sizeof(CSAMPLE)));
+        SampleUtil::copy(
+                pChunk,
+                pSource + m_signalInfo.frames2samples(
+                                  chunkRange.start() - frameIndexRange.start()),
+                sampleCount);
+        if (!m_chunkCached[chunkOffset].exchange(true, std::memory_order_release)) {
+            ++newChunkCount;
+        }
+    }
+    if (newChunkCount == 0) {
+        return;
+    }
+    m_cachedChunkCount.fetch_add(newChunkCount, std::memory_order_relaxed);
+
+    if (m_unpersistedChunkCount.fetch_add(newChunkCount, std::memory_order_relaxed) +
+                    newChunkCount <
+            kIndexPersistThresholdChunks) {
+        return;
+    }
+    if (m_pendingPersist.valid() &&
+            m_pendingPersist.wait_for(std::chrono::seconds(0)) !=
+                    std::future_status::ready) {
+        // Still busy with the previous index, the chunks are picked up
+        // by the next one
+        return;
+    }
+    m_pendingPersist = std::async(std::launch::async, [this] {
+        persistIndex();
+    });
+}
+
+void PcmChunkCache::waitForPendingPersist() {
+    if (m_pendingPersist.valid()) {
+        m_pendingPersist.wait();
+        m_pendingPersist = std::future<void>();
+    }
+}
+
+// static
+std::string PcmChunkCache::indexPathFor(const std::string& path) {
+    return path + ".idx";
+}
+
+// static
+std::string PcmChunkCache::pathForBackingFile(const std::string& backingFilePath) {
+    return backingFilePath + ".pcm";
+}
+
+bool PcmChunkCache::persistIndex() {
+    const auto lock = std::lock_guard(m_persistMutex);
+    if (!m_file.isOpen()) {
+        return false;
+    }
+    m_unpersistedChunkCount.store(0, std::memory_order_relaxed);
+    // Chunks that are visible now have their samples written already
+    std::vector<uint8_t> chunkFlags(m_chunkCount);
+    for (SINT i = 0; i < m_chunkCount; ++i) {
+        chunkFlags[i] = m_chunkCached[i].load(std::memory_order_acquire) ? 1 : 0;
+    }
+    // Only the chunks that have been added since the previous index need
+    // to be written back before the index may refer to them. Adjacent
+    // chunks are written back together.
+    SINT chunkOffset = 0;
+    while (chunkOffset < m_chunkCount) {
+        if (chunkFlags[chunkOffset] == 0 || m_persistedChunks[chunkOffset] != 0) {
+            ++chunkOffset;
+            continue;
+        }
+        const SINT firstChunkOffset = chunkOffset;
+        while (chunkOffset < m_chunkCount &&
+                chunkFlags[chunkOffset] != 0 &&
+                m_persistedChunks[chunkOffset] == 0) {
+            ++chunkOffset;
+        }
+        const int64_t start = chunkByteOffset(firstChunkOffset);
+        const int64_t end = std::min(chunkByteOffset(chunkOffset), m_file.size());
+        if (!m_file.sync(start, end - start)) {
+            return false;
+        }
+    }
+
+    IndexHeader header;
+    std::memcpy(header.magic, kIndexMagic, sizeof(header.magic));
+    header.version = kIndexVersion;
+    header.channelCount = m_signalInfo.getChannelCount();
+    header.sampleRate = m_signalInfo.getSampleRate();
+    header.sampleSize = sizeof(CSAMPLE);
+    header.frameIndexStart = m_frameIndexRange.start();
+    header.frameIndexEnd = m_frameIndexRange.end();
+    header.chunkCount = m_chunkCount;
+    if (!SparseBackingFile::replaceFile(indexPathFor(m_file.path()),
+                &header,
+                sizeof(header),
+                chunkFlags.data(),
+                chunkFlags.size())) {
+        return false;
+    }
+    m_persistedChunks = std::move(chunkFlags);
+    return true;
+}
+
+bool PcmChunkCache::loadIndex() {
+    std::vector<uint8_t> content;
+    if (!SparseBackingFile::readFile(indexPathFor(m_file.path()),
+                sizeof(IndexHeader) + static_cast<std::size_t>(m_chunkCount),
+                &content) ||
+            content.size() < sizeof(IndexHeader)) {
+        return false;
+    }
+    IndexHeader header;
+    std::memcpy(&header, content.data(), sizeof(header));
+    const bool valid = std::memcmp(header.magic, kIndexMagic, sizeof(header.magic)) == 0 &&
+            header.version == kIndexVersion &&
+            header.channelCount == m_signalInfo.getChannelCount() &&
+            header.sampleRate == m_signalInfo.getSampleRate() &&
+            header.sampleSize == sizeof(CSAMPLE) &&
+            header.frameIndexStart == m_frameIndexRange.start() &&
+            header.frameIndexEnd == m_frameIndexRange.end() &&
+            header.chunkCount == m_chunkCount &&
+            content.size() == sizeof(header) + static_cast<std::size_t>(m_chunkCount);
+    if (!valid) {
+        return false;
+    }
+    const uint8_t* chunkFlags = content.data() + sizeof(header);
+    SINT cachedChunkCount = 0;
+    for (SINT i = 0; i < m_chunkCount; ++i) {
+        if (chunkFlags[i] != 0) {
+            m_chunkCached[i].store(true, std::memory_order_relaxed);
+            m_persistedChunks[i] = 1;
+            ++cachedChunkCount;
+        }
+    }
+    m_cachedChunkCount.store(cachedChunkCount);
+    return true;
+}
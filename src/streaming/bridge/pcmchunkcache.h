@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "audio/signalinfo.h"
+#include "streaming/bridge/sparsebackingfile.h"
+#include "util/indexrange.h"
+#include "util/types.h"
+
+/// Decoded sample data of a streamed track, persisted on disk.
+///
+/// The data is laid out in chunks of CachingReaderChunk::kFrames frames
+/// with the same chunk indices as the CachingReader, i.e. chunk i covers
+/// the frames [i * kFrames, (i + 1) * kFrames) clamped to the frame index
+/// range of the track. Only complete chunks are stored. Reading a cached
+/// chunk is a plain copy from the memory-mapped file, neither the
+/// compressed data nor the decoder are involved.
+///
+/// A chunk is published with a release store after its samples have been
+/// written, so concurrent readers never see partially written chunks. The
+/// set of complete chunks is persisted in a sidecar index next to the file.
+/// While decoding the index is persisted by a background task after the
+/// newly added chunks have been written back, so the index never refers to
+/// samples that are not on disk.
+/// The cache is discarded if the signal info or the frame index range of
+/// the decoder has changed.
+class PcmChunkCache {
+  public:
+    PcmChunkCache();
+    ~PcmChunkCache();
+
+    PcmChunkCache(const PcmChunkCache&) = delete;
+    PcmChunkCache& operator=(const PcmChunkCache&) = delete;
+
+    /// Maps the file at path, creating it if needed, and restores the
+    /// complete chunks from its sidecar index.
+    bool open(const std::string& path,
+            const mixxx::audio::SignalInfo& signalInfo,
+            mixxx::IndexRange frameIndexRange);
+    /// Persists the index and unmaps the file.
+    void close();
+    bool isOpen() const {
+        return m_file.isOpen();
+    }
+
+    SINT getChunkCount() const {
+        return m_chunkCount;
+    }
+    SINT getCachedChunkCount() const {
+        return m_cachedChunkCount.load(std::memory_order_relaxed);
+    }
+    bool isChunkCached(SINT chunkIndex) const;
+
+    /// Copies the longest prefix of frameIndexRange that is available from
+    /// cached chunks into pDest. Returns the number of frames copied.
+    SINT read(mixxx::IndexRange frameIndexRange, CSAMPLE* pDest) const;
+
+    /// Stores all chunks that are completely contained in frameIndexRange.
+    /// pSource contains the samples of frameIndexRange.
+    void write(mixxx::IndexRange frameIndexRange, const CSAMPLE* pSource);
+
+    /// Writes back the chunks that have been added since the previous
+    /// index and then the sidecar index. Blocks until both are on disk.
+    bool persistIndex();
+
+    static std::string indexPathFor(const std::string& path);
+    /// The path of the PCM cache that belongs to the SparseCache backing
+    /// file of the same track.
+    static std::string pathForBackingFile(const std::string& backingFilePath);
+
+  private:
+    /// The chunk range relative to the first chunk of the track.
+    mixxx::IndexRange chunkFrameIndexRange(SINT chunkOffset) const;
+    int64_t chunkByteOffset(SINT chunkOffset) const;
+
+    bool loadIndex();
+    void waitForPendingPersist();
+
+    SparseBackingFile m_file;
+    mixxx::audio::SignalInfo m_signalInfo;
+    mixxx::IndexRange m_frameIndexRange;
+    SINT m_firstChunkIndex;
+    SINT m_chunkCount;
+
+    // One flag per chunk, set once the samples have been written
+    std::unique_ptr<std::atomic<bool>[]> m_chunkCached;
+    std::atomic<SINT> m_cachedChunkCount;
+
+    std::atomic<SINT> m_unpersistedChunkCount;
+    // Only accessed by the thread that writes chunks
+    std::future<void> m_pendingPersist;
+
+    // Serializes persisting the index. The decoding thread never takes it.
+    std::mutex m_persistMutex;
+    // The chunk flags of the last persisted index
+    std::vector<uint8_t> m_persistedChunks;
+};
@@ -0,0 +1,179 @@
+#include "prefetchscheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+namespace {
+
+bool overlaps(const SparseCache::CachedRange& lhs, const SparseCache::CachedRange& rhs) {
+    return lhs.start < rhs.end && rhs.start < lhs.end;
+}
+
+} // anonymous namespace
+
+PrefetchScheduler::PrefetchScheduler()
+        : PrefetchScheduler(Config()) {
+}
+
+PrefetchScheduler::PrefetchScheduler(const Config& config)
+        : m_config(config) {
+}
+
+void PrefetchScheduler::updateDeck(int deck, DeckState state) {
+    m_decks[deck] = std::move(state);
+}
+
+void PrefetchScheduler::removeDeck(int deck) {
+    m_decks.erase(deck);
+}
+
+std::vector<PrefetchScheduler::Request> PrefetchScheduler::nextRequests() {
+    const int freeSlots = m_config.maxConcurrentRequests - inFlightCount();
+    if (freeSlots <= 0) {
+        return {};
+    }
+
+    std::vector<Candidate> candidates;
+    for (const auto& [deck, state] : m_decks) {
+        collectCandidates(deck, state, &candidates);
+    }
+    std::sort(candidates.begin(),
+            candidates.end(),
+            [](const Candidate& lhs, const Candidate& rhs) {
+                // Higher priority first, then more urgent, then closer
+                return std::make_tuple(-static_cast<int>(lhs.priority),
+                               static_cast<int>(lhs.urgency),
+                               lhs.distance) <
+                        std::make_tuple(-static_cast<int>(rhs.priority),
+                                static_cast<int>(rhs.urgency),
+                                rhs.distance);
+            });
+
+    std::vector<Request> requests;
+    for (const auto& candidate : candidates) {
+        if (static_cast<int>(requests.size()) >= freeSlots) {
+            break;
+        }
+        const auto& pCache = m_decks[candidate.deck].pCache;
+        // The same track may be loaded on multiple decks
+        if (isInFlight(pCache.get(), candidate.range)) {
+            continue;
+        }
+        Request request{candidate.deck,
+                pCache,
+                candidate.range.start,
+                candidate.range.length()};
+        m_inFlight.push_back(request);
+        requests.push_back(std::move(request));
+    }
+    return requests;
+}
+
+void PrefetchScheduler::requestFinished(const Request& request) {
+    const auto it = std::find_if(m_inFlight.begin(),
+            m_inFlight.end(),
+            [&request](const Request& inFlight) {
+                return inFlight.pCache == request.pCache &&
+                        inFlight.start == request.start &&
+                        inFlight.length == request.length;
+            });
+    if (it != m_inFlight.end()) {
+        m_inFlight.erase(it);
+    }
+}
+
+bool PrefetchScheduler::isInFlight(const SparseCache* pCache,
+        const SparseCache::CachedRange& range) const {
+    return std::any_of(m_inFlight.begin(),
+            m_inFlight.end(),
+            [pCache, &range](const Request& inFlight) {
+                return inFlight.pCache.get() == pCache &&
+                        overlaps(range,
+                                {inFlight.start,
+                                        inFlight.start + inFlight.length});
+            });
+}
+
+void PrefetchScheduler::collectCandidates(int deck,
+        const DeckState& state,
+        std::vector<Candidate>* pCandidates) const {
+    if (!state.pCache || state.durationSeconds <= 0.0) {
+        return;
+    }
+    const int64_t totalSize = state.pCache->getTotalSize();
+    if (totalSize <= 0 || state.pCache->isFullyCached()) {
+        return;
+    }
+    const double bytesPerSecond = totalSize / state.durationSeconds;
+    const auto toBytes = [bytesPerSecond](double seconds) {
+        return static_cast<int64_t>(std::ceil(seconds * bytesPerSecond));
+    };
+    const auto toOffset = [totalSize](double position) {
+        return static_cast<int64_t>(std::clamp(position, 0.0, 1.0) * totalSize);
+    };
+
+    // Scratching or playing faster consumes more bytes per second. A
+    // stopped deck is expected to continue at normal speed.
+    const double speed = std::max(std::abs(state.rate), 1.0);
+    const bool reverse = state.rate < 0.0;
+    const int64_t position = toOffset(state.position);
+    const int64_t behind = toBytes(m_config.lookBehindSeconds * speed);
+    const int64_t immediate = toBytes(m_config.jumpTargetSeconds * speed);
+    const int64_t ahead = toBytes(m_config.lookAheadSeconds * speed);
+    if (reverse) {
+        addWindow(deck, state, Urgency::Immediate, position - immediate, position + behind, position, pCandidates);
+        addWindow(deck, state, Urgency::LookAhead, position - ahead, position - immediate, position, pCandidates);
+    } else {
+        addWindow(deck, state, Urgency::Immediate, position - behind, position + immediate, position, pCandidates);
+        addWindow(deck, state, Urgency::LookAhead, position + immediate, position + ahead, position, pCandidates);
+    }
+
+    const int64_t jumpTargetBehind = toBytes(m_config.lookBehindSeconds);
+    const int64_t jumpTargetAhead = toBytes(m_config.jumpTargetSeconds);
+    for (const double jumpTarget : state.jumpTargets) {
+        const int64_t target = toOffset(jumpTarget);
+        addWindow(deck,
+                state,
+                Urgency::JumpTarget,
+                target - jumpTargetBehind,
+                target + jumpTargetAhead,
+                target,
+                pCandidates);
+    }
+}
+
+void PrefetchScheduler::addWindow(int deck,
+        const DeckState& state,
+        Urgency urgency,
+        int64_t start,
+        int64_t end,
+        int64_t anchor,
+        std::vector<Candidate>* pCandidates) const {
+    const int64_t totalSize = state.pCache->getTotalSize();
+    start = std::clamp<int64_t>(start, 0, totalSize);
+    end = std::clamp<int64_t>(end, 0, totalSize);
+    if (start >= end) {
+        return;
+    }
+    const int64_t maxRequestBytes = std::max<int64_t>(m_config.maxRequestBytes, 1);
+    for (const auto& missing : state.pCache->getMissingRanges(start, end - start)) {
+        // Split at multiples of maxRequestBytes so that overlapping
+        // windows (e.g. of two decks playing the same track) result in
+        // identical requests.
+        int64_t chunkStart = missing.start;
+        while (chunkStart < missing.end) {
+            const int64_t chunkEnd = std::min(missing.end,
+                    (chunkStart / maxRequestBytes + 1) * maxRequestBytes);
+            const SparseCache::CachedRange range{chunkStart, chunkEnd};
+            if (!isInFlight(state.pCache.get(), range)) {
+                const int64_t distance = anchor < range.start
+                        ? range.start - anchor
+                        : std::max<int64_t>(anchor - range.end, 0);
+                pCandidates->push_back(Candidate{
+                        deck, state.priority, urgency, distance, range});
+            }
+            chunkStart = chunkEnd;
+        }
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "streaming/bridge/sparsecache.h"
+
+/// Decides which byte ranges of streamed tracks should be downloaded next.
+///
+/// The scheduler knows the play state of every deck that has a streamed
+/// track loaded and keeps a window ahead of the play position as well as
+/// small windows around possible jump targets (hotcues, loop start, cue
+/// point) downloaded. Missing ranges are split into HTTP range requests of
+/// bounded size and ranked by deck priority, urgency and distance from the
+/// position where they will be needed. The number of requests in flight is
+/// capped.
+///
+/// Byte offsets are derived from the relative play position assuming a
+/// constant bitrate, which holds well enough for the streamed formats to
+/// make prefetching effective.
+///
+/// Not thread-safe, all methods must be called from the same thread.
+class PrefetchScheduler {
+  public:
+    /// Ordered from least to most important.
+    enum class Priority {
+        Preview = 0,
+        Cued = 1,
+        Playing = 2,
+    };
+
+    struct Config {
+        /// Playback time to keep downloaded ahead of the play position.
+        double lookAheadSeconds = 30.0;
+        /// Playback time to keep downloaded behind the play position and
+        /// before jump targets, needed for decoder preroll.
+        double lookBehindSeconds = 1.0;
+        /// Playback time to keep downloaded after each jump target. The
+        /// same amount directly ahead of the play position is fetched with
+        /// the highest urgency.
+        double jumpTargetSeconds = 4.0;
+        int64_t maxRequestBytes = 256 * 1024;
+        int maxConcurrentRequests = 4;
+    };
+
+    struct DeckState {
+        std::shared_ptr<SparseCache> pCache;
+        Priority priority = Priority::Cued;
+        /// Play position relative to the track length [0, 1].
+        double position = 0.0;
+        /// Signed playback rate, 1.0 is normal speed forward.
+        double rate = 1.0;
+        double durationSeconds = 0.0;
+        /// Positions relative to the track length [0, 1].
+        std::vector<double> jumpTargets;
+    };
+
+    struct Request {
+        int deck;
+        std::shared_ptr<SparseCache> pCache;
+        int64_t start;
+        int64_t length;
+    };
+
+    PrefetchScheduler();
+    explicit PrefetchScheduler(const Config& config);
+
+    const Config& config() const {
+        return m_config;
+    }
+    void setConfig(const Config& config) {
+        m_config = config;
+    }
+
+    void updateDeck(int deck, DeckState state);
+    void removeDeck(int deck);
+
+    /// Returns the requests that should be started now, at most as many as
+    /// there are free slots. They are considered in flight until
+    /// requestFinished() is called for them.
+    std::vector<Request> nextRequests();
+    void requestFinished(const Request& request);
+
+    int inFlightCount() const {
+        return static_cast<int>(m_inFlight.size());
+    }
+
+  private:
+    enum class Urgency {
+        Immediate = 0,
+        JumpTarget = 1,
+        LookAhead = 2,
+    };
+
+    struct Candidate {
+        int deck;
+        Priority priority;
+        Urgency urgency;
+        int64_t distance;
+        SparseCache::CachedRange range;
+    };
+
+    void collectCandidates(int deck,
+            const DeckState& state,
+            std::vector<Candidate>* pCandidates) const;
+    /// Adds the missing, not yet requested parts of [start, end) split
+    /// into requests of at most maxRequestBytes.
+    void addWindow(int deck,
+            const DeckState& state,
+            Urgency urgency,
+            int64_t start,
+            int64_t end,
+            int64_t anchor,
+            std::vector<Candidate>* pCandidates) const;
+    bool isInFlight(const SparseCache* pCache,
+            const SparseCache::CachedRange& range) const;
+
+    Config m_config;
+    std::map<int, DeckState> m_decks;
+    std::vector<Request> m_inFlight;
+};
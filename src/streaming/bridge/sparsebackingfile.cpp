@@ -0,0 +1,416 @@
+#include "sparsebackingfile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <winioctl.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+
+namespace {
+
+#ifdef _WIN32
+
+std::wstring toWidePath(const std::string& path) {
+    const int length = ::MultiByteToWideChar(
+            CP_UTF8, 0, path.data(), static_cast<int>(path.size()), nullptr, 0);
+    std::wstring widePath(static_cast<std::size_t>(length), L'\0');
+    ::MultiByteToWideChar(CP_UTF8,
+            0,
+            path.data(),
+            static_cast<int>(path.size()),
+            widePath.data(),
+            length);
+    return widePath;
+}
+
+bool writeFully(HANDLE hFile, const void* pBuffer, std::size_t size) {
+    const auto* pBytes = static_cast<const char*>(pBuffer);
+    while (size > 0) {
+        const DWORD chunkSize = static_cast<DWORD>(
+                std::min<std::size_t>(size, MAXDWORD));
+        DWORD written = 0;
+        if (!::WriteFile(hFile, pBytes, chunkSize, &written, nullptr) || written == 0) {
+            return false;
+        }
+        pBytes += written;
+        size -= written;
+    }
+    return true;
+}
+
+#else
+
+bool readFully(int fd, void* pBuffer, std::size_t size) {
+    auto* pBytes = static_cast<char*>(pBuffer);
+    while (size > 0) {
+        const ssize_t result = ::read(fd, pBytes, size);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        pBytes += result;
+        size -= static_cast<std::size_t>(result);
+    }
+    return true;
+}
+
+bool writeFully(int fd, const void* pBuffer, std::size_t size) {
+    const auto* pBytes = static_cast<const char*>(pBuffer);
+    while (size > 0) {
+        const ssize_t result = ::write(fd, pBytes, size);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        pBytes += result;
+        size -= static_cast<std::size_t>(result);
+    }
+    return true;
+}
+
+#endif
+
+} // anonymous namespace
+
+SparseBackingFile::SparseBackingFile()
+        :
+#ifdef _WIN32
+          m_hFile(INVALID_HANDLE_VALUE),
+#else
+          m_fd(-1),
+#endif
+          m_size(0),
+          m_pData(nullptr) {
+}
+
+SparseBackingFile::~SparseBackingFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool SparseBackingFile::open(const std::string& path, int64_t size) {
+    close();
+    if (size <= 0) {
+        return false;
+    }
+
+    const HANDLE hFile = ::CreateFileW(toWidePath(path).c_str(),
+            GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr,
+            OPEN_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    // Without this flag NTFS allocates (and zero-fills) all blocks up to
+    // the new end of file. Fails harmlessly on file systems like FAT.
+    DWORD bytesReturned = 0;
+    ::DeviceIoControl(hFile, FSCTL_SET_SPARSE, nullptr, 0, nullptr, 0, &bytesReturned, nullptr);
+
+    LARGE_INTEGER fileSize;
+    if (!::GetFileSizeEx(hFile, &fileSize)) {
+        ::CloseHandle(hFile);
+        return false;
+    }
+    if (fileSize.QuadPart != size) {
+        LARGE_INTEGER newSize;
+        newSize.QuadPart = size;
+        if (!::SetFilePointerEx(hFile, newSize, nullptr, FILE_BEGIN) ||
+                !::SetEndOfFile(hFile)) {
+            ::CloseHandle(hFile);
+            return false;
+        }
+    }
+
+    const HANDLE hMapping = ::CreateFileMappingW(hFile,
+            nullptr,
+            PAGE_READWRITE,
+            static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+            static_cast<DWORD>(static_cast<uint64_t>(size) & 0xFFFFFFFF),
+            nullptr);
+    if (!hMapping) {
+        ::CloseHandle(hFile);
+        return false;
+    }
+    void* pData = ::MapViewOfFile(hMapping,
+            FILE_MAP_ALL_ACCESS,
+            0,
+            0,
+            static_cast<SIZE_T>(size));
+    // The view keeps the mapping object alive
+    ::CloseHandle(hMapping);
+    if (!pData) {
+        ::CloseHandle(hFile);
+        return false;
+    }
+
+    m_path = path;
+    m_hFile = hFile;
+    m_size = size;
+    m_pData = static_cast<uint8_t*>(pData);
+    return true;
+}
+
+void SparseBackingFile::close() {
+    if (m_pData) {
+        ::UnmapViewOfFile(m_pData);
+        m_pData = nullptr;
+    }
+    if (m_hFile != INVALID_HANDLE_VALUE) {
+        ::CloseHandle(m_hFile);
+        m_hFile = INVALID_HANDLE_VALUE;
+    }
+    m_size = 0;
+    m_path.clear();
+}
+
+#else
+
+bool SparseBackingFile::open(const std::string& path, int64_t size) {
+    close();
+    if (size <= 0) {
+        errno = EINVAL;
+        return false;
+    }
+
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (::fstat(fd, &fileStat) != 0) {
+        const int error = errno;
+        ::close(fd);
+        errno = error;
+        return false;
+    }
+    // Extending the file with ftruncate() creates a hole, i.e. no blocks
+    // are allocated until data is actually written.
+    if (fileStat.st_size != size && ::ftruncate(fd, size) != 0) {
+        const int error = errno;
+        ::close(fd);
+        errno = error;
+        return false;
+    }
+
+    void* pData = ::mmap(nullptr,
+            static_cast<size_t>(size),
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED,
+            fd,
+            0);
+    if (pData == MAP_FAILED) {
+        const int error = errno;
+        ::close(fd);
+        errno = error;
+        return false;
+    }
+
+    m_path = path;
+    m_fd = fd;
+    m_size = size;
+    m_pData = static_cast<uint8_t*>(pData);
+    return true;
+}
+
+void SparseBackingFile::close() {
+    if (m_pData) {
+        ::munmap(m_pData, static_cast<size_t>(m_size));
+        m_pData = nullptr;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_size = 0;
+    m_path.clear();
+}
+
+#endif
+
+uint8_t* SparseBackingFile::data(int64_t offset, int64_t length) {
+    if (!m_pData || !isInBounds(offset, length)) {
+        return nullptr;
+    }
+    return m_pData + offset;
+}
+
+const uint8_t* SparseBackingFile::data(int64_t offset, int64_t length) const {
+    if (!m_pData || !isInBounds(offset, length)) {
+        return nullptr;
+    }
+    return m_pData + offset;
+}
+
+bool SparseBackingFile::sync(int64_t offset, int64_t length) {
+    if (!m_pData || !isInBounds(offset, length)) {
+        return false;
+    }
+    if (length == 0) {
+        return true;
+    }
+    const int64_t page = pageSize();
+    const int64_t alignedStart = (offset / page) * page;
+    const int64_t alignedEnd = std::min(
+            ((offset + length + page - 1) / page) * page, m_size);
+#ifdef _WIN32
+    // FlushViewOfFile() only initiates the write back of the pages
+    return ::FlushViewOfFile(m_pData + alignedStart,
+                   static_cast<SIZE_T>(alignedEnd - alignedStart)) &&
+            ::FlushFileBuffers(m_hFile);
+#else
+    return ::msync(m_pData + alignedStart,
+                   static_cast<size_t>(alignedEnd - alignedStart),
+                   MS_SYNC) == 0;
+#endif
+}
+
+// static
+int64_t SparseBackingFile::pageSize() {
+#ifdef _WIN32
+    static const int64_t kPageSize = [] {
+        SYSTEM_INFO systemInfo;
+        ::GetSystemInfo(&systemInfo);
+        return static_cast<int64_t>(systemInfo.dwPageSize);
+    }();
+#else
+    static const int64_t kPageSize = ::sysconf(_SC_PAGESIZE);
+#endif
+    return kPageSize;
+}
+
+// static
+bool SparseBackingFile::readFile(const std::string& path,
+        std::size_t maxSize,
+        std::vector<uint8_t>* pContent) {
+#ifdef _WIN32
+    const HANDLE hFile = ::CreateFileW(toWidePath(path).c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    bool success = ::GetFileSizeEx(hFile, &fileSize) &&
+            static_cast<uint64_t>(fileSize.QuadPart) <= maxSize;
+    if (success) {
+        pContent->resize(static_cast<std::size_t>(fileSize.QuadPart));
+        std::size_t offset = 0;
+        while (success && offset < pContent->size()) {
+            const DWORD chunkSize = static_cast<DWORD>(
+                    std::min<std::size_t>(pContent->size() - offset, MAXDWORD));
+            DWORD read = 0;
+            success = ::ReadFile(hFile, pContent->data() + offset, chunkSize, &read, nullptr) &&
+                    read > 0;
+            offset += read;
+        }
+    }
+    ::CloseHandle(hFile);
+    return success;
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat fileStat;
+    bool success = ::fstat(fd, &fileStat) == 0 &&
+            fileStat.st_size >= 0 &&
+            static_cast<uint64_t>(fileStat.st_size) <= maxSize;
+    if (success) {
+        pContent->resize(static_cast<std::size_t>(fileStat.st_size));
+        success = readFully(fd, pContent->data(), pContent->size());
+    }
+    ::close(fd);
+    return success;
+#endif
+}
+
+// static
+bool SparseBackingFile::replaceFile(const std::string& path,
+        const void* pHeader,
+        std::size_t headerSize,
+        const void* pPayload,
+        std::size_t payloadSize) {
+    const std::string tempPath = path + ".tmp";
+#ifdef _WIN32
+    const std::wstring wideTempPath = toWidePath(tempPath);
+    const HANDLE hFile = ::CreateFileW(wideTempPath.c_str(),
+            GENERIC_WRITE,
+            0,
+            nullptr,
+            CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    const bool success = writeFully(hFile, pHeader, headerSize) &&
+            writeFully(hFile, pPayload, payloadSize) &&
+            ::FlushFileBuffers(hFile);
+    ::CloseHandle(hFile);
+    if (!success ||
+            !::MoveFileExW(wideTempPath.c_str(),
+                    toWidePath(path).c_str(),
+                    MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        ::DeleteFileW(wideTempPath.c_str());
+        return false;
+    }
+    return true;
+#else
+    const int fd = ::open(tempPath.c_str(),
+            O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+            0644);
+    if (fd < 0) {
+        return false;
+    }
+    const bool success = writeFully(fd, pHeader, headerSize) &&
+            writeFully(fd, pPayload, payloadSize) &&
+            ::fsync(fd) == 0;
+    ::close(fd);
+    if (!success || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        ::unlink(tempPath.c_str());
+        return false;
+    }
+    return true;
+#endif
+}
+
+// static
+int64_t SparseBackingFile::allocatedSize(const std::string& path) {
+#ifdef _WIN32
+    // Returns the allocated size for sparse and compressed files
+    DWORD sizeHigh = 0;
+    const DWORD sizeLow = ::GetCompressedFileSizeW(toWidePath(path).c_str(), &sizeHigh);
+    if (sizeLow == INVALID_FILE_SIZE && ::GetLastError() != NO_ERROR) {
+        return 0;
+    }
+    return static_cast<int64_t>((static_cast<uint64_t>(sizeHigh) << 32) | sizeLow);
+#else
+    struct stat fileStat;
+    if (::stat(path.c_str(), &fileStat) != 0) {
+        return 0;
+    }
+    // st_blocks is always counted in units of 512 bytes
+    return static_cast<int64_t>(fileStat.st_blocks) * 512;
+#endif
+}
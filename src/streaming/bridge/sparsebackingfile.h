@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// A preallocated sparse file that is memory-mapped in its entirety.
+///
+/// The file is extended to its final size without writing to it so that
+/// the file system only allocates blocks for regions that have actually
+/// been written. On Windows the file is flagged as sparse explicitly.
+/// Downloaded data is written directly into the shared mapping and read
+/// back from it without intermediate copies.
+///
+/// The class does not depend on Qt, because it is shared with the
+/// mixxx-fs daemon.
+class SparseBackingFile {
+  public:
+    SparseBackingFile();
+    ~SparseBackingFile();
+
+    SparseBackingFile(const SparseBackingFile&) = delete;
+    SparseBackingFile& operator=(const SparseBackingFile&) = delete;
+
+    /// Opens or creates the file at path and maps size bytes. An existing
+    /// file is resized if its size differs.
+    bool open(const std::string& path, int64_t size);
+    void close();
+
+    bool isOpen() const {
+        return m_pData != nullptr;
+    }
+    const std::string& path() const {
+        return m_path;
+    }
+    int64_t size() const {
+        return m_size;
+    }
+#ifndef _WIN32
+    /// Allows to splice data out of the file, e.g. into a FUSE reply
+    int fileDescriptor() const {
+        return m_fd;
+    }
+#endif
+
+    /// Returns a pointer into the mapping or nullptr if the requested
+    /// range is out of bounds.
+    uint8_t* data(int64_t offset, int64_t length);
+    const uint8_t* data(int64_t offset, int64_t length) const;
+
+    /// Synchronously writes back all pages that overlap the given range.
+    /// The range is widened to page boundaries as required by the OS.
+    bool sync(int64_t offset, int64_t length);
+
+    static int64_t pageSize();
+
+    /// Reads the whole file at path unless it is larger than maxSize.
+    /// Used for the small sidecar index files.
+    static bool readFile(const std::string& path,
+            std::size_t maxSize,
+            std::vector<uint8_t>* pContent);
+    /// Writes a header followed by a payload into a temporary file and
+    /// atomically replaces the file at path with it. Used for the sidecar
+    /// index files that describe the content of a backing file.
+    static bool replaceFile(const std::string& path,
+            const void* pHeader,
+            std::size_t headerSize,
+            const void* pPayload,
+            std::size_t payloadSize);
+    /// The number of bytes that the file system has actually allocated for
+    /// the file at path, i.e. without the holes. 0 if the file is missing.
+    static int64_t allocatedSize(const std::string& path);
+
+  private:
+    bool isInBounds(int64_t offset, int64_t length) const {
+        return offset >= 0 && length >= 0 && offset + length <= m_size;
+    }
+
+    std::string m_path;
+#ifdef _WIN32
+    void* m_hFile;
+#else
+    int m_fd;
+#endif
+    int64_t m_size;
+    uint8_t* m_pData;
+};
@@ -1,29 +1,326 @@
 #include "sparsecache.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+namespace {
+
+// Persist the index after this many bytes have been downloaded. Limits the
+// amount of data that must be downloaded again after a crash.
+constexpr int64_t kIndexPersistThresholdBytes = 4 * 1024 * 1024;
+
+constexpr char kIndexMagic[8] = {'M', 'X', 'S', 'P', 'I', 'D', 'X', '\0'};
+constexpr uint32_t kIndexVersion = 1;
+
+// On-disk layout of the sidecar index, followed by rangeCount
+// pairs of int64_t [start, end). Native byte order, the index is
+// never shared between machines.
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    int64_t totalSize;
+    uint64_t rangeCount;
+};
+
+} // anonymous namespace
+
 SparseCache::SparseCache()
-        : m_totalSize(0) {
+        : SparseCache(0) {
+}
+
+SparseCache::SparseCache(int64_t totalSize)
+        : m_totalSize(totalSize),
+          m_dirtyStart(std::numeric_limits<int64_t>::max()),
+          m_dirtyEnd(0),
+          m_dirtyBytes(0) {
+}
+
+SparseCache::~SparseCache() {
+    closeBackingFile();
+}
+
+void SparseCache::setTotalSize(int64_t totalSize) {
+    m_totalSize.store(totalSize);
 }
 
 bool SparseCache::isRangeCached(int64_t start, int64_t length) const {
-    return false;
+    if (length <= 0) {
+        return true;
+    }
+    return m_intervals.read([start, length](const IntervalMap& intervals) {
+        return intervals.covers(start, start + length);
+    });
+}
+
+int64_t SparseCache::getCachedLength(int64_t offset) const {
+    return m_intervals.read([offset](const IntervalMap& intervals) {
+        return intervals.cachedLengthAt(offset);
+    });
 }
 
 std::vector<SparseCache::CachedRange> SparseCache::getMissingRanges(int64_t start, int64_t length) const {
-    return {{start, start + length}};
+    if (length <= 0) {
+        return {};
+    }
+    return m_intervals.read([start, length](const IntervalMap& intervals) {
+        return intervals.missing(start, start + length);
+    });
 }
 
 void SparseCache::markCached(int64_t start, int64_t length) {
-    // Stub
+    if (length <= 0) {
+        return;
+    }
+    bool persist = false;
+    if (m_backingFile.isOpen()) {
+        // The dirty region must be recorded before the range becomes
+        // visible, otherwise a concurrent persistIndex() could write the
+        // range to the index without syncing its pages first.
+        const auto lock = std::lock_guard(m_persistMutex);
+        m_dirtyStart = std::min(m_dirtyStart, start);
+        m_dirtyEnd = std::max(m_dirtyEnd, start + length);
+        m_dirtyBytes += length;
+        persist = m_dirtyBytes >= kIndexPersistThresholdBytes;
+    }
+    m_intervals.modify([start, length](IntervalMap& intervals) {
+        intervals.insert(start, start + length);
+    });
+    if (persist) {
+        persistIndex();
+    }
 }
 
 double SparseCache::getCachedPercentage() const {
-    return 0.0;
+    const int64_t totalSize = m_totalSize.load();
+    if (totalSize <= 0) {
+        return 0.0;
+    }
+    return 100.0 * static_cast<double>(getCachedBytes()) / totalSize;
+}
+
+int64_t SparseCache::getCachedBytes() const {
+    return m_intervals.read([](const IntervalMap& intervals) {
+        return intervals.cachedBytes();
+    });
+}
+
+bool SparseCache::isFullyCached() const {
+    const int64_t totalSize = m_totalSize.load();
+    return totalSize > 0 && isRangeCached(0, totalSize);
 }
 
 std::vector<SparseCache::CachedRange> SparseCache::getAllCachedRanges() const {
-    return {};
+    return m_intervals.read([](const IntervalMap& intervals) {
+        return intervals.ranges();
+    });
+}
+
+std::size_t SparseCache::getRangeCount() const {
+    return m_intervals.read([](const IntervalMap& intervals) {
+        return intervals.size();
+    });
+}
+
+bool SparseCache::openBackingFile(const std::string& path) {
+    closeBackingFile();
+    if (!m_backingFile.open(path, m_totalSize.load())) {
+        return false;
+    }
+    m_backingFilePath = path;
+    if (!loadIndex()) {
+        // Without a valid index the content of the file is unknown
+        m_intervals.modify([](IntervalMap& intervals) {
+            intervals = IntervalMap();
+        });
+    }
+    return true;
+}
+
+void SparseCache::closeBackingFile() {
+    if (!m_backingFile.isOpen()) {
+        return;
+    }
+    persistIndex();
+    m_backingFile.close();
+    m_backingFilePath.clear();
+}
+
+uint8_t* SparseCache::getWritableData(int64_t offset, int64_t length) {
+    return m_backingFile.data(offset, length);
+}
+
+const uint8_t* SparseCache::getData(int64_t offset, int64_t length) const {
+    return m_backingFile.data(offset, length);
+}
+
+// static
+std::string SparseCache::indexPathFor(const std::string& backingFilePath) {
+    return backingFilePath + ".idx";
+}
+
+bool SparseCache::persistIndex() {
+    const auto lock = std::lock_guard(m_persistMutex);
+    return persistIndexLocked();
+}
+
+bool SparseCache::persistIndexLocked() {
+    if (!m_backingFile.isOpen()) {
+        return false;
+    }
+    // Ranges that are visible now have their dirty region recorded
+    // already, see markCached().
+    const std::vector<CachedRange> ranges = getAllCachedRanges();
+    if (m_dirtyEnd > m_dirtyStart &&
+            !m_backingFile.sync(m_dirtyStart, m_dirtyEnd - m_dirtyStart)) {
+        return false;
+    }
+    m_dirtyStart = std::numeric_limits<int64_t>::max();
+    m_dirtyEnd = 0;
+    m_dirtyBytes = 0;
+
+    IndexHeader header;
+    std::memcpy(header.magic, kIndexMagic, sizeof(header.magic));
+    header.version = kIndexVersion;
+    header.reserved = 0;
+    header.totalSize = m_backingFile.size();
+    header.rangeCount = ranges.size();
+
+    std::vector<int64_t> entries;
+    entries.reserve(2 * ranges.size());
+    for (const auto& range : ranges) {
+        entries.push_back(range.start);
+        entries.push_back(range.end);
+    }
+    return SparseBackingFile::replaceFile(indexPathFor(m_backingFilePath),
+            &header,
+            sizeof(header),
+            entries.data(),
+            entries.size() * sizeof(int64_t));
+}
+
+bool SparseCache::loadIndex() {
+    // Disjoint, non-adjacent ranges are at least 1 byte apart
+    const uint64_t maxRangeCount =
+            static_cast<uint64_t>(m_backingFile.size() / 2 + 1);
+    std::vector<uint8_t> content;
+    if (!SparseBackingFile::readFile(indexPathFor(m_backingFilePath),
+                sizeof(IndexHeader) + maxRangeCount * 2 * sizeof(int64_t),
+                &content) ||
+            content.size() < sizeof(IndexHeader)) {
+        return false;
+    }
+    IndexHeader header;
+    std::memcpy(&header, content.data(), sizeof(header));
+    // The range count of a corrupt index must not be trusted before
+    // it has been checked against the actual size of the file
+    const std::size_t payloadSize = content.size() - sizeof(header);
+    bool valid = std::memcmp(header.magic, kIndexMagic, sizeof(header.magic)) == 0 &&
+            header.version == kIndexVersion &&
+            header.totalSize == m_backingFile.size() &&
+            payloadSize % (2 * sizeof(int64_t)) == 0 &&
+            header.rangeCount == payloadSize / (2 * sizeof(int64_t));
+    if (!valid) {
+        return false;
+    }
+    std::vector<int64_t> entries(2 * header.rangeCount);
+    std::memcpy(entries.data(), content.data() + sizeof(header), payloadSize);
+    for (size_t i = 0; valid && i < entries.size(); i += 2) {
+        valid = entries[i] >= 0 &&
+                entries[i] < entries[i + 1] &&
+                entries[i + 1] <= header.totalSize;
+    }
+    if (!valid) {
+        return false;
+    }
+    m_intervals.modify([&entries](IntervalMap& intervals) {
+        intervals = IntervalMap();
+        for (size_t i = 0; i < entries.size(); i += 2) {
+            intervals.insert(entries[i], entries[i + 1]);
+        }
+    });
+    return true;
+}
+
+void SparseCache::IntervalMap::insert(int64_t start, int64_t end) {
+    auto it = m_intervals.upper_bound(start);
+    if (it != m_intervals.begin()) {
+        const auto prev = std::prev(it);
+        if (prev->second >= start) {
+            // Overlapping or adjacent predecessor, absorbed below
+            it = prev;
+            start = prev->first;
+        }
+    }
+    // Absorb all intervals that overlap or touch [start, end)
+    while (it != m_intervals.end() && it->first <= end) {
+        end = std::max(end, it->second);
+        m_cachedBytes -= it->second - it->first;
+        it = m_intervals.erase(it);
+    }
+    m_intervals.emplace_hint(it, start, end);
+    m_cachedBytes += end - start;
+}
+
+std::map<int64_t, int64_t>::const_iterator SparseCache::IntervalMap::find(
+        int64_t offset) const {
+    auto it = m_intervals.upper_bound(offset);
+    if (it == m_intervals.begin()) {
+        return m_intervals.end();
+    }
+    --it;
+    if (it->second <= offset) {
+        return m_intervals.end();
+    }
+    return it;
+}
+
+bool SparseCache::IntervalMap::covers(int64_t start, int64_t end) const {
+    const auto it = find(start);
+    return it != m_intervals.end() && it->second >= end;
+}
+
+int64_t SparseCache::IntervalMap::cachedLengthAt(int64_t offset) const {
+    const auto it = find(offset);
+    if (it == m_intervals.end()) {
+        return 0;
+    }
+    return it->second - offset;
+}
+
+std::vector<SparseCache::CachedRange> SparseCache::IntervalMap::missing(
+        int64_t start, int64_t end) const {
+    std::vector<CachedRange> result;
+    int64_t pos = start;
+    auto it = m_intervals.upper_bound(start);
+    if (it != m_intervals.begin()) {
+        const auto prev = std::prev(it);
+        if (prev->second > pos) {
+            pos = prev->second;
+        }
+    }
+    while (pos < end) {
+        if (it == m_intervals.end() || it->first >= end) {
+            result.push_back({pos, end});
+            break;
+        }
+        if (it->first > pos) {
+            result.push_back({pos, it->first});
+        }
+        pos = it->second;
+        ++it;
+    }
+    return result;
 }
 
-void SparseCache::mergeOverlappingIntervals() {
-    // Stub
+std::vector<SparseCache::CachedRange> SparseCache::IntervalMap::ranges() const {
+    std::vector<CachedRange> result;
+    result.reserve(m_intervals.size());
+    for (const auto& [start, end] : m_intervals) {
+        result.push_back({start, end});
+    }
+    return result;
 }
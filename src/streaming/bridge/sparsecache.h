@@ -1,22 +1,64 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "streaming/bridge/leftright.h"
+#include "streaming/bridge/sparsebackingfile.h"
+
+/// Bookkeeping of the byte ranges of a streamed file that are available
+/// locally.
+///
+/// Ranges are stored as disjoint, non-adjacent [start, end) intervals in an
+/// ordered map and merged on insertion. All queries are O(log n) in the
+/// number of stored intervals (plus the size of the result).
+///
+/// The downloader calls markCached() while reader threads query the ranges.
+/// Queries never wait on a lock held by the downloader, see LeftRight.
+///
+/// Optionally the data itself is kept in a memory-mapped SparseBackingFile.
+/// The cached ranges are then persisted in a compact sidecar index next to
+/// it so that a partially downloaded file survives a restart.
 class SparseCache {
   public:
     struct CachedRange {
         int64_t start;
         int64_t end; // exclusive
+
+        int64_t length() const {
+            return end - start;
+        }
+        bool operator==(const CachedRange& other) const {
+            return start == other.start && end == other.end;
+        }
     };
 
     SparseCache();
+    explicit SparseCache(int64_t totalSize);
+    ~SparseCache();
+
+    SparseCache(const SparseCache&) = delete;
+    SparseCache& operator=(const SparseCache&) = delete;
+
+    /// The size of the complete file in bytes. Only needed for
+    /// getCachedPercentage() and isFullyCached().
+    void setTotalSize(int64_t totalSize);
+    int64_t getTotalSize() const {
+        return m_totalSize.load();
+    }
 
     // Check if byte range is fully cached
     bool isRangeCached(int64_t start, int64_t length) const;
 
+    /// Returns the number of contiguous bytes that are cached starting at
+    /// offset or 0 if the byte at offset is missing.
+    int64_t getCachedLength(int64_t offset) const;
+
     // Get list of missing ranges within a request
     std::vector<CachedRange> getMissingRanges(int64_t start, int64_t length) const;
 
@@ -26,13 +68,82 @@ class SparseCache {
     // Get total cached percentage
     double getCachedPercentage() const;
 
+    int64_t getCachedBytes() const;
+
+    bool isFullyCached() const;
+
     // Get all cached ranges (for waveform rendering)
     std::vector<CachedRange> getAllCachedRanges() const;
 
+    /// The number of disjoint intervals, i.e. the fragmentation of the file.
+    std::size_t getRangeCount() const;
+
+    /// Maps the backing file at path, creating it if needed, and restores
+    /// the cached ranges from its sidecar index. Requires the total size to
+    /// be set. Must not be called while other threads access the cache.
+    bool openBackingFile(const std::string& path);
+    /// Persists the index and unmaps the backing file.
+    void closeBackingFile();
+    bool hasBackingFile() const {
+        return m_backingFile.isOpen();
+    }
+    const std::string& getBackingFilePath() const {
+        return m_backingFilePath;
+    }
+#ifndef _WIN32
+    int getBackingFileDescriptor() const {
+        return m_backingFile.fileDescriptor();
+    }
+#endif
+
+    /// Direct access to the mapped backing file. Downloaded data is written
+    /// in place and then published with markCached(). Returns nullptr if no
+    /// backing file is open or the range is out of bounds.
+    uint8_t* getWritableData(int64_t offset, int64_t length);
+    const uint8_t* getData(int64_t offset, int64_t length) const;
+
+    /// Writes back all dirty pages and then the sidecar index. The index
+    /// never refers to data that has not reached the disk.
+    bool persistIndex();
+
+    static std::string indexPathFor(const std::string& backingFilePath);
+
   private:
-    std::map<int64_t, int64_t> m_intervals; // start -> end
-    int64_t m_totalSize;
+    /// A single copy of the interval map as managed by LeftRight.
+    class IntervalMap {
+      public:
+        void insert(int64_t start, int64_t end);
+        bool covers(int64_t start, int64_t end) const;
+        int64_t cachedLengthAt(int64_t offset) const;
+        std::vector<CachedRange> missing(int64_t start, int64_t end) const;
+        std::vector<CachedRange> ranges() const;
+
+        int64_t cachedBytes() const {
+            return m_cachedBytes;
+        }
+        std::size_t size() const {
+            return m_intervals.size();
+        }
+
+      private:
+        /// Returns the interval that contains offset or end() if none.
+        std::map<int64_t, int64_t>::const_iterator find(int64_t offset) const;
+
+        std::map<int64_t, int64_t> m_intervals; // start -> end
+        int64_t m_cachedBytes = 0;
+    };
+
+    bool loadIndex();
+    bool persistIndexLocked();
+
+    LeftRight<IntervalMap> m_intervals;
+    std::atomic<int64_t> m_totalSize;
     std::string m_backingFilePath;
+    SparseBackingFile m_backingFile;
 
-    void mergeOverlappingIntervals();
+    // Guards the dirty region that has not been written to the index yet
+    std::mutex m_persistMutex;
+    int64_t m_dirtyStart;
+    int64_t m_dirtyEnd;
+    int64_t m_dirtyBytes;
 };
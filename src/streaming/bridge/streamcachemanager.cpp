@@ -0,0 +1,345 @@
+#include "streaming/bridge/streamcachemanager.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+
+#include "streaming/bridge/pcmchunkcache.h"
+#include "streaming/bridge/sparsebackingfile.h"
+#include "util/assert.h"
+#include "util/compatibility/qmutex.h"
+#include "util/counter.h"
+#include "util/logger.h"
+#include "util/stat.h"
+
+namespace {
+
+const mixxx::Logger kLogger("StreamCacheManager");
+
+const QString kManifestFileName = QStringLiteral("cache-manifest.json");
+const QString kIndexFileSuffix = QStringLiteral(".idx");
+const QString kPcmFileSuffix = QStringLiteral(".pcm");
+
+const QString kStatHits = QStringLiteral("StreamCacheManager hits");
+const QString kStatMisses = QStringLiteral("StreamCacheManager misses");
+const QString kStatEvictions = QStringLiteral("StreamCacheManager evictions");
+const QString kStatEvictedBytes = QStringLiteral("StreamCacheManager evicted bytes");
+const QString kStatUsedBytes = QStringLiteral("StreamCacheManager used bytes");
+
+int64_t currentTimeMs() {
+    return QDateTime::currentMSecsSinceEpoch();
+}
+
+int64_t allocatedSizeOfFiles(const std::vector<std::string>& paths) {
+    int64_t bytes = 0;
+    for (const auto& path : paths) {
+        bytes += SparseBackingFile::allocatedSize(path);
+    }
+    return bytes;
+}
+
+} // anonymous namespace
+
+StreamCacheManager::StreamCacheManager(const QString& directory, int64_t byteBudget)
+        : m_directory(directory),
+          m_byteBudget(byteBudget),
+          m_usedBytes(0),
+          m_pendingHits(0),
+          m_pendingMisses(0) {
+    QDir().mkpath(m_directory);
+    scanDirectory();
+    loadManifest();
+    kLogger.info()
+            << "Using" << m_usedBytes << "of" << m_byteBudget
+            << "bytes for" << m_entries.size() << "tracks";
+}
+
+StreamCacheManager::~StreamCacheManager() {
+    saveManifest();
+}
+
+void StreamCacheManager::setByteBudget(int64_t byteBudget) {
+    {
+        const auto locker = lockMutex(&m_mutex);
+        m_byteBudget = byteBudget;
+    }
+    // Shrink the cache immediately if needed
+    reserve(0);
+}
+
+int64_t StreamCacheManager::getByteBudget() const {
+    const auto locker = lockMutex(&m_mutex);
+    return m_byteBudget;
+}
+
+int64_t StreamCacheManager::getUsedBytes() const {
+    const auto locker = lockMutex(&m_mutex);
+    return m_usedBytes;
+}
+
+// static
+std::vector<std::string> StreamCacheManager::filesForBackingFile(
+        const std::string& backingFilePath) {
+    const std::string pcmPath = PcmChunkCache::pathForBackingFile(backingFilePath);
+    return {
+            backingFilePath,
+            SparseCache::indexPathFor(backingFilePath),
+            pcmPath,
+            PcmChunkCache::indexPathFor(pcmPath),
+    };
+}
+
+void StreamCacheManager::scanDirectory() {
+    const auto locker = lockMutex(&m_mutex);
+    // Every backing file that has been opened before has a sidecar index
+    const QFileInfoList indexFiles = QDir(m_directory).entryInfoList(
+            {QStringLiteral("*") + kIndexFileSuffix}, QDir::Files);
+    for (const QFileInfo& indexFile : indexFiles) {
+        const QString backingFilePath = indexFile.filePath().chopped(
+                kIndexFileSuffix.size());
+        if (backingFilePath.endsWith(kPcmFileSuffix) ||
+                !QFile::exists(backingFilePath)) {
+            continue;
+        }
+        Entry& entry = m_entries[backingFilePath.toStdString()];
+        entry.bytes = allocatedSizeOfFiles(
+                filesForBackingFile(backingFilePath.toStdString()));
+        entry.lastAccessMs = indexFile.lastModified().toMSecsSinceEpoch();
+        // Without holes the sparse file is complete. Overridden by the
+        // manifest if available.
+        entry.fullyCached = SparseBackingFile::allocatedSize(
+                                    backingFilePath.toStdString()) >=
+                QFileInfo(backingFilePath).size();
+        m_usedBytes += entry.bytes;
+    }
+}
+
+void StreamCacheManager::loadManifest() {
+    const auto locker = lockMutex(&m_mutex);
+    QFile file(QDir(m_directory).filePath(kManifestFileName));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const QJsonArray tracks =
+            QJsonDocument::fromJson(file.readAll()).object()["tracks"].toArray();
+    for (const QJsonValue& value : tracks) {
+        const QJsonObject track = value.toObject();
+        const std::string backingFilePath =
+                QDir(m_directory).filePath(track["file"].toString()).toStdString();
+        const auto it = m_entries.find(backingFilePath);
+        if (it == m_entries.end()) {
+            // The files have been deleted in the meantime
+            continue;
+        }
+        it->second.lastAccessMs = static_cast<int64_t>(
+                track["lastAccessMs"].toDouble(it->second.lastAccessMs));
+        it->second.playCount = track["playCount"].toInt();
+        it->second.fullyCached = track["fullyCached"].toBool();
+        it->second.permanent = track["permanent"].toBool();
+    }
+}
+
+bool StreamCacheManager::saveManifest() const {
+    const auto locker = lockMutex(&m_mutex);
+    return saveManifestLocked();
+}
+
+bool StreamCacheManager::saveManifestLocked() const {
+    QJsonArray tracks;
+    for (const auto& [backingFilePath, entry] : m_entries) {
+        tracks.append(QJsonObject{
+                {"file", QFileInfo(QString::fromStdString(backingFilePath)).fileName()},
+                {"lastAccessMs", static_cast<double>(entry.lastAccessMs)},
+                {"playCount", entry.playCount},
+                {"fullyCached", entry.fullyCached},
+                {"permanent", entry.permanent},
+        });
+    }
+    QSaveFile file(QDir(m_directory).filePath(kManifestFileName));
+    if (!file.open(QIODevice::WriteOnly)) {
+        kLogger.warning() << "Failed to write" << file.fileName();
+        return false;
+    }
+    file.write(QJsonDocument(QJsonObject{{"tracks", tracks}}).toJson());
+    return file.commit();
+}
+
+StreamCacheManager::Entry& StreamCacheManager::entryLocked(
+        const std::string& backingFilePath) {
+    return m_entries[backingFilePath];
+}
+
+void StreamCacheManager::trackOpened(const std::shared_ptr<SparseCache>& pCache) {
+    VERIFY_OR_DEBUG_ASSERT(pCache && pCache->hasBackingFile()) {
+        return;
+    }
+    const auto locker = lockMutex(&m_mutex);
+    Entry& entry = entryLocked(pCache->getBackingFilePath());
+    entry.pCache = pCache;
+    entry.lastAccessMs = currentTimeMs();
+    updateUsedBytesLocked();
+}
+
+void StreamCacheManager::trackPlayed(const std::string& backingFilePath) {
+    const auto locker = lockMutex(&m_mutex);
+    Entry& entry = entryLocked(backingFilePath);
+    ++entry.playCount;
+    entry.lastAccessMs = currentTimeMs();
+}
+
+void StreamCacheManager::setOfflineStatus(
+        const std::string& backingFilePath, OfflineStatus status) {
+    const auto locker = lockMutex(&m_mutex);
+    Entry& entry = entryLocked(backingFilePath);
+    const bool permanent = status == OfflineStatus::OfflinePermanent;
+    if (entry.permanent != permanent) {
+        entry.permanent = permanent;
+        saveManifestLocked();
+    }
+}
+
+OfflineStatus StreamCacheManager::getOfflineStatus(
+        const std::string& backingFilePath) const {
+    const auto locker = lockMutex(&m_mutex);
+    const auto it = m_entries.find(backingFilePath);
+    if (it == m_entries.end()) {
+        return OfflineStatus::CloudOnly;
+    }
+    const Entry& entry = it->second;
+    if (entry.permanent) {
+        return OfflineStatus::OfflinePermanent;
+    }
+    if (const auto pCache = entry.pCache.lock()) {
+        if (pCache->isFullyCached()) {
+            return OfflineStatus::FullCache;
+        }
+        return pCache->getCachedBytes() > 0
+                ? OfflineStatus::PartialCache
+                : OfflineStatus::CloudOnly;
+    }
+    if (entry.fullyCached) {
+        return OfflineStatus::FullCache;
+    }
+    return entry.bytes > 0 ? OfflineStatus::PartialCache : OfflineStatus::CloudOnly;
+}
+
+void StreamCacheManager::reportAccessCounts() {
+    const int hits = m_pendingHits.exchange(0, std::memory_order_relaxed);
+    if (hits > 0) {
+        Counter(kStatHits).increment(hits);
+    }
+    const int misses = m_pendingMisses.exchange(0, std::memory_order_relaxed);
+    if (misses > 0) {
+        Counter(kStatMisses).increment(misses);
+    }
+}
+
+int64_t StreamCacheManager::updateUsedBytesLocked() {
+    const int64_t nowMs = currentTimeMs();
+    m_usedBytes = 0;
+    for (auto& [backingFilePath, entry] : m_entries) {
+        if (const auto pCache = entry.pCache.lock()) {
+            // Tracks are read as long as they are in use
+            entry.lastAccessMs = nowMs;
+            // Pages that have been written through the mapping might not
+            // be allocated yet, the cached bytes are a lower bound
+            entry.bytes = std::max(
+                    allocatedSizeOfFiles(filesForBackingFile(backingFilePath)),
+                    pCache->getCachedBytes());
+            entry.fullyCached = pCache->isFullyCached();
+        }
+        m_usedBytes += entry.bytes;
+    }
+    return m_usedBytes;
+}
+
+bool StreamCacheManager::reserve(int64_t bytes) {
+    reportAccessCounts();
+    const auto locker = lockMutex(&m_mutex);
+    if (updateUsedBytesLocked() + bytes <= m_byteBudget) {
+        reportUsedBytesLocked();
+        return true;
+    }
+
+    std::vector<std::map<std::string, Entry>::const_iterator> candidates;
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        if (!it->second.permanent && !it->second.isInUse()) {
+            candidates.push_back(it);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto& lhs, const auto& rhs) {
+        const Entry& left = lhs->second;
+        const Entry& right = rhs->second;
+        if (left.fullyCached != right.fullyCached) {
+            return !left.fullyCached;
+        }
+        if (left.playCount != right.playCount) {
+            return left.playCount < right.playCount;
+        }
+        return left.lastAccessMs < right.lastAccessMs;
+    });
+
+    bool evicted = false;
+    for (const auto& candidate : candidates) {
+        if (m_usedBytes + bytes <= m_byteBudget) {
+            break;
+        }
+        // Copy the key, the entry is erased
+        const std::string backingFilePath = candidate->first;
+        evictLocked(backingFilePath);
+        evicted = true;
+    }
+    if (evicted) {
+        saveManifestLocked();
+    }
+    reportUsedBytesLocked();
+    if (m_usedBytes + bytes > m_byteBudget) {
+        kLogger.warning()
+                << "Unable to free" << bytes << "bytes, using"
+                << m_usedBytes << "of" << m_byteBudget << "bytes";
+        return false;
+    }
+    return true;
+}
+
+int64_t StreamCacheManager::evict(const std::string& backingFilePath) {
+    const auto locker = lockMutex(&m_mutex);
+    const int64_t freedBytes = evictLocked(backingFilePath);
+    if (freedBytes > 0) {
+        saveManifestLocked();
+        reportUsedBytesLocked();
+    }
+    return freedBytes;
+}
+
+int64_t StreamCacheManager::evictLocked(const std::string& backingFilePath) {
+    const auto it = m_entries.find(backingFilePath);
+    if (it == m_entries.end() || it->second.isInUse()) {
+        return 0;
+    }
+    const int64_t freedBytes = it->second.bytes;
+    for (const auto& path : filesForBackingFile(backingFilePath)) {
+        std::remove(path.c_str());
+    }
+    m_usedBytes -= freedBytes;
+    m_entries.erase(it);
+    Counter(kStatEvictions).increment();
+    Counter(kStatEvictedBytes).increment(static_cast<int>(std::min<int64_t>(
+            freedBytes, std::numeric_limits<int>::max())));
+    kLogger.info() << "Evicted" << QString::fromStdString(backingFilePath) << "freeing" << freedBytes << "bytes";
+    return freedBytes;
+}
+
+void StreamCacheManager::reportUsedBytesLocked() const {
+    Stat::track(kStatUsedBytes,
+            Stat::UNSPECIFIED,
+            Stat::experimentFlags(Stat::COUNT | Stat::AVERAGE | Stat::MIN | Stat::MAX),
+            static_cast<double>(m_usedBytes));
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "streaming/bridge/sparsecache.h"
+#include "streaming/hook/streamingdto.h"
+
+/// Keeps the disk usage of all streamed tracks within a byte budget.
+///
+/// Every track in the cache directory is accounted with the bytes that the
+/// file system has allocated for its SparseCache backing file, its PCM cache
+/// and their sidecar indices. When a download would exceed the budget the
+/// least valuable tracks are deleted first: Partially cached tracks before
+/// fully cached ones, and within each tier the least played and then the
+/// least recently used. Tracks that are OfflinePermanent or currently
+/// opened by a player are never evicted.
+///
+/// Play counts, access times and the permanent flag are persisted in a
+/// manifest in the cache directory. Hits, misses and evictions are
+/// reported to the StatsManager.
+///
+/// All functions are thread-safe. Recording hits and misses only
+/// increments atomic counters and may be called from the reading thread,
+/// the counters are reported by the next call to reserve().
+class StreamCacheManager {
+  public:
+    StreamCacheManager(const QString& directory, int64_t byteBudget);
+    ~StreamCacheManager();
+
+    StreamCacheManager(const StreamCacheManager&) = delete;
+    StreamCacheManager& operator=(const StreamCacheManager&) = delete;
+
+    void setByteBudget(int64_t byteBudget);
+    int64_t getByteBudget() const;
+
+    /// The number of bytes on disk used by all tracks.
+    int64_t getUsedBytes() const;
+
+    /// Registers a cache that a player has opened. The track is not
+    /// evicted as long as any reference to the cache exists.
+    void trackOpened(const std::shared_ptr<SparseCache>& pCache);
+    void trackPlayed(const std::string& backingFilePath);
+
+    /// Only OfflinePermanent is stored explicitly, the other states follow
+    /// from the cached data.
+    void setOfflineStatus(const std::string& backingFilePath, OfflineStatus status);
+    OfflineStatus getOfflineStatus(const std::string& backingFilePath) const;
+
+    /// A read that could be served from the cache.
+    void recordHit() {
+        m_pendingHits.fetch_add(1, std::memory_order_relaxed);
+    }
+    /// A read that had to wait for or skip missing data.
+    void recordMiss() {
+        m_pendingMisses.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Evicts tracks until the given number of additional bytes fits into
+    /// the budget. Returns false if the budget cannot be met because all
+    /// remaining tracks are permanent or in use.
+    bool reserve(int64_t bytes);
+
+    /// Removes all files of a track that is not in use. Returns the number
+    /// of bytes freed.
+    int64_t evict(const std::string& backingFilePath);
+
+    bool saveManifest() const;
+
+    /// All files on disk that belong to the track with the backing file.
+    static std::vector<std::string> filesForBackingFile(
+            const std::string& backingFilePath);
+
+  private:
+    struct Entry {
+        std::weak_ptr<SparseCache> pCache;
+        int64_t bytes = 0;
+        int64_t lastAccessMs = 0;
+        int playCount = 0;
+        bool fullyCached = false;
+        bool permanent = false;
+
+        bool isInUse() const {
+            return !pCache.expired();
+        }
+    };
+
+    void scanDirectory();
+    void loadManifest();
+    bool saveManifestLocked() const;
+    /// Updates the size of tracks that are in use and returns the total.
+    int64_t updateUsedBytesLocked();
+    Entry& entryLocked(const std::string& backingFilePath);
+    int64_t evictLocked(const std::string& backingFilePath);
+    void reportUsedBytesLocked() const;
+    void reportAccessCounts();
+
+    const QString m_directory;
+
+    mutable QMutex m_mutex;
+    int64_t m_byteBudget;
+    int64_t m_usedBytes;
+    // Keyed by the path of the backing file
+    std::map<std::string, Entry> m_entries;
+
+    std::atomic<int> m_pendingHits;
+    std::atomic<int> m_pendingMisses;
+};
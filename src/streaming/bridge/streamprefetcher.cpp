@@ -0,0 +1,248 @@
+#include "streaming/bridge/streamprefetcher.h"
+
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+
+#include "engine/engine.h"
+#include "mixer/playermanager.h"
+#include "moc_streamprefetcher.cpp"
+#include "streaming/bridge/streamcachemanager.h"
+#include "util/assert.h"
+#include "util/defs.h"
+#include "util/logger.h"
+
+namespace {
+
+const mixxx::Logger kLogger("StreamPrefetcher");
+
+const ConfigKey kLookAheadSecondsKey =
+        ConfigKey(QStringLiteral("[Streaming]"), QStringLiteral("PrefetchLookAheadSeconds"));
+const ConfigKey kMaxConcurrentRequestsKey =
+        ConfigKey(QStringLiteral("[Streaming]"), QStringLiteral("PrefetchMaxConcurrentRequests"));
+
+constexpr int kUpdateIntervalMillis = 100;
+constexpr int kHttpStatusPartialContent = 206;
+
+// Positions of cues and loops are reported in samples, -1 if unset
+bool isValidSamplePosition(double position) {
+    return position >= 0.0;
+}
+
+} // anonymous namespace
+
+StreamPrefetcher::Player::Player(const QString& group)
+        : group(group),
+          play(group, QStringLiteral("play")),
+          playPosition(group, QStringLiteral("playposition")),
+          rateRatio(group, QStringLiteral("rate_ratio")),
+          reverse(group, QStringLiteral("reverse")),
+          scratch2(group, QStringLiteral("scratch2")),
+          scratch2Enable(group, QStringLiteral("scratch2_enable")),
+          trackSamples(group, QStringLiteral("track_samples")),
+          trackSampleRate(group, QStringLiteral("track_samplerate")),
+          cuePoint(group, QStringLiteral("cue_point")),
+          loopStartPosition(group, QStringLiteral("loop_start_position")),
+          wasPlaying(false) {
+    hotcuePositions.reserve(kMaxNumberOfHotcues);
+    for (int i = 1; i <= kMaxNumberOfHotcues; ++i) {
+        hotcuePositions.emplace_back(group,
+                QStringLiteral("hotcue_%1_position").arg(i));
+    }
+}
+
+StreamPrefetcher::StreamPrefetcher(UserSettingsPointer pConfig,
+        QNetworkAccessManager* pNam,
+        QObject* parent)
+        : QObject(parent),
+          m_pNam(pNam),
+          m_pCacheManager(nullptr),
+          m_nextDeckId(0) {
+    PrefetchScheduler::Config config;
+    config.lookAheadSeconds = pConfig->getValue(
+            kLookAheadSecondsKey, config.lookAheadSeconds);
+    config.maxConcurrentRequests = pConfig->getValue(
+            kMaxConcurrentRequestsKey, config.maxConcurrentRequests);
+    m_scheduler.setConfig(config);
+
+    m_timer.setInterval(kUpdateIntervalMillis);
+    connect(&m_timer, &QTimer::timeout, this, &StreamPrefetcher::slotUpdate);
+}
+
+StreamPrefetcher::~StreamPrefetcher() {
+    m_timer.stop();
+}
+
+void StreamPrefetcher::setTrack(const QString& group,
+        std::shared_ptr<SparseCache> pCache,
+        const QUrl& streamUrl) {
+    clearTrack(group);
+    if (!pCache || !pCache->hasBackingFile() || !streamUrl.isValid()) {
+        kLogger.warning() << "Not prefetching" << streamUrl << "for" << group;
+        return;
+    }
+    if (m_pCacheManager) {
+        m_pCacheManager->trackOpened(pCache);
+    }
+    const int deckId = m_nextDeckId++;
+    auto pPlayer = std::make_unique<Player>(group);
+    pPlayer->pCache = std::move(pCache);
+    pPlayer->streamUrl = streamUrl;
+    m_players.emplace(deckId, std::move(pPlayer));
+    m_deckIdsByGroup.insert(group, deckId);
+    if (!m_timer.isActive()) {
+        m_timer.start();
+    }
+    slotUpdate();
+}
+
+void StreamPrefetcher::clearTrack(const QString& group) {
+    const auto it = m_deckIdsByGroup.constFind(group);
+    if (it == m_deckIdsByGroup.constEnd()) {
+        return;
+    }
+    // Requests in flight are left to finish, the data is still useful
+    m_scheduler.removeDeck(it.value());
+    m_players.erase(it.value());
+    m_deckIdsByGroup.erase(it);
+    if (m_players.empty()) {
+        m_timer.stop();
+    }
+}
+
+PrefetchScheduler::DeckState StreamPrefetcher::deckState(const Player& player) const {
+    PrefetchScheduler::DeckState state;
+    state.pCache = player.pCache;
+    if (PlayerManager::isPreviewDeckGroup(player.group)) {
+        state.priority = PrefetchScheduler::Priority::Preview;
+    } else if (player.play.toBool()) {
+        state.priority = PrefetchScheduler::Priority::Playing;
+    } else {
+        state.priority = PrefetchScheduler::Priority::Cued;
+    }
+    state.position = player.playPosition.get();
+    // rate_ratio is the unsigned tempo ratio, the direction is controlled
+    // separately. Scratching overrides both.
+    if (player.scratch2Enable.toBool()) {
+        state.rate = player.scratch2.get();
+    } else {
+        state.rate = player.rateRatio.get();
+        if (player.reverse.toBool()) {
+            state.rate = -state.rate;
+        }
+    }
+
+    const double trackSamples = player.trackSamples.get();
+    const double sampleRate = player.trackSampleRate.get();
+    if (trackSamples <= 0.0 || sampleRate <= 0.0) {
+        // Track not loaded (yet)
+        return state;
+    }
+    // track_samples counts samples of the stereo engine signal
+    state.durationSeconds = trackSamples / mixxx::kEngineChannelOutputCount / sampleRate;
+
+    const auto addJumpTarget = [&state, trackSamples](double samplePosition) {
+        if (isValidSamplePosition(samplePosition)) {
+            state.jumpTargets.push_back(samplePosition / trackSamples);
+        }
+    };
+    addJumpTarget(player.cuePoint.get());
+    addJumpTarget(player.loopStartPosition.get());
+    for (const auto& hotcuePosition : player.hotcuePositions) {
+        addJumpTarget(hotcuePosition.get());
+    }
+    return state;
+}
+
+void StreamPrefetcher::slotUpdate() {
+    for (const auto& [deckId, pPlayer] : m_players) {
+        const bool playing = pPlayer->play.toBool();
+        if (m_pCacheManager && playing && !pPlayer->wasPlaying) {
+            m_pCacheManager->trackPlayed(pPlayer->pCache->getBackingFilePath());
+        }
+        pPlayer->wasPlaying = playing;
+        m_scheduler.updateDeck(deckId, deckState(*pPlayer));
+    }
+    for (const auto& request : m_scheduler.nextRequests()) {
+        startRequest(request);
+    }
+}
+
+void StreamPrefetcher::startRequest(const PrefetchScheduler::Request& request) {
+    const auto it = m_players.find(request.deck);
+    VERIFY_OR_DEBUG_ASSERT(it != m_players.end()) {
+        m_scheduler.requestFinished(request);
+        return;
+    }
+    const QString group = it->second->group;
+    // Never stall a playing deck, its data is needed right now. Only the
+    // look ahead of idle decks is dropped when the disk is full.
+    if (m_pCacheManager &&
+            !m_pCacheManager->reserve(request.length) &&
+            !it->second->play.toBool()) {
+        m_scheduler.requestFinished(request);
+        return;
+    }
+
+    QNetworkRequest networkRequest(it->second->streamUrl);
+    networkRequest.setRawHeader("Range",
+            QStringLiteral("bytes=%1-%2")
+                    .arg(request.start)
+                    .arg(request.start + request.length - 1)
+                    .toLatin1());
+    QNetworkReply* pReply = m_pNam->get(networkRequest);
+
+    // Bytes received so far, shared by both handlers
+    auto pReceived = std::make_shared<qint64>(0);
+    connect(pReply,
+            &QNetworkReply::readyRead,
+            this,
+            [pReply, request, pReceived]() {
+                // A server that ignores the Range header would send the
+                // whole file from the start
+                if (pReply->attribute(QNetworkRequest::HttpStatusCodeAttribute)
+                                .toInt() != kHttpStatusPartialContent) {
+                    pReply->abort();
+                    return;
+                }
+                while (pReply->bytesAvailable() > 0 && *pReceived < request.length) {
+                    const qint64 offset = request.start + *pReceived;
+                    const qint64 remaining = request.length - *pReceived;
+                    // Read straight into the mapped backing file
+                    uint8_t* pData = request.pCache->getWritableData(offset, remaining);
+                    VERIFY_OR_DEBUG_ASSERT(pData) {
+                        pReply->abort();
+                        return;
+                    }
+                    const qint64 bytesRead = pReply->read(
+                            reinterpret_cast<char*>(pData), remaining);
+                    if (bytesRead <= 0) {
+                        break;
+                    }
+                    request.pCache->markCached(offset, bytesRead);
+                    *pReceived += bytesRead;
+                }
+            });
+    connect(pReply,
+            &QNetworkReply::finished,
+            this,
+            [this, pReply, request, pReceived, group]() {
+                pReply->deleteLater();
+                m_scheduler.requestFinished(request);
+                if (*pReceived > 0) {
+                    emit rangeCached(group, request.start, *pReceived);
+                }
+                if (pReply->error() != QNetworkReply::NoError ||
+                        *pReceived < request.length) {
+                    kLogger.warning()
+                            << "Range request" << request.start << "+"
+                            << request.length << "for" << group
+                            << "failed:" << pReply->errorString();
+                    emit fetchFailed(group, pReply->errorString());
+                    // Retried on the next regular update
+                    return;
+                }
+                // Use the free slot immediately
+                slotUpdate();
+            });
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QUrl>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "control/pollingcontrolproxy.h"
+#include "preferences/usersettings.h"
+#include "streaming/bridge/prefetchscheduler.h"
+#include "streaming/bridge/sparsecache.h"
+
+class QNetworkAccessManager;
+class StreamCacheManager;
+
+/// Keeps the bytes that the decks will need next downloaded.
+///
+/// Periodically polls the play position, rate, hotcues, loop and cue point
+/// of every player with a streamed track loaded, feeds them into a
+/// PrefetchScheduler and issues the resulting HTTP range requests. The
+/// response data is written directly into the backing file of the track's
+/// SparseCache.
+class StreamPrefetcher : public QObject {
+    Q_OBJECT
+  public:
+    StreamPrefetcher(UserSettingsPointer pConfig,
+            QNetworkAccessManager* pNam,
+            QObject* parent = nullptr);
+    ~StreamPrefetcher() override;
+
+    /// Starts prefetching the streamed track loaded into the player group.
+    void setTrack(const QString& group,
+            std::shared_ptr<SparseCache> pCache,
+            const QUrl& streamUrl);
+    void clearTrack(const QString& group);
+
+    /// Optional. Downloads for decks that are not playing are skipped if
+    /// they would exceed the disk budget of the cache manager.
+    void setCacheManager(StreamCacheManager* pCacheManager) {
+        m_pCacheManager = pCacheManager;
+    }
+
+  signals:
+    void rangeCached(const QString& group, qint64 start, qint64 length);
+    void fetchFailed(const QString& group, const QString& errorString);
+
+  private slots:
+    void slotUpdate();
+
+  private:
+    struct Player {
+        explicit Player(const QString& group);
+
+        QString group;
+        std::shared_ptr<SparseCache> pCache;
+        QUrl streamUrl;
+        PollingControlProxy play;
+        PollingControlProxy playPosition;
+        PollingControlProxy rateRatio;
+        PollingControlProxy reverse;
+        PollingControlProxy scratch2;
+        PollingControlProxy scratch2Enable;
+        PollingControlProxy trackSamples;
+        PollingControlProxy trackSampleRate;
+        PollingControlProxy cuePoint;
+        PollingControlProxy loopStartPosition;
+        std::vector<PollingControlProxy> hotcuePositions;
+        bool wasPlaying;
+    };
+
+    PrefetchScheduler::DeckState deckState(const Player& player) const;
+    void startRequest(const PrefetchScheduler::Request& request);
+
+    QNetworkAccessManager* const m_pNam;
+    StreamCacheManager* m_pCacheManager;
+    PrefetchScheduler m_scheduler;
+    QTimer m_timer;
+    // Keyed by the deck id used with the scheduler
+    std::map<int, std::unique_ptr<Player>> m_players;
+    QHash<QString, int> m_deckIdsByGroup;
+    int m_nextDeckId;
+};
@@ -0,0 +1,156 @@
+#include "streaming/bridge/streamwaveformbuilder.h"
+
+#include "analyzer/analyzertrack.h"
+#include "analyzer/constants.h"
+#include "engine/cachingreader/cachingreaderchunk.h"
+#include "sources/audiosourcestereoproxy.h"
+#include "sources/soundsourcekineticproxy.h"
+#include "track/track.h"
+#include "util/assert.h"
+#include "util/logger.h"
+#include "util/math.h"
+
+namespace {
+
+const mixxx::Logger kLogger("StreamWaveformBuilder");
+
+constexpr SINT kChunkFrames = CachingReaderChunk::kFrames;
+
+} // anonymous namespace
+
+StreamWaveformBuilder::StreamWaveformBuilder(
+        UserSettingsPointer pConfig,
+        const QSqlDatabase& dbConnection)
+        : m_analyzer(pConfig, dbConnection),
+          m_analyzedChunkCount(0) {
+}
+
+bool StreamWaveformBuilder::setTrack(TrackPointer pTrack,
+        std::shared_ptr<mixxx::SoundSourceKineticProxy> pSource) {
+    clearTrack();
+    VERIFY_OR_DEBUG_ASSERT(pTrack && pSource) {
+        return false;
+    }
+    mixxx::AudioSourcePointer pAudioSource = pSource;
+    // Like in the AnalyzerThread
+    if (pAudioSource->getSignalInfo().getChannelCount() % mixxx::kAnalysisChannels) {
+        pAudioSource = std::make_shared<mixxx::AudioSourceStereoProxy>(
+                pAudioSource, kChunkFrames);
+    }
+    const auto signalInfo = pAudioSource->getSignalInfo();
+    const SINT frameLength = pAudioSource->frameLength();
+    if (!m_analyzer.initialize(AnalyzerTrack(pTrack),
+                signalInfo.getSampleRate(),
+                signalInfo.getChannelCount(),
+                frameLength)) {
+        return false;
+    }
+
+    m_pTrack = std::move(pTrack);
+    m_pSource = std::move(pSource);
+    m_pAudioSource = std::move(pAudioSource);
+    m_analyzedChunks.assign((frameLength + kChunkFrames - 1) / kChunkFrames, false);
+    m_analyzedChunkCount = 0;
+    m_sampleBuffer = mixxx::SampleBuffer(signalInfo.frames2samples(kChunkFrames));
+    return true;
+}
+
+void StreamWaveformBuilder::clearTrack() {
+    if (m_pTrack) {
+        m_analyzer.cleanup();
+    }
+    m_pTrack.reset();
+    m_pSource.reset();
+    m_pAudioSource.reset();
+    m_analyzedChunks.clear();
+    m_analyzedChunkCount = 0;
+}
+
+int StreamWaveformBuilder::update(int maxChunkCount) {
+    if (!m_pTrack || isComplete()) {
+        return 0;
+    }
+
+    const SINT frameIndexMin = m_pSource->frameIndexMin();
+    const SINT frameIndexMax = m_pSource->frameIndexMax();
+    const SINT chunkCount = static_cast<SINT>(m_analyzedChunks.size());
+    int analyzedChunkCount = 0;
+    for (const auto& cachedRange : m_pSource->getCachedFrameRanges()) {
+        // Only whole chunks, except for the last one of the track. Chunks
+        // at the edges of the range are analyzed when their neighbours
+        // have been downloaded.
+        const SINT firstChunk =
+                (cachedRange.start() - frameIndexMin + kChunkFrames - 1) /
+                kChunkFrames;
+        const SINT endChunk = cachedRange.end() >= frameIndexMax
+                ? chunkCount
+                : (cachedRange.end() - frameIndexMin) / kChunkFrames;
+        for (SINT chunkIndex = firstChunk;
+                chunkIndex < endChunk && analyzedChunkCount < maxChunkCount;
+                ++chunkIndex) {
+            if (!m_analyzedChunks[chunkIndex] && analyzeChunk(chunkIndex)) {
+                ++analyzedChunkCount;
+            }
+        }
+    }
+    if (analyzedChunkCount == 0) {
+        return 0;
+    }
+
+    if (isComplete()) {
+        kLogger.debug() << "Waveform of" << m_pTrack->getLocation() << "complete";
+        m_analyzer.storeResults(m_pTrack);
+        m_analyzer.cleanup();
+    } else {
+        m_analyzer.storePartialResults(m_pTrack, getAnalyzedRanges());
+    }
+    return analyzedChunkCount;
+}
+
+bool StreamWaveformBuilder::analyzeChunk(SINT chunkIndex) {
+    const SINT chunkFrameOffset = chunkIndex * kChunkFrames;
+    const SINT firstFrame = m_pSource->frameIndexMin() + chunkFrameOffset;
+    const auto chunkFrameRange = mixxx::IndexRange::forward(firstFrame,
+            math_min(kChunkFrames, m_pSource->frameIndexMax() - firstFrame));
+    const auto readableSampleFrames = m_pAudioSource->readSampleFrames(
+            mixxx::WritableSampleFrames(chunkFrameRange,
+                    mixxx::SampleBuffer::WritableSlice(m_sampleBuffer)));
+    if (readableSampleFrames.frameIndexRange() != chunkFrameRange) {
+        // Not decodable yet, retry with the next update
+        return false;
+    }
+
+    // Chunks are usually analyzed in order, a seek is only needed at holes
+    m_analyzer.seekFrame(chunkFrameOffset);
+    if (!m_analyzer.processSamples(readableSampleFrames.readableData(),
+                readableSampleFrames.readableLength())) {
+        return false;
+    }
+    m_analyzedChunks[chunkIndex] = true;
+    ++m_analyzedChunkCount;
+    return true;
+}
+
+QVector<QPair<double, double>> StreamWaveformBuilder::getAnalyzedRanges() const {
+    QVector<QPair<double, double>> ranges;
+    if (!m_pSource) {
+        return ranges;
+    }
+    const double frameLength = m_pSource->frameIndexRange().length();
+    const SINT chunkCount = static_cast<SINT>(m_analyzedChunks.size());
+    SINT chunkIndex = 0;
+    while (chunkIndex < chunkCount) {
+        if (!m_analyzedChunks[chunkIndex]) {
+            ++chunkIndex;
+            continue;
+        }
+        const SINT firstChunk = chunkIndex;
+        while (chunkIndex < chunkCount && m_analyzedChunks[chunkIndex]) {
+            ++chunkIndex;
+        }
+        ranges.append(qMakePair(
+                firstChunk * kChunkFrames / frameLength,
+                math_min(1.0, chunkIndex * kChunkFrames / frameLength)));
+    }
+    return ranges;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QPair>
+#include <QVector>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "analyzer/analyzerwaveform.h"
+#include "preferences/usersettings.h"
+#include "sources/audiosource.h"
+#include "track/track_decl.h"
+#include "util/samplebuffer.h"
+
+class QSqlDatabase;
+
+namespace mixxx {
+class SoundSourceKineticProxy;
+} // namespace mixxx
+
+/// Builds the waveforms of a streamed track from the parts that have been
+/// downloaded so far.
+///
+/// The audio is analyzed in chunks of CachingReaderChunk::kFrames frames.
+/// Each update() analyzes the chunks that have become decodable since the
+/// previous call, a chunk is never analyzed twice. After each update the
+/// waveforms are set on the track together with the covered ranges, i.e.
+/// the overview fills in the holes as the downloads land. Once all chunks
+/// have been analyzed the waveforms are stored like those of a local file.
+///
+/// The source must be opened exclusively for the builder, it must not be
+/// shared with a deck. update() must be called from the thread that owns
+/// the database connection.
+class StreamWaveformBuilder {
+  public:
+    StreamWaveformBuilder(
+            UserSettingsPointer pConfig,
+            const QSqlDatabase& dbConnection);
+
+    /// Returns false if no waveforms need to be built for the track, e.g.
+    /// if they have been stored before.
+    bool setTrack(TrackPointer pTrack,
+            std::shared_ptr<mixxx::SoundSourceKineticProxy> pSource);
+    void clearTrack();
+
+    /// Analyzes up to maxChunkCount of the chunks that have been downloaded
+    /// since the previous update and returns their number.
+    int update(int maxChunkCount = std::numeric_limits<int>::max());
+
+    bool isComplete() const {
+        return !m_analyzedChunks.empty() &&
+                m_analyzedChunkCount == static_cast<SINT>(m_analyzedChunks.size());
+    }
+
+    /// The analyzed parts as [start, end) fractions of the track duration.
+    QVector<QPair<double, double>> getAnalyzedRanges() const;
+
+  private:
+    bool analyzeChunk(SINT chunkIndex);
+
+    AnalyzerWaveform m_analyzer;
+
+    TrackPointer m_pTrack;
+    std::shared_ptr<mixxx::SoundSourceKineticProxy> m_pSource;
+    // The source, mixed to stereo if needed
+    mixxx::AudioSourcePointer m_pAudioSource;
+
+    std::vector<bool> m_analyzedChunks;
+    SINT m_analyzedChunkCount;
+
+    mixxx::SampleBuffer m_sampleBuffer;
+};
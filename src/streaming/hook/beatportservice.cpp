@@ -6,6 +6,7 @@
 #include <QNetworkReply>
 #include <QNetworkRequest>
 #include <QUrlQuery>
+#include <algorithm>
 
 #include "oauthmanager.h"
 
@@ -14,13 +15,22 @@ BeatportService::BeatportService(QNetworkAccessManager* pNam, OAuthManager* pOAu
           m_pNam(pNam),
           m_pOAuthManager(pOAuthManager),
           m_authState(AuthState::LoggedOut),
-          m_subscriptionTier(SubscriptionTier::None) {
+          m_subscriptionTier(SubscriptionTier::None),
+          m_trackCache(kTrackCacheCapacity) {
     setupOAuth();
+
+    m_batchTimer.setSingleShot(true);
+    m_batchTimer.setInterval(kTrackBatchWindowMs);
+    connect(&m_batchTimer, &QTimer::timeout, this, &BeatportService::slotFlushTrackBatch);
 }
 
 BeatportService::~BeatportService() {
 }
 
+void BeatportService::setResponseCacheDirectory(const QString& directory) {
+    m_responseCache = CatalogResponseCache(directory);
+}
+
 void BeatportService::setupOAuth() {
     // Register this service with the OAuth manager
     m_pOAuthManager->registerService(
@@ -97,12 +107,7 @@ void BeatportService::fetchSubscriptionInfo() {
     }
 
     QUrl url(QString("%1/my/subscriptions").arg(kBaseUrl));
-    QNetworkRequest request(url);
-    request.setRawHeader("Authorization", QString("Bearer %1").arg(accessToken).toUtf8());
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    request.setRawHeader("User-Agent", "Mixxx-Kinetic/1.0");
-
-    QNetworkReply* reply = m_pNam->get(request);
+    QNetworkReply* reply = m_pNam->get(newApiRequest(url, accessToken));
     connect(reply, &QNetworkReply::finished, this, [this, reply]() {
         reply->deleteLater();
 
@@ -130,41 +135,88 @@ void BeatportService::fetchSubscriptionInfo() {
 }
 
 QFuture<TrackMetadata> BeatportService::fetchTrackMetadata(const QString& trackId) {
-    QString accessToken = m_pOAuthManager->getAccessToken(serviceId());
-    if (accessToken.isEmpty()) {
-        // Return empty future - TODO: use QPromise for proper future handling
-        return QFuture<TrackMetadata>();
+    auto pPromise = std::make_shared<QPromise<TrackMetadata>>();
+    pPromise->start();
+    const auto future = pPromise->future();
+
+    if (const TrackMetadata* pCached = m_trackCache.object(trackId)) {
+        pPromise->addResult(*pCached);
+        pPromise->finish();
+        return future;
+    }
+    if (m_pOAuthManager->getAccessToken(serviceId()).isEmpty()) {
+        pPromise->finish();
+        return future;
     }
 
-    QUrl url(QString("%1/catalog/tracks/%2").arg(kBaseUrl, trackId));
-    QNetworkRequest request(url);
-    request.setRawHeader("Authorization", QString("Bearer %1").arg(accessToken).toUtf8());
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    request.setRawHeader("User-Agent", "Mixxx-Kinetic/1.0");
-
-    QNetworkReply* reply = m_pNam->get(request);
-    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
-        reply->deleteLater();
-
-        if (reply->error() != QNetworkReply::NoError) {
-            qWarning() << "BeatportService: Failed to fetch track metadata:" << reply->errorString();
-            return;
+    // Requests for the same track share the pending result
+    auto& promises = m_pendingTrackPromises[trackId];
+    if (promises.isEmpty()) {
+        m_batchTrackIds.append(trackId);
+        if (!m_batchTimer.isActive()) {
+            m_batchTimer.start();
         }
+    }
+    promises.append(pPromise);
+    return future;
+}
 
-        QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
-        QJsonObject obj = doc.object();
+void BeatportService::slotFlushTrackBatch() {
+    QStringList trackIds;
+    trackIds.swap(m_batchTrackIds);
+    // Sorted ids produce the same cache key for the same set of tracks
+    std::sort(trackIds.begin(), trackIds.end());
+    for (int i = 0; i < trackIds.size(); i += kMaxTrackBatchSize) {
+        fetchTrackBatch(trackIds.mid(i, kMaxTrackBatchSize));
+    }
+}
 
-        TrackMetadata metadata = parseTrackMetadata(obj);
-        // TODO: Signal or return through QPromise
-    });
+void BeatportService::fetchTrackBatch(const QStringList& trackIds) {
+    QUrl url(QString("%1/catalog/tracks/").arg(kBaseUrl));
+    QUrlQuery urlQuery;
+    urlQuery.addQueryItem("id", trackIds.join(','));
+    urlQuery.addQueryItem("per_page", QString::number(trackIds.size()));
+    url.setQuery(urlQuery);
 
-    return QFuture<TrackMetadata>();
+    getJson(
+            url,
+            [this, trackIds](const QJsonObject& obj) {
+                const QVector<TrackMetadata> tracks = parseTrackList(obj);
+                for (const TrackMetadata& metadata : tracks) {
+                    resolveTrack(metadata.remoteId, &metadata);
+                }
+                // Unknown ids are not part of the results
+                for (const QString& trackId : trackIds) {
+                    resolveTrack(trackId, nullptr);
+                }
+            },
+            [this, trackIds](const QString& errorString) {
+                qWarning() << "BeatportService: Failed to fetch track metadata:" << errorString;
+                for (const QString& trackId : trackIds) {
+                    resolveTrack(trackId, nullptr);
+                }
+            });
+}
+
+void BeatportService::resolveTrack(const QString& trackId, const TrackMetadata* pMetadata) {
+    const QList<TrackPromisePointer> promises = m_pendingTrackPromises.take(trackId);
+    for (const auto& pPromise : promises) {
+        if (pMetadata) {
+            pPromise->addResult(*pMetadata);
+        }
+        pPromise->finish();
+    }
 }
 
 QFuture<QVector<TrackMetadata>> BeatportService::search(const SearchQuery& query) {
+    auto pPromise = std::make_shared<QPromise<QVector<TrackMetadata>>>();
+    pPromise->start();
+    const auto future = pPromise->future();
+
     QString accessToken = m_pOAuthManager->getAccessToken(serviceId());
     if (accessToken.isEmpty()) {
-        return QFuture<QVector<TrackMetadata>>();
+        pPromise->finish();
+        return future;
     }
 
     QUrl url(QString("%1/catalog/search").arg(kBaseUrl));
@@ -180,45 +232,103 @@ QFuture<QVector<TrackMetadata>> BeatportService::search(const SearchQuery& query
     urlQuery.addQueryItem("offset", QString::number(query.offset));
     url.setQuery(urlQuery);
 
-    QNetworkRequest request(url);
-    request.setRawHeader("Authorization", QString("Bearer %1").arg(accessToken).toUtf8());
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    request.setRawHeader("User-Agent", "Mixxx-Kinetic/1.0");
+    getJson(
+            url,
+            [this, pPromise](const QJsonObject& obj) {
+                pPromise->addResult(parseTrackList(obj));
+                pPromise->finish();
+            },
+            [pPromise](const QString& errorString) {
+                qWarning() << "BeatportService: Search failed:" << errorString;
+                pPromise->finish();
+            });
+    return future;
+}
 
-    QNetworkReply* reply = m_pNam->get(request);
-    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
-        reply->deleteLater();
+QUrl BeatportService::playlistPageUrl(const QString& playlistId, int page) const {
+    QUrl url(QString("%1/catalog/playlists/%2/tracks/").arg(kBaseUrl, playlistId));
+    QUrlQuery urlQuery;
+    urlQuery.addQueryItem("page", QString::number(page));
+    urlQuery.addQueryItem("per_page", QString::number(kPlaylistPageSize));
+    url.setQuery(urlQuery);
+    return url;
+}
 
-        if (reply->error() != QNetworkReply::NoError) {
-            qWarning() << "BeatportService: Search failed:" << reply->errorString();
-            return;
-        }
+QFuture<QVector<TrackMetadata>> BeatportService::getPlaylist(const QString& playlistId) {
+    auto pPromise = std::make_shared<QPromise<QVector<TrackMetadata>>>();
+    pPromise->start();
+    const auto future = pPromise->future();
 
-        QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
-        QJsonObject obj = doc.object();
-        QJsonArray results = obj["results"].toArray();
+    if (m_pOAuthManager->getAccessToken(serviceId()).isEmpty()) {
+        pPromise->finish();
+        return future;
+    }
 
-        QVector<TrackMetadata> tracks;
-        for (const QJsonValue& value : results) {
-            tracks.append(parseTrackMetadata(value.toObject()));
+    // The first page tells how many pages follow. Those are requested
+    // all at once and reassembled in order.
+    struct PlaylistPages {
+        QVector<QVector<TrackMetadata>> pages;
+        int pendingPageCount = 0;
+        bool failed = false;
+    };
+    auto pPages = std::make_shared<PlaylistPages>();
+    const auto finish = [pPromise, pPages]() {
+        if (!pPages->failed) {
+            QVector<TrackMetadata> tracks;
+            for (const auto& page : std::as_const(pPages->pages)) {
+                tracks += page;
+            }
+            pPromise->addResult(tracks);
         }
-
-        // TODO: Signal or return through QPromise
-    });
-
-    return QFuture<QVector<TrackMetadata>>();
-}
-
-QFuture<QVector<TrackMetadata>> BeatportService::getPlaylist(const QString& playlistId) {
-    // TODO: Implement playlist fetching
-    Q_UNUSED(playlistId);
-    return QFuture<QVector<TrackMetadata>>();
+        pPromise->finish();
+    };
+    const auto onError = [pPages, finish](const QString& errorString) {
+        qWarning() << "BeatportService: Failed to fetch playlist:" << errorString;
+        pPages->failed = true;
+        if (--pPages->pendingPageCount <= 0) {
+            finish();
+        }
+    };
+
+    pPages->pendingPageCount = 1;
+    getJson(
+            playlistPageUrl(playlistId, 1),
+            [this, playlistId, pPages, finish, onError](const QJsonObject& obj) {
+                const int trackCount = obj["count"].toInt();
+                const int pageCount = std::max(1,
+                        (trackCount + kPlaylistPageSize - 1) / kPlaylistPageSize);
+                pPages->pages.resize(pageCount);
+                pPages->pages[0] = parseTrackList(obj);
+                pPages->pendingPageCount = pageCount - 1;
+                if (pPages->pendingPageCount == 0) {
+                    finish();
+                    return;
+                }
+                for (int page = 2; page <= pageCount; ++page) {
+                    getJson(
+                            playlistPageUrl(playlistId, page),
+                            [this, pPages, finish, page](const QJsonObject& pageObj) {
+                                pPages->pages[page - 1] = parseTrackList(pageObj);
+                                if (--pPages->pendingPageCount == 0) {
+                                    finish();
+                                }
+                            },
+                            onError);
+                }
+            },
+            onError);
+    return future;
 }
 
 QFuture<StreamInfo> BeatportService::getStreamInfo(const QString& trackId) {
+    auto pPromise = std::make_shared<QPromise<StreamInfo>>();
+    pPromise->start();
+    const auto future = pPromise->future();
+
     QString accessToken = m_pOAuthManager->getAccessToken(serviceId());
     if (accessToken.isEmpty()) {
-        return QFuture<StreamInfo>();
+        pPromise->finish();
+        return future;
     }
 
     QUrl url(QString("%1/catalog/tracks/%2/stream").arg(kBaseUrl, trackId));
@@ -229,17 +339,14 @@ QFuture<StreamInfo> BeatportService::getStreamInfo(const QString& trackId) {
     }
     url.setQuery(urlQuery);
 
-    QNetworkRequest request(url);
-    request.setRawHeader("Authorization", QString("Bearer %1").arg(accessToken).toUtf8());
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    request.setRawHeader("User-Agent", "Mixxx-Kinetic/1.0");
-
-    QNetworkReply* reply = m_pNam->get(request);
-    connect(reply, &QNetworkReply::finished, this, [this, reply, trackId]() {
+    // Stream URLs are signed and short-lived, they are never cached
+    QNetworkReply* reply = m_pNam->get(newApiRequest(url, accessToken));
+    connect(reply, &QNetworkReply::finished, this, [reply, trackId, pPromise]() {
         reply->deleteLater();
 
         if (reply->error() != QNetworkReply::NoError) {
             qWarning() << "BeatportService: Failed to get stream info:" << reply->errorString();
+            pPromise->finish();
             return;
         }
 
@@ -260,10 +367,117 @@ QFuture<StreamInfo> BeatportService::getStreamInfo(const QString& trackId) {
         // URL TTL is typically 1 hour
         info.expiresAt = QDateTime::currentDateTime().addSecs(3600);
 
-        // TODO: Signal or return through QPromise
+        pPromise->addResult(info);
+        pPromise->finish();
+    });
+
+    return future;
+}
+
+QNetworkRequest BeatportService::newApiRequest(
+        const QUrl& url, const QString& accessToken) const {
+    QNetworkRequest request(url);
+    request.setRawHeader("Authorization", QString("Bearer %1").arg(accessToken).toUtf8());
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    request.setRawHeader("User-Agent", "Mixxx-Kinetic/1.0");
+    // Concurrent catalog requests share a single connection
+    request.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    return request;
+}
+
+void BeatportService::getJson(const QUrl& url, JsonCallback onSuccess, ErrorCallback onError) {
+    // Responses may depend on the account, e.g. the subscription
+    const QString key = m_pOAuthManager->getAccountKey(serviceId()) +
+            QLatin1Char(' ') + url.toString(QUrl::FullyEncoded);
+    const auto cachedEntry = m_responseCache.lookup(key);
+    if (cachedEntry && cachedEntry->isFresh()) {
+        const QJsonDocument doc = QJsonDocument::fromJson(cachedEntry->body);
+        if (doc.isObject()) {
+            onSuccess(doc.object());
+            return;
+        }
+        m_responseCache.remove(key);
+    }
+
+    // Join an identical request that is already in flight
+    auto pendingIt = m_pendingGets.find(key);
+    if (pendingIt != m_pendingGets.end()) {
+        pendingIt->append({std::move(onSuccess), std::move(onError)});
+        return;
+    }
+    m_pendingGets.insert(key, {{std::move(onSuccess), std::move(onError)}});
+
+    QNetworkRequest request = newApiRequest(url, m_pOAuthManager->getAccessToken(serviceId()));
+    if (cachedEntry && !cachedEntry->etag.isEmpty()) {
+        request.setRawHeader("If-None-Match", cachedEntry->etag);
+    }
+    QNetworkReply* reply = m_pNam->get(request);
+    connect(reply, &QNetworkReply::finished, this, [this, key, reply, cachedEntry]() {
+        onGetFinished(key, reply, cachedEntry);
     });
+}
 
-    return QFuture<StreamInfo>();
+void BeatportService::onGetFinished(const QString& key,
+        QNetworkReply* pReply,
+        const std::optional<CatalogResponseCache::Entry>& cachedEntry) {
+    pReply->deleteLater();
+    const QList<PendingCallbacks> callbacks = m_pendingGets.take(key);
+
+    const int statusCode = pReply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    QString errorString;
+    CatalogResponseCache::Entry entry;
+    if (pReply->error() != QNetworkReply::NoError) {
+        errorString = pReply->errorString();
+    } else if (statusCode == 304 && cachedEntry) {
+        // Not modified, only the lifetime of the cached response is extended
+        entry = *cachedEntry;
+        entry.expiresAt = m_responseCache.expiresAtFromReply(pReply);
+    } else if (statusCode >= 400) {
+        errorString = QString("HTTP status %1").arg(statusCode);
+    } else {
+        entry = m_responseCache.entryFromReply(pReply, pReply->readAll());
+    }
+
+    QJsonObject obj;
+    if (errorString.isEmpty()) {
+        // Parsed once for all requests that joined
+        const QJsonDocument doc = QJsonDocument::fromJson(entry.body);
+        if (doc.isObject()) {
+            obj = doc.object();
+            if (CatalogResponseCache::isStorable(pReply)) {
+                m_responseCache.insert(key, entry);
+            } else {
+                m_responseCache.remove(key);
+            }
+        } else {
+            errorString = QStringLiteral("Invalid JSON response");
+        }
+    }
+    for (const auto& callback : callbacks) {
+        if (errorString.isEmpty()) {
+            callback.onSuccess(obj);
+        } else {
+            callback.onError(errorString);
+        }
+    }
+}
+
+QVector<TrackMetadata> BeatportService::parseTrackList(const QJsonObject& json) {
+    const QJsonArray results = json["results"].toArray();
+    QVector<TrackMetadata> tracks;
+    tracks.reserve(results.size());
+    for (const QJsonValue& value : results) {
+        QJsonObject trackObj = value.toObject();
+        // Playlist items wrap the track
+        if (trackObj.contains("track")) {
+            trackObj = trackObj["track"].toObject();
+        }
+        TrackMetadata metadata = parseTrackMetadata(trackObj);
+        m_trackCache.insert(metadata.remoteId, new TrackMetadata(metadata));
+        tracks.append(metadata);
+    }
+    return tracks;
 }
 
 TrackMetadata BeatportService::parseTrackMetadata(const QJsonObject& json) {
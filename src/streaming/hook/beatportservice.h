@@ -1,18 +1,37 @@
 #pragma once
 
+#include <QCache>
 #include <QFuture>
+#include <QHash>
+#include <QJsonObject>
 #include <QNetworkAccessManager>
+#include <QNetworkRequest>
 #include <QObject>
+#include <QPromise>
 #include <QString>
+#include <QStringList>
+#include <QTimer>
 #include <QUrl>
 #include <QVector>
+#include <functional>
+#include <memory>
+#include <optional>
 
+#include "catalogresponsecache.h"
 #include "streamingdto.h"
 #include "streamingservice.h"
 
 // Forward declarations
 class OAuthManager;
 
+/// Catalog requests are coalesced and cached:
+///  - fetchTrackMetadata() calls issued within a short window are batched
+///    into a single multi-ID request.
+///  - Identical requests that are in flight at the same time share a
+///    single reply.
+///  - Playlist pages after the first one are requested concurrently.
+///  - Responses are kept in a CatalogResponseCache on disk and parsed
+///    tracks in a bounded in-memory LRU cache.
 class BeatportService : public StreamingService {
     Q_OBJECT
   public:
@@ -37,12 +56,16 @@ class BeatportService : public StreamingService {
     // Streaming
     QFuture<StreamInfo> getStreamInfo(const QString& trackId) override;
 
+    /// Persists catalog responses in directory. Disabled if empty.
+    void setResponseCacheDirectory(const QString& directory);
+
   protected:
     QUrl getAuthorizationUrl() const override;
 
   private slots:
     void onAuthStateChanged(const QString& serviceId);
     void onAuthError(const QString& serviceId, const QString& errorMsg);
+    void slotFlushTrackBatch();
 
   private:
     QNetworkAccessManager* m_pNam;
@@ -58,9 +81,43 @@ class BeatportService : public StreamingService {
     static constexpr const char* kClientSecret = ""; // Optional for some flows
     static constexpr const char* kScope = "streaming catalog";
 
+    // Catalog request coalescing and caching
+    using JsonCallback = std::function<void(const QJsonObject&)>;
+    using ErrorCallback = std::function<void(const QString&)>;
+    struct PendingCallbacks {
+        JsonCallback onSuccess;
+        ErrorCallback onError;
+    };
+    using TrackPromisePointer = std::shared_ptr<QPromise<TrackMetadata>>;
+
+    static constexpr int kTrackBatchWindowMs = 5;
+    static constexpr int kMaxTrackBatchSize = 100;
+    static constexpr int kPlaylistPageSize = 100;
+    static constexpr int kTrackCacheCapacity = 2000;
+
+    QCache<QString, TrackMetadata> m_trackCache;
+    CatalogResponseCache m_responseCache;
+    // Keyed by the encoded request URL
+    QHash<QString, QList<PendingCallbacks>> m_pendingGets;
+    // Track ids that have not been requested yet
+    QStringList m_batchTrackIds;
+    QHash<QString, QList<TrackPromisePointer>> m_pendingTrackPromises;
+    QTimer m_batchTimer;
+
     // Helper methods
     void setupOAuth();
     void fetchSubscriptionInfo();
+    QNetworkRequest newApiRequest(const QUrl& url, const QString& accessToken) const;
+    /// Invokes exactly one of the callbacks, possibly synchronously if a
+    /// fresh response is cached.
+    void getJson(const QUrl& url, JsonCallback onSuccess, ErrorCallback onError);
+    void onGetFinished(const QString& key,
+            QNetworkReply* pReply,
+            const std::optional<CatalogResponseCache::Entry>& cachedEntry);
+    void fetchTrackBatch(const QStringList& trackIds);
+    void resolveTrack(const QString& trackId, const TrackMetadata* pMetadata);
+    QVector<TrackMetadata> parseTrackList(const QJsonObject& json);
+    QUrl playlistPageUrl(const QString& playlistId, int page) const;
     TrackMetadata parseTrackMetadata(const QJsonObject& json);
     QString normalizeKey(const QString& beatportKey);
     QString normalizeArtists(const QJsonArray& artistsArray);
@@ -0,0 +1,132 @@
+#include "catalogresponsecache.h"
+
+#include <algorithm>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QNetworkReply>
+#include <QSaveFile>
+#include <QtDebug>
+
+namespace {
+
+constexpr quint32 kFileMagic = 0x4d584352; // "MXCR"
+constexpr quint32 kFileVersion = 1;
+
+const QByteArray kMaxAgeDirective = QByteArrayLiteral("max-age=");
+
+QList<QByteArray> cacheControlDirectives(QNetworkReply* pReply) {
+    QList<QByteArray> directives = pReply->rawHeader("Cache-Control").split(',');
+    for (auto& directive : directives) {
+        directive = directive.trimmed().toLower();
+    }
+    return directives;
+}
+
+} // anonymous namespace
+
+CatalogResponseCache::CatalogResponseCache(
+        const QString& directory, int defaultTtlSeconds)
+        : m_directory(directory),
+          m_defaultTtlSeconds(defaultTtlSeconds) {
+    if (isEnabled()) {
+        QDir().mkpath(m_directory);
+    }
+}
+
+QString CatalogResponseCache::filePathFor(const QString& key) const {
+    const QByteArray hash = QCryptographicHash::hash(
+            key.toUtf8(), QCryptographicHash::Sha1);
+    return QDir(m_directory).filePath(
+            QString::fromLatin1(hash.toHex()) + QStringLiteral(".response"));
+}
+
+std::optional<CatalogResponseCache::Entry> CatalogResponseCache::lookup(
+        const QString& key) const {
+    if (!isEnabled()) {
+        return std::nullopt;
+    }
+    QFile file(filePathFor(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+    }
+    QDataStream stream(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString storedKey;
+    Entry entry;
+    stream >> magic >> version;
+    if (magic != kFileMagic || version != kFileVersion) {
+        return std::nullopt;
+    }
+    stream >> storedKey >> entry.etag >> entry.expiresAt >> entry.body;
+    // The key guards against hash collisions
+    if (stream.status() != QDataStream::Ok || storedKey != key) {
+        return std::nullopt;
+    }
+    return entry;
+}
+
+void CatalogResponseCache::insert(const QString& key, const Entry& entry) {
+    if (!isEnabled()) {
+        return;
+    }
+    // Readers never see a partially written entry
+    QSaveFile file(filePathFor(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "CatalogResponseCache: Failed to write" << file.fileName();
+        return;
+    }
+    QDataStream stream(&file);
+    stream << kFileMagic << kFileVersion
+           << key << entry.etag << entry.expiresAt << entry.body;
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "CatalogResponseCache: Failed to write" << file.fileName();
+    }
+}
+
+void CatalogResponseCache::remove(const QString& key) {
+    if (!isEnabled()) {
+        return;
+    }
+    QFile::remove(filePathFor(key));
+}
+
+// static
+bool CatalogResponseCache::isStorable(QNetworkReply* pReply) {
+    const QList<QByteArray> directives = cacheControlDirectives(pReply);
+    // private may be followed by a list of header fields
+    return std::none_of(directives.cbegin(),
+            directives.cend(),
+            [](const QByteArray& directive) {
+                return directive == "no-store" || directive.startsWith("private");
+            });
+}
+
+CatalogResponseCache::Entry CatalogResponseCache::entryFromReply(
+        QNetworkReply* pReply, const QByteArray& body) const {
+    Entry entry;
+    entry.body = body;
+    entry.etag = pReply->rawHeader("ETag");
+    entry.expiresAt = expiresAtFromReply(pReply);
+    return entry;
+}
+
+QDateTime CatalogResponseCache::expiresAtFromReply(QNetworkReply* pReply) const {
+    int ttlSeconds = m_defaultTtlSeconds;
+    for (const QByteArray& directive : cacheControlDirectives(pReply)) {
+        if (directive == "no-cache") {
+            // Only ever used after revalidation
+            ttlSeconds = 0;
+        } else if (directive.startsWith(kMaxAgeDirective)) {
+            bool ok = false;
+            const int maxAge = directive.mid(kMaxAgeDirective.size()).toInt(&ok);
+            if (ok && maxAge >= 0) {
+                ttlSeconds = maxAge;
+            }
+        }
+    }
+    return QDateTime::currentDateTimeUtc().addSecs(ttlSeconds);
+}
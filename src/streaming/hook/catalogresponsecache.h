@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QString>
+#include <optional>
+
+class QNetworkReply;
+
+/// On-disk cache of catalog API responses, keyed by the account and the
+/// request URL.
+///
+/// Each entry stores the raw response body together with its ETag and an
+/// expiration time. Fresh entries are served without contacting the
+/// server. Stale entries with an ETag are revalidated with a conditional
+/// request, a 304 response then only extends their lifetime.
+///
+/// All functions must be called from the same thread.
+class CatalogResponseCache {
+  public:
+    struct Entry {
+        QByteArray body;
+        QByteArray etag;
+        QDateTime expiresAt;
+
+        bool isFresh() const {
+            return QDateTime::currentDateTimeUtc() < expiresAt;
+        }
+    };
+
+    /// An empty directory disables the cache.
+    explicit CatalogResponseCache(
+            const QString& directory = QString(),
+            int defaultTtlSeconds = kDefaultTtlSeconds);
+
+    bool isEnabled() const {
+        return !m_directory.isEmpty();
+    }
+
+    std::optional<Entry> lookup(const QString& key) const;
+    void insert(const QString& key, const Entry& entry);
+    void remove(const QString& key);
+
+    /// Replies with the Cache-Control directives no-store or private must
+    /// not be written to disk.
+    static bool isStorable(QNetworkReply* pReply);
+
+    /// Creates an entry from a successful reply. The lifetime is taken from
+    /// the Cache-Control max-age directive if present.
+    Entry entryFromReply(QNetworkReply* pReply, const QByteArray& body) const;
+    QDateTime expiresAtFromReply(QNetworkReply* pReply) const;
+
+    static constexpr int kDefaultTtlSeconds = 3600;
+
+  private:
+    QString filePathFor(const QString& key) const;
+
+    QString m_directory;
+    int m_defaultTtlSeconds;
+};
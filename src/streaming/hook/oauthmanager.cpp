@@ -1,5 +1,6 @@
 #include "oauthmanager.h"
 
+#include <QCryptographicHash>
 #include <QEventLoop>
 #include <QNetworkAccessManager>
 
@@ -165,6 +166,29 @@ QString OAuthManager::getAccessToken(const QString& serviceId) {
     return QString();
 }
 
+QString OAuthManager::getAccountKey(const QString& serviceId) const {
+    const auto it = m_tokenCache.constFind(serviceId);
+    if (it == m_tokenCache.constEnd()) {
+        return QString();
+    }
+    // The refresh token outlives many access tokens
+    const QString& token = it->refreshToken.isEmpty()
+            ? it->accessToken
+            : it->refreshToken;
+    if (token.isEmpty()) {
+        return QString();
+    }
+    return QString::fromLatin1(
+            QCryptographicHash::hash(
+                    (serviceId + QLatin1Char(':') + token).toUtf8(),
+                    QCryptographicHash::Sha256)
+                    .toHex());
+}
+
+void OAuthManager::setTokens(const QString& serviceId, const TokenPair& tokens) {
+    m_tokenCache.insert(serviceId, tokens);
+}
+
 void OAuthManager::pollForToken(const QString& serviceId, const QString& deviceCode, int interval) {
     // Clean up any existing poll state for this service
     stopPolling(serviceId);
@@ -42,12 +42,19 @@ class OAuthManager : public QObject {
 
     // Storage (Keyring wrapper interaction)
     bool hasValidToken(const QString& serviceId) const;
+    // Makes tokens that have been obtained elsewhere available without
+    // persisting them in the keyring
+    void setTokens(const QString& serviceId, const TokenPair& tokens);
     QString getAccessToken(const QString& serviceId); // Blocking or maybe should return QFuture/Optional?
                                                       // For now, assuming synchronous lookup from memory/keyring is desired for speed
                                                       // but keyring on Linux (DBus) can be async.
                                                       // mixxx typically loads secrets at startup?
                                                       // Let's implement getting from memory cache which is populated on startup/refresh.
 
+    // Identifies the account that the tokens of the service belong to
+    // without revealing them. Empty if not logged in.
+    QString getAccountKey(const QString& serviceId) const;
+
     // Signals
   signals:
     void tokenRefreshed(const QString& serviceId);
@@ -0,0 +1,135 @@
+#include "streaming/hook/streamingcatalogsearch.h"
+
+#include <QFutureWatcher>
+#include <QtDebug>
+#include <utility>
+
+#include "library/searchquery.h"
+#include "library/trackcollection.h"
+#include "streaming/hook/streamingservice.h"
+
+namespace {
+
+// Splits "field:argument" tokens. Returns an empty field for plain words.
+std::pair<QString, QString> splitFilterToken(const QString& token) {
+    const int colon = token.indexOf(':');
+    if (colon <= 0) {
+        return {QString(), token};
+    }
+    QString argument = token.mid(colon + 1);
+    if (argument.startsWith('"') && argument.endsWith('"') && argument.size() >= 2) {
+        argument = argument.mid(1, argument.size() - 2);
+    }
+    return {token.left(colon), argument};
+}
+
+} // anonymous namespace
+
+StreamingCatalogSearch::StreamingCatalogSearch(
+        StreamingService* pService,
+        TrackCollection* pTrackCollection,
+        QObject* parent)
+        : QObject(parent),
+          m_pService(pService),
+          m_queryParser(pTrackCollection, StreamingTrackIndex::kSearchColumns),
+          m_refreshIntervalSeconds(kDefaultRefreshIntervalSeconds) {
+    m_trackIndex.initialize(pTrackCollection->database());
+}
+
+QVector<TrackMetadata> StreamingCatalogSearch::search(const QString& queryText) {
+    refresh(queryText);
+    return searchIndex(queryText);
+}
+
+QVector<TrackMetadata> StreamingCatalogSearch::searchIndex(
+        const QString& queryText) const {
+    const auto pQuery = m_queryParser.parseQuery(queryText, QString());
+    QVector<TrackMetadata> tracks = m_trackIndex.searchTracks(
+            m_pService->serviceId(), *pQuery, kMaxResults);
+    for (auto& track : tracks) {
+        track.source = m_pService;
+    }
+    return tracks;
+}
+
+void StreamingCatalogSearch::refresh(const QString& queryText) {
+    if (m_pendingRefreshes.contains(queryText)) {
+        return;
+    }
+    const QDateTime lastRefresh = m_lastRefresh.value(queryText);
+    if (lastRefresh.isValid() &&
+            lastRefresh.secsTo(QDateTime::currentDateTimeUtc()) <
+                    m_refreshIntervalSeconds) {
+        return;
+    }
+    if (!m_pService->isAuthenticated()) {
+        return;
+    }
+    m_pendingRefreshes.insert(queryText);
+
+    auto* pWatcher = new QFutureWatcher<QVector<TrackMetadata>>(this);
+    connect(pWatcher,
+            &QFutureWatcher<QVector<TrackMetadata>>::finished,
+            this,
+            [this, pWatcher, queryText]() {
+                pWatcher->deleteLater();
+                m_pendingRefreshes.remove(queryText);
+                const auto future = pWatcher->future();
+                if (future.resultCount() == 0) {
+                    // Failed, keep serving the indexed results and retry
+                    // with the next search
+                    return;
+                }
+                m_lastRefresh.insert(queryText, QDateTime::currentDateTimeUtc());
+                if (!m_trackIndex.storeTracks(
+                            m_pService->serviceId(), future.result())) {
+                    qWarning() << "StreamingCatalogSearch: Failed to index"
+                               << future.result().size() << "tracks";
+                    return;
+                }
+                emit resultsRefreshed(queryText, searchIndex(queryText));
+            });
+    pWatcher->setFuture(m_pService->search(remoteQueryFor(queryText, kMaxResults)));
+}
+
+// static
+SearchQuery StreamingCatalogSearch::remoteQueryFor(
+        const QString& queryText, int limit) {
+    SearchQuery query;
+    query.limit = limit;
+    QStringList words;
+    const QStringList tokens = SearchQueryParser::splitQueryIntoWords(queryText);
+    for (const QString& token : tokens) {
+        if (token.startsWith('-')) {
+            // Exclusions can only be applied locally
+            continue;
+        }
+        const QString plainToken = token.startsWith('~') ? token.mid(1) : token;
+        const auto [field, argument] = splitFilterToken(plainToken);
+        if (field.isEmpty()) {
+            words << argument;
+        } else if (field == QLatin1String("a") || field == QLatin1String("artist")) {
+            query.artist = argument;
+        } else if (field == QLatin1String("g") || field == QLatin1String("genre")) {
+            query.genre = argument;
+        } else if (field == QLatin1String("k") || field == QLatin1String("key")) {
+            query.key = argument;
+        } else if (field == QLatin1String("b") || field == QLatin1String("bpm")) {
+            const QStringList bounds = argument.split('-');
+            bool lowOk = false;
+            bool highOk = false;
+            const int low = qRound(bounds.first().toDouble(&lowOk));
+            const int high = qRound(bounds.last().toDouble(&highOk));
+            if (lowOk && highOk && bounds.size() <= 2) {
+                query.bpmRange = qMakePair(low, high);
+            }
+        } else if (field == QLatin1String("t") || field == QLatin1String("title") ||
+                field == QLatin1String("al") || field == QLatin1String("album")) {
+            words << argument;
+        }
+    }
+    query.text = words.join(' ');
+    return query;
+}
+
+#include "streamingcatalogsearch.moc"
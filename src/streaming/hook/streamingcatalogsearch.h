@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include "library/searchqueryparser.h"
+#include "streaming/hook/streamingdto.h"
+#include "streaming/hook/streamingtrackindex.h"
+
+class StreamingService;
+class TrackCollection;
+
+/// Library search over the catalog of a streaming service.
+///
+/// Searches are answered immediately from the local StreamingTrackIndex,
+/// using the same query syntax as the library. The remote search only runs
+/// as a refresh in the background: Its results are stored in the index and
+/// the updated local results are announced by resultsRefreshed(). A query
+/// is refreshed at most once per refresh interval, so repeated searches
+/// with a slow or missing connection don't queue up remote requests.
+class StreamingCatalogSearch : public QObject {
+    Q_OBJECT
+  public:
+    StreamingCatalogSearch(
+            StreamingService* pService,
+            TrackCollection* pTrackCollection,
+            QObject* parent = nullptr);
+    ~StreamingCatalogSearch() override = default;
+
+    /// Returns the indexed tracks that match the query and schedules a
+    /// remote refresh if needed.
+    QVector<TrackMetadata> search(const QString& queryText);
+
+    /// Returns the indexed tracks that match the query without contacting
+    /// the service.
+    QVector<TrackMetadata> searchIndex(const QString& queryText) const;
+
+    void setRefreshIntervalSeconds(int seconds) {
+        m_refreshIntervalSeconds = seconds;
+    }
+
+    /// Translates a library search query into the query of the service.
+    /// Filters that the service does not support are dropped, the results
+    /// are filtered locally anyway.
+    static SearchQuery remoteQueryFor(const QString& queryText, int limit);
+
+    static constexpr int kDefaultRefreshIntervalSeconds = 300;
+    static constexpr int kMaxResults = 200;
+
+  signals:
+    void resultsRefreshed(
+            const QString& queryText,
+            const QVector<TrackMetadata>& tracks);
+
+  private:
+    void refresh(const QString& queryText);
+
+    StreamingService* const m_pService;
+    StreamingTrackIndex m_trackIndex;
+    SearchQueryParser m_queryParser;
+
+    int m_refreshIntervalSeconds;
+    QHash<QString, QDateTime> m_lastRefresh;
+    QSet<QString> m_pendingRefreshes;
+};
@@ -0,0 +1,189 @@
+#include "streaming/hook/streamingtrackindex.h"
+
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QVariant>
+#include <QtDebug>
+
+#include "library/queryutil.h"
+#include "library/searchquery.h"
+#include "track/keyutils.h"
+#include "util/db/sqltransaction.h"
+
+namespace {
+
+const QString kTrackColumns = QStringLiteral(
+        "remote_id,artist,title,album,genre,year,label,"
+        "bpm,key,duration,coverart_url");
+
+// Exposes the streaming tracks with all columns of the library table that
+// SearchQueryParser may refer to. Counters and flags have the defaults of
+// the library table, streamed tracks have never been played or rated.
+// Tracks count as added when they have been returned by the service most
+// recently. The id is NULL to prevent crate filters from matching library
+// tracks with the same id.
+const QString kLibraryColumnsSubselect =
+        QStringLiteral(
+                "SELECT %1,last_seen_ms,key_id,"
+                "NULL AS id,"
+                "NULL AS album_artist,"
+                "NULL AS composer,"
+                "NULL AS grouping,"
+                "NULL AS comment,"
+                "NULL AS tracknumber,"
+                "0 AS played,"
+                "0 AS timesplayed,"
+                "NULL AS last_played_at,"
+                "0 AS rating,"
+                "NULL AS bitrate,"
+                "NULL AS samplerate,"
+                "NULL AS channels,"
+                "NULL AS location,"
+                "NULL AS directory,"
+                "NULL AS filetype,"
+                "strftime('%Y-%m-%dT%H:%M:%f',last_seen_ms/1000.0,'unixepoch') "
+                "AS datetime_added,"
+                "0 AS bpm_lock,"
+                "NULL AS beats_version "
+                "FROM streaming_tracks WHERE service_id=:service_id")
+                .arg(kTrackColumns);
+
+TrackMetadata trackFromQuery(const QSqlQuery& query) {
+    const QSqlRecord record = query.record();
+    TrackMetadata track{};
+    track.remoteId = query.value(record.indexOf("remote_id")).toString();
+    track.artist = query.value(record.indexOf("artist")).toString();
+    track.title = query.value(record.indexOf("title")).toString();
+    track.album = query.value(record.indexOf("album")).toString();
+    track.genre = query.value(record.indexOf("genre")).toString();
+    track.year = query.value(record.indexOf("year")).toInt();
+    track.label = query.value(record.indexOf("label")).toString();
+    track.bpm = qRound(query.value(record.indexOf("bpm")).toDouble());
+    track.key = query.value(record.indexOf("key")).toString();
+    track.durationMs = qRound(query.value(record.indexOf("duration")).toDouble() * 1000);
+    track.coverArtUrl = query.value(record.indexOf("coverart_url")).toString();
+    track.source = nullptr;
+    return track;
+}
+
+} // anonymous namespace
+
+const QStringList StreamingTrackIndex::kSearchColumns = {
+        QStringLiteral("artist"),
+        QStringLiteral("title"),
+        QStringLiteral("album"),
+        QStringLiteral("genre"),
+        QStringLiteral("label"),
+};
+
+bool StreamingTrackIndex::storeTracks(
+        const QString& serviceId,
+        const QVector<TrackMetadata>& tracks) {
+    if (tracks.isEmpty()) {
+        return true;
+    }
+    SqlTransaction transaction(m_database);
+    if (!transaction) {
+        return false;
+    }
+    QSqlQuery query(m_database);
+    query.prepare(QStringLiteral(
+            "INSERT OR REPLACE INTO streaming_tracks "
+            "(service_id,%1,key_id,last_seen_ms) VALUES "
+            "(:service_id,:remote_id,:artist,:title,:album,:genre,:year,:label,"
+            ":bpm,:key,:duration,:coverart_url,:key_id,:last_seen_ms)")
+                    .arg(kTrackColumns));
+    const qint64 lastSeenMs = QDateTime::currentMSecsSinceEpoch();
+    for (const auto& track : tracks) {
+        if (track.remoteId.isEmpty()) {
+            continue;
+        }
+        query.bindValue(":service_id", serviceId);
+        query.bindValue(":remote_id", track.remoteId);
+        query.bindValue(":artist", track.artist);
+        query.bindValue(":title", track.title);
+        query.bindValue(":album", track.album);
+        query.bindValue(":genre", track.genre);
+        query.bindValue(":year",
+                track.year > 0 ? QString::number(track.year) : QString());
+        query.bindValue(":label", track.label);
+        query.bindValue(":bpm", track.bpm);
+        query.bindValue(":key", track.key);
+        query.bindValue(":duration", track.durationMs / 1000.0);
+        query.bindValue(":coverart_url", track.coverArtUrl);
+        query.bindValue(":key_id",
+                static_cast<int>(KeyUtils::guessKeyFromText(track.key)));
+        query.bindValue(":last_seen_ms", lastSeenMs);
+        if (!query.exec()) {
+            LOG_FAILED_QUERY(query);
+            transaction.rollback();
+            return false;
+        }
+    }
+    return transaction.commit();
+}
+
+std::optional<TrackMetadata> StreamingTrackIndex::getTrack(
+        const QString& serviceId,
+        const QString& remoteId) const {
+    QSqlQuery query(m_database);
+    query.prepare(QStringLiteral(
+            "SELECT %1 FROM streaming_tracks "
+            "WHERE service_id=:service_id AND remote_id=:remote_id")
+                    .arg(kTrackColumns));
+    query.bindValue(":service_id", serviceId);
+    query.bindValue(":remote_id", remoteId);
+    if (!query.exec()) {
+        LOG_FAILED_QUERY(query);
+        return std::nullopt;
+    }
+    if (!query.next()) {
+        return std::nullopt;
+    }
+    return trackFromQuery(query);
+}
+
+QVector<TrackMetadata> StreamingTrackIndex::searchTracks(
+        const QString& serviceId,
+        const QueryNode& queryNode,
+        int limit,
+        int offset) const {
+    QString filter = queryNode.toSql();
+    if (filter.isEmpty()) {
+        // An empty query matches all tracks
+        filter = QStringLiteral("1");
+    }
+    QSqlQuery query(m_database);
+    query.prepare(QStringLiteral(
+            "SELECT %1 FROM (%2) WHERE %3 "
+            "ORDER BY last_seen_ms DESC LIMIT :limit OFFSET :offset")
+                    .arg(kTrackColumns, kLibraryColumnsSubselect, filter));
+    query.bindValue(":service_id", serviceId);
+    query.bindValue(":limit", limit);
+    query.bindValue(":offset", offset);
+    QVector<TrackMetadata> tracks;
+    if (!query.exec()) {
+        LOG_FAILED_QUERY(query);
+        return tracks;
+    }
+    while (query.next()) {
+        tracks.append(trackFromQuery(query));
+    }
+    return tracks;
+}
+
+int StreamingTrackIndex::removeTracksNotSeenSince(
+        const QString& serviceId,
+        const QDateTime& dateTime) {
+    QSqlQuery query(m_database);
+    query.prepare(QStringLiteral(
+            "DELETE FROM streaming_tracks "
+            "WHERE service_id=:service_id AND last_seen_ms<:last_seen_ms"));
+    query.bindValue(":service_id", serviceId);
+    query.bindValue(":last_seen_ms", dateTime.toMSecsSinceEpoch());
+    if (!query.exec()) {
+        LOG_FAILED_QUERY(query);
+        return 0;
+    }
+    return query.numRowsAffected();
+}
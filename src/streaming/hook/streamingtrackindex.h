@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QDateTime>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <optional>
+
+#include "library/dao/dao.h"
+#include "streaming/hook/streamingdto.h"
+
+class QueryNode;
+
+/// Persistent index of catalog tracks that have been returned by streaming
+/// services, stored in the streaming_tracks table of the library database.
+///
+/// The table uses the column names of the library table. Queries that are
+/// created by SearchQueryParser, including the bpm:, key: and genre:
+/// filters, can be applied to the index without a network connection.
+/// Library columns without a streaming counterpart read as NULL or as the
+/// default of the library table.
+class StreamingTrackIndex : public DAO {
+  public:
+    ~StreamingTrackIndex() override = default;
+
+    /// Columns that are searched by terms without a filter prefix.
+    static const QStringList kSearchColumns;
+
+    /// Inserts or updates the tracks within a single transaction and marks
+    /// them as seen now. Returns false if the transaction failed.
+    bool storeTracks(
+            const QString& serviceId,
+            const QVector<TrackMetadata>& tracks);
+
+    std::optional<TrackMetadata> getTrack(
+            const QString& serviceId,
+            const QString& remoteId) const;
+
+    /// Returns the tracks of a service that match the query, most recently
+    /// seen first. The source of the results is not set.
+    QVector<TrackMetadata> searchTracks(
+            const QString& serviceId,
+            const QueryNode& query,
+            int limit,
+            int offset = 0) const;
+
+    /// Removes tracks that have not been returned by the service since
+    /// the given time. Returns the number of removed tracks.
+    int removeTracksNotSeenSince(
+            const QString& serviceId,
+            const QDateTime& dateTime);
+};
@@ -0,0 +1,272 @@
+#include "streaming/streamingmanager.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QTimer>
+
+#include "library/library.h"
+#include "library/trackcollection.h"
+#include "library/trackcollectionmanager.h"
+#include "mixer/basetrackplayer.h"
+#include "mixer/playermanager.h"
+#include "mixer/previewdeck.h"
+#include "moc_streamingmanager.cpp"
+#include "sources/soundsourcestream.h"
+#include "streaming/bridge/streamcachemanager.h"
+#include "streaming/bridge/streamprefetcher.h"
+#include "streaming/bridge/streamwaveformbuilder.h"
+#include "streaming/hook/beatportservice.h"
+#include "streaming/hook/oauthmanager.h"
+#include "streaming/hook/streamingcatalogsearch.h"
+#include "track/track.h"
+#include "util/logger.h"
+
+namespace {
+
+const mixxx::Logger kLogger("StreamingManager");
+
+const ConfigKey kCacheDirectoryKey =
+        ConfigKey(QStringLiteral("[Streaming]"), QStringLiteral("CacheDirectory"));
+
+const ConfigKey kCacheBudgetMegabytesKey =
+        ConfigKey(QStringLiteral("[Streaming]"), QStringLiteral("CacheBudgetMB"));
+constexpr int kDefaultCacheBudgetMegabytes = 4096;
+
+// Waveforms are built in the main thread that owns the database
+// connection. Large downloads are analyzed in slices to keep the GUI
+// responsive.
+constexpr int kWaveformChunksPerUpdate = 16;
+
+// Catalog responses are kept apart from the files of streamed tracks
+const QString kResponseCacheSubdirectory = QStringLiteral("responses");
+
+// Files of streamed tracks are named <service id>-<remote id>.<suffix>
+const QChar kRemoteIdSeparator = QLatin1Char('-');
+
+QString cacheDirectoryFromConfig(const UserSettingsPointer& pConfig) {
+    const QString directory = pConfig->getValueString(kCacheDirectoryKey);
+    if (!directory.isEmpty()) {
+        return directory;
+    }
+    return QDir(pConfig->getSettingsPath()).filePath(QStringLiteral("streaming"));
+}
+
+} // anonymous namespace
+
+StreamingManager::StreamingManager(UserSettingsPointer pConfig,
+        PlayerManager* pPlayerManager,
+        Library* pLibrary,
+        QObject* parent)
+        : QObject(parent),
+          m_pConfig(pConfig),
+          m_pPlayerManager(pPlayerManager),
+          m_database(pLibrary->trackCollectionManager()->internalCollection()->database()),
+          m_cacheDirectory(QDir::cleanPath(
+                  QDir(cacheDirectoryFromConfig(pConfig)).absolutePath())),
+          m_pOAuthManager(std::make_unique<OAuthManager>(&m_network)),
+          m_pService(std::make_unique<BeatportService>(
+                  &m_network, m_pOAuthManager.get())),
+          m_pCacheManager(std::make_shared<StreamCacheManager>(m_cacheDirectory,
+                  static_cast<int64_t>(pConfig->getValue(kCacheBudgetMegabytesKey,
+                          kDefaultCacheBudgetMegabytes)) *
+                          1024 * 1024)),
+          m_pPrefetcher(std::make_unique<StreamPrefetcher>(pConfig, &m_network)),
+          m_pCatalogSearch(std::make_unique<StreamingCatalogSearch>(m_pService.get(),
+                  pLibrary->trackCollectionManager()->internalCollection())) {
+    if (!QDir().mkpath(m_cacheDirectory)) {
+        kLogger.warning()
+                << "Failed to create the cache directory"
+                << m_cacheDirectory;
+    }
+    mixxx::SoundSourceStream::setCacheDirectory(m_cacheDirectory);
+    mixxx::SoundSourceStream::setCacheManager(m_pCacheManager);
+    m_pPrefetcher->setCacheManager(m_pCacheManager.get());
+    m_pService->setResponseCacheDirectory(
+            QDir(m_cacheDirectory).filePath(kResponseCacheSubdirectory));
+
+    connect(pLibrary,
+            &Library::search,
+            this,
+            &StreamingManager::slotSearch);
+    connect(m_pPrefetcher.get(),
+            &StreamPrefetcher::rangeCached,
+            this,
+            &StreamingManager::slotRangeCached);
+    connect(m_pCatalogSearch.get(),
+            &StreamingCatalogSearch::resultsRefreshed,
+            this,
+            &StreamingManager::catalogSearchResults);
+
+    connect(m_pPlayerManager,
+            &PlayerManager::numberOfDecksChanged,
+            this,
+            &StreamingManager::slotNumberOfPlayersChanged);
+    slotNumberOfPlayersChanged();
+}
+
+StreamingManager::~StreamingManager() {
+    // Tracks that are loaded after the shutdown are decoded as plain files
+    mixxx::SoundSourceStream::setCacheDirectory(QString());
+    mixxx::SoundSourceStream::setCacheManager(nullptr);
+}
+
+QString StreamingManager::trackLocation(
+        const QString& remoteId, const QString& fileSuffix) const {
+    return QDir(m_cacheDirectory)
+            .filePath(m_pService->serviceId() + kRemoteIdSeparator +
+                    remoteId + QLatin1Char('.') + fileSuffix);
+}
+
+QString StreamingManager::remoteIdForLocation(const QString& location) const {
+    const QFileInfo fileInfo(location);
+    if (QDir::cleanPath(fileInfo.absolutePath()) != m_cacheDirectory) {
+        return QString();
+    }
+    const QString prefix = m_pService->serviceId() + kRemoteIdSeparator;
+    const QString baseName = fileInfo.completeBaseName();
+    if (!baseName.startsWith(prefix)) {
+        return QString();
+    }
+    return baseName.mid(prefix.size());
+}
+
+void StreamingManager::slotSearch(const QString& queryText) {
+    if (queryText.trimmed().isEmpty()) {
+        // Clearing the search must not list the whole index
+        return;
+    }
+    emit catalogSearchResults(queryText, m_pCatalogSearch->search(queryText));
+}
+
+void StreamingManager::slotNumberOfPlayersChanged() {
+    for (unsigned int i = 1; i <= PlayerManager::numDecks(); ++i) {
+        connectPlayer(m_pPlayerManager->getDeck(i));
+    }
+    for (unsigned int i = 1; i <= PlayerManager::numPreviewDecks(); ++i) {
+        connectPlayer(m_pPlayerManager->getPreviewDeck(i));
+    }
+}
+
+void StreamingManager::connectPlayer(BaseTrackPlayer* pPlayer) {
+    if (!pPlayer || m_connectedPlayers.contains(pPlayer)) {
+        return;
+    }
+    m_connectedPlayers.insert(pPlayer);
+    const QString group = pPlayer->getGroup();
+    connect(pPlayer,
+            &BaseTrackPlayer::newTrackLoaded,
+            this,
+            [this, group](TrackPointer pTrack) {
+                trackLoaded(group, pTrack);
+            });
+    connect(pPlayer,
+            &BaseTrackPlayer::playerEmpty,
+            this,
+            [this, group]() {
+                trackUnloaded(group);
+            });
+    trackLoaded(group, pPlayer->getLoadedTrack());
+}
+
+void StreamingManager::trackLoaded(const QString& group, const TrackPointer& pTrack) {
+    trackUnloaded(group);
+    if (!pTrack) {
+        return;
+    }
+    const QString location = pTrack->getLocation();
+    const QString remoteId = remoteIdForLocation(location);
+    if (remoteId.isEmpty()) {
+        return;
+    }
+    auto pCache = mixxx::SoundSourceStream::sharedCacheForFile(location);
+    if (!pCache || pCache->isFullyCached()) {
+        return;
+    }
+    startWaveformBuilder(group, pTrack, pCache);
+    if (!m_pService->isAuthenticated()) {
+        kLogger.info()
+                << "Not logged in, only the cached parts of"
+                << location
+                << "are playable";
+        return;
+    }
+
+    const int generation = m_loadGenerations.value(group);
+    auto* pWatcher = new QFutureWatcher<StreamInfo>(this);
+    connect(pWatcher,
+            &QFutureWatcher<StreamInfo>::finished,
+            this,
+            [this, pWatcher, group, generation, pCache, remoteId]() {
+                pWatcher->deleteLater();
+                if (m_loadGenerations.value(group) != generation) {
+                    // The track has been replaced in the meantime
+                    return;
+                }
+                if (pWatcher->future().resultCount() == 0 ||
+                        !pWatcher->result().streamUrl.isValid()) {
+                    kLogger.warning()
+                            << "No stream available for track"
+                            << remoteId;
+                    return;
+                }
+                m_pPrefetcher->setTrack(group, pCache, pWatcher->result().streamUrl);
+            });
+    pWatcher->setFuture(m_pService->getStreamInfo(remoteId));
+}
+
+void StreamingManager::trackUnloaded(const QString& group) {
+    ++m_loadGenerations[group];
+    m_pPrefetcher->clearTrack(group);
+    const auto it = m_waveformBuilders.find(group);
+    if (it != m_waveformBuilders.end()) {
+        it->second->clearTrack();
+        m_waveformBuilders.erase(it);
+    }
+}
+
+void StreamingManager::startWaveformBuilder(const QString& group,
+        const TrackPointer& pTrack,
+        const std::shared_ptr<SparseCache>& pCache) {
+    // A decoder of its own, the one of the deck must not be shared
+    auto pSource = std::make_shared<mixxx::SoundSourceStream>(pCache, pTrack->getType());
+    if (pSource->open(mixxx::AudioSource::OpenMode::Strict) !=
+            mixxx::AudioSource::OpenResult::Succeeded) {
+        kLogger.info()
+                << "Not enough data to build the waveform of"
+                << pTrack->getLocation();
+        return;
+    }
+    auto pBuilder = std::make_unique<StreamWaveformBuilder>(m_pConfig, m_database);
+    if (!pBuilder->setTrack(pTrack, std::move(pSource))) {
+        // The waveform has been stored before
+        return;
+    }
+    m_waveformBuilders[group] = std::move(pBuilder);
+    updateWaveform(group);
+}
+
+void StreamingManager::slotRangeCached(const QString& group) {
+    updateWaveform(group);
+}
+
+void StreamingManager::updateWaveform(const QString& group) {
+    const auto it = m_waveformBuilders.find(group);
+    if (it == m_waveformBuilders.end() || m_pendingWaveformUpdates.contains(group)) {
+        return;
+    }
+    StreamWaveformBuilder* pBuilder = it->second.get();
+    if (pBuilder->update(kWaveformChunksPerUpdate) < kWaveformChunksPerUpdate) {
+        if (pBuilder->isComplete()) {
+            pBuilder->clearTrack();
+            m_waveformBuilders.erase(it);
+        }
+        return;
+    }
+    // More chunks may be waiting, continue after pending events
+    m_pendingWaveformUpdates.insert(group);
+    QTimer::singleShot(0, this, [this, group]() {
+        m_pendingWaveformUpdates.remove(group);
+        updateWaveform(group);
+    });
+}
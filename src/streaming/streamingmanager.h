@@ -0,0 +1,104 @@
+#pragma once
+
+#include <QHash>
+#include <QNetworkAccessManager>
+#include <QObject>
+#include <QSet>
+#include <QSqlDatabase>
+#include <QString>
+#include <map>
+#include <memory>
+
+#include "preferences/usersettings.h"
+#include "streaming/hook/streamingdto.h"
+#include "track/track_decl.h"
+
+class SparseCache;
+
+class BaseTrackPlayer;
+class BeatportService;
+class Library;
+class OAuthManager;
+class PlayerManager;
+class StreamCacheManager;
+class StreamPrefetcher;
+class StreamWaveformBuilder;
+class StreamingCatalogSearch;
+
+/// Connects the streaming services and caches to the players.
+///
+/// Streamed tracks are stored as SparseCache backing files in the cache
+/// directory. They are loaded like any other file, SoundSourceProxy decodes
+/// them with a SoundSourceKineticProxy. When a streamed track is loaded into
+/// a player the stream URL is requested from the service and the
+/// StreamPrefetcher keeps the data around the play position downloaded.
+/// Without a connection only the cached parts of the track are playable.
+/// The StreamCacheManager keeps the cache directory within the disk budget.
+/// The overview waveform of a partially downloaded track is built from the
+/// downloaded parts and completed as the downloads land.
+///
+/// Library searches are also run against the catalog of the service.
+/// Matches from the local index are reported right away, the results of
+/// the remote search follow when they arrive.
+class StreamingManager : public QObject {
+    Q_OBJECT
+  public:
+    StreamingManager(UserSettingsPointer pConfig,
+            PlayerManager* pPlayerManager,
+            Library* pLibrary,
+            QObject* parent = nullptr);
+    ~StreamingManager() override;
+
+    const QString& getCacheDirectory() const {
+        return m_cacheDirectory;
+    }
+
+    /// The file of a streamed track in the cache directory, whether it
+    /// exists or not.
+    QString trackLocation(const QString& remoteId, const QString& fileSuffix) const;
+
+  signals:
+    void catalogSearchResults(
+            const QString& queryText,
+            const QVector<TrackMetadata>& tracks);
+
+  private slots:
+    void slotNumberOfPlayersChanged();
+    void slotSearch(const QString& queryText);
+    void slotRangeCached(const QString& group);
+
+  private:
+    void connectPlayer(BaseTrackPlayer* pPlayer);
+    void trackLoaded(const QString& group, const TrackPointer& pTrack);
+    void trackUnloaded(const QString& group);
+    void startWaveformBuilder(const QString& group,
+            const TrackPointer& pTrack,
+            const std::shared_ptr<SparseCache>& pCache);
+    void updateWaveform(const QString& group);
+
+    /// Returns the id of the track at the service or an empty string
+    /// if the file does not belong to a streamed track of the service.
+    QString remoteIdForLocation(const QString& location) const;
+
+    const UserSettingsPointer m_pConfig;
+    PlayerManager* const m_pPlayerManager;
+    const QSqlDatabase m_database;
+    const QString m_cacheDirectory;
+
+    QNetworkAccessManager m_network;
+    std::unique_ptr<OAuthManager> m_pOAuthManager;
+    std::unique_ptr<BeatportService> m_pService;
+    // Shared with the decoders of open tracks
+    std::shared_ptr<StreamCacheManager> m_pCacheManager;
+    std::unique_ptr<StreamPrefetcher> m_pPrefetcher;
+    std::unique_ptr<StreamingCatalogSearch> m_pCatalogSearch;
+
+    // Keyed by the group of the player
+    std::map<QString, std::unique_ptr<StreamWaveformBuilder>> m_waveformBuilders;
+    QSet<QString> m_pendingWaveformUpdates;
+
+    QSet<BaseTrackPlayer*> m_connectedPlayers;
+    // Incremented when the track of a player changes to discard the
+    // stream infos of tracks that are no longer loaded
+    QHash<QString, int> m_loadGenerations;
+};
@@ -2,6 +2,7 @@
 
 #include <QDir>
 #include <QtDebug>
+#include <algorithm>
 #include <vector>
 
 #include "analyzer/analyzertrack.h"
@@ -130,4 +131,36 @@ TEST_F(AnalyzerWaveformTest, canary) {
     EXPECT_DOUBLE_EQ(pWaveformSummary->getAudioVisualRatio(), 1.0);
 }
 
+// Parts of a partially downloaded track are analyzed out of order
+TEST_F(AnalyzerWaveformTest, seekFrame) {
+    constexpr SINT kFrameLength = kBigBufSize / kChannelCount;
+    constexpr SINT kHalfFrameLength = kFrameLength / 2;
+    ASSERT_TRUE(m_aw.initialize(AnalyzerTrack(m_pTrack),
+            m_pTrack->getSampleRate(),
+            m_pTrack->getChannels(),
+            kFrameLength));
+    ConstWaveformPointer pWaveform = m_pTrack->getWaveform();
+    ASSERT_NE(pWaveform, nullptr);
+
+    // Second half first
+    std::vector<CSAMPLE> samples(kHalfFrameLength * kChannelCount, 0.5f);
+    m_aw.seekFrame(kHalfFrameLength);
+    EXPECT_TRUE(m_aw.processSamples(samples.data(), samples.size()));
+    const int completion = pWaveform->getCompletion();
+    const int firstStoredIndex = kChannelCount *
+            static_cast<int>(kHalfFrameLength / pWaveform->getAudioVisualRatio());
+    EXPECT_GT(completion, firstStoredIndex);
+    EXPECT_EQ(0, pWaveform->getAll(0));
+    EXPECT_GT(pWaveform->getAll(firstStoredIndex), 0);
+
+    // The completion does not move backwards
+    std::fill(samples.begin(), samples.end(), 0.25f);
+    m_aw.seekFrame(0);
+    EXPECT_TRUE(m_aw.processSamples(samples.data(), samples.size()));
+    EXPECT_EQ(completion, pWaveform->getCompletion());
+    EXPECT_GT(pWaveform->getAll(0), 0);
+    EXPECT_GT(pWaveform->getAll(firstStoredIndex), pWaveform->getAll(0));
+    m_aw.cleanup();
+}
+
 } // namespace
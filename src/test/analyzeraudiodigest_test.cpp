@@ -0,0 +1,80 @@
+#include "analyzer/analyzeraudiodigest.h"
+
+#include <gtest/gtest.h>
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "library/dao/analysisdao.h"
+#include "sources/soundsourceproxy.h"
+#include "test/librarytest.h"
+#include "track/track.h"
+
+namespace {
+
+class AnalyzerAudioDigestTest : public LibraryTest {
+  protected:
+    QString calculate(const QString& location) {
+        auto pAudioSource = SoundSourceProxy(Track::newTemporary(location))
+                                    .openAudioSource();
+        if (!pAudioSource) {
+            ADD_FAILURE() << "Failed to open" << location.toStdString();
+            return QString();
+        }
+        return AnalyzerAudioDigest::calculate(pAudioSource.get());
+    }
+};
+
+TEST_F(AnalyzerAudioDigestTest, IdenticalAudio) {
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    const QString location = getTestDir().filePath(QStringLiteral("sine-30.wav"));
+    const QString copiedLocation = tempDir.filePath(QStringLiteral("moved.wav"));
+    ASSERT_TRUE(QFile::copy(location, copiedLocation));
+
+    const QString digest = calculate(location);
+    EXPECT_FALSE(digest.isEmpty());
+    EXPECT_EQ(digest, calculate(location));
+    EXPECT_EQ(digest, calculate(copiedLocation));
+}
+
+TEST_F(AnalyzerAudioDigestTest, DifferentAudio) {
+    const QString digest = calculate(
+            getTestDir().filePath(QStringLiteral("sine-30.wav")));
+    const QString otherDigest = calculate(
+            getTestDir().filePath(QStringLiteral("id3-test-data/cover-test.wav")));
+    EXPECT_FALSE(digest.isEmpty());
+    EXPECT_FALSE(otherDigest.isEmpty());
+    EXPECT_NE(digest, otherDigest);
+}
+
+TEST_F(AnalyzerAudioDigestTest, FindTrackByAudioDigest) {
+    const auto pTrack = getOrAddTrackByLocation(
+            getTestDir().filePath(QStringLiteral("sine-30.wav")));
+    const auto pOtherTrack = getOrAddTrackByLocation(
+            getTestDir().filePath(QStringLiteral("id3-test-data/cover-test.wav")));
+    ASSERT_NE(nullptr, pTrack);
+    ASSERT_NE(nullptr, pOtherTrack);
+    const TrackId trackId = pTrack->getId();
+    const TrackId otherTrackId = pOtherTrack->getId();
+    ASSERT_TRUE(trackId.isValid());
+    ASSERT_TRUE(otherTrackId.isValid());
+
+    AnalysisDao analysisDao(config());
+    analysisDao.initialize(dbConnection());
+    const QString digest = QStringLiteral("0123456789abcdef");
+    ASSERT_TRUE(analysisDao.saveAudioDigest(trackId, digest));
+
+    EXPECT_EQ(trackId, analysisDao.findTrackByAudioDigest(digest, otherTrackId));
+    // The track itself is not identical to another track
+    EXPECT_FALSE(analysisDao.findTrackByAudioDigest(digest, trackId).isValid());
+    EXPECT_FALSE(analysisDao.findTrackByAudioDigest(
+                                    QStringLiteral("fedcba9876543210"), otherTrackId)
+                         .isValid());
+
+    // Purged tracks are forgotten
+    analysisDao.deleteAnalyses(QList<TrackId>{trackId});
+    EXPECT_FALSE(analysisDao.findTrackByAudioDigest(digest, otherTrackId).isValid());
+}
+
+} // anonymous namespace
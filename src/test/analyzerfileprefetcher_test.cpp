@@ -0,0 +1,72 @@
+#include "analyzer/analyzerfileprefetcher.h"
+
+#include <gtest/gtest.h>
+
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <map>
+
+#include "test/mixxxtest.h"
+
+namespace {
+
+class AnalyzerFilePrefetcherTest : public MixxxTest {
+  protected:
+    void waitForSignals(QSignalSpy* pSpy, int count) {
+        for (int i = 0; i < 100 && pSpy->count() < count; ++i) {
+            pSpy->wait(50);
+        }
+        // Deliver the queued signals
+        application()->processEvents();
+        application()->processEvents();
+    }
+};
+
+TEST_F(AnalyzerFilePrefetcherTest, ReadFiles) {
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    AnalyzerFilePrefetcher prefetcher;
+    QSignalSpy spy(&prefetcher, &AnalyzerFilePrefetcher::prefetched);
+
+    // More files than needed for adjusting the number of threads
+    constexpr int kFileCount = 20;
+    std::map<TrackId, qint64> fileSizes;
+    for (int i = 0; i < kFileCount; ++i) {
+        const TrackId trackId(QVariant(i + 1));
+        const qint64 fileSize = (i + 1) * 100000;
+        QFile file(tempDir.filePath(QString::number(i)));
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        ASSERT_EQ(fileSize, file.write(QByteArray(fileSize, 'x')));
+        file.close();
+        fileSizes.emplace(trackId, fileSize);
+        prefetcher.prefetch(trackId, file.fileName());
+    }
+    waitForSignals(&spy, kFileCount);
+
+    ASSERT_EQ(kFileCount, spy.count());
+    for (const auto& arguments : std::as_const(spy)) {
+        const auto trackId = arguments.at(0).value<TrackId>();
+        EXPECT_EQ(fileSizes.at(trackId), arguments.at(1).toLongLong());
+    }
+    EXPECT_GT(prefetcher.megabytesPerSecond(), 0);
+    EXPECT_GE(prefetcher.threadCount(), 1);
+    EXPECT_LE(prefetcher.threadCount(), AnalyzerFilePrefetcher::kMaxThreadCount);
+}
+
+TEST_F(AnalyzerFilePrefetcherTest, MissingFile) {
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    AnalyzerFilePrefetcher prefetcher;
+    QSignalSpy spy(&prefetcher, &AnalyzerFilePrefetcher::prefetched);
+
+    prefetcher.prefetch(TrackId(QVariant(1)), tempDir.filePath(QStringLiteral("missing")));
+    waitForSignals(&spy, 1);
+
+    ASSERT_EQ(1, spy.count());
+    EXPECT_EQ(0, spy.at(0).at(1).toLongLong());
+}
+
+} // namespace
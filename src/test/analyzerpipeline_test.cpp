@@ -0,0 +1,158 @@
+#include "analyzer/analyzerpipeline.h"
+
+#include <gtest/gtest.h>
+
+#include <QThread>
+#include <array>
+#include <vector>
+
+#include "analyzer/analyzertrack.h"
+#include "analyzer/constants.h"
+#include "test/mixxxtest.h"
+#include "track/track.h"
+
+namespace {
+
+// Checks that it receives the samples 0, 1, 2, ... in order
+class SequenceAnalyzer : public Analyzer {
+  public:
+    SequenceAnalyzer(bool slow, SINT* pProcessedSamples, bool* pInOrder)
+            : m_slow(slow),
+              m_pProcessedSamples(pProcessedSamples),
+              m_pInOrder(pInOrder) {
+    }
+
+    bool initialize(const AnalyzerTrack&,
+            mixxx::audio::SampleRate,
+            mixxx::audio::ChannelCount,
+            SINT) override {
+        *m_pProcessedSamples = 0;
+        *m_pInOrder = true;
+        return true;
+    }
+
+    bool processSamples(const CSAMPLE* pIn, SINT count) override {
+        for (SINT i = 0; i < count; ++i) {
+            if (pIn[i] != static_cast<CSAMPLE>(*m_pProcessedSamples + i)) {
+                *m_pInOrder = false;
+            }
+        }
+        *m_pProcessedSamples += count;
+        if (m_slow) {
+            QThread::usleep(100);
+        }
+        return true;
+    }
+
+    void storeResults(TrackPointer) override {
+    }
+
+    void cleanup() override {
+    }
+
+  private:
+    const bool m_slow;
+    SINT* const m_pProcessedSamples;
+    bool* const m_pInOrder;
+};
+
+class AnalyzerPipelineTest : public MixxxTest {
+  protected:
+    static constexpr int kAnalyzerCount = 3;
+    // Small chunks with exactly representable sample values
+    static constexpr SINT kSamplesPerChunk = 1024;
+
+    AnalyzerPipelineTest() {
+        for (int i = 0; i < kAnalyzerCount; ++i) {
+            // The first analyzer is the slowest
+            m_analyzers.emplace_back(std::make_unique<SequenceAnalyzer>(
+                    i == 0, &m_processedSamples[i], &m_inOrder[i]));
+        }
+        const AnalyzerTrack track(Track::newTemporary());
+        for (auto& analyzer : m_analyzers) {
+            analyzer.initialize(track,
+                    mixxx::audio::SampleRate(44100),
+                    mixxx::kAnalysisChannels,
+                    100000);
+        }
+    }
+
+    ~AnalyzerPipelineTest() override {
+        for (auto& analyzer : m_analyzers) {
+            analyzer.cancel();
+        }
+    }
+
+    void publishChunks(AnalyzerPipeline* pPipeline, int chunkCount) {
+        for (int chunk = 0; chunk < chunkCount; ++chunk) {
+            const auto slice = pPipeline->acquireChunk();
+            ASSERT_GE(slice.length(), kSamplesPerChunk);
+            for (SINT i = 0; i < kSamplesPerChunk; ++i) {
+                slice.data()[i] = static_cast<CSAMPLE>(m_publishedSamples + i);
+            }
+            pPipeline->publishChunk(slice.data(), kSamplesPerChunk);
+            m_publishedSamples += kSamplesPerChunk;
+        }
+    }
+
+    std::vector<AnalyzerWithState> m_analyzers;
+    std::array<SINT, kAnalyzerCount> m_processedSamples{};
+    std::array<bool, kAnalyzerCount> m_inOrder{};
+    SINT m_publishedSamples = 0;
+};
+
+TEST_F(AnalyzerPipelineTest, AllAnalyzersProcessAllChunksInOrder) {
+    AnalyzerPipeline pipeline(&m_analyzers);
+    pipeline.start();
+    // More chunks than the ring holds
+    publishChunks(&pipeline, AnalyzerPipeline::kChunkCount * 5);
+    pipeline.finish(false);
+
+    for (int i = 0; i < kAnalyzerCount; ++i) {
+        EXPECT_EQ(m_publishedSamples, m_processedSamples[i]);
+        EXPECT_TRUE(m_inOrder[i]);
+        EXPECT_TRUE(m_analyzers[i].isActive());
+    }
+}
+
+TEST_F(AnalyzerPipelineTest, Cancel) {
+    AnalyzerPipeline pipeline(&m_analyzers);
+    pipeline.start();
+    publishChunks(&pipeline, AnalyzerPipeline::kChunkCount * 2);
+    pipeline.finish(true);
+
+    for (int i = 0; i < kAnalyzerCount; ++i) {
+        EXPECT_LE(m_processedSamples[i], m_publishedSamples);
+        EXPECT_TRUE(m_inOrder[i]);
+    }
+}
+
+TEST_F(AnalyzerPipelineTest, Restart) {
+    AnalyzerPipeline pipeline(&m_analyzers);
+    pipeline.start();
+    // Leave an acquired chunk unpublished
+    publishChunks(&pipeline, 3);
+    pipeline.acquireChunk();
+    pipeline.finish(true);
+
+    for (auto& analyzer : m_analyzers) {
+        analyzer.cancel();
+        analyzer.initialize(AnalyzerTrack(Track::newTemporary()),
+                mixxx::audio::SampleRate(44100),
+                mixxx::kAnalysisChannels,
+                100000);
+    }
+    m_publishedSamples = 0;
+
+    // All chunks of the ring are available again
+    pipeline.start();
+    publishChunks(&pipeline, AnalyzerPipeline::kChunkCount * 3);
+    pipeline.finish(false);
+
+    for (int i = 0; i < kAnalyzerCount; ++i) {
+        EXPECT_EQ(m_publishedSamples, m_processedSamples[i]);
+        EXPECT_TRUE(m_inOrder[i]);
+    }
+}
+
+} // namespace
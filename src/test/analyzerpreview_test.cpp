@@ -0,0 +1,179 @@
+#include "analyzer/analyzerpreview.h"
+
+#include <gtest/gtest.h>
+
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "analyzer/analyzer.h"
+#include "analyzer/analyzerbeats.h"
+#include "analyzer/analyzerkey.h"
+#include "analyzer/analyzertrack.h"
+#include "analyzer/constants.h"
+#include "sources/audiosourcestereoproxy.h"
+#include "sources/soundsourceproxy.h"
+#include "test/mixxxtest.h"
+#include "track/beatfactory.h"
+#include "track/keyfactory.h"
+#include "track/track.h"
+#include "util/math.h"
+#include "util/samplebuffer.h"
+
+namespace {
+
+constexpr int kSampleRate = 44100;
+constexpr double kBpm = 120.0;
+
+// Longer than the preview windows and their gaps
+constexpr int kLongTrackSeconds = 100;
+
+// Writes a 16 bit stereo WAV file with a kick on every beat over a
+// sustained A minor chord
+bool writeLongTrack(const QString& location) {
+    QFile file(location);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    constexpr int kChannelCount = 2;
+    constexpr int kBytesPerSample = 2;
+    constexpr quint32 kFrameCount = kLongTrackSeconds * kSampleRate;
+    constexpr quint32 kDataBytes = kFrameCount * kChannelCount * kBytesPerSample;
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.writeRawData("RIFF", 4);
+    stream << quint32(36 + kDataBytes);
+    stream.writeRawData("WAVEfmt ", 8);
+    stream << quint32(16) << quint16(1) << quint16(kChannelCount)
+           << quint32(kSampleRate)
+           << quint32(kSampleRate * kChannelCount * kBytesPerSample)
+           << quint16(kChannelCount * kBytesPerSample) << quint16(8 * kBytesPerSample);
+    stream.writeRawData("data", 4);
+    stream << kDataBytes;
+
+    const double chordHz[] = {220.0, 261.63, 329.63};
+    const auto beatFrames = static_cast<quint32>(kSampleRate * 60 / kBpm);
+    for (quint32 frame = 0; frame < kFrameCount; ++frame) {
+        const double t = static_cast<double>(frame) / kSampleRate;
+        double value = 0.0;
+        for (const double hz : chordHz) {
+            value += 0.1 * std::sin(2 * M_PI * hz * t);
+        }
+        const double beatT = static_cast<double>(frame % beatFrames) / kSampleRate;
+        value += 0.6 * std::exp(-beatT * 30) * std::sin(2 * M_PI * 60 * beatT);
+        const auto sample = static_cast<qint16>(value * 32767 * 0.9);
+        stream << sample << sample;
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+class AnalyzerPreviewTest : public MixxxTest {
+  protected:
+    // Runs the analyzers over the whole track like the AnalyzerThread
+    static void analyzeTrack(const TrackPointer& pTrack,
+            mixxx::AudioSource* pAudioSource,
+            std::vector<AnalyzerWithState>* pAnalyzers) {
+        const AnalyzerTrack track(pTrack);
+        const auto& signalInfo = pAudioSource->getSignalInfo();
+        for (auto& analyzer : *pAnalyzers) {
+            EXPECT_TRUE(analyzer.initialize(track,
+                    signalInfo.getSampleRate(),
+                    signalInfo.getChannelCount(),
+                    pAudioSource->frameLength()));
+        }
+        mixxx::SampleBuffer sampleBuffer(
+                signalInfo.frames2samples(mixxx::kAnalysisFramesPerChunk));
+        auto remainingFrameIndexRange = pAudioSource->frameIndexRange();
+        while (!remainingFrameIndexRange.empty()) {
+            const auto chunkFrameIndexRange = remainingFrameIndexRange.splitAndShrinkFront(
+                    std::min(mixxx::kAnalysisFramesPerChunk,
+                            remainingFrameIndexRange.length()));
+            const auto readableSampleFrames = pAudioSource->readSampleFrames(
+                    mixxx::WritableSampleFrames(chunkFrameIndexRange,
+                            mixxx::SampleBuffer::WritableSlice(sampleBuffer)));
+            ASSERT_EQ(chunkFrameIndexRange, readableSampleFrames.frameIndexRange());
+            for (auto& analyzer : *pAnalyzers) {
+                analyzer.processSamples(readableSampleFrames.readableData(),
+                        readableSampleFrames.readableLength());
+            }
+        }
+        for (auto& analyzer : *pAnalyzers) {
+            analyzer.finish(track);
+        }
+    }
+};
+
+TEST_F(AnalyzerPreviewTest, IsPreviewSubVersion) {
+    QHash<QString, QString> extraVersionInfo;
+    extraVersionInfo.insert(QStringLiteral("vamp_plugin_id"), QStringLiteral("qm-tempotracker:0"));
+    EXPECT_FALSE(AnalyzerPreview::isPreviewSubVersion(
+            BeatFactory::getPreferredSubVersion(extraVersionInfo)));
+    EXPECT_FALSE(AnalyzerPreview::isPreviewSubVersion(
+            KeyFactory::getPreferredSubVersion(extraVersionInfo)));
+    EXPECT_FALSE(AnalyzerPreview::isPreviewSubVersion(QString()));
+
+    extraVersionInfo.insert(QStringLiteral("preview"), QStringLiteral("1"));
+    EXPECT_TRUE(AnalyzerPreview::isPreviewSubVersion(
+            BeatFactory::getPreferredSubVersion(extraVersionInfo)));
+    EXPECT_TRUE(AnalyzerPreview::isPreviewSubVersion(
+            KeyFactory::getPreferredSubVersion(extraVersionInfo)));
+}
+
+TEST_F(AnalyzerPreviewTest, SkipShortTracks) {
+    const TrackPointer pTrack = Track::newTemporary(
+            getTestDir().filePath(QStringLiteral("sine-30.wav")));
+    mixxx::AudioSourcePointer pAudioSource = SoundSourceProxy(pTrack).openAudioSource();
+    ASSERT_NE(nullptr, pAudioSource);
+    // The test file is mono
+    pAudioSource = std::make_shared<mixxx::AudioSourceStereoProxy>(
+            pAudioSource, mixxx::kAnalysisFramesPerChunk);
+
+    // The full analysis of a track that is shorter than the
+    // preview windows and their gaps is fast enough
+    AnalyzerPreview preview(config(), true);
+    EXPECT_FALSE(preview.analyze(AnalyzerTrack(pTrack), pAudioSource.get()));
+    EXPECT_EQ(nullptr, pTrack->getBeats());
+}
+
+TEST_F(AnalyzerPreviewTest, ProvisionalResultsAreReplaced) {
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    const QString location = tempDir.filePath(QStringLiteral("long.wav"));
+    ASSERT_TRUE(writeLongTrack(location));
+    const TrackPointer pTrack = Track::newTemporary(location);
+    const mixxx::AudioSourcePointer pAudioSource = SoundSourceProxy(pTrack).openAudioSource();
+    ASSERT_NE(nullptr, pAudioSource);
+    ASSERT_GE(pAudioSource->frameLength(), kLongTrackSeconds * kSampleRate);
+
+    KeyDetectionSettings keySettings(config());
+    keySettings.setKeyDetectionEnabled(true);
+
+    AnalyzerPreview preview(config(), true);
+    ASSERT_TRUE(preview.analyze(AnalyzerTrack(pTrack), pAudioSource.get()));
+    const mixxx::BeatsPointer pPreviewBeats = pTrack->getBeats();
+    ASSERT_NE(nullptr, pPreviewBeats);
+    EXPECT_TRUE(AnalyzerPreview::isPreviewSubVersion(pPreviewBeats->getSubVersion()));
+    EXPECT_NEAR(kBpm, pTrack->getBpm(), 1.0);
+    EXPECT_NE(mixxx::track::io::key::INVALID, pTrack->getKeys().getGlobalKey());
+    EXPECT_TRUE(AnalyzerPreview::isPreviewSubVersion(pTrack->getKeys().getSubVersion()));
+
+    // The full analysis replaces the provisional results
+    std::vector<AnalyzerWithState> analyzers;
+    analyzers.emplace_back(std::make_unique<AnalyzerBeats>(config(), true));
+    analyzers.emplace_back(std::make_unique<AnalyzerKey>(keySettings));
+    analyzeTrack(pTrack, pAudioSource.get(), &analyzers);
+
+    const mixxx::BeatsPointer pBeats = pTrack->getBeats();
+    ASSERT_NE(nullptr, pBeats);
+    EXPECT_NE(pPreviewBeats, pBeats);
+    EXPECT_FALSE(AnalyzerPreview::isPreviewSubVersion(pBeats->getSubVersion()));
+    EXPECT_NEAR(kBpm, pTrack->getBpm(), 1.0);
+    EXPECT_NE(mixxx::track::io::key::INVALID, pTrack->getKeys().getGlobalKey());
+    EXPECT_FALSE(AnalyzerPreview::isPreviewSubVersion(pTrack->getKeys().getSubVersion()));
+}
+
+} // anonymous namespace
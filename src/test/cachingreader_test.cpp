@@ -0,0 +1,143 @@
+#include "engine/cachingreader/cachingreader.h"
+
+#include <gtest/gtest.h>
+
+#include <QElapsedTimer>
+#include <QThread>
+#include <atomic>
+#include <vector>
+
+#include "engine/engineworkerscheduler.h"
+#include "sources/audiosourcestereoproxy.h"
+#include "sources/soundsourceproxy.h"
+#include "test/mixxxtest.h"
+#include "test/soundsourceproviderregistration.h"
+#include "track/track.h"
+
+class CachingReaderTest : public MixxxTest, SoundSourceProviderRegistration {
+  protected:
+    CachingReaderTest()
+            : m_reader(QStringLiteral("[Channel1]"),
+                      config(),
+                      mixxx::audio::ChannelCount::stereo()),
+              m_loadedCount(0) {
+        m_reader.setScheduler(&m_scheduler);
+        m_scheduler.start();
+        QObject::connect(&m_reader,
+                &CachingReader::trackLoaded,
+                &m_reader,
+                [this]() { ++m_loadedCount; },
+                Qt::DirectConnection);
+    }
+
+    QString trackLocation() const {
+        return getTestDir().filePath(QStringLiteral("sine-30.wav"));
+    }
+
+    // Loads the test track and waits until the worker has published it,
+    // without processing the update in the engine
+    void loadTrack() {
+        const int loadedCount = m_loadedCount.load() + 1;
+        m_reader.newTrack(Track::newTemporary(trackLocation()));
+        QElapsedTimer timer;
+        timer.start();
+        while (m_loadedCount.load() < loadedCount && timer.elapsed() < 10000) {
+            // Like the engine callback
+            m_scheduler.runWorkers();
+            QThread::msleep(1);
+        }
+        ASSERT_EQ(loadedCount, m_loadedCount.load());
+    }
+
+    std::vector<CSAMPLE> readExpectedSamples(SINT startFrame, SINT frameCount) const {
+        SoundSourceProxy proxy(Track::newTemporary(trackLocation()));
+        mixxx::AudioSource::OpenParams openParams;
+        openParams.setChannelCount(mixxx::audio::ChannelCount::stereo());
+        auto pAudioSource = proxy.openAudioSource(openParams);
+        // The test file is mono
+        if (pAudioSource &&
+                pAudioSource->getSignalInfo().getChannelCount() !=
+                        mixxx::audio::ChannelCount::stereo()) {
+            pAudioSource = mixxx::AudioSourceStereoProxy::create(
+                    pAudioSource, CachingReaderChunk::kFrames);
+        }
+        if (!pAudioSource) {
+            ADD_FAILURE() << "Failed to open the audio source";
+            return {};
+        }
+        mixxx::SampleBuffer buffer(
+                pAudioSource->getSignalInfo().frames2samples(frameCount));
+        const auto readableSampleFrames = pAudioSource->readSampleFrames(
+                mixxx::WritableSampleFrames(
+                        mixxx::IndexRange::forward(startFrame, frameCount),
+                        mixxx::SampleBuffer::WritableSlice(buffer)));
+        return std::vector<CSAMPLE>(readableSampleFrames.readableData(),
+                readableSampleFrames.readableData() +
+                        readableSampleFrames.readableLength());
+    }
+
+    const CSAMPLE* preloadedSamples() const {
+        return m_reader.m_pPreloadedSamples;
+    }
+
+    int pendingChunkReadRequests() {
+        return m_reader.m_chunkReadRequestFIFO.readAvailable();
+    }
+
+    // Destroyed after the reader that has registered its worker
+    EngineWorkerScheduler m_scheduler;
+    CachingReader m_reader;
+    std::atomic<int> m_loadedCount;
+};
+
+namespace {
+
+TEST_F(CachingReaderTest, ReadPreloadedWithoutWorker) {
+    loadTrack();
+
+    // Far from the start of the track, i.e. not in any chunk that might
+    // have been read while loading
+    constexpr SINT kStartFrame = 10 * CachingReaderChunk::kFrames + 123;
+    constexpr SINT kFrameCount = 1024;
+    const auto expectedSamples = readExpectedSamples(kStartFrame, kFrameCount);
+    ASSERT_EQ(static_cast<std::size_t>(2 * kFrameCount), expectedSamples.size());
+
+    // A cached read would miss and request the chunks from the worker
+    std::vector<CSAMPLE> samples(expectedSamples.size());
+    EXPECT_EQ(CachingReader::ReadResult::AVAILABLE,
+            m_reader.read(2 * kStartFrame,
+                    2 * kFrameCount,
+                    false,
+                    samples.data(),
+                    mixxx::audio::ChannelCount::stereo()));
+    ASSERT_NE(nullptr, preloadedSamples());
+    EXPECT_EQ(expectedSamples, samples);
+
+    HintVector hintList;
+    hintList.append(Hint{kStartFrame * 4, Hint::kFrameCountForward, Hint::Type::HotCue});
+    m_reader.hintAndMaybeWake(hintList);
+    EXPECT_EQ(0, pendingChunkReadRequests());
+}
+
+TEST_F(CachingReaderTest, ReusePreloadBufferAfterAcknowledgement) {
+    loadTrack();
+    m_reader.process();
+    const CSAMPLE* pFirstSamples = preloadedSamples();
+    ASSERT_NE(nullptr, pFirstSamples);
+
+    // The engine still reads from the first buffer until it processes the
+    // next update. The second track takes the other buffer and the third
+    // track is not preloaded, because no buffer is free.
+    loadTrack();
+    loadTrack();
+    m_reader.process();
+    EXPECT_EQ(nullptr, preloadedSamples());
+
+    // The engine has acknowledged that it no longer reads from the first
+    // buffer, which is reused for the next track
+    loadTrack();
+    m_reader.process();
+    EXPECT_EQ(pFirstSamples, preloadedSamples());
+}
+
+} // anonymous namespace
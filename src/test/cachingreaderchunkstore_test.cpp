@@ -0,0 +1,76 @@
+#include "engine/cachingreader/cachingreaderchunkstore.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+class CachingReaderChunkStoreTest : public testing::Test {
+  protected:
+    CachingReaderChunkStore& store() {
+        return CachingReaderChunkStore::instance();
+    }
+
+    const QString m_key = QStringLiteral("test.wav||2");
+};
+
+TEST_F(CachingReaderChunkStoreTest, ShareWhileOpenedByMultipleReaders) {
+    store().openFile(m_key);
+    EXPECT_FALSE(store().isShared(m_key));
+    store().openFile(m_key);
+    EXPECT_TRUE(store().isShared(m_key));
+
+    auto pSharedChunk = std::make_shared<const CachingReaderSharedChunk>(16);
+    store().insert(m_key, 3, pSharedChunk);
+    EXPECT_EQ(pSharedChunk, store().lookup(m_key, 3));
+    EXPECT_EQ(nullptr, store().lookup(m_key, 4));
+
+    // The store does not keep unreferenced chunks
+    pSharedChunk.reset();
+    EXPECT_EQ(nullptr, store().lookup(m_key, 3));
+
+    store().closeFile(m_key);
+    EXPECT_FALSE(store().isShared(m_key));
+    store().closeFile(m_key);
+}
+
+TEST_F(CachingReaderChunkStoreTest, DropChunksAfterClosing) {
+    store().openFile(m_key);
+    auto pSharedChunk = std::make_shared<const CachingReaderSharedChunk>(16);
+    store().insert(m_key, 0, pSharedChunk);
+    store().closeFile(m_key);
+
+    store().openFile(m_key);
+    EXPECT_EQ(nullptr, store().lookup(m_key, 0));
+    store().closeFile(m_key);
+
+    // Inserting into a closed file is ignored
+    store().insert(m_key, 0, pSharedChunk);
+    store().openFile(m_key);
+    EXPECT_EQ(nullptr, store().lookup(m_key, 0));
+    store().closeFile(m_key);
+}
+
+TEST_F(CachingReaderChunkStoreTest, RetainChunksUntilLookedUp) {
+    store().openFile(m_key);
+    store().openFile(m_key);
+
+    auto pSharedChunk = std::make_shared<const CachingReaderSharedChunk>(16);
+    const CachingReaderSharedChunk* pRetainedChunk = pSharedChunk.get();
+    store().retain(m_key, 1, std::move(pSharedChunk));
+    auto pLookedUpChunk = store().lookup(m_key, 1);
+    EXPECT_EQ(pRetainedChunk, pLookedUpChunk.get());
+
+    // Released by the store after the lookup
+    pLookedUpChunk.reset();
+    EXPECT_EQ(nullptr, store().lookup(m_key, 1));
+
+    // Retained chunks are still shared after the other reader has closed
+    // the file, but not after all readers have closed it
+    store().retain(m_key, 2, std::make_shared<const CachingReaderSharedChunk>(16));
+    store().closeFile(m_key);
+    EXPECT_TRUE(store().isShared(m_key));
+    store().closeFile(m_key);
+    EXPECT_FALSE(store().isShared(m_key));
+}
+
+} // anonymous namespace
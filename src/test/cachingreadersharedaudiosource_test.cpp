@@ -0,0 +1,134 @@
+#include "engine/cachingreader/cachingreadersharedaudiosource.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "engine/cachingreader/cachingreaderchunkstore.h"
+#include "sources/audiosourcestereoproxy.h"
+#include "sources/soundsourceproxy.h"
+#include "test/mixxxtest.h"
+#include "test/soundsourceproviderregistration.h"
+#include "track/track.h"
+#include "util/math.h"
+
+namespace {
+
+class CachingReaderSharedAudioSourceTest : public MixxxTest, SoundSourceProviderRegistration {
+  protected:
+    mixxx::AudioSourcePointer openAudioSource() {
+        SoundSourceProxy proxy(Track::newTemporary(
+                getTestDir().filePath(QStringLiteral("sine-30.wav"))));
+        mixxx::AudioSource::OpenParams openParams;
+        openParams.setChannelCount(mixxx::audio::ChannelCount::stereo());
+        auto pAudioSource = proxy.openAudioSource(openParams);
+        // The test file is mono
+        if (pAudioSource &&
+                pAudioSource->getSignalInfo().getChannelCount() !=
+                        mixxx::audio::ChannelCount::stereo()) {
+            pAudioSource = mixxx::AudioSourceStereoProxy::create(
+                    pAudioSource, CachingReaderChunk::kFrames);
+        }
+        return pAudioSource;
+    }
+
+    mixxx::AudioSourcePointer openSharedAudioSource() {
+        auto pAudioSource = openAudioSource();
+        if (!pAudioSource) {
+            return nullptr;
+        }
+        return std::make_shared<CachingReaderSharedAudioSource>(
+                std::move(pAudioSource), m_key);
+    }
+
+    // Reads all samples in blocks that are not aligned with the chunks
+    static std::vector<CSAMPLE> readAll(const mixxx::AudioSourcePointer& pAudioSource) {
+        constexpr SINT kBlockFrames = 3000;
+        std::vector<CSAMPLE> samples;
+        if (!pAudioSource) {
+            ADD_FAILURE() << "Failed to open the audio source";
+            return samples;
+        }
+        mixxx::SampleBuffer buffer(
+                pAudioSource->getSignalInfo().frames2samples(kBlockFrames));
+        auto remainingFrameIndexRange = pAudioSource->frameIndexRange();
+        while (!remainingFrameIndexRange.empty()) {
+            const auto frameIndexRange = remainingFrameIndexRange.splitAndShrinkFront(
+                    math_min(kBlockFrames, remainingFrameIndexRange.length()));
+            const auto readableSampleFrames = pAudioSource->readSampleFrames(
+                    mixxx::WritableSampleFrames(frameIndexRange,
+                            mixxx::SampleBuffer::WritableSlice(buffer)));
+            EXPECT_EQ(frameIndexRange, readableSampleFrames.frameIndexRange());
+            samples.insert(samples.end(),
+                    readableSampleFrames.readableData(),
+                    readableSampleFrames.readableData() +
+                            readableSampleFrames.readableLength());
+        }
+        return samples;
+    }
+
+    CachingReaderChunkStore& store() {
+        return CachingReaderChunkStore::instance();
+    }
+
+    const QString m_key = QStringLiteral("sine-30.wav||1");
+};
+
+TEST_F(CachingReaderSharedAudioSourceTest, ReadLikeTheAudioSource) {
+    const auto expectedSamples = readAll(openAudioSource());
+    ASSERT_FALSE(expectedSamples.empty());
+    EXPECT_EQ(expectedSamples, readAll(openSharedAudioSource()));
+    EXPECT_FALSE(store().isShared(m_key));
+}
+
+TEST_F(CachingReaderSharedAudioSourceTest, RetainChunksForOtherReader) {
+    const auto expectedSamples = readAll(openAudioSource());
+
+    // Another reader, e.g. a deck, has opened the same file
+    store().openFile(m_key);
+    EXPECT_EQ(expectedSamples, readAll(openSharedAudioSource()));
+
+    // The chunks outlive the shared audio source
+    EXPECT_TRUE(store().isShared(m_key));
+    const auto pSharedChunk = store().lookup(m_key, 1);
+    ASSERT_NE(nullptr, pSharedChunk);
+    const auto& readableSampleFrames = pSharedChunk->readableSampleFrames;
+    ASSERT_EQ(mixxx::IndexRange::forward(
+                      CachingReaderChunk::kFrames, CachingReaderChunk::kFrames),
+            readableSampleFrames.frameIndexRange());
+    const auto chunkSamples = CachingReaderChunk::frames2samples(
+            CachingReaderChunk::kFrames, mixxx::audio::ChannelCount::stereo());
+    EXPECT_TRUE(std::equal(readableSampleFrames.readableData(),
+            readableSampleFrames.readableData() + chunkSamples,
+            expectedSamples.begin() + chunkSamples));
+
+    store().closeFile(m_key);
+    EXPECT_FALSE(store().isShared(m_key));
+}
+
+TEST_F(CachingReaderSharedAudioSourceTest, ReadChunksOfOtherReader) {
+    store().openFile(m_key);
+    // The first chunk has already been decoded by the other reader
+    const auto chunkSamples = CachingReaderChunk::frames2samples(
+            CachingReaderChunk::kFrames, mixxx::audio::ChannelCount::stereo());
+    auto pSharedChunk = std::make_shared<CachingReaderSharedChunk>(chunkSamples);
+    pSharedChunk->sampleBuffer.fill(0.5f);
+    pSharedChunk->readableSampleFrames = mixxx::ReadableSampleFrames(
+            mixxx::IndexRange::forward(0, CachingReaderChunk::kFrames),
+            mixxx::SampleBuffer::ReadableSlice(pSharedChunk->sampleBuffer, 0, chunkSamples));
+    store().insert(m_key, 0, pSharedChunk);
+
+    const auto samples = readAll(openSharedAudioSource());
+    ASSERT_GT(static_cast<SINT>(samples.size()), chunkSamples);
+    EXPECT_TRUE(std::all_of(samples.begin(),
+            samples.begin() + chunkSamples,
+            [](CSAMPLE sample) { return sample == 0.5f; }));
+    EXPECT_FALSE(std::all_of(samples.begin() + chunkSamples,
+            samples.end(),
+            [](CSAMPLE sample) { return sample == 0.5f; }));
+
+    store().closeFile(m_key);
+}
+
+} // anonymous namespace
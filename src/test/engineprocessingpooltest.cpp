@@ -0,0 +1,68 @@
+#include "engine/engineprocessingpool.h"
+
+#include <gtest/gtest.h>
+
+#include <QThread>
+#include <atomic>
+#include <vector>
+
+namespace {
+
+struct TaskCounters {
+    explicit TaskCounters(int taskCount)
+            : calls(taskCount) {
+    }
+
+    std::vector<std::atomic<int>> calls;
+    std::atomic<int> callerThreadCalls{0};
+    QThread* pCallerThread = QThread::currentThread();
+};
+
+void countTask(void* pContext, int taskIndex) {
+    auto* pCounters = static_cast<TaskCounters*>(pContext);
+    pCounters->calls[taskIndex].fetch_add(1);
+    if (QThread::currentThread() == pCounters->pCallerThread) {
+        pCounters->callerThreadCalls.fetch_add(1);
+    }
+}
+
+TEST(EngineProcessingPoolTest, EachTaskRunsOnce) {
+    constexpr int kTaskCount = 8;
+    EngineProcessingPool pool(3);
+    EXPECT_EQ(3, pool.workerCount());
+
+    // Many short batches in a row, like the audio callback
+    for (int batch = 0; batch < 1000; ++batch) {
+        TaskCounters counters(kTaskCount);
+        pool.run(kTaskCount, &countTask, &counters);
+        for (int i = 0; i < kTaskCount; ++i) {
+            ASSERT_EQ(1, counters.calls[i].load()) << "batch" << batch << "task" << i;
+        }
+    }
+}
+
+TEST(EngineProcessingPoolTest, BatchesOfVaryingSize) {
+    EngineProcessingPool pool(3);
+    // Batches with fewer tasks than workers leave permits of the wake-up
+    // semaphore to workers that are still busy or have not woken up yet
+    for (int batch = 0; batch < 1000; ++batch) {
+        const int taskCount = batch % 6;
+        TaskCounters counters(taskCount);
+        pool.run(taskCount, &countTask, &counters);
+        for (int i = 0; i < taskCount; ++i) {
+            ASSERT_EQ(1, counters.calls[i].load()) << "batch" << batch << "task" << i;
+        }
+    }
+}
+
+TEST(EngineProcessingPoolTest, WithoutWorkers) {
+    constexpr int kTaskCount = 4;
+    EngineProcessingPool pool(0);
+    TaskCounters counters(kTaskCount);
+    pool.run(kTaskCount, &countTask, &counters);
+    EXPECT_EQ(kTaskCount, counters.callerThreadCalls.load());
+    pool.run(0, &countTask, &counters);
+    EXPECT_EQ(kTaskCount, counters.callerThreadCalls.load());
+}
+
+} // anonymous namespace
@@ -0,0 +1,70 @@
+#include "engine/engineprofiler.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+namespace {
+
+using Histogram = EngineProfiler::Histogram;
+
+TEST(EngineProfilerTest, BucketBoundsAreContiguous) {
+    for (qint64 micros = 0; micros < 2000000; micros += 1 + micros / 64) {
+        const int index = Histogram::bucketIndex(micros);
+        ASSERT_GE(index, 0);
+        ASSERT_LT(index, EngineProfiler::kBucketCount);
+        EXPECT_LT(micros, Histogram::bucketUpperBoundMicros(index));
+        if (index > 0) {
+            EXPECT_GE(micros, Histogram::bucketUpperBoundMicros(index - 1));
+        }
+    }
+    // Long durations end up in the last bucket
+    EXPECT_EQ(EngineProfiler::kBucketCount - 1, Histogram::bucketIndex(100000000));
+}
+
+TEST(EngineProfilerTest, Percentiles) {
+    auto pHistogram = std::make_unique<Histogram>();
+    for (int i = 0; i < 990; ++i) {
+        pHistogram->add(100000, false);
+    }
+    for (int i = 0; i < 10; ++i) {
+        pHistogram->add(3000000, true);
+    }
+    EXPECT_EQ(1000u, pHistogram->count());
+    EXPECT_EQ(10u, pHistogram->overBudgetCount());
+    EXPECT_DOUBLE_EQ(3000.0, pHistogram->maxMicros());
+    EXPECT_DOUBLE_EQ(129.0, pHistogram->meanMicros());
+    // The bucket of 100 us ends at 104 us
+    EXPECT_DOUBLE_EQ(104.0, pHistogram->percentileMicros(50));
+    EXPECT_DOUBLE_EQ(104.0, pHistogram->percentileMicros(98.9));
+    EXPECT_DOUBLE_EQ(3000.0, pHistogram->percentileMicros(99.9));
+
+    pHistogram->reset();
+    EXPECT_EQ(0u, pHistogram->count());
+    EXPECT_DOUBLE_EQ(0.0, pHistogram->percentileMicros(50));
+}
+
+TEST(EngineProfilerTest, SumUpChannelTimesPerCallback) {
+    // Each engine has a profiler of its own
+    auto pProfiler = std::make_unique<EngineProfiler>();
+    auto pOtherProfiler = std::make_unique<EngineProfiler>();
+
+    // A channel that is processed on a worker and finished on the engine
+    // thread reports two times
+    pProfiler->beginCallback();
+    pProfiler->addStageTime(EngineProfiler::Stage::Channels, mixxx::Duration::fromMicros(50));
+    pProfiler->addChannelTime(3, mixxx::Duration::fromMicros(30));
+    pProfiler->addChannelTime(3, mixxx::Duration::fromMicros(20));
+    pProfiler->endCallback(mixxx::Duration());
+
+    EXPECT_EQ(1u, pProfiler->stageHistogram(EngineProfiler::Stage::Channels).count());
+    EXPECT_EQ(1u, pProfiler->stageHistogram(EngineProfiler::Stage::Callback).count());
+    EXPECT_EQ(0u, pProfiler->stageHistogram(EngineProfiler::Stage::BusEffects).count());
+    EXPECT_EQ(1u, pProfiler->channelHistogram(3).count());
+    EXPECT_DOUBLE_EQ(50.0, pProfiler->channelHistogram(3).maxMicros());
+    EXPECT_EQ(0u, pProfiler->channelHistogram(2).count());
+    EXPECT_EQ(0u, pOtherProfiler->stageHistogram(EngineProfiler::Stage::Callback).count());
+    EXPECT_EQ(0u, pOtherProfiler->channelHistogram(3).count());
+}
+
+} // anonymous namespace
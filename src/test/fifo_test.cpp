@@ -0,0 +1,198 @@
+#include "util/fifo.h"
+
+#include <benchmark/benchmark.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "pa_ringbuffer.h"
+#include "util/types.h"
+
+namespace {
+
+class FifoTest : public testing::Test {
+};
+
+TEST_F(FifoTest, CapacityIsRoundedUp) {
+    FIFO<int> fifo(5);
+    EXPECT_EQ(8, fifo.capacity());
+    EXPECT_EQ(0, fifo.readAvailable());
+    EXPECT_EQ(8, fifo.writeAvailable());
+}
+
+TEST_F(FifoTest, ReadWriteWrapAround) {
+    FIFO<int> fifo(8);
+    std::vector<int> data = {1, 2, 3, 4, 5, 6};
+    std::vector<int> result(8, 0);
+
+    EXPECT_EQ(6, fifo.write(data.data(), 6));
+    EXPECT_EQ(4, fifo.read(result.data(), 4));
+    EXPECT_EQ(std::vector<int>({1, 2, 3, 4, 0, 0, 0, 0}), result);
+
+    // Only 6 of 10 elements fit, the write wraps around the end
+    std::vector<int> data2 = {7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+    EXPECT_EQ(6, fifo.write(data2.data(), 10));
+    EXPECT_EQ(0, fifo.writeAvailable());
+    EXPECT_EQ(8, fifo.readAvailable());
+    EXPECT_EQ(8, fifo.read(result.data(), 10));
+    EXPECT_EQ(std::vector<int>({5, 6, 7, 8, 9, 10, 11, 12}), result);
+    EXPECT_EQ(0, fifo.readAvailable());
+}
+
+TEST_F(FifoTest, Regions) {
+    FIFO<int> fifo(8);
+    std::vector<int> data = {1, 2, 3, 4, 5, 6};
+    fifo.write(data.data(), 6);
+    fifo.flushReadData(5);
+    EXPECT_EQ(1, fifo.readAvailable());
+
+    int* pRegion1;
+    int size1;
+    int* pRegion2;
+    int size2;
+    EXPECT_EQ(4,
+            fifo.aquireWriteRegions(4, &pRegion1, &size1, &pRegion2, &size2));
+    EXPECT_EQ(2, size1);
+    EXPECT_EQ(2, size2);
+    for (int i = 0; i < size1; ++i) {
+        pRegion1[i] = 7 + i;
+    }
+    for (int i = 0; i < size2; ++i) {
+        pRegion2[i] = 7 + size1 + i;
+    }
+    fifo.releaseWriteRegions(4);
+
+    EXPECT_EQ(5,
+            fifo.aquireReadRegions(8, &pRegion1, &size1, &pRegion2, &size2));
+    EXPECT_EQ(3, size1);
+    EXPECT_EQ(2, size2);
+    EXPECT_EQ(6, pRegion1[0]);
+    EXPECT_EQ(8, pRegion1[2]);
+    EXPECT_EQ(10, pRegion2[1]);
+    fifo.releaseReadRegions(5);
+    EXPECT_EQ(0, fifo.readAvailable());
+}
+
+TEST_F(FifoTest, ProducerConsumerThreads) {
+    constexpr int kCount = 1 << 16;
+    FIFO<int> fifo(256);
+    std::thread producer([&fifo] {
+        int values[64];
+        for (int i = 0; i < kCount; i += 64) {
+            for (int j = 0; j < 64; ++j) {
+                values[j] = i + j;
+            }
+            fifo.writeBlocking(values, 64);
+        }
+    });
+    int expected = 0;
+    int values[100];
+    while (expected < kCount) {
+        const int count = fifo.read(values, 100);
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+        for (int i = 0; i < count; ++i) {
+            ASSERT_EQ(expected, values[i]);
+            ++expected;
+        }
+    }
+    producer.join();
+    EXPECT_EQ(0, fifo.readAvailable());
+}
+
+// The previous implementation for comparison
+class PaUtilFifo {
+  public:
+    explicit PaUtilFifo(int size)
+            : m_data(size) {
+        PaUtil_InitializeRingBuffer(&m_ringBuffer,
+                static_cast<ring_buffer_size_t>(sizeof(CSAMPLE)),
+                static_cast<ring_buffer_size_t>(m_data.size()),
+                m_data.data());
+    }
+    int read(CSAMPLE* pData, int count) {
+        return PaUtil_ReadRingBuffer(&m_ringBuffer, pData, count);
+    }
+    int write(const CSAMPLE* pData, int count) {
+        return PaUtil_WriteRingBuffer(&m_ringBuffer, pData, count);
+    }
+
+  private:
+    std::vector<CSAMPLE> m_data;
+    PaUtilRingBuffer m_ringBuffer;
+};
+
+// Passes one audio buffer through a FIFO that holds 4 buffers like the
+// sidechain does, in the same thread
+template<class Fifo>
+void benchmarkWriteRead(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    Fifo fifo(size * 4);
+    std::vector<CSAMPLE> input(size, 0.5f);
+    std::vector<CSAMPLE> output(size);
+    for (auto _ : state) {
+        fifo.write(input.data(), size);
+        fifo.read(output.data(), size);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+// Streams buffers from a producer to a consumer thread
+template<class Fifo>
+void benchmarkProducerConsumer(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    constexpr int kBufferCount = 1024;
+    for (auto _ : state) {
+        Fifo fifo(size * 4);
+        std::thread consumer([&fifo, size] {
+            std::vector<CSAMPLE> output(size);
+            int remaining = size * kBufferCount;
+            while (remaining > 0) {
+                const int count = fifo.read(output.data(), size);
+                if (count == 0) {
+                    std::this_thread::yield();
+                }
+                remaining -= count;
+            }
+        });
+        std::vector<CSAMPLE> input(size, 0.5f);
+        for (int i = 0; i < kBufferCount; ++i) {
+            int written = 0;
+            while (written < size) {
+                const int count = fifo.write(input.data() + written, size - written);
+                if (count == 0) {
+                    std::this_thread::yield();
+                }
+                written += count;
+            }
+        }
+        consumer.join();
+    }
+    state.SetItemsProcessed(state.iterations() * size * kBufferCount);
+}
+
+static void BM_FifoWriteRead(benchmark::State& state) {
+    benchmarkWriteRead<FIFO<CSAMPLE>>(state);
+}
+BENCHMARK(BM_FifoWriteRead)->Range(128, 8192);
+
+static void BM_PaUtilRingBufferWriteRead(benchmark::State& state) {
+    benchmarkWriteRead<PaUtilFifo>(state);
+}
+BENCHMARK(BM_PaUtilRingBufferWriteRead)->Range(128, 8192);
+
+static void BM_FifoProducerConsumer(benchmark::State& state) {
+    benchmarkProducerConsumer<FIFO<CSAMPLE>>(state);
+}
+BENCHMARK(BM_FifoProducerConsumer)->Range(128, 8192);
+
+static void BM_PaUtilRingBufferProducerConsumer(benchmark::State& state) {
+    benchmarkProducerConsumer<PaUtilFifo>(state);
+}
+BENCHMARK(BM_PaUtilRingBufferProducerConsumer)->Range(128, 8192);
+
+} // anonymous namespace
@@ -107,6 +107,10 @@ void MockNetworkReply::SetData(const QByteArray& data) {
     m_pos = 0;
 }
 
+void MockNetworkReply::SetRawHeader(const QByteArray& name, const QByteArray& value) {
+    setRawHeader(name, value);
+}
+
 void MockNetworkReply::abort() {
     setAttribute(QNetworkRequest::HttpStatusCodeAttribute, {});
     setError(OperationCanceledError, tr("Operation canceled"));
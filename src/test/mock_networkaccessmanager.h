@@ -39,6 +39,7 @@ class MockNetworkReply : public QNetworkReply {
 
     // Use these to set expectations.
     void SetData(const QByteArray& data);
+    void SetRawHeader(const QByteArray& name, const QByteArray& value);
     virtual void setAttribute(QNetworkRequest::Attribute code, const QVariant& value);
 
     // Call this when you are ready for the finished() signal.
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <QBuffer>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "engine/offlinerenderer.h"
+#include "recording/defs_recording.h"
+#include "test/signalpathtest.h"
+#include "track/track.h"
+
+namespace {
+
+class OfflineRendererTest : public BaseSignalPathTest {
+  protected:
+    QByteArray render(const QString& fileName) {
+        // Start every rendering from an empty deck
+        if (m_pChannel1->getEngineBuffer()->isTrackLoaded()) {
+            m_pChannel1->getEngineBuffer()->ejectTrack();
+        }
+        ControlObject::set(ConfigKey(m_sGroup1, "play"), 0.0);
+
+        OfflineRenderer renderer(m_pConfig, m_pEngineMixer);
+        renderer.addPlayer(m_pMixerDeck1);
+        renderer.addTrackLoad(0.0,
+                m_sGroup1,
+                getTestDir().filePath(QStringLiteral("sine-30.wav")));
+        renderer.addControlChange(0.0, ConfigKey(m_sGroup1, "play"), 1.0);
+        renderer.addControlChange(0.5, ConfigKey(m_sGroup1, "volume"), 0.5);
+
+        QString errorMessage;
+        EXPECT_TRUE(renderer.render(fileName, ENCODING_WAVE, 1.0, &errorMessage))
+                << errorMessage.toStdString();
+        EXPECT_GT(renderer.realtimeFactor(), 0.0);
+
+        QFile file(fileName);
+        EXPECT_TRUE(file.open(QIODevice::ReadOnly));
+        return file.readAll();
+    }
+};
+
+TEST_F(OfflineRendererTest, LoadTimeline) {
+    QByteArray timeline(
+            "# comment\n"
+            "\n"
+            "0 [Channel1] load /path/with spaces/track.wav\n"
+            "1.5 [Channel1] play 1\n"
+            "0.25 [Master] crossfader -0.5\n");
+    QBuffer buffer(&timeline);
+    ASSERT_TRUE(buffer.open(QIODevice::ReadOnly));
+
+    OfflineRenderer renderer(m_pConfig, m_pEngineMixer);
+    QString errorMessage;
+    ASSERT_TRUE(renderer.loadTimeline(&buffer, &errorMessage));
+    ASSERT_EQ(3, renderer.events().size());
+
+    const auto& load = renderer.events()[0];
+    EXPECT_EQ(OfflineRenderer::Event::Type::LoadTrack, load.type);
+    EXPECT_EQ(m_sGroup1, load.key.group);
+    EXPECT_EQ(QStringLiteral("/path/with spaces/track.wav"), load.trackLocation);
+    EXPECT_EQ(nullptr, load.pTrack);
+
+    const auto& play = renderer.events()[1];
+    EXPECT_EQ(OfflineRenderer::Event::Type::SetControl, play.type);
+    EXPECT_DOUBLE_EQ(1.5, play.timeSeconds);
+    EXPECT_EQ(ConfigKey(m_sGroup1, "play"), play.key);
+    EXPECT_DOUBLE_EQ(1.0, play.value);
+
+    EXPECT_DOUBLE_EQ(-0.5, renderer.events()[2].value);
+}
+
+TEST_F(OfflineRendererTest, LoadTimelineRejectsInvalidLines) {
+    for (const char* line : {"[Channel1] play 1\n",
+                 "-1 [Channel1] play 1\n",
+                 "0 [Channel1] play\n",
+                 "0 [Channel1] play on\n",
+                 "0 [Channel1] play 1 2\n"}) {
+        QByteArray timeline(line);
+        QBuffer buffer(&timeline);
+        ASSERT_TRUE(buffer.open(QIODevice::ReadOnly));
+
+        OfflineRenderer renderer(m_pConfig, m_pEngineMixer);
+        QString errorMessage;
+        EXPECT_FALSE(renderer.loadTimeline(&buffer, &errorMessage)) << line;
+        EXPECT_FALSE(errorMessage.isEmpty());
+    }
+}
+
+TEST_F(OfflineRendererTest, AddTrackSequence) {
+    QList<TrackPointer> tracks;
+    for (const double durationSeconds : {60.0, 30.0, 90.0}) {
+        TrackPointer pTrack = Track::newTemporary(
+                getTestDir().filePath(QStringLiteral("sine-30.wav")));
+        pTrack->setDuration(durationSeconds);
+        tracks.append(pTrack);
+    }
+
+    OfflineRenderer renderer(m_pConfig, m_pEngineMixer);
+    renderer.addPlayer(m_pMixerDeck1);
+    renderer.addPlayer(m_pMixerDeck2);
+    EXPECT_DOUBLE_EQ(160.0, renderer.addTrackSequence(tracks, 10.0));
+
+    QList<OfflineRenderer::Event> loads;
+    QList<OfflineRenderer::Event> crossfades;
+    for (const auto& event : renderer.events()) {
+        if (event.type == OfflineRenderer::Event::Type::LoadTrack) {
+            loads.append(event);
+        } else if (event.key == ConfigKey("[Master]", "crossfader")) {
+            crossfades.append(event);
+        }
+    }
+    // The decks take turns, every track starts before the previous one ends
+    ASSERT_EQ(3, loads.size());
+    EXPECT_EQ(m_sGroup1, loads[0].key.group);
+    EXPECT_DOUBLE_EQ(0.0, loads[0].timeSeconds);
+    EXPECT_EQ(m_sGroup2, loads[1].key.group);
+    EXPECT_DOUBLE_EQ(50.0, loads[1].timeSeconds);
+    EXPECT_EQ(m_sGroup1, loads[2].key.group);
+    EXPECT_DOUBLE_EQ(70.0, loads[2].timeSeconds);
+    // The tracks are loaded with their metadata instead of by location
+    for (int i = 0; i < loads.size(); ++i) {
+        EXPECT_EQ(tracks[i], loads[i].pTrack);
+    }
+
+    // The crossfader starts on the left and ends up on the left again
+    ASSERT_FALSE(crossfades.isEmpty());
+    EXPECT_DOUBLE_EQ(-1.0, crossfades.first().value);
+    EXPECT_DOUBLE_EQ(-1.0, crossfades.last().value);
+    EXPECT_DOUBLE_EQ(80.0, crossfades.last().timeSeconds);
+    for (const auto& crossfade : crossfades) {
+        EXPECT_LE(crossfade.timeSeconds, 80.0);
+        if (crossfade.timeSeconds > 50.0 && crossfade.timeSeconds < 60.0) {
+            EXPECT_GT(crossfade.value, -1.0);
+        }
+    }
+}
+
+TEST_F(OfflineRendererTest, EncodingForFileName) {
+    EXPECT_EQ(QString(ENCODING_WAVE), OfflineRenderer::encodingForFileName("mix.wav"));
+    EXPECT_EQ(QString(ENCODING_FLAC), OfflineRenderer::encodingForFileName("/tmp/mix.FLAC"));
+    EXPECT_TRUE(OfflineRenderer::encodingForFileName("mix.txt").isEmpty());
+    EXPECT_TRUE(OfflineRenderer::encodingForFileName("mix").isEmpty());
+}
+
+TEST_F(OfflineRendererTest, RenderUnknownControlFails) {
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    OfflineRenderer renderer(m_pConfig, m_pEngineMixer);
+    renderer.addControlChange(0.1, ConfigKey("[Channel1]", "does_not_exist"), 1.0);
+    QString errorMessage;
+    EXPECT_FALSE(renderer.render(
+            tempDir.filePath(QStringLiteral("unknown.wav")), ENCODING_WAVE, 1.0, &errorMessage));
+    EXPECT_FALSE(errorMessage.isEmpty());
+}
+
+TEST_F(OfflineRendererTest, RenderIsDeterministic) {
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const QByteArray first = render(tempDir.filePath(QStringLiteral("first.wav")));
+    const QByteArray second = render(tempDir.filePath(QStringLiteral("second.wav")));
+
+    // At least one second of 16 bit stereo audio
+    EXPECT_GE(first.size(), 44100 * 2 * 2);
+    EXPECT_EQ(first, second);
+    // The deck is audible
+    EXPECT_NE(first.right(4096), QByteArray(4096, '\0'));
+
+    // The preference that was changed for the rendering is restored
+    EXPECT_FALSE(m_pConfig->exists(ConfigKey(m_sGroup1, "preload_whole_track")));
+}
+
+} // namespace
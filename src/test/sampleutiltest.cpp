@@ -4,6 +4,8 @@
 #include <QList>
 #include <QPair>
 #include <QtDebug>
+#include <cmath>
+#include <utility>
 #include <vector>
 
 #include "util/sample.h"
@@ -466,6 +468,73 @@ TEST_F(SampleUtilTest, mixMultichannelToStereo) {
     EXPECT_FLOAT_EQ(destination[3], 0.9f + 1.1f + 1.3f /* + 1.5f*/);
 }
 
+// The kernels are compiled for several instruction sets and the variant for
+// the CPU is selected at runtime. Every variant must round like the plain
+// loops below, i.e. multiplications and additions must not be fused.
+TEST_F(SampleUtilTest, vectorizedKernelsMatchScalarLoops) {
+    for (const int size : std::as_const(sizes)) {
+        const int numSamples = size - size % 2;
+        std::vector<CSAMPLE> src1(numSamples);
+        std::vector<CSAMPLE> src2(numSamples);
+        std::vector<CSAMPLE> src3(numSamples);
+        std::vector<CSAMPLE> dest(numSamples);
+        for (int i = 0; i < numSamples; ++i) {
+            src1[i] = std::sin(0.1f * i);
+            src2[i] = std::cos(0.37f * i);
+            src3[i] = 0.3f - 0.11f * (i % 7);
+            dest[i] = std::sin(0.013f * i);
+        }
+
+        std::vector<CSAMPLE> result = dest;
+        std::vector<CSAMPLE> expected = dest;
+        SampleUtil::addWithGain(result.data(), src1.data(), 0.3f, numSamples);
+        for (int i = 0; i < numSamples; ++i) {
+            expected[i] += src1[i] * 0.3f;
+        }
+        EXPECT_EQ(expected, result);
+
+        result = dest;
+        expected = dest;
+        SampleUtil::add3WithGain(result.data(),
+                src1.data(),
+                0.7f,
+                src2.data(),
+                0.2f,
+                src3.data(),
+                0.9f,
+                numSamples);
+        for (int i = 0; i < numSamples; ++i) {
+            expected[i] += src1[i] * 0.7f + src2[i] * 0.2f + src3[i] * 0.9f;
+        }
+        EXPECT_EQ(expected, result);
+
+        result = dest;
+        expected = dest;
+        SampleUtil::addWithRampingGain(result.data(), src1.data(), 0.2f, 0.9f, numSamples);
+        const CSAMPLE_GAIN gainDelta = (0.9f - 0.2f) / CSAMPLE_GAIN(numSamples / 2);
+        for (int i = 0; i < numSamples / 2; ++i) {
+            const CSAMPLE_GAIN gain = (0.2f + gainDelta) + gainDelta * i;
+            expected[i * 2] += src1[i * 2] * gain;
+            expected[i * 2 + 1] += src1[i * 2 + 1] * gain;
+        }
+        EXPECT_EQ(expected, result);
+
+        result = dest;
+        expected = dest;
+        SampleUtil::linearCrossfadeBuffersOut(result.data(),
+                src1.data(),
+                numSamples,
+                mixxx::audio::ChannelCount::stereo());
+        const CSAMPLE_GAIN crossInc = CSAMPLE_GAIN_ONE / CSAMPLE_GAIN(numSamples / 2);
+        for (int i = 0; i < numSamples; ++i) {
+            const CSAMPLE_GAIN crossMix = crossInc * (i / 2);
+            expected[i] *= (CSAMPLE_GAIN_ONE - crossMix);
+            expected[i] += src1[i] * crossMix;
+        }
+        EXPECT_EQ(expected, result);
+    }
+}
+
 static void BM_MemCpy(benchmark::State& state) {
     SINT size = static_cast<SINT>(state.range(0));
     CSAMPLE* buffer = SampleUtil::alloc(size);
@@ -652,4 +721,94 @@ static void BM_Copy2WithRampingGain(benchmark::State& state) {
 }
 BENCHMARK(BM_Copy2WithRampingGain)->Range(64, 4096);
 
+static void BM_ApplyRampingGain(benchmark::State& state) {
+    SINT size = static_cast<SINT>(state.range(0));
+    CSAMPLE* buffer = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer, 0.5f, size);
+
+    for (auto _ : state) {
+        SampleUtil::applyRampingGain(buffer, 1.0f, 1.0001f, size);
+    }
+    state.SetLabel(SampleUtil::vectorInstructionSet());
+
+    SampleUtil::free(buffer);
+}
+BENCHMARK(BM_ApplyRampingGain)->Range(64, 4096);
+
+static void BM_Add3WithGain(benchmark::State& state) {
+    SINT size = static_cast<SINT>(state.range(0));
+    CSAMPLE* buffer = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer, 0.0f, size);
+    CSAMPLE* buffer2 = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer2, 0.1f, size);
+    CSAMPLE* buffer3 = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer3, 0.2f, size);
+    CSAMPLE* buffer4 = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer4, 0.3f, size);
+
+    for (auto _ : state) {
+        SampleUtil::add3WithGain(buffer, buffer2, 0.5f, buffer3, 0.5f, buffer4, 0.5f, size);
+    }
+    state.SetLabel(SampleUtil::vectorInstructionSet());
+
+    SampleUtil::free(buffer);
+    SampleUtil::free(buffer2);
+    SampleUtil::free(buffer3);
+    SampleUtil::free(buffer4);
+}
+BENCHMARK(BM_Add3WithGain)->Range(64, 4096);
+
+static void BM_CopyWithRampingNormalization(benchmark::State& state) {
+    SINT size = static_cast<SINT>(state.range(0));
+    CSAMPLE* buffer = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer, 0.0f, size);
+    CSAMPLE* buffer2 = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer2, 0.25f, size);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(SampleUtil::copyWithRampingNormalization(
+                buffer, buffer2, 1.0f, 0.5f, size));
+    }
+    state.SetLabel(SampleUtil::vectorInstructionSet());
+
+    SampleUtil::free(buffer);
+    SampleUtil::free(buffer2);
+}
+BENCHMARK(BM_CopyWithRampingNormalization)->Range(64, 4096);
+
+static void BM_SumAbsPerChannel(benchmark::State& state) {
+    SINT size = static_cast<SINT>(state.range(0));
+    CSAMPLE* buffer = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer, -0.5f, size);
+
+    for (auto _ : state) {
+        CSAMPLE absL;
+        CSAMPLE absR;
+        benchmark::DoNotOptimize(SampleUtil::sumAbsPerChannel(&absL, &absR, buffer, size));
+    }
+
+    SampleUtil::free(buffer);
+}
+BENCHMARK(BM_SumAbsPerChannel)->Range(64, 4096);
+
+static void BM_LinearCrossfadeStemBuffersIn(benchmark::State& state) {
+    SINT size = static_cast<SINT>(state.range(0));
+    CSAMPLE* buffer = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer, 0.5f, size);
+    CSAMPLE* buffer2 = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer2, -0.5f, size);
+
+    for (auto _ : state) {
+        SampleUtil::linearCrossfadeBuffersIn(buffer,
+                buffer2,
+                size,
+                mixxx::audio::ChannelCount::stem());
+    }
+    state.SetLabel(SampleUtil::vectorInstructionSet());
+
+    SampleUtil::free(buffer);
+    SampleUtil::free(buffer2);
+}
+BENCHMARK(BM_LinearCrossfadeStemBuffersIn)->Range(64, 4096);
+
 }  // namespace
@@ -0,0 +1,95 @@
+#include "engine/sidechain/sidechainring.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace {
+
+class SideChainRingTest : public testing::Test {
+  protected:
+    SideChainRingTest()
+            : m_pRing(std::make_shared<SideChainRing>(16)) {
+    }
+
+    void write(int count) {
+        std::vector<CSAMPLE> samples(count);
+        for (auto& sample : samples) {
+            sample = static_cast<CSAMPLE>(m_nextSample++);
+        }
+        m_pRing->write(samples.data(), count);
+    }
+
+    static std::vector<CSAMPLE> read(SideChainRing::Reader* pReader, int count) {
+        const CSAMPLE* dataPtr1;
+        int size1;
+        const CSAMPLE* dataPtr2;
+        int size2;
+        const int readCount = pReader->aquireReadRegions(
+                count, &dataPtr1, &size1, &dataPtr2, &size2);
+        std::vector<CSAMPLE> result(dataPtr1, dataPtr1 + size1);
+        result.insert(result.end(), dataPtr2, dataPtr2 + size2);
+        EXPECT_EQ(readCount, static_cast<int>(result.size()));
+        EXPECT_TRUE(pReader->releaseReadRegions(readCount));
+        return result;
+    }
+
+    std::shared_ptr<SideChainRing> m_pRing;
+    int m_nextSample = 0;
+};
+
+TEST_F(SideChainRingTest, ReadersKeepTheirOwnPosition) {
+    SideChainRing::Reader reader1(m_pRing);
+    write(6);
+    SideChainRing::Reader reader2(m_pRing);
+    write(4);
+
+    EXPECT_EQ(10, reader1.readAvailable());
+    EXPECT_EQ(4, reader2.readAvailable());
+    EXPECT_EQ(std::vector<CSAMPLE>({0, 1, 2, 3, 4, 5, 6, 7}), read(&reader1, 8));
+    EXPECT_EQ(std::vector<CSAMPLE>({6, 7, 8, 9}), read(&reader2, 8));
+    EXPECT_EQ(2, reader1.readAvailable());
+    EXPECT_EQ(0, reader2.readAvailable());
+
+    // Wrap around the end of the ring
+    write(10);
+    EXPECT_EQ(std::vector<CSAMPLE>({8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19}),
+            read(&reader1, 16));
+    EXPECT_EQ(std::vector<CSAMPLE>({10, 11, 12, 13, 14, 15, 16, 17, 18, 19}),
+            read(&reader2, 16));
+    EXPECT_EQ(0, reader1.overrunCount());
+    EXPECT_EQ(0, reader2.overrunCount());
+}
+
+TEST_F(SideChainRingTest, SlowReaderIsResynchronized) {
+    SideChainRing::Reader slowReader(m_pRing);
+    SideChainRing::Reader fastReader(m_pRing);
+    for (int i = 0; i < 5; ++i) {
+        write(4);
+        EXPECT_EQ(4u, read(&fastReader, 4).size());
+    }
+
+    // The oldest 12 of 20 samples are skipped and half of the ring is kept
+    EXPECT_EQ(std::vector<CSAMPLE>({12, 13, 14, 15, 16, 17, 18, 19}),
+            read(&slowReader, 16));
+    EXPECT_EQ(1, slowReader.overrunCount());
+    EXPECT_EQ(12u, slowReader.lostSampleCount());
+    EXPECT_EQ(0, fastReader.overrunCount());
+}
+
+TEST_F(SideChainRingTest, DetectOverwriteWhileReading) {
+    SideChainRing::Reader reader(m_pRing);
+    write(8);
+    const CSAMPLE* dataPtr1;
+    int size1;
+    const CSAMPLE* dataPtr2;
+    int size2;
+    EXPECT_EQ(8, reader.aquireReadRegions(8, &dataPtr1, &size1, &dataPtr2, &size2));
+    // The producer overwrites the first sample
+    write(9);
+    EXPECT_FALSE(reader.releaseReadRegions(8));
+    EXPECT_EQ(1, reader.overrunCount());
+    EXPECT_EQ(8u, reader.lostSampleCount());
+}
+
+} // anonymous namespace
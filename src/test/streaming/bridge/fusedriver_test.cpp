@@ -0,0 +1,210 @@
+#include "streaming/bridge/fusedriver.h"
+
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+using CachedRange = SparseCache::CachedRange;
+
+constexpr int64_t kFileSize = 1 << 20;
+
+// Requests are opaque to the driver, so any distinct pointer will do
+fuse_req_t fakeRequest(uintptr_t id) {
+    return reinterpret_cast<fuse_req_t>(id);
+}
+
+struct Reply {
+    int64_t start = -1;
+    int64_t length = -1;
+    int error = 0;
+};
+
+// Records the replies instead of sending them through a FUSE session
+class RecordingFuseDriver : public FuseDriver {
+  public:
+    using FuseDriver::FuseDriver;
+    using FuseDriver::doRead;
+
+    std::map<fuse_req_t, Reply> replies;
+
+  protected:
+    void replyData(fuse_req_t req,
+            const SparseCache& cache,
+            int64_t start,
+            int64_t length) override {
+        EXPECT_TRUE(length == 0 || cache.isRangeCached(start, length));
+        EXPECT_EQ(0u, replies.count(req)) << "Replied twice";
+        replies[req] = Reply{start, length, 0};
+    }
+    void replyError(fuse_req_t req, int error) override {
+        EXPECT_EQ(0u, replies.count(req)) << "Replied twice";
+        replies[req] = Reply{-1, -1, error};
+    }
+};
+
+class RecordingRangeFetcher : public RangeFetcher {
+  public:
+    void fetchRanges(fuse_ino_t ino,
+            const std::shared_ptr<SparseCache>& pCache,
+            const std::vector<CachedRange>& ranges) override {
+        (void)pCache;
+        fetchedInodes.push_back(ino);
+        fetchedRanges.insert(fetchedRanges.end(), ranges.begin(), ranges.end());
+    }
+
+    std::vector<fuse_ino_t> fetchedInodes;
+    std::vector<CachedRange> fetchedRanges;
+};
+
+class FuseDriverTest : public testing::Test {
+  protected:
+    FuseDriverTest()
+            : m_tempDir(std::filesystem::temp_directory_path() /
+                      ("mixxx-fusedriver-test-" + std::to_string(std::rand()))),
+              m_driver(&m_fetcher) {
+        std::filesystem::create_directories(m_tempDir);
+    }
+
+    ~FuseDriverTest() override {
+        std::error_code error;
+        std::filesystem::remove_all(m_tempDir, error);
+    }
+
+    std::shared_ptr<SparseCache> newCache(const std::string& name) {
+        auto pCache = std::make_shared<SparseCache>(kFileSize);
+        EXPECT_TRUE(pCache->openBackingFile((m_tempDir / name).string()));
+        return pCache;
+    }
+
+    // What the RangeFetcher does after a download
+    void download(fuse_ino_t ino, SparseCache* pCache, int64_t start, int64_t length) {
+        pCache->markCached(start, length);
+        m_driver.notifyRangeCached(ino);
+    }
+
+    const std::filesystem::path m_tempDir;
+    RecordingRangeFetcher m_fetcher;
+    RecordingFuseDriver m_driver;
+};
+
+TEST_F(FuseDriverTest, AddTrack) {
+    const auto pCache = newCache("a.cache");
+    const fuse_ino_t ino = m_driver.addTrack("a.aac", pCache);
+    EXPECT_NE(0u, ino);
+    EXPECT_NE(static_cast<fuse_ino_t>(FUSE_ROOT_ID), ino);
+    // Names must be unique and flat
+    EXPECT_EQ(0u, m_driver.addTrack("a.aac", newCache("b.cache")));
+    EXPECT_EQ(0u, m_driver.addTrack("dir/b.aac", newCache("c.cache")));
+    // A backing file is required to splice the data into replies
+    EXPECT_EQ(0u, m_driver.addTrack("d.aac", std::make_shared<SparseCache>(kFileSize)));
+}
+
+TEST_F(FuseDriverTest, ReadCachedRange) {
+    const auto pCache = newCache("a.cache");
+    const fuse_ino_t ino = m_driver.addTrack("a.aac", pCache);
+    pCache->markCached(0, 8192);
+
+    m_driver.doRead(fakeRequest(1), ino, 4096, 1000);
+    ASSERT_EQ(1u, m_driver.replies.count(fakeRequest(1)));
+    EXPECT_EQ(1000, m_driver.replies[fakeRequest(1)].start);
+    EXPECT_EQ(4096, m_driver.replies[fakeRequest(1)].length);
+    EXPECT_TRUE(m_fetcher.fetchedRanges.empty());
+}
+
+TEST_F(FuseDriverTest, ReadIsClampedToEndOfFile) {
+    const auto pCache = newCache("a.cache");
+    const fuse_ino_t ino = m_driver.addTrack("a.aac", pCache);
+    pCache->markCached(kFileSize - 100, 100);
+
+    m_driver.doRead(fakeRequest(1), ino, 4096, kFileSize - 100);
+    EXPECT_EQ(100, m_driver.replies[fakeRequest(1)].length);
+    m_driver.doRead(fakeRequest(2), ino, 4096, kFileSize);
+    EXPECT_EQ(0, m_driver.replies[fakeRequest(2)].length);
+    EXPECT_TRUE(m_fetcher.fetchedRanges.empty());
+}
+
+TEST_F(FuseDriverTest, ReadUnknownInode) {
+    m_driver.doRead(fakeRequest(1), 12345, 4096, 0);
+    EXPECT_EQ(EBADF, m_driver.replies[fakeRequest(1)].error);
+}
+
+TEST_F(FuseDriverTest, ParkReadUntilCached) {
+    const auto pCache = newCache("a.cache");
+    const fuse_ino_t ino = m_driver.addTrack("a.aac", pCache);
+    pCache->markCached(0, 1000);
+
+    m_driver.doRead(fakeRequest(1), ino, 4096, 0);
+    EXPECT_TRUE(m_driver.replies.empty());
+    // Only the missing part is fetched
+    ASSERT_EQ(1u, m_fetcher.fetchedRanges.size());
+    EXPECT_EQ((CachedRange{1000, 4096}), m_fetcher.fetchedRanges[0]);
+    EXPECT_EQ(ino, m_fetcher.fetchedInodes[0]);
+
+    // A partial download does not complete the read
+    download(ino, pCache.get(), 1000, 1000);
+    EXPECT_TRUE(m_driver.replies.empty());
+
+    download(ino, pCache.get(), 2000, 2096);
+    ASSERT_EQ(1u, m_driver.replies.count(fakeRequest(1)));
+    EXPECT_EQ(0, m_driver.replies[fakeRequest(1)].start);
+    EXPECT_EQ(4096, m_driver.replies[fakeRequest(1)].length);
+}
+
+TEST_F(FuseDriverTest, FetchFailureOnlyFailsOverlappingReads) {
+    const auto pCache = newCache("a.cache");
+    const fuse_ino_t ino = m_driver.addTrack("a.aac", pCache);
+
+    m_driver.doRead(fakeRequest(1), ino, 4096, 0);
+    m_driver.doRead(fakeRequest(2), ino, 4096, 65536);
+    m_driver.notifyFetchFailed(ino, 0, 4096, ETIMEDOUT);
+    EXPECT_EQ(ETIMEDOUT, m_driver.replies[fakeRequest(1)].error);
+    EXPECT_EQ(0u, m_driver.replies.count(fakeRequest(2)));
+
+    download(ino, pCache.get(), 65536, 4096);
+    EXPECT_EQ(4096, m_driver.replies[fakeRequest(2)].length);
+}
+
+TEST_F(FuseDriverTest, RemoveTrackFailsPendingReads) {
+    const auto pCache = newCache("a.cache");
+    const fuse_ino_t ino = m_driver.addTrack("a.aac", pCache);
+
+    m_driver.doRead(fakeRequest(1), ino, 4096, 0);
+    m_driver.removeTrack(ino);
+    EXPECT_EQ(EIO, m_driver.replies[fakeRequest(1)].error);
+    // The name can be reused
+    EXPECT_NE(0u, m_driver.addTrack("a.aac", newCache("b.cache")));
+}
+
+TEST_F(FuseDriverTest, FailPendingReadsOnShutdown) {
+    const auto pCache = newCache("a.cache");
+    const fuse_ino_t ino = m_driver.addTrack("a.aac", pCache);
+
+    m_driver.doRead(fakeRequest(1), ino, 4096, 0);
+    m_driver.doRead(fakeRequest(2), ino, 4096, 8192);
+    m_driver.failPendingReads(EIO);
+    EXPECT_EQ(EIO, m_driver.replies[fakeRequest(1)].error);
+    EXPECT_EQ(EIO, m_driver.replies[fakeRequest(2)].error);
+
+    // Late downloads must not reply again
+    download(ino, pCache.get(), 0, 16384);
+    EXPECT_EQ(2u, m_driver.replies.size());
+}
+
+TEST_F(FuseDriverTest, ReadWithoutFetcher) {
+    RecordingFuseDriver driver;
+    const auto pCache = newCache("a.cache");
+    const fuse_ino_t ino = driver.addTrack("a.aac", pCache);
+
+    driver.doRead(fakeRequest(1), ino, 4096, 0);
+    EXPECT_EQ(EIO, driver.replies[fakeRequest(1)].error);
+}
+
+} // anonymous namespace
@@ -0,0 +1,110 @@
+#include "streaming/bridge/pcmchunkcache.h"
+
+#include <gtest/gtest.h>
+
+#include <QTemporaryDir>
+#include <vector>
+
+#include "engine/cachingreader/cachingreaderchunk.h"
+
+namespace {
+
+constexpr SINT kChunkFrames = CachingReaderChunk::kFrames;
+
+const mixxx::audio::SignalInfo kSignalInfo(
+        mixxx::audio::ChannelCount::stereo(),
+        mixxx::audio::SampleRate(44100));
+
+// 3 complete chunks and a partial last chunk
+const mixxx::IndexRange kFrameIndexRange =
+        mixxx::IndexRange::forward(0, 3 * kChunkFrames + 100);
+
+class PcmChunkCacheTest : public testing::Test {
+  protected:
+    std::string cachePath() const {
+        return m_tempDir.filePath(QStringLiteral("track.pcm")).toStdString();
+    }
+
+    // Every sample encodes its frame index
+    static std::vector<CSAMPLE> samples(mixxx::IndexRange frameIndexRange) {
+        std::vector<CSAMPLE> result;
+        for (SINT frame = frameIndexRange.start(); frame < frameIndexRange.end(); ++frame) {
+            result.push_back(static_cast<CSAMPLE>(frame));
+            result.push_back(static_cast<CSAMPLE>(-frame));
+        }
+        return result;
+    }
+
+    QTemporaryDir m_tempDir;
+};
+
+TEST_F(PcmChunkCacheTest, OnlyCompleteChunksAreStored) {
+    PcmChunkCache cache;
+    ASSERT_TRUE(cache.open(cachePath(), kSignalInfo, kFrameIndexRange));
+    EXPECT_EQ(4, cache.getChunkCount());
+
+    const auto range = mixxx::IndexRange::between(100, 2 * kChunkFrames + 100);
+    cache.write(range, samples(range).data());
+    EXPECT_FALSE(cache.isChunkCached(0));
+    EXPECT_TRUE(cache.isChunkCached(1));
+    EXPECT_FALSE(cache.isChunkCached(2));
+    EXPECT_EQ(1, cache.getCachedChunkCount());
+
+    // The last chunk is shorter than kFrames
+    const auto lastChunk = mixxx::IndexRange::between(
+            3 * kChunkFrames, kFrameIndexRange.end());
+    cache.write(lastChunk, samples(lastChunk).data());
+    EXPECT_TRUE(cache.isChunkCached(3));
+}
+
+TEST_F(PcmChunkCacheTest, ReadStopsAtMissingChunk) {
+    PcmChunkCache cache;
+    ASSERT_TRUE(cache.open(cachePath(), kSignalInfo, kFrameIndexRange));
+    const auto written = mixxx::IndexRange::between(kChunkFrames, 3 * kChunkFrames);
+    cache.write(written, samples(written).data());
+
+    std::vector<CSAMPLE> buffer(kSignalInfo.frames2samples(kFrameIndexRange.length()));
+    EXPECT_EQ(0, cache.read(kFrameIndexRange, buffer.data()));
+
+    const auto requested = mixxx::IndexRange::between(kChunkFrames + 10, kFrameIndexRange.end());
+    EXPECT_EQ(2 * kChunkFrames - 10, cache.read(requested, buffer.data()));
+    EXPECT_EQ(static_cast<CSAMPLE>(kChunkFrames + 10), buffer[0]);
+    EXPECT_EQ(static_cast<CSAMPLE>(-(kChunkFrames + 10)), buffer[1]);
+    const SINT lastSample = kSignalInfo.frames2samples(2 * kChunkFrames - 10) - 2;
+    EXPECT_EQ(static_cast<CSAMPLE>(3 * kChunkFrames - 1), buffer[lastSample]);
+}
+
+TEST_F(PcmChunkCacheTest, RestoreAfterReopen) {
+    const auto written = mixxx::IndexRange::between(0, kChunkFrames);
+    {
+        PcmChunkCache cache;
+        ASSERT_TRUE(cache.open(cachePath(), kSignalInfo, kFrameIndexRange));
+        cache.write(written, samples(written).data());
+    }
+    PcmChunkCache cache;
+    ASSERT_TRUE(cache.open(cachePath(), kSignalInfo, kFrameIndexRange));
+    EXPECT_TRUE(cache.isChunkCached(0));
+    EXPECT_EQ(1, cache.getCachedChunkCount());
+    std::vector<CSAMPLE> buffer(kSignalInfo.frames2samples(kChunkFrames));
+    EXPECT_EQ(kChunkFrames, cache.read(written, buffer.data()));
+    EXPECT_EQ(samples(written), buffer);
+}
+
+TEST_F(PcmChunkCacheTest, DiscardIndexOnSignalInfoMismatch) {
+    const auto written = mixxx::IndexRange::between(0, kChunkFrames);
+    {
+        PcmChunkCache cache;
+        ASSERT_TRUE(cache.open(cachePath(), kSignalInfo, kFrameIndexRange));
+        cache.write(written, samples(written).data());
+    }
+    // Another decoder reports a different sample rate
+    PcmChunkCache cache;
+    ASSERT_TRUE(cache.open(cachePath(),
+            mixxx::audio::SignalInfo(
+                    mixxx::audio::ChannelCount::stereo(),
+                    mixxx::audio::SampleRate(48000)),
+            kFrameIndexRange));
+    EXPECT_EQ(0, cache.getCachedChunkCount());
+}
+
+} // anonymous namespace
@@ -0,0 +1,124 @@
+#include "streaming/bridge/prefetchscheduler.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// 100 seconds at 10 KiB/s
+constexpr int64_t kTrackBytes = 1024000;
+constexpr double kDurationSeconds = 100.0;
+constexpr int64_t kBytesPerSecond = 10240;
+
+class PrefetchSchedulerTest : public testing::Test {
+  protected:
+    PrefetchSchedulerTest()
+            : m_pCache(std::make_shared<SparseCache>(kTrackBytes)) {
+        PrefetchScheduler::Config config;
+        config.lookAheadSeconds = 10.0;
+        config.lookBehindSeconds = 0.0;
+        config.jumpTargetSeconds = 1.0;
+        config.maxRequestBytes = kBytesPerSecond;
+        config.maxConcurrentRequests = 100;
+        m_scheduler.setConfig(config);
+    }
+
+    PrefetchScheduler::DeckState deckState(
+            std::shared_ptr<SparseCache> pCache,
+            PrefetchScheduler::Priority priority,
+            double position) const {
+        PrefetchScheduler::DeckState state;
+        state.pCache = std::move(pCache);
+        state.priority = priority;
+        state.position = position;
+        state.durationSeconds = kDurationSeconds;
+        return state;
+    }
+
+    std::shared_ptr<SparseCache> m_pCache;
+    PrefetchScheduler m_scheduler;
+};
+
+TEST_F(PrefetchSchedulerTest, LookAheadInPlaybackOrder) {
+    m_scheduler.updateDeck(1, deckState(m_pCache, PrefetchScheduler::Priority::Playing, 0.5));
+    const auto requests = m_scheduler.nextRequests();
+    ASSERT_EQ(10u, requests.size());
+    for (size_t i = 0; i < requests.size(); ++i) {
+        EXPECT_EQ(kTrackBytes / 2 + static_cast<int64_t>(i) * kBytesPerSecond,
+                requests[i].start);
+        EXPECT_EQ(kBytesPerSecond, requests[i].length);
+    }
+}
+
+TEST_F(PrefetchSchedulerTest, ReversePlayback) {
+    auto state = deckState(m_pCache, PrefetchScheduler::Priority::Playing, 0.5);
+    state.rate = -1.0;
+    m_scheduler.updateDeck(1, state);
+    const auto requests = m_scheduler.nextRequests();
+    ASSERT_FALSE(requests.empty());
+    EXPECT_EQ(kTrackBytes / 2 - kBytesPerSecond, requests.front().start);
+    for (const auto& request : requests) {
+        EXPECT_LE(request.start + request.length, kTrackBytes / 2);
+    }
+}
+
+TEST_F(PrefetchSchedulerTest, SkipsCachedAndInFlight) {
+    m_pCache->markCached(kTrackBytes / 2, 5 * kBytesPerSecond);
+    m_scheduler.updateDeck(1, deckState(m_pCache, PrefetchScheduler::Priority::Playing, 0.5));
+    const auto requests = m_scheduler.nextRequests();
+    ASSERT_EQ(5u, requests.size());
+    EXPECT_EQ(kTrackBytes / 2 + 5 * kBytesPerSecond, requests.front().start);
+    EXPECT_TRUE(m_scheduler.nextRequests().empty());
+
+    m_scheduler.requestFinished(requests.front());
+    EXPECT_EQ(4, m_scheduler.inFlightCount());
+    // Not downloaded, so it is requested again
+    const auto retry = m_scheduler.nextRequests();
+    ASSERT_EQ(1u, retry.size());
+    EXPECT_EQ(requests.front().start, retry.front().start);
+}
+
+TEST_F(PrefetchSchedulerTest, JumpTargetsBeforeLookAheadTail) {
+    auto state = deckState(m_pCache, PrefetchScheduler::Priority::Playing, 0.0);
+    state.jumpTargets = {0.8};
+    m_scheduler.updateDeck(1, state);
+    const auto requests = m_scheduler.nextRequests();
+    ASSERT_GE(requests.size(), 2u);
+    // Immediate window first, then the hotcue
+    EXPECT_EQ(0, requests[0].start);
+    EXPECT_EQ(kTrackBytes * 8 / 10, requests[1].start);
+}
+
+TEST_F(PrefetchSchedulerTest, DeckPriorityAndConcurrencyLimit) {
+    auto config = m_scheduler.config();
+    config.maxConcurrentRequests = 2;
+    m_scheduler.setConfig(config);
+
+    auto pPreviewCache = std::make_shared<SparseCache>(kTrackBytes);
+    auto pPlayingCache = std::make_shared<SparseCache>(kTrackBytes);
+    m_scheduler.updateDeck(1, deckState(pPreviewCache, PrefetchScheduler::Priority::Preview, 0.0));
+    m_scheduler.updateDeck(2, deckState(m_pCache, PrefetchScheduler::Priority::Cued, 0.0));
+    m_scheduler.updateDeck(3, deckState(pPlayingCache, PrefetchScheduler::Priority::Playing, 0.0));
+
+    const auto requests = m_scheduler.nextRequests();
+    ASSERT_EQ(2u, requests.size());
+    // Even the look-ahead tail of the playing deck precedes the
+    // immediate window of the cued deck
+    EXPECT_EQ(3, requests[0].deck);
+    EXPECT_EQ(3, requests[1].deck);
+    EXPECT_TRUE(m_scheduler.nextRequests().empty());
+
+    m_scheduler.removeDeck(3);
+    m_scheduler.requestFinished(requests[0]);
+    m_scheduler.requestFinished(requests[1]);
+    const auto next = m_scheduler.nextRequests();
+    ASSERT_EQ(2u, next.size());
+    EXPECT_EQ(2, next[0].deck);
+}
+
+TEST_F(PrefetchSchedulerTest, SameTrackOnTwoDecks) {
+    m_scheduler.updateDeck(1, deckState(m_pCache, PrefetchScheduler::Priority::Playing, 0.5));
+    m_scheduler.updateDeck(2, deckState(m_pCache, PrefetchScheduler::Priority::Cued, 0.5));
+    EXPECT_EQ(10u, m_scheduler.nextRequests().size());
+}
+
+} // namespace
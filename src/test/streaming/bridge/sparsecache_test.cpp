@@ -0,0 +1,271 @@
+#include "streaming/bridge/sparsecache.h"
+
+#include <gtest/gtest.h>
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <thread>
+
+#ifdef USE_BENCH
+#include <benchmark/benchmark.h>
+#endif
+
+namespace {
+
+using CachedRange = SparseCache::CachedRange;
+
+class SparseCacheTest : public testing::Test {
+  protected:
+    SparseCache m_cache{1000};
+};
+
+TEST_F(SparseCacheTest, Empty) {
+    EXPECT_FALSE(m_cache.isRangeCached(0, 1));
+    EXPECT_TRUE(m_cache.isRangeCached(10, 0));
+    EXPECT_EQ(0, m_cache.getCachedLength(0));
+    EXPECT_EQ(0.0, m_cache.getCachedPercentage());
+    EXPECT_EQ(std::vector<CachedRange>({{0, 100}}),
+            m_cache.getMissingRanges(0, 100));
+    EXPECT_TRUE(m_cache.getAllCachedRanges().empty());
+}
+
+TEST_F(SparseCacheTest, MergeOverlapping) {
+    m_cache.markCached(100, 100);
+    m_cache.markCached(150, 100);
+    EXPECT_EQ(std::vector<CachedRange>({{100, 250}}),
+            m_cache.getAllCachedRanges());
+    EXPECT_EQ(150, m_cache.getCachedBytes());
+}
+
+TEST_F(SparseCacheTest, MergeAdjacent) {
+    m_cache.markCached(0, 10);
+    m_cache.markCached(20, 10);
+    m_cache.markCached(10, 10);
+    EXPECT_EQ(std::vector<CachedRange>({{0, 30}}),
+            m_cache.getAllCachedRanges());
+    EXPECT_EQ(1u, m_cache.getRangeCount());
+}
+
+TEST_F(SparseCacheTest, MergeSpanningMany) {
+    for (int64_t start = 0; start < 100; start += 20) {
+        m_cache.markCached(start, 10);
+    }
+    EXPECT_EQ(5u, m_cache.getRangeCount());
+    EXPECT_EQ(50, m_cache.getCachedBytes());
+
+    m_cache.markCached(5, 80);
+    EXPECT_EQ(std::vector<CachedRange>({{0, 90}}),
+            m_cache.getAllCachedRanges());
+    EXPECT_EQ(90, m_cache.getCachedBytes());
+}
+
+TEST_F(SparseCacheTest, ContainedInsertIsNoop) {
+    m_cache.markCached(0, 100);
+    m_cache.markCached(10, 10);
+    EXPECT_EQ(std::vector<CachedRange>({{0, 100}}),
+            m_cache.getAllCachedRanges());
+    EXPECT_EQ(100, m_cache.getCachedBytes());
+}
+
+TEST_F(SparseCacheTest, Coverage) {
+    m_cache.markCached(100, 100);
+    EXPECT_TRUE(m_cache.isRangeCached(100, 100));
+    EXPECT_TRUE(m_cache.isRangeCached(150, 10));
+    EXPECT_FALSE(m_cache.isRangeCached(99, 2));
+    EXPECT_FALSE(m_cache.isRangeCached(199, 2));
+    EXPECT_FALSE(m_cache.isRangeCached(200, 1));
+    EXPECT_EQ(50, m_cache.getCachedLength(150));
+    EXPECT_EQ(0, m_cache.getCachedLength(200));
+    EXPECT_EQ(0, m_cache.getCachedLength(99));
+}
+
+TEST_F(SparseCacheTest, MissingRanges) {
+    m_cache.markCached(100, 100);
+    m_cache.markCached(300, 100);
+    EXPECT_EQ(std::vector<CachedRange>({{50, 100}, {200, 300}, {400, 450}}),
+            m_cache.getMissingRanges(50, 400));
+    EXPECT_EQ(std::vector<CachedRange>({{200, 250}}),
+            m_cache.getMissingRanges(150, 100));
+    EXPECT_TRUE(m_cache.getMissingRanges(120, 50).empty());
+}
+
+TEST_F(SparseCacheTest, FullyCached) {
+    m_cache.markCached(0, 500);
+    EXPECT_FALSE(m_cache.isFullyCached());
+    EXPECT_DOUBLE_EQ(50.0, m_cache.getCachedPercentage());
+    m_cache.markCached(500, 500);
+    EXPECT_TRUE(m_cache.isFullyCached());
+    EXPECT_DOUBLE_EQ(100.0, m_cache.getCachedPercentage());
+}
+
+TEST_F(SparseCacheTest, ConcurrentReadersSeeMonotonicCoverage) {
+    constexpr int64_t kBlockSize = 16;
+    constexpr int64_t kBlockCount = 2000;
+    SparseCache cache(kBlockSize * kBlockCount);
+    std::atomic<bool> done = false;
+    std::atomic<bool> failed = false;
+
+    std::thread reader([&] {
+        int64_t lastCachedBytes = 0;
+        while (!done.load()) {
+            const int64_t cachedBytes = cache.getCachedBytes();
+            if (cachedBytes < lastCachedBytes) {
+                failed.store(true);
+            }
+            lastCachedBytes = cachedBytes;
+            // Block 0 is inserted first, it must never disappear
+            if (cachedBytes > 0 && !cache.isRangeCached(0, kBlockSize)) {
+                failed.store(true);
+            }
+        }
+    });
+
+    // Insert even blocks first, then fill the gaps in between
+    for (int64_t block = 0; block < kBlockCount; block += 2) {
+        cache.markCached(block * kBlockSize, kBlockSize);
+    }
+    for (int64_t block = 1; block < kBlockCount; block += 2) {
+        cache.markCached(block * kBlockSize, kBlockSize);
+    }
+    done.store(true);
+    reader.join();
+
+    EXPECT_FALSE(failed.load());
+    EXPECT_TRUE(cache.isFullyCached());
+    EXPECT_EQ(1u, cache.getRangeCount());
+}
+
+class SparseCacheBackingFileTest : public testing::Test {
+  protected:
+    std::string backingFilePath() const {
+        return m_tempDir.filePath(QStringLiteral("track.bin")).toStdString();
+    }
+
+    QTemporaryDir m_tempDir;
+};
+
+TEST_F(SparseCacheBackingFileTest, RequiresTotalSize) {
+    SparseCache cache;
+    EXPECT_FALSE(cache.openBackingFile(backingFilePath()));
+    EXPECT_FALSE(cache.hasBackingFile());
+    EXPECT_EQ(nullptr, cache.getWritableData(0, 1));
+}
+
+TEST_F(SparseCacheBackingFileTest, WriteInPlace) {
+    SparseCache cache(1 << 20);
+    ASSERT_TRUE(cache.openBackingFile(backingFilePath()));
+    EXPECT_EQ(nullptr, cache.getWritableData((1 << 20) - 1, 2));
+
+    uint8_t* pData = cache.getWritableData(5000, 4);
+    ASSERT_NE(nullptr, pData);
+    std::memcpy(pData, "abcd", 4);
+    cache.markCached(5000, 4);
+    EXPECT_TRUE(cache.isRangeCached(5000, 4));
+    EXPECT_EQ(0, std::memcmp(cache.getData(5000, 4), "abcd", 4));
+}
+
+TEST_F(SparseCacheBackingFileTest, RestoreAfterReopen) {
+    {
+        SparseCache cache(1 << 20);
+        ASSERT_TRUE(cache.openBackingFile(backingFilePath()));
+        std::memcpy(cache.getWritableData(100, 3), "xyz", 3);
+        cache.markCached(100, 3);
+        cache.markCached(65536, 4096);
+    }
+    SparseCache cache(1 << 20);
+    ASSERT_TRUE(cache.openBackingFile(backingFilePath()));
+    EXPECT_EQ(std::vector<CachedRange>({{100, 103}, {65536, 69632}}),
+            cache.getAllCachedRanges());
+    EXPECT_EQ(0, std::memcmp(cache.getData(100, 3), "xyz", 3));
+}
+
+TEST_F(SparseCacheBackingFileTest, DiscardIndexOnSizeMismatch) {
+    {
+        SparseCache cache(1 << 20);
+        ASSERT_TRUE(cache.openBackingFile(backingFilePath()));
+        cache.markCached(0, 4096);
+    }
+    // The remote file has changed
+    SparseCache cache(1 << 19);
+    ASSERT_TRUE(cache.openBackingFile(backingFilePath()));
+    EXPECT_EQ(0, cache.getCachedBytes());
+}
+
+TEST_F(SparseCacheBackingFileTest, DiscardCorruptIndex) {
+    {
+        SparseCache cache(1 << 20);
+        ASSERT_TRUE(cache.openBackingFile(backingFilePath()));
+        cache.markCached(0, 4096);
+    }
+    // Claim more ranges than the index file contains
+    QFile indexFile(QString::fromStdString(
+            SparseCache::indexPathFor(backingFilePath())));
+    ASSERT_TRUE(indexFile.open(QIODevice::ReadWrite));
+    // The range count follows the magic, version, reserved and size fields
+    ASSERT_TRUE(indexFile.seek(24));
+    const uint64_t rangeCount = 1000;
+    ASSERT_EQ(static_cast<qint64>(sizeof(rangeCount)),
+            indexFile.write(reinterpret_cast<const char*>(&rangeCount),
+                    sizeof(rangeCount)));
+    indexFile.close();
+
+    SparseCache cache(1 << 20);
+    ASSERT_TRUE(cache.openBackingFile(backingFilePath()));
+    EXPECT_EQ(0, cache.getCachedBytes());
+}
+
+#ifdef USE_BENCH
+// A heavily fragmented file: every other block of kBlockSize bytes is cached
+static void fillFragmented(SparseCache* pCache, int64_t rangeCount) {
+    constexpr int64_t kBlockSize = 4096;
+    for (int64_t i = 0; i < rangeCount; ++i) {
+        pCache->markCached(2 * i * kBlockSize, kBlockSize);
+    }
+}
+
+static void BM_SparseCacheIsRangeCached(benchmark::State& state) {
+    const int64_t rangeCount = state.range(0);
+    SparseCache cache(2 * rangeCount * 4096);
+    fillFragmented(&cache, rangeCount);
+    std::mt19937_64 generator(0);
+    std::uniform_int_distribution<int64_t> offsets(0, cache.getTotalSize() - 1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache.isRangeCached(offsets(generator), 1024));
+    }
+}
+BENCHMARK(BM_SparseCacheIsRangeCached)->Range(64, 16384);
+
+static void BM_SparseCacheGetMissingRanges(benchmark::State& state) {
+    const int64_t rangeCount = state.range(0);
+    SparseCache cache(2 * rangeCount * 4096);
+    fillFragmented(&cache, rangeCount);
+    std::mt19937_64 generator(0);
+    std::uniform_int_distribution<int64_t> offsets(0, cache.getTotalSize() - 1);
+    for (auto _ : state) {
+        // A typical read-ahead window of 256 KiB
+        benchmark::DoNotOptimize(cache.getMissingRanges(offsets(generator), 256 * 1024));
+    }
+}
+BENCHMARK(BM_SparseCacheGetMissingRanges)->Range(64, 16384);
+
+static void BM_SparseCacheMarkCached(benchmark::State& state) {
+    const int64_t rangeCount = state.range(0);
+    for (auto _ : state) {
+        state.PauseTiming();
+        SparseCache cache(2 * rangeCount * 4096);
+        state.ResumeTiming();
+        fillFragmented(&cache, rangeCount);
+        // Fill all gaps, merging everything into a single interval
+        for (int64_t i = 0; i < rangeCount; ++i) {
+            cache.markCached((2 * i + 1) * 4096, 4096);
+        }
+        benchmark::DoNotOptimize(cache.getRangeCount());
+    }
+}
+BENCHMARK(BM_SparseCacheMarkCached)->Range(64, 16384);
+#endif
+
+} // namespace
@@ -0,0 +1,105 @@
+#include "streaming/bridge/streamcachemanager.h"
+
+#include <gtest/gtest.h>
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <cstring>
+
+namespace {
+
+constexpr int64_t kTrackSize = 256 * 1024;
+
+class StreamCacheManagerTest : public testing::Test {
+  protected:
+    std::string backingFilePath(const QString& name) const {
+        return m_tempDir.filePath(name).toStdString();
+    }
+
+    // Creates the backing file and index of a track with the first
+    // cachedBytes downloaded
+    std::shared_ptr<SparseCache> createTrack(const QString& name,
+            int64_t totalSize,
+            int64_t cachedBytes) const {
+        auto pCache = std::make_shared<SparseCache>(totalSize);
+        EXPECT_TRUE(pCache->openBackingFile(backingFilePath(name)));
+        std::memset(pCache->getWritableData(0, cachedBytes), 0x55, cachedBytes);
+        pCache->markCached(0, cachedBytes);
+        EXPECT_TRUE(pCache->persistIndex());
+        return pCache;
+    }
+
+    bool exists(const QString& name) const {
+        return QFile::exists(m_tempDir.filePath(name));
+    }
+
+    QTemporaryDir m_tempDir;
+};
+
+TEST_F(StreamCacheManagerTest, EvictPartialTracksFirst) {
+    // The least recently used track is complete
+    createTrack("full", 64 * 1024, 64 * 1024);
+    createTrack("partial", kTrackSize, 64 * 1024);
+    createTrack("permanent", kTrackSize, 64 * 1024);
+
+    StreamCacheManager manager(m_tempDir.path(), kTrackSize * 4);
+    const int64_t usedBytes = manager.getUsedBytes();
+    EXPECT_GE(usedBytes, 3 * 64 * 1024);
+    EXPECT_EQ(OfflineStatus::PartialCache, manager.getOfflineStatus(backingFilePath("partial")));
+    manager.setOfflineStatus(backingFilePath("permanent"), OfflineStatus::OfflinePermanent);
+
+    // One track needs to go
+    manager.setByteBudget(usedBytes - 1);
+    EXPECT_FALSE(exists("partial"));
+    EXPECT_FALSE(exists("partial.idx"));
+    EXPECT_TRUE(exists("full"));
+    EXPECT_TRUE(exists("permanent"));
+    EXPECT_EQ(OfflineStatus::CloudOnly, manager.getOfflineStatus(backingFilePath("partial")));
+
+    // Permanent tracks are kept even if the budget cannot be met
+    EXPECT_FALSE(manager.reserve(manager.getByteBudget()));
+    EXPECT_FALSE(exists("full"));
+    EXPECT_TRUE(exists("permanent"));
+    EXPECT_EQ(OfflineStatus::OfflinePermanent,
+            manager.getOfflineStatus(backingFilePath("permanent")));
+}
+
+TEST_F(StreamCacheManagerTest, EvictLeastPlayedFirst) {
+    createTrack("often", kTrackSize, 64 * 1024);
+    createTrack("once", kTrackSize, 64 * 1024);
+
+    StreamCacheManager manager(m_tempDir.path(), kTrackSize * 4);
+    manager.trackPlayed(backingFilePath("often"));
+    manager.trackPlayed(backingFilePath("often"));
+    manager.trackPlayed(backingFilePath("once"));
+
+    manager.setByteBudget(manager.getUsedBytes() - 1);
+    EXPECT_TRUE(exists("often"));
+    EXPECT_FALSE(exists("once"));
+}
+
+TEST_F(StreamCacheManagerTest, KeepTracksInUse) {
+    StreamCacheManager manager(m_tempDir.path(), kTrackSize * 4);
+    const auto pCache = createTrack("loaded", kTrackSize, 64 * 1024);
+    manager.trackOpened(pCache);
+    EXPECT_GE(manager.getUsedBytes(), 64 * 1024);
+
+    EXPECT_FALSE(manager.reserve(kTrackSize * 4));
+    EXPECT_TRUE(exists("loaded"));
+    EXPECT_EQ(0, manager.evict(backingFilePath("loaded")));
+}
+
+TEST_F(StreamCacheManagerTest, RestoreManifest) {
+    createTrack("track", kTrackSize, 64 * 1024);
+    {
+        StreamCacheManager manager(m_tempDir.path(), kTrackSize * 4);
+        manager.setOfflineStatus(backingFilePath("track"), OfflineStatus::OfflinePermanent);
+    }
+    StreamCacheManager manager(m_tempDir.path(), 0);
+    EXPECT_EQ(OfflineStatus::OfflinePermanent,
+            manager.getOfflineStatus(backingFilePath("track")));
+    EXPECT_FALSE(manager.reserve(0));
+    EXPECT_TRUE(exists("track"));
+}
+
+} // anonymous namespace
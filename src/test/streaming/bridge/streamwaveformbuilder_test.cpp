@@ -0,0 +1,109 @@
+#include "streaming/bridge/streamwaveformbuilder.h"
+
+#include <gtest/gtest.h>
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <cstring>
+
+#include "sources/soundsourcestream.h"
+#include "test/mixxxtest.h"
+#include "test/soundsourceproviderregistration.h"
+#include "track/track.h"
+
+namespace {
+
+class StreamWaveformBuilderTest : public MixxxTest, SoundSourceProviderRegistration {
+  protected:
+    StreamWaveformBuilderTest()
+            : m_builder(config(), QSqlDatabase()) {
+    }
+
+    void SetUp() override {
+        QFile file(getTestDir().filePath(
+                QStringLiteral("id3-test-data/cover-test.wav")));
+        ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+        m_fileData = file.readAll();
+
+        m_pCache = std::make_shared<SparseCache>(m_fileData.size());
+        ASSERT_TRUE(m_pCache->openBackingFile(
+                m_tempDir.filePath(QStringLiteral("track.wav")).toStdString()));
+        m_pTrack = Track::newTemporary();
+    }
+
+    // Simulates the download of a byte range
+    void download(int64_t start, int64_t length) {
+        std::memcpy(m_pCache->getWritableData(start, length),
+                m_fileData.constData() + start,
+                length);
+        m_pCache->markCached(start, length);
+    }
+
+    std::shared_ptr<mixxx::SoundSourceStream> openStream() {
+        auto pStream = std::make_shared<mixxx::SoundSourceStream>(
+                m_pCache, QStringLiteral("wav"));
+        if (pStream->open(mixxx::AudioSource::OpenMode::Strict) !=
+                mixxx::AudioSource::OpenResult::Succeeded) {
+            return nullptr;
+        }
+        return pStream;
+    }
+
+    QTemporaryDir m_tempDir;
+    QByteArray m_fileData;
+    std::shared_ptr<SparseCache> m_pCache;
+    TrackPointer m_pTrack;
+    StreamWaveformBuilder m_builder;
+};
+
+TEST_F(StreamWaveformBuilderTest, FillHolesAsDownloadsLand) {
+    const int64_t quarterSize = m_fileData.size() / 4;
+    download(0, quarterSize);
+    download(2 * quarterSize, quarterSize);
+    auto pStream = openStream();
+    ASSERT_NE(nullptr, pStream);
+    ASSERT_TRUE(m_builder.setTrack(m_pTrack, pStream));
+
+    // Both downloaded regions are analyzed
+    EXPECT_GT(m_builder.update(), 0);
+    EXPECT_FALSE(m_builder.isComplete());
+    ConstWaveformPointer pSummary = m_pTrack->getWaveformSummary();
+    ASSERT_NE(nullptr, pSummary);
+    const auto cachedRanges = pSummary->getCachedRanges();
+    ASSERT_EQ(2, cachedRanges.size());
+    EXPECT_EQ(0.0, cachedRanges.first().first);
+    EXPECT_LT(cachedRanges.first().second, 0.25);
+    EXPECT_GT(cachedRanges.last().first, 0.5);
+    EXPECT_LT(cachedRanges.last().second, 0.75);
+    EXPECT_GT(pSummary->getCompletion(), pSummary->getDataSize() / 2);
+    EXPECT_LT(pSummary->getCompletion(), pSummary->getDataSize());
+
+    // Nothing new to analyze
+    EXPECT_EQ(0, m_builder.update());
+
+    // Only the missing chunks are analyzed
+    download(quarterSize, quarterSize);
+    download(3 * quarterSize, m_fileData.size() - 3 * quarterSize);
+    const int remainingChunkCount = m_builder.update();
+    EXPECT_GT(remainingChunkCount, 0);
+    EXPECT_TRUE(m_builder.isComplete());
+    pSummary = m_pTrack->getWaveformSummary();
+    ASSERT_NE(nullptr, pSummary);
+    EXPECT_TRUE(pSummary->getCachedRanges().isEmpty());
+    EXPECT_EQ(pSummary->getDataSize(), pSummary->getCompletion());
+    EXPECT_EQ(0, m_builder.update());
+}
+
+TEST_F(StreamWaveformBuilderTest, LimitChunksPerUpdate) {
+    download(0, m_fileData.size());
+    auto pStream = openStream();
+    ASSERT_NE(nullptr, pStream);
+    ASSERT_TRUE(m_builder.setTrack(m_pTrack, pStream));
+
+    EXPECT_EQ(1, m_builder.update(1));
+    EXPECT_FALSE(m_builder.isComplete());
+    EXPECT_GT(m_builder.update(), 0);
+    EXPECT_TRUE(m_builder.isComplete());
+}
+
+} // anonymous namespace
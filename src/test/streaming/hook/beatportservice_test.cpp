@@ -0,0 +1,227 @@
+#include "streaming/hook/beatportservice.h"
+
+#include <gtest/gtest.h>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "streaming/hook/oauthmanager.h"
+#include "test/mixxxtest.h"
+#include "test/mock_networkaccessmanager.h"
+
+namespace {
+
+// Longer than the batching window of BeatportService
+constexpr int kBatchWaitMs = 50;
+
+QByteArray tracksJson(const QList<int>& trackIds, int totalCount = -1) {
+    QJsonArray results;
+    for (int trackId : trackIds) {
+        results.append(QJsonObject{
+                {"id", trackId},
+                {"name", QString("Track %1").arg(trackId)},
+                {"bpm", 124}});
+    }
+    return QJsonDocument(QJsonObject{
+                                 {"count", totalCount < 0 ? trackIds.size() : totalCount},
+                                 {"results", results}})
+            .toJson(QJsonDocument::Compact);
+}
+
+class BeatportServiceTest : public MixxxTest {
+  protected:
+    BeatportServiceTest()
+            : m_oauthManager(&m_network) {
+        OAuthManager::TokenPair tokens;
+        tokens.accessToken = QStringLiteral("token");
+        tokens.expiresAt = QDateTime::currentDateTime().addSecs(3600);
+        m_oauthManager.setTokens(QStringLiteral("beatport"), tokens);
+    }
+
+    MockNetworkAccessManager m_network;
+    OAuthManager m_oauthManager;
+};
+
+TEST_F(BeatportServiceTest, BatchConcurrentTrackRequests) {
+    BeatportService service(&m_network, &m_oauthManager);
+    MockNetworkReply* pReply = m_network.ExpectGet(
+            "catalog/tracks",
+            {{"id", "1,2,3"}},
+            200,
+            tracksJson({1, 2, 3}));
+
+    const auto future3 = service.fetchTrackMetadata("3");
+    const auto future1 = service.fetchTrackMetadata("1");
+    const auto future2 = service.fetchTrackMetadata("2");
+    const auto future1Again = service.fetchTrackMetadata("1");
+    QTest::qWait(kBatchWaitMs);
+    EXPECT_FALSE(future1.isFinished());
+
+    pReply->Done();
+    application()->processEvents();
+    ASSERT_TRUE(future1.isFinished());
+    ASSERT_TRUE(future1Again.isFinished());
+    EXPECT_EQ("1", future1.result().remoteId);
+    EXPECT_EQ("1", future1Again.result().remoteId);
+    EXPECT_EQ("2", future2.result().remoteId);
+    EXPECT_EQ("3", future3.result().remoteId);
+
+    // Served from memory without another request
+    const auto cached = service.fetchTrackMetadata("2");
+    ASSERT_TRUE(cached.isFinished());
+    EXPECT_EQ("Track 2", cached.result().title);
+}
+
+TEST_F(BeatportServiceTest, UnknownTrackFinishesWithoutResult) {
+    BeatportService service(&m_network, &m_oauthManager);
+    MockNetworkReply* pReply = m_network.ExpectGet(
+            "catalog/tracks",
+            {{"id", "1,4"}},
+            200,
+            tracksJson({1}));
+
+    const auto future1 = service.fetchTrackMetadata("1");
+    const auto future4 = service.fetchTrackMetadata("4");
+    QTest::qWait(kBatchWaitMs);
+    pReply->Done();
+    application()->processEvents();
+
+    ASSERT_TRUE(future4.isFinished());
+    EXPECT_EQ(0, future4.resultCount());
+    EXPECT_EQ(1, future1.resultCount());
+}
+
+TEST_F(BeatportServiceTest, RequestPlaylistPagesConcurrently) {
+    BeatportService service(&m_network, &m_oauthManager);
+    QList<int> firstPage;
+    QList<int> secondPage;
+    QList<int> thirdPage;
+    for (int i = 0; i < 250; ++i) {
+        (i < 100 ? firstPage : (i < 200 ? secondPage : thirdPage)).append(i);
+    }
+    MockNetworkReply* pPage1 = m_network.ExpectGet(
+            "catalog/playlists/42/tracks",
+            {{"page", "1"}},
+            200,
+            tracksJson(firstPage, 250));
+    MockNetworkReply* pPage2 = m_network.ExpectGet(
+            "catalog/playlists/42/tracks",
+            {{"page", "2"}},
+            200,
+            tracksJson(secondPage, 250));
+    MockNetworkReply* pPage3 = m_network.ExpectGet(
+            "catalog/playlists/42/tracks",
+            {{"page", "3"}},
+            200,
+            tracksJson(thirdPage, 250));
+
+    const auto future = service.getPlaylist("42");
+    pPage1->Done();
+    application()->processEvents();
+    EXPECT_FALSE(future.isFinished());
+
+    // Both remaining pages are in flight, replies may arrive in any order
+    pPage3->Done();
+    pPage2->Done();
+    application()->processEvents();
+
+    ASSERT_TRUE(future.isFinished());
+    const QVector<TrackMetadata> tracks = future.result();
+    ASSERT_EQ(250, tracks.size());
+    for (int i = 0; i < tracks.size(); ++i) {
+        EXPECT_EQ(QString::number(i), tracks[i].remoteId);
+    }
+}
+
+TEST_F(BeatportServiceTest, ServeResponsesFromDiskCache) {
+    QTemporaryDir cacheDir;
+    SearchQuery query;
+    query.text = QStringLiteral("acid");
+    {
+        BeatportService service(&m_network, &m_oauthManager);
+        service.setResponseCacheDirectory(cacheDir.path());
+        MockNetworkReply* pReply = m_network.ExpectGet(
+                "catalog/search",
+                {{"q", "acid"}},
+                200,
+                tracksJson({7, 8}));
+        const auto future = service.search(query);
+        pReply->Done();
+        application()->processEvents();
+        ASSERT_TRUE(future.isFinished());
+        EXPECT_EQ(2, future.result().size());
+    }
+
+    // A new instance does not need the network
+    BeatportService service(&m_network, &m_oauthManager);
+    service.setResponseCacheDirectory(cacheDir.path());
+    const auto future = service.search(query);
+    ASSERT_TRUE(future.isFinished());
+    EXPECT_EQ(2, future.result().size());
+}
+
+TEST_F(BeatportServiceTest, DoNotPersistPrivateResponses) {
+    QTemporaryDir cacheDir;
+    SearchQuery query;
+    query.text = QStringLiteral("acid");
+    for (const char* cacheControl : {"no-store", "private, max-age=600"}) {
+        BeatportService service(&m_network, &m_oauthManager);
+        service.setResponseCacheDirectory(cacheDir.path());
+        MockNetworkReply* pReply = m_network.ExpectGet(
+                "catalog/search",
+                {{"q", "acid"}},
+                200,
+                tracksJson({7, 8}));
+        pReply->SetRawHeader("Cache-Control", cacheControl);
+        const auto future = service.search(query);
+        // Not served from the disk cache
+        EXPECT_FALSE(future.isFinished()) << cacheControl;
+        pReply->Done();
+        application()->processEvents();
+        ASSERT_TRUE(future.isFinished());
+        EXPECT_EQ(2, future.result().size());
+    }
+}
+
+TEST_F(BeatportServiceTest, SeparateResponsesOfAccounts) {
+    QTemporaryDir cacheDir;
+    SearchQuery query;
+    query.text = QStringLiteral("acid");
+    {
+        BeatportService service(&m_network, &m_oauthManager);
+        service.setResponseCacheDirectory(cacheDir.path());
+        MockNetworkReply* pReply = m_network.ExpectGet(
+                "catalog/search",
+                {{"q", "acid"}},
+                200,
+                tracksJson({7, 8}));
+        const auto future = service.search(query);
+        pReply->Done();
+        application()->processEvents();
+        ASSERT_TRUE(future.isFinished());
+    }
+
+    OAuthManager::TokenPair tokens;
+    tokens.accessToken = QStringLiteral("other token");
+    tokens.expiresAt = QDateTime::currentDateTime().addSecs(3600);
+    m_oauthManager.setTokens(QStringLiteral("beatport"), tokens);
+
+    BeatportService service(&m_network, &m_oauthManager);
+    service.setResponseCacheDirectory(cacheDir.path());
+    MockNetworkReply* pReply = m_network.ExpectGet(
+            "catalog/search",
+            {{"q", "acid"}},
+            200,
+            tracksJson({9}));
+    const auto future = service.search(query);
+    EXPECT_FALSE(future.isFinished());
+    pReply->Done();
+    application()->processEvents();
+    ASSERT_TRUE(future.isFinished());
+    EXPECT_EQ(1, future.result().size());
+}
+
+} // anonymous namespace
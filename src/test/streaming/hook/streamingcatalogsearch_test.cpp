@@ -0,0 +1,220 @@
+#include "streaming/hook/streamingcatalogsearch.h"
+
+#include <gtest/gtest.h>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocale>
+#include <QTest>
+
+#include "streaming/hook/beatportservice.h"
+#include "streaming/hook/oauthmanager.h"
+#include "test/librarytest.h"
+#include "test/mock_networkaccessmanager.h"
+
+namespace {
+
+TrackMetadata newTrack(const QString& remoteId,
+        const QString& title,
+        int bpm,
+        const QString& key,
+        const QString& genre) {
+    TrackMetadata track{};
+    track.remoteId = remoteId;
+    track.title = title;
+    track.artist = QStringLiteral("Artist");
+    track.bpm = bpm;
+    track.key = key;
+    track.genre = genre;
+    track.durationMs = 360000;
+    return track;
+}
+
+QStringList remoteIds(const QVector<TrackMetadata>& tracks) {
+    QStringList ids;
+    for (const auto& track : tracks) {
+        ids << track.remoteId;
+    }
+    ids.sort();
+    return ids;
+}
+
+class StreamingCatalogSearchTest : public LibraryTest {
+  protected:
+    StreamingCatalogSearchTest()
+            : m_oauthManager(&m_network),
+              m_service(&m_network, &m_oauthManager) {
+        OAuthManager::TokenPair tokens;
+        tokens.accessToken = QStringLiteral("token");
+        tokens.expiresAt = QDateTime::currentDateTime().addSecs(3600);
+        m_oauthManager.setTokens(m_service.serviceId(), tokens);
+        // Logging in fetches the subscription tier
+        m_network.ExpectGet("my/subscriptions", {}, 200, QByteArray("{}"));
+        emit m_oauthManager.tokenRefreshed(m_service.serviceId());
+        m_trackIndex.initialize(internalCollection()->database());
+    }
+
+    MockNetworkAccessManager m_network;
+    OAuthManager m_oauthManager;
+    BeatportService m_service;
+    StreamingTrackIndex m_trackIndex;
+};
+
+TEST_F(StreamingCatalogSearchTest, SearchIndexWithLibraryFilters) {
+    ASSERT_TRUE(m_trackIndex.storeTracks(m_service.serviceId(),
+            {newTrack("1", "Acid Rain", 124, "8A", "Techno"),
+                    newTrack("2", "Deep Water", 122, "5A", "Deep House"),
+                    newTrack("3", "Half Time", 87, "8A", "Drum & Bass")}));
+    // Tracks of other services are not visible
+    ASSERT_TRUE(m_trackIndex.storeTracks(QStringLiteral("tidal"),
+            {newTrack("1", "Acid Rain", 124, "8A", "Techno")}));
+
+    StreamingCatalogSearch search(&m_service, internalCollection());
+    EXPECT_EQ(QStringList({"1", "2", "3"}), remoteIds(search.searchIndex("")));
+    EXPECT_EQ(QStringList({"1"}), remoteIds(search.searchIndex("acid")));
+    EXPECT_EQ(QStringList({"1", "3"}), remoteIds(search.searchIndex("key:8A")));
+    EXPECT_EQ(QStringList({"2"}), remoteIds(search.searchIndex("genre:house")));
+    EXPECT_EQ(QStringList({"1", "2"}), remoteIds(search.searchIndex("bpm:120-125")));
+    EXPECT_EQ(QStringList({"3"}), remoteIds(search.searchIndex("-genre:house key:8A bpm:<100")));
+    // Crate filters never match streamed tracks
+    EXPECT_TRUE(search.searchIndex("crate:foo").isEmpty());
+
+    for (const auto& track : search.searchIndex("")) {
+        EXPECT_EQ(&m_service, track.source);
+    }
+}
+
+TEST_F(StreamingCatalogSearchTest, SearchIndexWithEachFilter) {
+    TrackMetadata acidRain = newTrack("1", "Acid Rain", 124, "8A", "Techno");
+    acidRain.year = 2020;
+    ASSERT_TRUE(m_trackIndex.storeTracks(m_service.serviceId(),
+            {acidRain,
+                    newTrack("2", "Deep Water", 122, "5A", "Deep House"),
+                    newTrack("3", "Half Time", 87, "8A", "Drum & Bass")}));
+    StreamingCatalogSearch search(&m_service, internalCollection());
+
+    // A query that refers to a missing column fails and returns nothing,
+    // so every filter is expected to match at least one track
+    struct FilterQuery {
+        QString queryText;
+        QStringList remoteIds;
+    };
+    const QStringList all = {"1", "2", "3"};
+    // Dates are parsed in the short format of the locale
+    const QString addedSince = QLocale().toString(QDate(2001, 1, 1), QLocale::ShortFormat);
+    const QList<FilterQuery> filterQueries = {
+            {"a:artist", all},
+            {"artist:artist", all},
+            {"aa:\"\"", all},
+            {"album_artist:\"\"", all},
+            {"al:\"\"", all},
+            {"album:\"\"", all},
+            {"t:rain", {"1"}},
+            {"title:rain", {"1"}},
+            {"g:house", {"2"}},
+            {"genre:house", {"2"}},
+            {"cp:\"\"", all},
+            {"composer:\"\"", all},
+            {"gr:\"\"", all},
+            {"grouping:\"\"", all},
+            {"cm:\"\"", all},
+            {"comment:\"\"", all},
+            {"location:\"\"", all},
+            {"dir:\"\"", all},
+            {"directory:\"\"", all},
+            {"type:\"\"", all},
+            {"tr:\"\"", all},
+            {"track:\"\"", all},
+            {"pl:0", all},
+            {"played:0", all},
+            {"r:0", all},
+            {"rating:0", all},
+            {"br:\"\"", all},
+            {"bitrate:\"\"", all},
+            {"id:\"\"", all},
+            {"y:2020", {"1"}},
+            {"year:2020", {"1"}},
+            {"k:5A", {"2"}},
+            {"key:5A", {"2"}},
+            {"b:87", {"3"}},
+            {"bpm:87", {"3"}},
+            {"du:>5:00", all},
+            {"duration:>5:00", all},
+            {"ad:>" + addedSince, all},
+            {"added:>" + addedSince, all},
+            {"dateadded:>" + addedSince, all},
+            {"datetime_added:>" + addedSince, all},
+            {"date_added:>" + addedSince, all},
+    };
+    for (const auto& filterQuery : filterQueries) {
+        EXPECT_EQ(filterQuery.remoteIds,
+                remoteIds(search.searchIndex(filterQuery.queryText)))
+                << filterQuery.queryText.toStdString();
+    }
+}
+
+TEST_F(StreamingCatalogSearchTest, StoreTracksUpdatesExistingEntries) {
+    ASSERT_TRUE(m_trackIndex.storeTracks(m_service.serviceId(),
+            {newTrack("1", "Working Title", 120, "8A", "Techno")}));
+    ASSERT_TRUE(m_trackIndex.storeTracks(m_service.serviceId(),
+            {newTrack("1", "Final Title", 124, "8A", "Techno")}));
+
+    const auto track = m_trackIndex.getTrack(m_service.serviceId(), "1");
+    ASSERT_TRUE(track.has_value());
+    EXPECT_EQ("Final Title", track->title);
+    EXPECT_EQ(124, track->bpm);
+    EXPECT_EQ(360000, track->durationMs);
+
+    EXPECT_EQ(1, m_trackIndex.removeTracksNotSeenSince(
+                         m_service.serviceId(), QDateTime::currentDateTime().addSecs(1)));
+    EXPECT_FALSE(m_trackIndex.getTrack(m_service.serviceId(), "1").has_value());
+}
+
+TEST_F(StreamingCatalogSearchTest, RefreshInBackground) {
+    ASSERT_TRUE(m_trackIndex.storeTracks(m_service.serviceId(),
+            {newTrack("1", "Acid Rain", 124, "8A", "Techno")}));
+
+    const QJsonArray results{
+            QJsonObject{{"id", 1}, {"name", "Acid Rain"}, {"bpm", 124}},
+            QJsonObject{{"id", 2}, {"name", "Acid Test"}, {"bpm", 130}}};
+    MockNetworkReply* pReply = m_network.ExpectGet(
+            "catalog/search",
+            {{"q", "acid"}},
+            200,
+            QJsonDocument(QJsonObject{{"results", results}})
+                    .toJson(QJsonDocument::Compact));
+
+    StreamingCatalogSearch search(&m_service, internalCollection());
+    QVector<TrackMetadata> refreshedTracks;
+    QObject::connect(&search,
+            &StreamingCatalogSearch::resultsRefreshed,
+            [&refreshedTracks](const QString&, const QVector<TrackMetadata>& tracks) {
+                refreshedTracks = tracks;
+            });
+
+    // Answered from the index without waiting for the network
+    EXPECT_EQ(QStringList({"1"}), remoteIds(search.search("acid")));
+    pReply->Done();
+    // The future watcher reports the result asynchronously
+    EXPECT_TRUE(QTest::qWaitFor([&refreshedTracks]() {
+        return !refreshedTracks.isEmpty();
+    }));
+    EXPECT_EQ(QStringList({"1", "2"}), remoteIds(refreshedTracks));
+
+    // Refreshed recently, no further request is sent
+    EXPECT_EQ(QStringList({"1", "2"}), remoteIds(search.search("acid")));
+}
+
+TEST(StreamingCatalogSearchQueryTest, RemoteQueryFor) {
+    const SearchQuery query = StreamingCatalogSearch::remoteQueryFor(
+            "acid title:rain genre:\"Deep House\" ~bpm:120-125 key:8A -foo", 50);
+    EXPECT_EQ("acid rain", query.text);
+    EXPECT_EQ("Deep House", query.genre);
+    EXPECT_EQ("8A", query.key);
+    EXPECT_EQ(120, query.bpmRange.first);
+    EXPECT_EQ(125, query.bpmRange.second);
+    EXPECT_EQ(50, query.limit);
+}
+
+} // anonymous namespace
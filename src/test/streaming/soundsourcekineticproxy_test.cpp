@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <cstring>
+
+#include "sources/soundsourcestream.h"
+#include "test/mixxxtest.h"
+#include "test/soundsourceproviderregistration.h"
+#include "util/samplebuffer.h"
+
+namespace {
+
+constexpr SINT kReadFrameCount = 8192;
+
+class SoundSourceKineticProxyTest : public MixxxTest, SoundSourceProviderRegistration {
+  protected:
+    void SetUp() override {
+        QFile file(getTestDir().filePath(
+                QStringLiteral("id3-test-data/cover-test.wav")));
+        ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+        m_fileData = file.readAll();
+
+        m_pCache = std::make_shared<SparseCache>(m_fileData.size());
+        ASSERT_TRUE(m_pCache->openBackingFile(
+                m_tempDir.filePath(QStringLiteral("track.wav")).toStdString()));
+    }
+
+    // Simulates the download of a byte range
+    void download(int64_t start, int64_t length) {
+        std::memcpy(m_pCache->getWritableData(start, length),
+                m_fileData.constData() + start,
+                length);
+        m_pCache->markCached(start, length);
+    }
+
+    std::shared_ptr<mixxx::SoundSourceStream> openStream() {
+        auto pStream = std::make_shared<mixxx::SoundSourceStream>(
+                m_pCache, QStringLiteral("wav"));
+        if (pStream->open(mixxx::AudioSource::OpenMode::Strict) !=
+                mixxx::AudioSource::OpenResult::Succeeded) {
+            return nullptr;
+        }
+        return pStream;
+    }
+
+    mixxx::ReadableSampleFrames read(
+            mixxx::SoundSourceStream* pStream,
+            SINT firstFrame) {
+        m_buffer = mixxx::SampleBuffer(
+                pStream->getSignalInfo().frames2samples(kReadFrameCount));
+        return pStream->readSampleFrames(mixxx::WritableSampleFrames(
+                mixxx::IndexRange::forward(firstFrame, kReadFrameCount),
+                mixxx::SampleBuffer::WritableSlice(m_buffer)));
+    }
+
+    QTemporaryDir m_tempDir;
+    QByteArray m_fileData;
+    std::shared_ptr<SparseCache> m_pCache;
+    mixxx::SampleBuffer m_buffer;
+};
+
+TEST_F(SoundSourceKineticProxyTest, OpenRequiresHeader) {
+    EXPECT_EQ(nullptr, openStream());
+    download(0, m_fileData.size() / 4);
+    EXPECT_NE(nullptr, openStream());
+}
+
+TEST_F(SoundSourceKineticProxyTest, UnderrunKeepsFrameIndexRange) {
+    const int64_t halfSize = m_fileData.size() / 2;
+    download(0, halfSize);
+    auto pStream = openStream();
+    ASSERT_NE(nullptr, pStream);
+    const auto frameIndexRange = pStream->frameIndexRange();
+
+    // Cached region
+    const auto head = read(pStream.get(), frameIndexRange.start());
+    EXPECT_EQ(kReadFrameCount, head.frameLength());
+    EXPECT_EQ(0, pStream->getUnderrunCount());
+
+    // Missing region
+    const SINT tailFrame = frameIndexRange.end() - kReadFrameCount;
+    const auto tail = read(pStream.get(), tailFrame);
+    EXPECT_TRUE(tail.frameIndexRange().empty());
+    EXPECT_EQ(1, pStream->getUnderrunCount());
+    EXPECT_EQ(kReadFrameCount, pStream->getUnderrunFrameCount());
+    EXPECT_EQ(frameIndexRange, pStream->frameIndexRange());
+    // Tells the CachingReaderWorker to request the chunk again
+    EXPECT_TRUE(pStream->isShortReadTransient());
+    for (SINT i = 0; i < m_buffer.size(); ++i) {
+        ASSERT_EQ(CSAMPLE_ZERO, m_buffer[i]);
+    }
+
+    // The frames become readable after they have been downloaded
+    download(halfSize, m_fileData.size() - halfSize);
+    EXPECT_TRUE(pStream->isFullyCached());
+    EXPECT_EQ(kReadFrameCount, read(pStream.get(), tailFrame).frameLength());
+    EXPECT_FALSE(pStream->isShortReadTransient());
+    EXPECT_EQ(1, pStream->getUnderrunCount());
+}
+
+TEST_F(SoundSourceKineticProxyTest, PartialRead) {
+    download(0, m_fileData.size() / 2);
+    auto pStream = openStream();
+    ASSERT_NE(nullptr, pStream);
+    const auto frameIndexRange = pStream->frameIndexRange();
+
+    const auto cachedFrameRanges = pStream->getCachedFrameRanges();
+    ASSERT_EQ(1, cachedFrameRanges.size());
+    EXPECT_EQ(frameIndexRange.start(), cachedFrameRanges.first().start());
+    const SINT cachedEndFrame = cachedFrameRanges.first().end();
+
+    // Straddles the end of the cached region
+    const auto readable = read(pStream.get(), cachedEndFrame - kReadFrameCount / 2);
+    EXPECT_FALSE(readable.frameIndexRange().empty());
+    EXPECT_LT(readable.frameLength(), kReadFrameCount);
+    EXPECT_EQ(1, pStream->getUnderrunCount());
+    EXPECT_EQ(kReadFrameCount - readable.frameLength(),
+            pStream->getUnderrunFrameCount());
+    EXPECT_EQ(frameIndexRange, pStream->frameIndexRange());
+}
+
+} // anonymous namespace
@@ -1677,6 +1677,24 @@ bool Track::exportSeratoMetadata() {
     return true;
 }
 
+// static
+bool Track::isProvisionalSubVersion(const QString& subVersion) {
+    // See BeatFactory::getPreferredSubVersion()
+    return subVersion.split(QChar('|')).contains(QStringLiteral("preview=1"));
+}
+
+void Track::keepProvisionalResultsOutOfExport(
+        mixxx::TrackMetadata* pExportMetadata,
+        const mixxx::TrackMetadata& fileMetadata) const {
+    // The full analysis replaces them soon and is exported then
+    if (m_pBeats && isProvisionalSubVersion(m_pBeats->getSubVersion())) {
+        pExportMetadata->refTrackInfo().setBpm(fileMetadata.getTrackInfo().getBpm());
+    }
+    if (isProvisionalSubVersion(m_record.getKeys().getSubVersion())) {
+        pExportMetadata->refTrackInfo().setKeyText(fileMetadata.getTrackInfo().getKeyText());
+    }
+}
+
 ExportTrackMetadataResult Track::exportMetadata(
         const mixxx::MetadataSource& metadataSource,
         const SyncTrackMetadataParams& syncParams) {
@@ -1798,6 +1816,8 @@ ExportTrackMetadataResult Track::exportMetadata(
             }
         }
 
+        keepProvisionalResultsOutOfExport(&normalizedFromRecord, importedFromFile);
+
         // Finally the track's current metadata and the imported/adjusted metadata
         // can be compared for differences to decide whether the tags in the file
         // would change if we perform the write operation. This function will also
@@ -1835,6 +1855,7 @@ ExportTrackMetadataResult Track::exportMetadata(
             // Prepare export by cloning and normalizing the metadata
             normalizedFromRecord = m_record.getMetadata();
             normalizedFromRecord.normalizeBeforeExport();
+            keepProvisionalResultsOutOfExport(&normalizedFromRecord, importedFromFile);
         } else {
             kLogger.warning()
                     << "Skip exporting of track metadata after failure to import tags from file:"
@@ -289,6 +289,11 @@ class Track : public QObject {
     /// kArtistTitleSeparator.
     QString getInfo() const;
 
+    /// Provisional beats and keys, see AnalyzerPreview, are marked by a
+    /// "preview=1" fragment in their sub-version. They are never exported
+    /// into file tags.
+    static bool isProvisionalSubVersion(const QString& subVersion);
+
     /// The filename if BOTH artist AND title are empty, e.g. for tracks without
     /// any metadata in file tags. Otherwise just the title (even if it is empty).
     QString getTitleInfo() const;
@@ -595,6 +600,10 @@ class Track : public QObject {
     ExportTrackMetadataResult exportMetadata(
             const mixxx::MetadataSource& metadataSource,
             const SyncTrackMetadataParams& syncParams);
+    /// Replaces a provisional BPM and key with the values of the file tags
+    void keepProvisionalResultsOutOfExport(
+            mixxx::TrackMetadata* pExportMetadata,
+            const mixxx::TrackMetadata& fileMetadata) const;
     void updateStreamInfoFromSource(
             mixxx::audio::StreamInfo&& streamInfo);
 
@@ -240,6 +240,16 @@ bool CmdlineArgs::parse(const QStringList& arguments, CmdlineArgs::ParseMode mod
     parser.addOption(timelinePath);
     parser.addOption(timelinePathDeprecated);
 
+    const QCommandLineOption renderAutoDj(QStringLiteral("render-autodj"),
+            forUserFeedback ? QCoreApplication::translate("CmdlineArgs",
+                                      "Renders the Auto DJ queue to the given audio file "
+                                      "faster than real time and exits. The format is "
+                                      "chosen by the file extension (wav, flac, aiff, "
+                                      "ogg, mp3 or opus).")
+                            : QString(),
+            QStringLiteral("file"));
+    parser.addOption(renderAutoDj);
+
     const QCommandLineOption enableLegacyVuMeter(QStringLiteral("enable-legacy-vumeter"),
             forUserFeedback ? QCoreApplication::translate("CmdlineArgs",
                                       "Use legacy vu meter")
@@ -472,6 +482,10 @@ bool CmdlineArgs::parse(const QStringList& arguments, CmdlineArgs::ParseMode mod
         m_timelinePath = parser.value(timelinePathDeprecated);
     }
 
+    if (parser.isSet(renderAutoDj)) {
+        m_renderAutoDjPath = parser.value(renderAutoDj);
+    }
+
     m_useLegacyVuMeter = parser.isSet(enableLegacyVuMeter);
     m_useLegacySpinny = parser.isSet(enableLegacySpinny);
     m_controllerDebug = parser.isSet(controllerDebug) || parser.isSet(controllerDebugDeprecated);
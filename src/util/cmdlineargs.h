@@ -79,6 +79,12 @@ class CmdlineArgs final {
     }
     const QString& getResourcePath() const { return m_resourcePath; }
     const QString& getTimelinePath() const { return m_timelinePath; }
+    bool getRenderAutoDjEnabled() const {
+        return !m_renderAutoDjPath.isEmpty();
+    }
+    const QString& getRenderAutoDjPath() const {
+        return m_renderAutoDjPath;
+    }
 
     const QString& getStyle() const {
         return m_styleName;
@@ -126,5 +132,6 @@ class CmdlineArgs final {
     QString m_settingsPath;
     QString m_resourcePath;
     QString m_timelinePath;
+    QString m_renderAutoDjPath;
     QString m_styleName;
 };
@@ -1,37 +1,77 @@
 #pragma once
 
-#include "pa_ringbuffer.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
 
 #include "util/class.h"
 #include "util/math.h"
 
-template <class DataType>
+/// Lock-free ring buffer for a single producer and a single consumer thread,
+/// e.g. the engine callback and a worker.
+///
+/// The read and write index are placed on separate cache lines together with
+/// a cached copy of the index of the opposite side. The shared index of the
+/// other thread is only loaded if the cached copy indicates that the buffer
+/// is full or empty, so both sides rarely touch the same cache line.
+///
+/// Besides copying, the producer and the consumer can access the buffer
+/// directly through up to two contiguous regions (zero-copy).
+template<class DataType>
 class FIFO {
   public:
     explicit FIFO(int size)
-            : m_data(roundUpToPowerOf2(size)) {
-        // If we can't represent the next higher power of 2 then bail.
-        if (m_data.size() == 0) {
-            return;
-        }
-        PaUtil_InitializeRingBuffer(&m_ringBuffer,
-                static_cast<ring_buffer_size_t>(sizeof(DataType)),
-                static_cast<ring_buffer_size_t>(m_data.size()),
-                m_data.data());
+            : m_data(roundUpToPowerOf2(size)),
+              m_mask(static_cast<std::uint32_t>(m_data.size()) - 1),
+              m_writeIndex(0),
+              m_cachedReadIndex(0),
+              m_readIndex(0),
+              m_cachedWriteIndex(0) {
+        // If we can't represent the next higher power of 2 the
+        // capacity is 0 and nothing can be written.
     }
     virtual ~FIFO() {
     }
+
+    int capacity() const {
+        return static_cast<int>(m_data.size());
+    }
+
     int readAvailable() const {
-        return PaUtil_GetRingBufferReadAvailable(&m_ringBuffer);
+        return static_cast<int>(m_writeIndex.load(std::memory_order_acquire) -
+                m_readIndex.load(std::memory_order_relaxed));
     }
     int writeAvailable() const {
-        return PaUtil_GetRingBufferWriteAvailable(&m_ringBuffer);
+        return capacity() -
+                static_cast<int>(m_writeIndex.load(std::memory_order_relaxed) -
+                        m_readIndex.load(std::memory_order_acquire));
     }
+
+    /// Consumer
     int read(DataType* pData, int count) {
-        return PaUtil_ReadRingBuffer(&m_ringBuffer, pData, count);
+        DataType* pRegion1;
+        int size1;
+        DataType* pRegion2;
+        int size2;
+        const int readCount = aquireReadRegions(count, &pRegion1, &size1, &pRegion2, &size2);
+        std::copy(pRegion1, pRegion1 + size1, pData);
+        std::copy(pRegion2, pRegion2 + size2, pData + size1);
+        releaseReadRegions(readCount);
+        return readCount;
     }
+
+    /// Producer
     int write(const DataType* pData, int count) {
-        return PaUtil_WriteRingBuffer(&m_ringBuffer, pData, count);
+        DataType* pRegion1;
+        int size1;
+        DataType* pRegion2;
+        int size2;
+        const int writeCount = aquireWriteRegions(count, &pRegion1, &size1, &pRegion2, &size2);
+        std::copy(pData, pData + size1, pRegion1);
+        std::copy(pData + size1, pData + size1 + size2, pRegion2);
+        releaseWriteRegions(writeCount);
+        return writeCount;
     }
     void writeBlocking(const DataType* pData, int count) {
         int written = 0;
@@ -39,31 +79,105 @@ class FIFO {
             written += write(pData + written, count - written);
         }
     }
+
+    /// Producer: Returns the number of elements that can be written into the
+    /// regions, at most count. The second region is only used if the
+    /// writable elements wrap around the end of the buffer.
     int aquireWriteRegions(int count,
-            DataType** dataPtr1, ring_buffer_size_t* sizePtr1,
-            DataType** dataPtr2, ring_buffer_size_t* sizePtr2) {
-        return PaUtil_GetRingBufferWriteRegions(&m_ringBuffer, count,
-                (void**)dataPtr1, sizePtr1, (void**)dataPtr2, sizePtr2);
+            DataType** dataPtr1,
+            int* sizePtr1,
+            DataType** dataPtr2,
+            int* sizePtr2) {
+        const std::uint32_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+        int available = capacity() - static_cast<int>(writeIndex - m_cachedReadIndex);
+        if (available < count) {
+            m_cachedReadIndex = m_readIndex.load(std::memory_order_acquire);
+            available = capacity() - static_cast<int>(writeIndex - m_cachedReadIndex);
+        }
+        return getRegions(writeIndex,
+                math_min(math_max(count, 0), available),
+                dataPtr1,
+                sizePtr1,
+                dataPtr2,
+                sizePtr2);
     }
     int releaseWriteRegions(int count) {
-        return PaUtil_AdvanceRingBufferWriteIndex(&m_ringBuffer, count);
+        const std::uint32_t writeIndex =
+                m_writeIndex.load(std::memory_order_relaxed) +
+                static_cast<std::uint32_t>(count);
+        m_writeIndex.store(writeIndex, std::memory_order_release);
+        return static_cast<int>(writeIndex & m_mask);
     }
+
+    /// Consumer: Returns the number of elements that can be read from the
+    /// regions, at most count.
     int aquireReadRegions(int count,
-            DataType** dataPtr1, ring_buffer_size_t* sizePtr1,
-            DataType** dataPtr2, ring_buffer_size_t* sizePtr2) {
-        return PaUtil_GetRingBufferReadRegions(&m_ringBuffer, count,
-                (void**)dataPtr1, sizePtr1, (void**)dataPtr2, sizePtr2);
+            DataType** dataPtr1,
+            int* sizePtr1,
+            DataType** dataPtr2,
+            int* sizePtr2) {
+        const std::uint32_t readIndex = m_readIndex.load(std::memory_order_relaxed);
+        int available = static_cast<int>(m_cachedWriteIndex - readIndex);
+        if (available < count) {
+            m_cachedWriteIndex = m_writeIndex.load(std::memory_order_acquire);
+            available = static_cast<int>(m_cachedWriteIndex - readIndex);
+        }
+        return getRegions(readIndex,
+                math_min(math_max(count, 0), available),
+                dataPtr1,
+                sizePtr1,
+                dataPtr2,
+                sizePtr2);
     }
     int releaseReadRegions(int count) {
-        return PaUtil_AdvanceRingBufferReadIndex(&m_ringBuffer, count);
+        const std::uint32_t readIndex =
+                m_readIndex.load(std::memory_order_relaxed) +
+                static_cast<std::uint32_t>(count);
+        m_readIndex.store(readIndex, std::memory_order_release);
+        return static_cast<int>(readIndex & m_mask);
     }
     int flushReadData(int count) {
         int flush = math_min(readAvailable(), count);
-        return PaUtil_AdvanceRingBufferReadIndex(&m_ringBuffer, flush);
+        return releaseReadRegions(flush);
     }
 
   private:
+    // Avoid false sharing between the producer and the consumer
+    static constexpr std::size_t kCacheLineSize = 64;
+
+    int getRegions(std::uint32_t index,
+            int count,
+            DataType** dataPtr1,
+            int* sizePtr1,
+            DataType** dataPtr2,
+            int* sizePtr2) {
+        const int offset = static_cast<int>(index & m_mask);
+        if (offset + count > capacity()) {
+            // Wrap around the end of the buffer
+            const int size1 = capacity() - offset;
+            *dataPtr1 = m_data.data() + offset;
+            *sizePtr1 = size1;
+            *dataPtr2 = m_data.data();
+            *sizePtr2 = count - size1;
+        } else {
+            *dataPtr1 = m_data.data() + offset;
+            *sizePtr1 = count;
+            *dataPtr2 = nullptr;
+            *sizePtr2 = 0;
+        }
+        return count;
+    }
+
     std::vector<DataType> m_data;
-    PaUtilRingBuffer m_ringBuffer;
+    const std::uint32_t m_mask;
+
+    // The indices are running freely, only the lower bits are used for
+    // addressing. Owned by the producer.
+    alignas(kCacheLineSize) std::atomic<std::uint32_t> m_writeIndex;
+    std::uint32_t m_cachedReadIndex;
+    // Owned by the consumer
+    alignas(kCacheLineSize) std::atomic<std::uint32_t> m_readIndex;
+    std::uint32_t m_cachedWriteIndex;
+
     DISALLOW_COPY_AND_ASSIGN(FIFO);
 };
@@ -21,6 +21,26 @@ typedef qint32 int32_t;
 // "SINT i" is the preferred loop index type that should allow vectorization in
 // general. Unfortunately there are exceptions where "int i" is required for some reasons.
 
+// Distribution packages are built for a baseline CPU, e.g. SSE2 on x86-64. The
+// vectorized kernels below are additionally compiled for AVX2 and AVX-512 and
+// the dynamic linker picks the best clone for the running CPU at startup
+// (function multiversioning via GNU ifunc). This requires GCC or Clang >= 14
+// on Linux. macOS and Windows builds keep the baseline, NEON is the baseline
+// on aarch64.
+// All clones must produce identical results. This file is compiled with
+// -ffp-contract=off, because the AVX-512 clone could otherwise use FMA.
+// Sums are not multiversioned, because -ffast-math allows the compiler to
+// reorder the additions differently for each vector width.
+#if (!defined(__clang__) || __clang_major__ >= 14) && defined(__GNUC__) && \
+        defined(__x86_64__) && defined(__ELF__) && defined(__GLIBC__) &&  \
+        !defined(__AVX2__)
+#define SAMPLE_UTIL_MULTIVERSION_ENABLED
+#define SAMPLE_UTIL_MULTIVERSION \
+    __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define SAMPLE_UTIL_MULTIVERSION
+#endif
+
 namespace {
 
 #ifdef __AVX__
@@ -111,6 +131,32 @@ void SampleUtil::free(CSAMPLE* pBuffer) {
 }
 
 // static
+const char* SampleUtil::vectorInstructionSet() {
+#ifdef SAMPLE_UTIL_MULTIVERSION_ENABLED
+    if (__builtin_cpu_supports("avx512f")) {
+        return "avx512f";
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return "avx2";
+    }
+    return "default";
+#elif defined(__AVX512F__)
+    return "avx512f";
+#elif defined(__AVX2__)
+    return "avx2";
+#elif defined(__AVX__)
+    return "avx";
+#elif defined(__SSE2__) || defined(_M_X64)
+    return "sse2";
+#elif defined(__ARM_NEON)
+    return "neon";
+#else
+    return "default";
+#endif
+}
+
+// static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::applyGain(CSAMPLE* pBuffer, CSAMPLE_GAIN gain,
         SINT numSamples) {
     if (gain == CSAMPLE_GAIN_ONE) {
@@ -128,6 +174,7 @@ void SampleUtil::applyGain(CSAMPLE* pBuffer, CSAMPLE_GAIN gain,
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::applyRampingGain(CSAMPLE* pBuffer, CSAMPLE_GAIN old_gain,
         CSAMPLE_GAIN new_gain, SINT numSamples) {
     if (old_gain == CSAMPLE_GAIN_ONE && new_gain == CSAMPLE_GAIN_ONE) {
@@ -175,6 +222,7 @@ CSAMPLE SampleUtil::copyWithRampingNormalization(CSAMPLE* pDest,
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::applyAlternatingGain(CSAMPLE* pBuffer, CSAMPLE gain1,
         CSAMPLE gain2, SINT numSamples) {
     // This handles gain1 == CSAMPLE_GAIN_ONE && gain2 == CSAMPLE_GAIN_ONE as well.
@@ -232,6 +280,7 @@ void SampleUtil::applyRampingAlternatingGain(CSAMPLE* pBuffer,
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::add(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc,
         SINT numSamples) {
@@ -242,6 +291,7 @@ void SampleUtil::add(CSAMPLE* M_RESTRICT pDest,
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::addWithGain(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc,
         CSAMPLE_GAIN gain, SINT numSamples) {
@@ -255,6 +305,7 @@ void SampleUtil::addWithGain(CSAMPLE* M_RESTRICT pDest,
     }
 }
 
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::addWithRampingGain(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc,
         CSAMPLE_GAIN old_gain, CSAMPLE_GAIN new_gain,
@@ -282,6 +333,7 @@ void SampleUtil::addWithRampingGain(CSAMPLE* M_RESTRICT pDest,
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::add2WithGain(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc1, CSAMPLE_GAIN gain1,
         const CSAMPLE* M_RESTRICT pSrc2, CSAMPLE_GAIN gain2,
@@ -301,6 +353,7 @@ void SampleUtil::add2WithGain(CSAMPLE* M_RESTRICT pDest,
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::add3WithGain(CSAMPLE* pDest,
         const CSAMPLE* M_RESTRICT pSrc1, CSAMPLE_GAIN gain1,
         const CSAMPLE* M_RESTRICT pSrc2, CSAMPLE_GAIN gain2,
@@ -324,6 +377,7 @@ void SampleUtil::add3WithGain(CSAMPLE* pDest,
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::copyWithGain(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc,
         CSAMPLE_GAIN gain, SINT numSamples) {
@@ -347,6 +401,7 @@ void SampleUtil::copyWithGain(CSAMPLE* M_RESTRICT pDest,
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::copyWithRampingGain(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc,
         CSAMPLE_GAIN old_gain,
@@ -384,6 +439,7 @@ void SampleUtil::copyWithRampingGain(CSAMPLE* M_RESTRICT pDest,
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::convertS16ToFloat32(CSAMPLE* M_RESTRICT pDest,
         const SAMPLE* M_RESTRICT pSrc, SINT numSamples) {
     // SAMPLE_MIN = -32768 is a valid low sample, whereas SAMPLE_MAX = 32767
@@ -398,6 +454,7 @@ void SampleUtil::convertS16ToFloat32(CSAMPLE* M_RESTRICT pDest,
 }
 
 //static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::convertFloat32ToS16(SAMPLE* pDest, const CSAMPLE* pSrc,
         SINT numSamples) {
     // We use here -SAMPLE_MINIMUM for a perfect round trip with convertS16ToFloat32
@@ -460,6 +517,7 @@ CSAMPLE SampleUtil::rms(const CSAMPLE* pBuffer, SINT numSamples) {
     return sqrtf(sumSquared(pBuffer, numSamples) / numSamples);
 }
 
+SAMPLE_UTIL_MULTIVERSION
 CSAMPLE SampleUtil::maxAbsAmplitude(const CSAMPLE* pBuffer, SINT numSamples) {
     CSAMPLE max = pBuffer[0];
     // note: LOOP VECTORIZED.
@@ -473,6 +531,7 @@ CSAMPLE SampleUtil::maxAbsAmplitude(const CSAMPLE* pBuffer, SINT numSamples) {
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::copyClampBuffer(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc, SINT iNumSamples) {
     // note: LOOP VECTORIZED.
@@ -554,6 +613,7 @@ void SampleUtil::deinterleaveBuffer(CSAMPLE* M_RESTRICT pDest1,
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::linearCrossfadeStereoBuffersOut(
         CSAMPLE* M_RESTRICT pDestSrcFadeOut,
         const CSAMPLE* M_RESTRICT pSrcFadeIn,
@@ -576,6 +636,7 @@ void SampleUtil::linearCrossfadeStereoBuffersOut(
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::linearCrossfadeStemBuffersOut(
         CSAMPLE* M_RESTRICT pDestSrcFadeOut,
         const CSAMPLE* M_RESTRICT pSrcFadeIn,
@@ -605,6 +666,7 @@ void SampleUtil::linearCrossfadeStemBuffersOut(
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::linearCrossfadeBuffersOut(
         CSAMPLE* pDestSrcFadeOut,
         const CSAMPLE* pSrcFadeIn,
@@ -643,6 +705,7 @@ void SampleUtil::linearCrossfadeBuffersOut(
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::linearCrossfadeStereoBuffersIn(
         CSAMPLE* M_RESTRICT pDestSrcFadeIn,
         const CSAMPLE* M_RESTRICT pSrcFadeOut,
@@ -664,6 +727,7 @@ void SampleUtil::linearCrossfadeStereoBuffersIn(
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::linearCrossfadeStemBuffersIn(
         CSAMPLE* M_RESTRICT pDestSrcFadeIn,
         const CSAMPLE* M_RESTRICT pSrcFadeOut,
@@ -693,6 +757,7 @@ void SampleUtil::linearCrossfadeStemBuffersIn(
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::linearCrossfadeBuffersIn(
         CSAMPLE* pDestSrcFadeIn,
         const CSAMPLE* pSrcFadeOut,
@@ -754,6 +819,7 @@ void SampleUtil::mixStereoToMono(CSAMPLE* pBuffer, SINT numSamples) {
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::mixMultichannelToMono(CSAMPLE* pDest, const CSAMPLE* pSrc, SINT numSamples) {
     auto chCount = mixxx::kEngineChannelOutputCount.value();
     const CSAMPLE_GAIN mixScale = CSAMPLE_GAIN_ONE / (CSAMPLE_GAIN_ONE * chCount);
@@ -768,6 +834,7 @@ void SampleUtil::mixMultichannelToMono(CSAMPLE* pDest, const CSAMPLE* pSrc, SINT
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::mixMultichannelToStereo(CSAMPLE* pDest,
         const CSAMPLE* pSrc,
         SINT numFrames,
@@ -796,6 +863,7 @@ void SampleUtil::mixMultichannelToStereo(CSAMPLE* pDest,
 }
 
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::mixMultichannelToStereo(CSAMPLE* pDest,
         const CSAMPLE* pSrc,
         SINT numFrames,
@@ -941,6 +1009,7 @@ void SampleUtil::copyReverse(CSAMPLE* M_RESTRICT pDest,
     }
 }
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::copy1WithGain(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc0,
         CSAMPLE_GAIN gain0,
@@ -955,6 +1024,7 @@ void SampleUtil::copy1WithGain(CSAMPLE* M_RESTRICT pDest,
     }
 }
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::copy1WithRampingGain(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc0,
         CSAMPLE_GAIN gain0in,
@@ -974,6 +1044,7 @@ void SampleUtil::copy1WithRampingGain(CSAMPLE* M_RESTRICT pDest,
     }
 }
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::copy2WithGain(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc0,
         CSAMPLE_GAIN gain0,
@@ -995,6 +1066,7 @@ void SampleUtil::copy2WithGain(CSAMPLE* M_RESTRICT pDest,
     }
 }
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::copy2WithRampingGain(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc0,
         CSAMPLE_GAIN gain0in,
@@ -1026,6 +1098,7 @@ void SampleUtil::copy2WithRampingGain(CSAMPLE* M_RESTRICT pDest,
     }
 }
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::copy3WithGain(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc0,
         CSAMPLE_GAIN gain0,
@@ -1054,6 +1127,7 @@ void SampleUtil::copy3WithGain(CSAMPLE* M_RESTRICT pDest,
     }
 }
 // static
+SAMPLE_UTIL_MULTIVERSION
 void SampleUtil::copy3WithRampingGain(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc0,
         CSAMPLE_GAIN gain0in,
@@ -32,6 +32,10 @@ class SampleUtil {
     // Frees a 16-byte aligned buffer allocated by SampleUtil::alloc()
     static void free(CSAMPLE* pBuffer);
 
+    // The instruction set of the vectorized functions that has been selected
+    // for the running CPU, e.g. "avx2"
+    static const char* vectorInstructionSet();
+
     // Sets every sample in pBuffer to zero
     inline
     static void clear(CSAMPLE* pBuffer, SINT numSamples) {
@@ -326,4 +326,38 @@ void drawWaveformPartHSV(
     }
 }
 
+void drawMissingRanges(
+        QPainter* pPainter,
+        const QVector<QPair<double, double>>& cachedRanges,
+        const QRectF& rect,
+        Qt::Orientation orientation,
+        const QColor& color) {
+    const bool horizontal = orientation == Qt::Horizontal;
+    const double origin = horizontal ? rect.left() : rect.top();
+    const double length = horizontal ? rect.width() : rect.height();
+
+    const auto fillGap = [&](double start, double end) {
+        if (end <= start) {
+            return;
+        }
+        const double gapStart = origin + start * length;
+        const double gapLength = (end - start) * length;
+        if (horizontal) {
+            pPainter->fillRect(QRectF(gapStart, rect.top(), gapLength, rect.height()),
+                    QBrush(color, Qt::BDiagPattern));
+        } else {
+            pPainter->fillRect(QRectF(rect.left(), gapStart, rect.width(), gapLength),
+                    QBrush(color, Qt::BDiagPattern));
+        }
+    };
+
+    // The ranges are sorted and disjoint
+    double position = 0.0;
+    for (const auto& range : cachedRanges) {
+        fillGap(position, math_clamp(range.first, 0.0, 1.0));
+        position = math_max(position, math_clamp(range.second, 0.0, 1.0));
+    }
+    fillGap(position, 1.0);
+}
+
 } // namespace waveformOverviewRenderer
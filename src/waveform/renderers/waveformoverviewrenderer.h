@@ -6,6 +6,7 @@
 #include "waveform/waveform.h"
 
 class QPainter;
+class QRectF;
 class WaveformSignalColors;
 
 namespace waveformOverviewRenderer {
@@ -41,4 +42,14 @@ void drawWaveformPartHSV(
         int end,
         const WaveformSignalColors& signalColors,
         bool mono = false);
+
+/// Shades the parts of rect that are not covered by cachedRanges, i.e. the
+/// parts of a partially downloaded track the waveform has no data for yet.
+/// The ranges are [start, end) fractions of the track duration.
+void drawMissingRanges(
+        QPainter* pPainter,
+        const QVector<QPair<double, double>>& cachedRanges,
+        const QRectF& rect,
+        Qt::Orientation orientation,
+        const QColor& color);
 } // namespace waveformOverviewRenderer
@@ -3,8 +3,10 @@
 #include <QAtomicInt>
 #include <QByteArray>
 #include <QMutex>
+#include <QPair>
 #include <QSharedPointer>
 #include <QString>
+#include <QVector>
 #include <vector>
 
 #include "analyzer/constants.h"
@@ -79,6 +81,20 @@ class Waveform {
         m_description = description;
     }
 
+    // The parts of the track, as [start, end) fractions of its duration,
+    // that the waveform has been computed from so far. Empty if the waveform
+    // is not restricted to parts of the track, i.e. unless it is built from
+    // a partially downloaded stream.
+    QVector<QPair<double, double>> getCachedRanges() const {
+        const auto locker = lockMutex(&m_mutex);
+        return m_cachedRanges;
+    }
+
+    void setCachedRanges(const QVector<QPair<double, double>>& cachedRanges) {
+        const auto locker = lockMutex(&m_mutex);
+        m_cachedRanges = cachedRanges;
+    }
+
     QByteArray toByteArray() const;
 
     SaveState saveState() const {
@@ -157,6 +173,7 @@ class Waveform {
     mutable SaveState m_saveState;
     QString m_version;
     QString m_description;
+    QVector<QPair<double, double>> m_cachedRanges;
 
     // The size of the waveform data stored in m_data. Not allowed to change
     // after the constructor runs.
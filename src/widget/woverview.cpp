@@ -7,6 +7,8 @@
 #include <QPainter>
 #include <QPen>
 #include <QVBoxLayout>
+#include <algorithm>
+#include <cmath>
 
 #include "analyzer/analyzerprogress.h"
 #include "control/controlproxy.h"
@@ -325,16 +327,31 @@ void WOverview::slotWaveformSummaryUpdated() {
     }
     m_pWaveform = pTrack->getWaveformSummary();
     if (m_pWaveform) {
-        // If the waveform is already complete, just draw it.
-        if (m_pWaveform->getCompletion() == m_pWaveform->getDataSize()) {
-            m_actualCompletion = 0;
-            if (drawNextPixmapPart()) {
+        const auto cachedRanges = m_pWaveform->getCachedRanges();
+        if (!cachedRanges.isEmpty()) {
+            // A streamed track whose waveform is built from the downloaded
+            // parts. Only the parts that are new are drawn.
+            if (drawNewCachedRanges(cachedRanges)) {
                 update();
             }
+        } else if (m_pWaveform->getCompletion() == m_pWaveform->getDataSize()) {
+            // If the waveform is already complete, just draw it.
+            if (!m_drawnVisualPairs.isEmpty()) {
+                // The remaining parts of a streamed track
+                if (drawNewCachedRanges({qMakePair(0.0, 1.0)})) {
+                    update();
+                }
+            } else {
+                m_actualCompletion = 0;
+                if (drawNextPixmapPart()) {
+                    update();
+                }
+            }
         }
     } else {
         // Null waveform pointer means waveform was cleared.
         m_waveformSourceImage = QImage();
+        m_drawnVisualPairs.clear();
         m_analyzerProgress = kAnalyzerProgressUnknown;
         m_actualCompletion = 0;
         m_waveformPeak = -1.0;
@@ -383,6 +400,7 @@ void WOverview::slotLoadingTrack(TrackPointer pNewTrack, TrackPointer pOldTrack)
     }
 
     m_waveformSourceImage = QImage();
+    m_drawnVisualPairs.clear();
     m_analyzerProgress = kAnalyzerProgressUnknown;
     m_actualCompletion = 0;
     m_waveformPeak = -1.0;
@@ -463,6 +481,7 @@ void WOverview::slotTypeControlChanged(double v) {
     m_type = type;
     m_pWaveform.clear();
     m_waveformSourceImage = QImage();
+    m_drawnVisualPairs.clear();
     slotWaveformSummaryUpdated();
 }
 
@@ -697,6 +716,7 @@ void WOverview::paintEvent(QPaintEvent* pEvent) {
         drawEndOfTrackBackground(&painter);
         drawAxis(&painter);
         drawWaveformPixmap(&painter);
+        drawCacheCoverage(&painter);
         drawPlayedOverlay(&painter);
         drawMinuteMarkers(&painter);
         drawPlayPosition(&painter);
@@ -842,6 +862,23 @@ void WOverview::drawMinuteMarkers(QPainter* pPainter) {
     }
 }
 
+void WOverview::drawCacheCoverage(QPainter* pPainter) {
+    if (!m_pWaveform) {
+        return;
+    }
+    const auto cachedRanges = m_pWaveform->getCachedRanges();
+    if (cachedRanges.isEmpty()) {
+        return;
+    }
+    PainterScope painterScope(pPainter);
+    pPainter->setOpacity(0.5);
+    waveformOverviewRenderer::drawMissingRanges(pPainter,
+            cachedRanges,
+            QRectF(rect()),
+            m_orientation,
+            m_axesColor);
+}
+
 void WOverview::drawPlayedOverlay(QPainter* pPainter) {
     // Overlay the played part of the overview-waveform with a skin defined color
     if (!m_waveformSourceImage.isNull() && m_playedOverlayColor.alpha() > 0) {
@@ -1419,18 +1456,7 @@ bool WOverview::drawNextPixmapPart() {
     }
 
     if (m_waveformSourceImage.isNull()) {
-        // Waveform pixmap twice the height of the viewport to be scalable
-        // by total_gain
-        // We keep full range waveform data to scale it on paint
-        m_waveformSourceImage = QImage(
-                static_cast<int>(trackSamples / audioVisualRatio / 2) + 1,
-                2 * 255,
-                QImage::Format_ARGB32_Premultiplied);
-        m_waveformSourceImage.fill(QColor(0, 0, 0, 0).value());
-        if (dataSize / 2 != m_waveformSourceImage.width()) {
-            qWarning() << "Track duration has changed since last analysis"
-                       << m_waveformSourceImage.width() << "!=" << dataSize / 2;
-        }
+        createWaveformSourceImage(pWaveform);
     }
     DEBUG_ASSERT(!m_waveformSourceImage.isNull());
 
@@ -1455,49 +1481,126 @@ bool WOverview::drawNextPixmapPart() {
 
     QPainter painter(&m_waveformSourceImage);
     painter.translate(0.0, static_cast<double>(m_waveformSourceImage.height()) / 2.0);
+    drawWaveformPart(&painter, pWaveform, m_actualCompletion, nextCompletion);
+    m_actualCompletion = nextCompletion;
+
+    m_waveformImageScaled = QImage();
+    m_diffGain = 0;
+
+    // Test if the complete waveform is done
+    if (m_actualCompletion >= dataSize - 2) {
+        m_pixmapDone = true;
+    }
+
+    return true;
+}
+
+bool WOverview::drawNewCachedRanges(const QVector<QPair<double, double>>& cachedRanges) {
+    ConstWaveformPointer pWaveform = getWaveform();
+    if (!pWaveform) {
+        return false;
+    }
+    const int dataSize = pWaveform->getDataSize();
+    if (dataSize <= 0 || pWaveform->getAudioVisualRatio() <= 0 || getTrackSamples() <= 0) {
+        return false;
+    }
+    if (m_waveformSourceImage.isNull()) {
+        createWaveformSourceImage(pWaveform);
+        m_drawnVisualPairs.clear();
+    }
+    const int pairCount = dataSize / 2;
+    if (m_drawnVisualPairs.size() != pairCount) {
+        m_drawnVisualPairs = QBitArray(pairCount);
+    }
+
+    QPainter painter(&m_waveformSourceImage);
+    painter.translate(0.0, static_cast<double>(m_waveformSourceImage.height()) / 2.0);
+    bool drawn = false;
+    for (const auto& range : cachedRanges) {
+        // Pixels at the edges of a range may lack data
+        const int firstPair = std::clamp(
+                static_cast<int>(std::ceil(range.first * pairCount)), 0, pairCount);
+        const int endPair = std::clamp(
+                static_cast<int>(range.second * pairCount), 0, pairCount);
+        int pair = firstPair;
+        while (pair < endPair) {
+            if (m_drawnVisualPairs.testBit(pair)) {
+                ++pair;
+                continue;
+            }
+            const int startPair = pair;
+            while (pair < endPair && !m_drawnVisualPairs.testBit(pair)) {
+                m_drawnVisualPairs.setBit(pair);
+                ++pair;
+            }
+            drawWaveformPart(&painter, pWaveform, 2 * startPair, 2 * pair);
+            drawn = true;
+        }
+    }
+    if (!drawn) {
+        return false;
+    }
 
+    m_waveformImageScaled = QImage();
+    m_diffGain = 0;
+    if (m_drawnVisualPairs.count(true) == pairCount) {
+        // Nothing is left for drawNextPixmapPart()
+        m_actualCompletion = dataSize;
+        m_pixmapDone = true;
+    }
+    return true;
+}
+
+void WOverview::createWaveformSourceImage(const ConstWaveformPointer& pWaveform) {
+    const int dataSize = pWaveform->getDataSize();
+    // Waveform pixmap twice the height of the viewport to be scalable
+    // by total_gain
+    // We keep full range waveform data to scale it on paint
+    m_waveformSourceImage = QImage(
+            static_cast<int>(getTrackSamples() / pWaveform->getAudioVisualRatio() / 2) + 1,
+            2 * 255,
+            QImage::Format_ARGB32_Premultiplied);
+    m_waveformSourceImage.fill(QColor(0, 0, 0, 0).value());
+    if (dataSize / 2 != m_waveformSourceImage.width()) {
+        qWarning() << "Track duration has changed since last analysis"
+                   << m_waveformSourceImage.width() << "!=" << dataSize / 2;
+    }
+}
+
+void WOverview::drawWaveformPart(QPainter* pPainter,
+        const ConstWaveformPointer& pWaveform,
+        int start,
+        int end) {
     // Evaluate waveform ratio peak
-    for (int currentCompletion = m_actualCompletion;
-            currentCompletion < nextCompletion;
-            currentCompletion += 2) {
+    for (int visualIndex = start; visualIndex < end; visualIndex += 2) {
         m_waveformPeak = math_max3(
                 m_waveformPeak,
-                static_cast<float>(pWaveform->getAll(currentCompletion)),
-                static_cast<float>(pWaveform->getAll(currentCompletion + 1)));
+                static_cast<float>(pWaveform->getAll(visualIndex)),
+                static_cast<float>(pWaveform->getAll(visualIndex + 1)));
     }
 
     if (m_type == OverviewType::Filtered) {
         waveformOverviewRenderer::drawWaveformPartLMH(
-                &painter,
+                pPainter,
                 pWaveform,
-                &m_actualCompletion,
-                nextCompletion,
+                &start,
+                end,
                 m_signalColors);
     } else if (m_type == OverviewType::HSV) {
         waveformOverviewRenderer::drawWaveformPartHSV(
-                &painter,
+                pPainter,
                 pWaveform,
-                &m_actualCompletion,
-                nextCompletion,
+                &start,
+                end,
                 m_signalColors);
     } else { // OverviewType::RGB:
         waveformOverviewRenderer::drawWaveformPartRGB(
-                &painter,
+                pPainter,
                 pWaveform,
-                &m_actualCompletion,
-                nextCompletion,
+                &start,
+                end,
                 m_signalColors);
     }
-
-    m_waveformImageScaled = QImage();
-    m_diffGain = 0;
-
-    // Test if the complete waveform is done
-    if (m_actualCompletion >= dataSize - 2) {
-        m_pixmapDone = true;
-    }
-
-    return true;
 }
 
 void WOverview::paintText(const QString& text, QPainter* pPainter) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <QBitArray>
 #include <QColor>
 #include <QList>
 #include <QPixmap>
@@ -75,6 +76,15 @@ class WOverview : public WWidget, public TrackDropTarget {
     // Append the waveform overview pixmap according to available data
     // in waveform
     bool drawNextPixmapPart();
+    // Draws the parts of the waveform of a streamed track that have been
+    // computed since the previous call, see Waveform::getCachedRanges()
+    bool drawNewCachedRanges(const QVector<QPair<double, double>>& cachedRanges);
+    void createWaveformSourceImage(const ConstWaveformPointer& pWaveform);
+    // Draws the visual samples [start, end) into m_waveformSourceImage
+    void drawWaveformPart(QPainter* pPainter,
+            const ConstWaveformPointer& pWaveform,
+            int start,
+            int end);
     void drawNextPixmapPartHSV(QPainter* pPainter,
             ConstWaveformPointer pWaveform,
             const int nextCompletion);
@@ -88,6 +98,7 @@ class WOverview : public WWidget, public TrackDropTarget {
     void drawEndOfTrackBackground(QPainter* pPainter);
     void drawAxis(QPainter* pPainter);
     void drawWaveformPixmap(QPainter* pPainter);
+    void drawCacheCoverage(QPainter* pPainter);
     void drawMinuteMarkers(QPainter* pPainter);
     void drawPlayedOverlay(QPainter* pPainter);
     void drawPlayPosition(QPainter* pPainter);
@@ -148,6 +159,9 @@ class WOverview : public WWidget, public TrackDropTarget {
 
     mixxx::OverviewType m_type;
     int m_actualCompletion;
+    // The pairs of visual samples of a streamed track that have been drawn.
+    // Empty unless the waveform is built from a partial download.
+    QBitArray m_drawnVisualPairs;
     bool m_pixmapDone;
     float m_waveformPeak;
     float m_diffGain;
@@ -1782,13 +1782,16 @@ void WTrackMenu::slotAnalyze() {
 
 void WTrackMenu::slotReanalyze() {
     clearBeats();
-    addToAnalysis();
+    AnalyzerTrack::Options options;
+    options.reuseResults = false;
+    addToAnalysis(options);
 }
 
 void WTrackMenu::slotReanalyzeWithFixedTempo() {
     clearBeats();
     AnalyzerTrack::Options options;
     options.useFixedTempo = true;
+    options.reuseResults = false;
     addToAnalysis(options);
 }
 
@@ -1796,6 +1799,7 @@ void WTrackMenu::slotReanalyzeWithVariableTempo() {
     clearBeats();
     AnalyzerTrack::Options options;
     options.useFixedTempo = false;
+    options.reuseResults = false;
     addToAnalysis(options);
 }
 
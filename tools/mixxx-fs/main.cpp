@@ -1,10 +1,254 @@
+#include <curl/curl.h>
+#include <fuse_lowlevel.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "streaming/bridge/fusedriver.h"
+#include "streaming/bridge/httprangefetcher.h"
+
+namespace {
+
+// The bridge controls the daemon through its standard input, one command
+// per line. Every command is answered on the standard output with a line
+// that starts with "ok" or "error".
+//
+//   add <name> <url> [size]  Exposes the stream at url as the file <name>.
+//                            The size is queried from the server if omitted.
+//   remove <name>            Removes the file. Pending reads fail.
+//
+// The daemon exits when the standard input is closed.
+constexpr int kControlPollTimeoutMillis = 100;
+
+struct Options {
+    char* cacheDir = nullptr;
+};
+
+const struct fuse_opt kOptionSpecs[] = {
+        {"--cache-dir=%s", offsetof(Options, cacheDir), 1},
+        FUSE_OPT_END};
+
+std::filesystem::path defaultCacheDir() {
+    if (const char* pCacheHome = std::getenv("XDG_CACHE_HOME")) {
+        return std::filesystem::path(pCacheHome) / "mixxx" / "partial";
+    }
+    if (const char* pHome = std::getenv("HOME")) {
+        return std::filesystem::path(pHome) / ".cache" / "mixxx" / "partial";
+    }
+    return std::filesystem::temp_directory_path() / "mixxx-partial";
+}
+
+class Controller {
+  public:
+    Controller(FuseDriver* pDriver,
+            HttpRangeFetcher* pFetcher,
+            std::filesystem::path cacheDir)
+            : m_pDriver(pDriver),
+              m_pFetcher(pFetcher),
+              m_cacheDir(std::move(cacheDir)),
+              m_mainThread(pthread_self()),
+              m_stopped(false) {
+    }
+
+    void start() {
+        m_thread = std::thread(&Controller::run, this);
+    }
+
+    void stop() {
+        m_stopped.store(true);
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+  private:
+    void run() {
+        std::string buffer;
+        while (!m_stopped.load()) {
+            struct pollfd pollFd = {STDIN_FILENO, POLLIN, 0};
+            const int result = ::poll(&pollFd, 1, kControlPollTimeoutMillis);
+            if (result == 0 || (result < 0 && errno == EINTR)) {
+                continue;
+            }
+            char chunk[4096];
+            const ssize_t length = result > 0 ? ::read(STDIN_FILENO, chunk, sizeof(chunk)) : -1;
+            if (length <= 0) {
+                // The bridge has gone away. The signal handler installed
+                // by FUSE exits the session loop in the main thread.
+                pthread_kill(m_mainThread, SIGTERM);
+                return;
+            }
+            buffer.append(chunk, static_cast<std::size_t>(length));
+            std::size_t lineEnd;
+            while ((lineEnd = buffer.find('\n')) != std::string::npos) {
+                handleCommand(buffer.substr(0, lineEnd));
+                buffer.erase(0, lineEnd + 1);
+            }
+        }
+    }
+
+    void handleCommand(const std::string& line) {
+        std::istringstream stream(line);
+        std::string command;
+        std::string name;
+        stream >> command >> name;
+        if (command == "add") {
+            std::string url;
+            int64_t size = -1;
+            stream >> url;
+            if (!(stream >> size)) {
+                size = -1;
+            }
+            reply(addTrack(name, url, size), name);
+        } else if (command == "remove") {
+            reply(removeTrack(name), name);
+        } else if (!command.empty()) {
+            reply("unknown command " + command, name);
+        }
+    }
+
+    std::string addTrack(const std::string& name, const std::string& url, int64_t size) {
+        if (name.empty() || url.empty()) {
+            return "usage: add <name> <url> [size]";
+        }
+        if (name.find('/') != std::string::npos || m_inodes.count(name) > 0) {
+            return "invalid or duplicate name";
+        }
+        if (size <= 0) {
+            size = HttpRangeFetcher::queryContentLength(url);
+            if (size <= 0) {
+                return "failed to query the size";
+            }
+        }
+        auto pCache = std::make_shared<SparseCache>(size);
+        // A partial download of a previous session is resumed
+        if (!pCache->openBackingFile((m_cacheDir / (name + ".cache")).string())) {
+            return "failed to open the backing file";
+        }
+        // The inode is only known after registering the track, but the
+        // fetcher must know the URL before the first read arrives
+        const fuse_ino_t ino = m_pDriver->addTrack(name, pCache);
+        if (ino == 0) {
+            return "failed to add the track";
+        }
+        m_pFetcher->setUrl(ino, url);
+        m_inodes.emplace(name, ino);
+        return std::string();
+    }
+
+    std::string removeTrack(const std::string& name) {
+        const auto it = m_inodes.find(name);
+        if (it == m_inodes.end()) {
+            return "no such track";
+        }
+        m_pDriver->removeTrack(it->second);
+        m_pFetcher->removeUrl(it->second);
+        m_inodes.erase(it);
+        return std::string();
+    }
+
+    static void reply(const std::string& error, const std::string& name) {
+        if (error.empty()) {
+            std::cout << "ok " << name << std::endl;
+        } else {
+            std::cout << "error " << name << ' ' << error << std::endl;
+        }
+    }
+
+    FuseDriver* const m_pDriver;
+    HttpRangeFetcher* const m_pFetcher;
+    const std::filesystem::path m_cacheDir;
+    const pthread_t m_mainThread;
+    std::atomic<bool> m_stopped;
+    std::thread m_thread;
+    std::map<std::string, fuse_ino_t> m_inodes;
+};
+
+} // anonymous namespace
 
 int main(int argc, char* argv[]) {
-    // Basic stub for the FUSE daemon
-    std::cout << "Starting Mixxx-Kinetic FUSE Daemon..." << std::endl;
+    struct fuse_args args = FUSE_ARGS_INIT(argc, argv);
+    Options options;
+    if (fuse_opt_parse(&args, &options, kOptionSpecs, nullptr) != 0) {
+        return EXIT_FAILURE;
+    }
+    struct fuse_cmdline_opts opts;
+    if (fuse_parse_cmdline(&args, &opts) != 0) {
+        std::free(options.cacheDir);
+        return EXIT_FAILURE;
+    }
+    int result = EXIT_FAILURE;
+    if (opts.show_help) {
+        std::printf("usage: %s [options] --cache-dir=<dir> <mountpoint>\n\n", argv[0]);
+        fuse_cmdline_help();
+        fuse_lowlevel_help();
+        result = EXIT_SUCCESS;
+    } else if (opts.show_version) {
+        fuse_lowlevel_version();
+        result = EXIT_SUCCESS;
+    } else if (!opts.mountpoint) {
+        std::fprintf(stderr, "usage: %s [options] --cache-dir=<dir> <mountpoint>\n", argv[0]);
+    } else if (!opts.foreground) {
+        // Daemonizing would detach the standard input
+        std::fprintf(stderr, "%s is controlled by its standard input and must run in the foreground (-f)\n", argv[0]);
+    } else {
+        const std::filesystem::path cacheDir =
+                options.cacheDir ? std::filesystem::path(options.cacheDir) : defaultCacheDir();
+        std::error_code error;
+        std::filesystem::create_directories(cacheDir, error);
+        if (error) {
+            std::fprintf(stderr, "Failed to create the cache directory %s\n", cacheDir.c_str());
+        } else {
+            curl_global_init(CURL_GLOBAL_DEFAULT);
+
+            HttpRangeFetcher fetcher;
+            auto pDriver = std::make_unique<FuseDriver>(&fetcher);
+            struct fuse_session* pSession = fuse_session_new(&args,
+                    &FuseDriver::operations(),
+                    sizeof(fuse_lowlevel_ops),
+                    pDriver.get());
+            if (pSession) {
+                if (fuse_set_signal_handlers(pSession) == 0) {
+                    if (fuse_session_mount(pSession, opts.mountpoint) == 0) {
+                        fetcher.start(pDriver.get());
+                        Controller controller(pDriver.get(), &fetcher, cacheDir);
+                        controller.start();
+                        // A single session thread is sufficient, because reads
+                        // never block: misses are parked until the fetcher is done.
+                        result = fuse_session_loop(pSession) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+                        controller.stop();
+                        // No more replies must be sent after the session has
+                        // been destroyed
+                        fetcher.stop();
+                        pDriver->failPendingReads(EIO);
+                        pDriver.reset();
+                        fuse_session_unmount(pSession);
+                    }
+                    fuse_remove_signal_handlers(pSession);
+                }
+                fuse_session_destroy(pSession);
+            }
 
-    // TODO: Initialize FuseDriver and start loop
+            curl_global_cleanup();
+        }
+    }
 
-    return 0;
+    std::free(opts.mountpoint);
+    std::free(options.cacheDir);
+    fuse_opt_free_args(&args);
+    return result;
 }